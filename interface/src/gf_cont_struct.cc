@@ -48,8 +48,10 @@ void gf_cont_struct(getfemint::mexargs_in& in, getfemint::mexargs_out& out) {
     - 'lsolver', @str SOLVER_NAME
        name of the solver to be used for the incorporated linear systems
        (the default value is 'auto', which lets getfem choose itself);
-       possible values are 'superlu', 'mumps' (if supported), 'cg/ildlt',
-       'gmres/ilu' and 'gmres/ilut';
+       possible values are 'superlu', 'superlu/mixed', 'mumps' (if
+       supported), 'cg/ildlt', 'pipelined_cg/ildlt', 'gmres/ilu',
+       'gmres_cgs2/ilu', 'gmres/ilut', 'cg/amg', 'pipelined_cg/amg' and
+       'gmres/amg';
     - 'h_init', @scalar HIN
        initial step size (the default value is 1e-2);
     - 'h_max', @scalar HMAX
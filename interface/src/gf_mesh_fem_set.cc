@@ -241,6 +241,25 @@ void gf_mesh_fem_set(getfemint::mexargs_in& m_in,
        mf->reduce_to_basic_dof(cols);
        );
 
+    /*@SET ('dof renumbering', @str method)
+      Set the renumbering of the degrees of freedom done after their
+      enumeration. `method` is 'none', 'rcm' (reverse Cuthill-McKee
+      ordering, which reduces the bandwidth of the assembled matrices) or
+      'nested dissection' (which reduces the fill-in of the direct
+      solvers). The reduction and extension matrices, if any, are permuted
+      accordingly.@*/
+    sub_command
+      ("dof renumbering", 1, 1, 0, 0,
+       std::string meth = in.pop().to_string();
+       if (cmd_strmatch(meth, "none"))
+         mf->set_dof_renumbering(getfem::DOF_RENUMBERING_NONE);
+       else if (cmd_strmatch(meth, "rcm"))
+         mf->set_dof_renumbering(getfem::DOF_RENUMBERING_RCM);
+       else if (cmd_strmatch(meth, "nested dissection"))
+         mf->set_dof_renumbering(getfem::DOF_RENUMBERING_NESTED_DISSECTION);
+       else THROW_BADARG("bad renumbering method: " << meth);
+       );
+
     /*@SET ('dof partition', @ivec DOFP)
       Change the 'dof_partition' array.
       
@@ -388,6 +388,19 @@ void gf_mesh_set(getfemint::mexargs_in& m_in,
        );
 
 
+    /*@SET ('optimize layout')
+    Renumber the convexes along a Hilbert space filling curve and the
+    points in the order of their first use by the convexes.
+
+    The mesh is first packed as with MESH:SET('optimize structure'). The
+    new numbering improves the memory locality of the computations on
+    elements. The regions are renumbered accordingly.@*/
+    sub_command
+      ("optimize layout", 0, 0, 0, 0,
+       pmesh->optimize_layout();
+       );
+
+
     /*@SET ('refine'[, @ivec CVIDs])
     Use a Bank strategy for mesh refinement.
 
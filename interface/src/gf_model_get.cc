@@ -408,8 +408,10 @@ void gf_model_get(getfemint::mexargs_in& m_in,
     - 'lsolver', @str SOLVER_NAME
        select explicitely the solver used for the linear systems (the
        default value is 'auto', which lets getfem choose itself).
-       Possible values are 'superlu', 'mumps' (if supported),
-       'cg/ildlt', 'gmres/ilu' and 'gmres/ilut'.
+       Possible values are 'superlu', 'superlu/mixed', 'mumps' (if
+       supported), 'cg/ildlt', 'pipelined_cg/ildlt', 'gmres/ilu',
+       'gmres_cgs2/ilu', 'gmres/ilut', 'cg/amg', 'pipelined_cg/amg' and
+       'gmres/amg'.
     - 'lsearch', @str LINE_SEARCH_NAME
        select explicitely the line search method used for the linear systems (the
        default value is 'default').
@@ -1315,6 +1317,42 @@ void gf_model_get(getfemint::mexargs_in& m_in,
        );
 
 
+    /*@GET {instr, expr, stage, nbcalls, time} = ('generic assembly profiling')
+      Gives the execution statistics of the generic assembly instructions
+      collected since the profiling has been enabled (see
+      MODEL:SET('generic assembly profiling')), sorted by decreasing
+      cumulative time. `instr` is the list of instruction types, `expr` the
+      (sub-)expressions they come from, `stage` the stage of execution
+      ('begin', 'element' or 'point'), `nbcalls` the number of calls and
+      `time` the cumulative execution time in seconds.@*/
+    sub_command
+      ("generic assembly profiling", 0, 0, 0, 5,
+       std::vector<getfem::ga_profiling_data::entry> entries;
+       md->generic_assembly_profiling_data().report(entries);
+       std::vector<std::string> instr;
+       std::vector<std::string> expr;
+       std::vector<std::string> stage;
+       for (const auto &e : entries) {
+         instr.push_back(e.instruction);
+         expr.push_back(e.expression);
+         stage.push_back(e.stage);
+       }
+       out.pop().from_string_container(instr);
+       if (out.remaining()) out.pop().from_string_container(expr);
+       if (out.remaining()) out.pop().from_string_container(stage);
+       if (out.remaining()) {
+         iarray nbcalls = out.pop().create_iarray_h(unsigned(entries.size()));
+         for (size_type i = 0; i < entries.size(); ++i)
+           nbcalls[i] = int(entries[i].nb_calls);
+       }
+       if (out.remaining()) {
+         darray times = out.pop().create_darray_h(unsigned(entries.size()));
+         for (size_type i = 0; i < entries.size(); ++i)
+           times[i] = entries[i].time;
+       }
+       );
+
+
     /*@GET s = ('char')
       Output a (unique) string representation of the @tmodel.
 
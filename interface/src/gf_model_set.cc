@@ -2904,6 +2904,29 @@ void gf_model_set(getfemint::mexargs_in& m_in,
        getfem::add_Houbolt_scheme(*md, varname);
        );
 
+    /*@SET ('generic assembly profiling', @int enable)
+      Enable (`enable` = 1) or disable (`enable` = 0) the collection of the
+      execution statistics of the generic assembly instructions, for the
+      optimization of the expressions (see
+      MODEL:GET('generic assembly profiling')). The statistics are cleared.@*/
+    sub_command
+      ("generic assembly profiling", 1, 1, 0, 0,
+       bool enable = (in.pop().to_integer() != 0);
+       md->set_generic_assembly_profiling(enable);
+       md->clear_generic_assembly_profiling();
+       );
+
+    /*@SET ('structure frozen', @int frozen)
+      Enable (`frozen` = 1) or disable (`frozen` = 0) the structure frozen
+      state of the model. In this state, the sparsity structure of the
+      tangent matrix is kept between two assemblies and only its values are
+      set to zero. The structure is rebuilt when the size of the model
+      changes.@*/
+    sub_command
+      ("structure frozen", 1, 1, 0, 0,
+       md->set_structure_frozen(in.pop().to_integer() != 0);
+       );
+
      /*@SET ('disable bricks', @ivec bricks_indices)
        Disable a brick (the brick will no longer participate to the
        building of the tangent linear system).@*/
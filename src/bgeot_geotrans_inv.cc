@@ -99,6 +99,158 @@ namespace bgeot
     return point_in_convex(*pgt, n_ref, gmm::vect_norm2(y), IN_EPS);
   }
 
+  size_type geotrans_inv_convex::invert_points
+  (size_type nb, const base_vector &xreal, base_vector &xref,
+   std::vector<bool> &isin, std::vector<bool> &converged,
+   scalar_type IN_EPS, bool project_into_element) {
+    assert(pgt);
+    GMM_ASSERT1(xreal.size() == N*nb, "Dimensions mismatch");
+    xref.resize(P*nb);
+    isin.assign(nb, false); converged.assign(nb, true);
+    if (nb == 0) return 0;
+    if (std::dynamic_pointer_cast<const torus_geom_trans>(pgt)) {
+      // the torus transformations are inverted point by point, as by invert
+      base_node n(N), n_ref(P);
+      for (size_type i = 0; i < nb; ++i) {
+        for (size_type k = 0; k < N; ++k) n[k] = xreal[k*nb+i];
+        bool conv = true;
+        isin[i] = invert(n, n_ref, conv, IN_EPS, project_into_element);
+        converged[i] = conv;
+        for (size_type p = 0; p < P; ++p) xref[p*nb+i] = n_ref[p];
+      }
+    }
+    else if (pgt->is_linear())
+      invert_lin_points(nb, xreal, xref, isin, IN_EPS);
+    else
+      invert_nonlin_points(nb, xreal, xref, isin, converged, IN_EPS,
+                           project_into_element);
+    return size_type(std::count(isin.begin(), isin.end(), true));
+  }
+
+  /* batch inversion for linear geometric transformations. The loops on
+     the points are the inner ones and are done on contiguous arrays. */
+  void geotrans_inv_convex::invert_lin_points(size_type nb,
+                                              const base_vector &xreal,
+                                              base_vector &xref,
+                                              std::vector<bool> &isin,
+                                              scalar_type IN_EPS) {
+    base_matrix KK(N, P);
+    pgt->compute_K_matrix(G, pc, KK);
+    base_vector d(nb), res(nb, scalar_type(0));
+
+    // xref = B^T (xreal - G_0)
+    for (size_type p = 0; p < P; ++p) {
+      scalar_type *xp = &xref[p*nb];
+      std::fill(xp, xp + nb, scalar_type(0));
+      for (size_type k = 0; k < N; ++k) {
+        const scalar_type b = B(k, p), g = G(k, 0), *xk = &xreal[k*nb];
+        for (size_type i = 0; i < nb; ++i) xp[i] += b * (xk[i] - g);
+      }
+    }
+
+    // squared residual |G_0 + K xref - xreal|^2
+    for (size_type k = 0; k < N; ++k) {
+      const scalar_type g = G(k, 0), *xk = &xreal[k*nb];
+      for (size_type i = 0; i < nb; ++i) d[i] = g - xk[i];
+      for (size_type p = 0; p < P; ++p) {
+        const scalar_type a = KK(k, p), *xp = &xref[p*nb];
+        for (size_type i = 0; i < nb; ++i) d[i] += a * xp[i];
+      }
+      for (size_type i = 0; i < nb; ++i) res[i] += d[i] * d[i];
+    }
+
+    if (pgt->nb_points() == P + 1) { // simplex, same test as its is_in
+      base_vector e(nb, scalar_type(-1));
+      for (size_type i = 0; i < nb; ++i) d[i] = P ? -xref[i] : 0.0;
+      for (size_type p = 0; p < P; ++p) {
+        const scalar_type *xp = &xref[p*nb];
+        for (size_type i = 0; i < nb; ++i)
+          { e[i] += xp[i]; d[i] = std::max(d[i], -xp[i]); }
+      }
+      for (size_type i = 0; i < nb; ++i)
+        isin[i] = (std::max(d[i], e[i]) < IN_EPS)
+          && (gmm::sqrt(res[i]) < IN_EPS);
+    } else {
+      base_node x(P);
+      for (size_type i = 0; i < nb; ++i) {
+        for (size_type p = 0; p < P; ++p) x[p] = xref[p*nb+i];
+        isin[i] = point_in_convex(*pgt, x, gmm::sqrt(res[i]), IN_EPS);
+      }
+    }
+  }
+
+  /* batch inversion for non-linear geometric transformations. Same
+     initial guess and damped Newton iteration as invert_nonlin, step by
+     step, with workspaces shared by the points. */
+  void geotrans_inv_convex::invert_nonlin_points
+  (size_type nb, const base_vector &xreal, base_vector &xref,
+   std::vector<bool> &isin, std::vector<bool> &converged,
+   scalar_type IN_EPS, bool project_into_element) {
+    size_type nbpt = pgt->nb_points();
+    base_node x(P), x0_ref(P), y(N);
+    base_vector val(nbpt), diff(N);
+
+    auto residual = [&]() { // diff = pgt(x) - y, as transform(x, G) - y
+      pgt->poly_vector_val(x, val);
+      gmm::clear(diff);
+      base_matrix::const_iterator git = G.begin();
+      for (size_type l = 0; l < nbpt; ++l) {
+        const scalar_type a = val[l];
+        for (size_type k = 0; k < N; ++k, ++git) diff[k] += a * (*git);
+      }
+      for (size_type k = 0; k < N; ++k) diff[k] -= y[k];
+      return gmm::vect_norm2(diff);
+    };
+
+    for (size_type i = 0; i < nb; ++i) {
+      for (size_type k = 0; k < N; ++k) y[k] = xreal[k*nb+i];
+
+      { // initial guess
+        x0_ref = pgt->geometric_nodes()[0];
+        scalar_type res = gmm::vect_dist2(mat_col(G, 0), y);
+        for (size_type j = 1; j < nbpt; ++j) {
+          scalar_type res0 = gmm::vect_dist2(mat_col(G, j), y);
+          if (res0 < res) { res = res0; x0_ref = pgt->geometric_nodes()[j]; }
+        }
+        scalar_type res0 = std::numeric_limits<scalar_type>::max();
+        if (has_linearized_approx) {
+          for (size_type k = 0; k < N; ++k) diff[k] = y[k] - P_lin[k];
+          gmm::mult(K_ref_B_transp_lin, diff, x);
+          gmm::add(P_ref_lin, x);
+          if (project_into_element) project_into_convex(x, pgt);
+          res0 = residual();
+        }
+        if (res < res0) gmm::copy(x0_ref, x);
+        if (res < IN_EPS) x *= 0.999888783;
+      }
+
+      scalar_type res = residual();
+      scalar_type res0 = std::numeric_limits<scalar_type>::max();
+      double factor = 1.0;
+      while (res > IN_EPS) {
+        if ((gmm::abs(res - res0) < IN_EPS) || (factor < IN_EPS))
+          { converged[i] = false; break; }
+        if (res > res0) { // back to the previous point
+          gmm::add(gmm::scaled(x0_ref, factor), x);
+          residual();
+          factor *= 0.5;
+        } else {
+          if (factor < 1.0-IN_EPS) factor = 2.0;
+          res0 = res;
+        }
+        pgt->poly_vector_grad(x, pc);
+        update_B();
+        gmm::mult(gmm::transposed(B), diff, x0_ref);
+        gmm::add(gmm::scaled(x0_ref, -1.0 * factor), x);
+        if (project_into_element) project_into_convex(x, pgt);
+        res = residual();
+      }
+
+      isin[i] = point_in_convex(*pgt, x, res, IN_EPS);
+      for (size_type p = 0; p < P; ++p) xref[p*nb+i] = x[p];
+    }
+  }
+
   void geotrans_inv_convex::update_B() {
     if (P != N) {
       pgt->compute_K_matrix(G, pc, K);
@@ -33,11 +33,15 @@ namespace bgeot {
   };
   
   struct kdtree_node : public kdtree_elt_base {
-    scalar_type split_v;
+    /* bounds of the children in the splitting direction: the points of
+       left are <= left_max and the ones of right are >= right_min. Both are
+       equal to the splitting value when the tree is built, they may overlap
+       once the tree has been refitted. */
+    scalar_type left_max, right_min;
     std::unique_ptr<kdtree_elt_base> left, right; /* left: <=v, right: >v */
     kdtree_node(scalar_type v, std::unique_ptr<kdtree_elt_base> &&left_,
 		std::unique_ptr<kdtree_elt_base> &&right_) : 
-      kdtree_elt_base(0), split_v(v),
+      kdtree_elt_base(0), left_max(v), right_min(v),
       left(std::move(left_)), right(std::move(right_)) {}
   };
 
@@ -135,9 +139,9 @@ namespace bgeot {
 			     const kdtree_elt_base *t, unsigned dir) {
     if (!t->isleaf()) {
       const kdtree_node *tn = static_cast<const kdtree_node*>(t);
-      if (p.bmin[dir] <= tn->split_v && tn->left.get())
+      if (p.bmin[dir] <= tn->left_max && tn->left.get())
         points_in_box_(p, tn->left.get(), unsigned((dir+1)%p.N));
-      if (p.bmax[dir] > tn->split_v && tn->right)
+      if (p.bmax[dir] >= tn->right_min && tn->right)
         points_in_box_(p, tn->right.get(), unsigned((dir+1)%p.N));
     } else {
       const kdtree_leaf *tl = static_cast<const kdtree_leaf*>(t);
@@ -176,14 +180,15 @@ namespace bgeot {
     if (!t->isleaf()) {
       const kdtree_node *tn = static_cast<const kdtree_node*>(t);
       scalar_type tmp = p.vec_to_tree_elm[dir];
-      scalar_type dist = p.pos[dir] - tn->split_v;
+      scalar_type distl = p.pos[dir] - tn->left_max;
+      scalar_type distr = tn->right_min - p.pos[dir];
       if (tn->left.get()) {
-        if (dist > tmp) p.vec_to_tree_elm[dir] = dist;
+        if (distl > tmp) p.vec_to_tree_elm[dir] = distl;
         nearest_neighbor_assist(p, tn->left.get(), unsigned((dir+1)%p.N));
         p.vec_to_tree_elm[dir] = tmp;
       }
       if (tn->right) {
-        if (-dist > tmp) p.vec_to_tree_elm[dir] = -dist;
+        if (distr > tmp) p.vec_to_tree_elm[dir] = distr;
         nearest_neighbor_assist(p, tn->right.get(), unsigned((dir+1)%p.N));
         p.vec_to_tree_elm[dir] = tmp;
       }
@@ -210,8 +215,10 @@ namespace bgeot {
 			            const kdtree_elt_base *t, unsigned dir) {
     if (!t->isleaf()) {
       const kdtree_node *tn = static_cast<const kdtree_node*>(t);
-      scalar_type dist = p.pos[dir] - tn->split_v;
-      if ((dist <= scalar_type(0) && tn->left.get()) || !tn->right.get()) {
+      scalar_type distl = p.pos[dir] - tn->left_max;
+      scalar_type distr = tn->right_min - p.pos[dir];
+      bool to_left = (distl <= distr && tn->left.get()) || !tn->right.get();
+      if (to_left) {
         nearest_neighbor_main(p, tn->left.get(), unsigned((dir+1)%p.N));
       } else if (tn->right.get()) {
         nearest_neighbor_main(p, tn->right.get(), unsigned((dir+1)%p.N));
@@ -220,12 +227,14 @@ namespace bgeot {
       }
       // check the possibility of points at the opposite side of the current
       // tree node which are closer to pos as the current minimum distance
+      // (the children may overlap in a refitted tree)
+      scalar_type dist = std::max(to_left ? distr : distl, scalar_type(0));
       if (dist * dist <= p.dist2) {
         for (size_type k=0; k < p.N; ++k) p.vec_to_tree_elm[k] = 0.;
-        if ((dist <= scalar_type(0) && tn->right.get()) || !tn->left.get()) {
-          p.vec_to_tree_elm[dir] = -dist;
+        if (to_left && tn->right.get()) {
+          p.vec_to_tree_elm[dir] = dist;
           nearest_neighbor_assist(p, tn->right.get(), unsigned((dir+1)%p.N));
-        } else if (tn->left.get()) {
+        } else if (!to_left && tn->left.get()) {
           p.vec_to_tree_elm[dir] = dist;
           nearest_neighbor_assist(p, tn->left.get(), unsigned((dir+1)%p.N));
         }
@@ -236,13 +245,81 @@ namespace bgeot {
     }
   }
 
-  void kdtree::clear_tree() { tree = std::unique_ptr<kdtree_elt_base>(); }
+  /* recursive update of the bounds of the children of the nodes. The
+     bounding box of the points of t is returned in ws[i0 .. i0+2N[
+     (minimum then maximum). */
+  static void refit_(kdtree_elt_base *t, unsigned dir, size_type N,
+                     std::vector<scalar_type> &ws, size_type i0,
+                     scalar_type &overlap, size_type &nb_nodes) {
+    if (!t->isleaf()) {
+      kdtree_node *tn = static_cast<kdtree_node*>(t);
+      size_type i1 = i0 + 2*N;
+      if (ws.size() < i1 + 2*N) ws.resize(i1 + 2*N);
+      unsigned dir1 = unsigned((dir+1)%N);
+      if (tn->left.get()) {
+        refit_(tn->left.get(), dir1, N, ws, i1, overlap, nb_nodes);
+        tn->left_max = ws[i1+N+dir];
+        std::copy(ws.begin()+i1, ws.begin()+i1+2*N, ws.begin()+i0);
+      }
+      if (tn->right.get()) {
+        refit_(tn->right.get(), dir1, N, ws, i1, overlap, nb_nodes);
+        tn->right_min = ws[i1+dir];
+        if (tn->left.get())
+          for (size_type k = 0; k < N; ++k) {
+            ws[i0+k] = std::min(ws[i0+k], ws[i1+k]);
+            ws[i0+N+k] = std::max(ws[i0+N+k], ws[i1+N+k]);
+          }
+        else
+          std::copy(ws.begin()+i1, ws.begin()+i1+2*N, ws.begin()+i0);
+      }
+      if (tn->left.get() && tn->right.get()) {
+        scalar_type e = ws[i0+N+dir] - ws[i0+dir];
+        if (e > scalar_type(0))
+          overlap += std::max(tn->left_max-tn->right_min, scalar_type(0)) / e;
+        ++nb_nodes;
+      }
+    } else {
+      const kdtree_leaf *tl = static_cast<const kdtree_leaf*>(t);
+      kdtree_tab_type::const_iterator itpt = tl->it;
+      std::copy(itpt->n.begin(), itpt->n.end(), ws.begin()+i0);
+      std::copy(itpt->n.begin(), itpt->n.end(), ws.begin()+i0+N);
+      for (size_type i=tl->n-1; i; --i) {
+        ++itpt;
+        base_node::const_iterator it=itpt->n.const_begin();
+        for (size_type k = 0; k < N; ++k) {
+          ws[i0+k] = std::min(ws[i0+k], it[k]);
+          ws[i0+N+k] = std::max(ws[i0+N+k], it[k]);
+        }
+      }
+    }
+  }
+
+  bool kdtree::refit(scalar_type max_overlap) {
+    refit_needed = false;
+    if (!tree) return false;
+    scalar_type overlap(0);
+    size_type nb_nodes(0);
+    if (refit_ws.size() < 2*N) refit_ws.resize(2*N);
+    refit_(tree.get(), 0, N, refit_ws, 0, overlap, nb_nodes);
+    if (nb_nodes && overlap > max_overlap * scalar_type(nb_nodes)) {
+      tree = build_tree_(pts.begin(), pts.end(), 0);
+      return true;
+    }
+    return false;
+  }
+
+  void kdtree::clear_tree()
+  { tree = std::unique_ptr<kdtree_elt_base>(); refit_needed = false; }
+
+  void kdtree::build_tree()
+  { if (!tree) tree = build_tree_(pts.begin(), pts.end(), 0); }
 
   void kdtree::points_in_box(kdtree_tab_type &ipts,
 			     const base_node &min, 
 			     const base_node &max) {
     ipts.resize(0);
-    if (tree == 0) { tree = build_tree_(pts.begin(), pts.end(), 0); if (!tree) return; }
+    build_tree(); if (!tree) return;
+    GMM_ASSERT1(!refit_needed, "Points have been moved, refit the tree");
     base_node bmin(min), bmax(max);
     for (size_type i=0; i < bmin.size(); ++i) if (bmin[i] > bmax[i]) return;
     points_in_box_data_ p; 
@@ -255,10 +332,8 @@ namespace bgeot {
                                        const base_node &pos) {
     
     ipt.i = size_type(-1);
-    if (tree == 0) {
-      tree = build_tree_(pts.begin(), pts.end(), 0);
-      if (!tree) return scalar_type(-1);
-    }
+    build_tree(); if (!tree) return scalar_type(-1);
+    GMM_ASSERT1(!refit_needed, "Points have been moved, refit the tree");
     nearest_neighbor_data_ p;
     p.pos = pos.const_begin();
     p.ipt = &ipt;
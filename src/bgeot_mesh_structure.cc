@@ -497,4 +497,168 @@ namespace bgeot {
     // cerr << "cuthill_mckee_on_convexes: " << enumerate_dof_time << " sec\n";
   }
 
+  /* ******************************************************************** */
+  /*    Orderings of the points of a mesh structure.                       */
+  /* ******************************************************************** */
+
+  // Graph of the points used by at least one convex, two points being
+  // adjacent if they share a convex (compressed storage).
+  struct points_ordering_ {
+    std::vector<size_type> pts, xadj, adj;
+    std::vector<size_type> mark, seen, level, visit, lev;
+    size_type stamp, nmark;
+
+    size_type degree(size_type i) const { return xadj[i+1] - xadj[i]; }
+    void bfs(size_type s, size_type m);
+    size_type pseudo_peripheral(size_type s, size_type m);
+    void rcm(const std::vector<size_type> &nodes, size_type m,
+             std::vector<size_type> &order);
+    void nested_dissection(const std::vector<size_type> &nodes,
+                           std::vector<size_type> &order);
+    explicit points_ordering_(const mesh_structure &ms);
+  };
+
+  points_ordering_::points_ordering_(const mesh_structure &ms)
+    : stamp(0), nmark(2) {
+    size_type nbp = ms.nb_max_points();
+    std::vector<size_type> num(nbp, size_type(-1));
+    for (size_type ip = 0; ip < nbp; ++ip)
+      if (ms.is_point_valid(ip)) { num[ip] = pts.size(); pts.push_back(ip); }
+    size_type n = pts.size();
+    std::vector<size_type> tag(n, size_type(-1));
+    xadj.assign(n+1, 0);
+    for (size_type i = 0; i < n; ++i) {
+      tag[i] = i;
+      for (size_type cv : ms.convex_to_point(pts[i]))
+        for (size_type ip : ms.ind_points_of_convex(cv)) {
+          size_type j = num[ip];
+          if (tag[j] != i) { tag[j] = i; adj.push_back(j); }
+        }
+      xadj[i+1] = adj.size();
+    }
+    mark.assign(n, 0); seen.assign(n, 0); level.assign(n, 0);
+  }
+
+  // Level structure rooted at s of the component of s in the subgraph of
+  // the nodes marked m. visit contains the nodes level by level, lev the
+  // beginning of each level in visit.
+  void points_ordering_::bfs(size_type s, size_type m) {
+    ++stamp;
+    visit.resize(0); lev.resize(0);
+    visit.push_back(s); seen[s] = stamp; level[s] = 0;
+    for (size_type k = 0; k < visit.size(); ++k) {
+      size_type i = visit[k];
+      if (k == 0 || level[i] != level[visit[k-1]]) lev.push_back(k);
+      for (size_type l = xadj[i]; l < xadj[i+1]; ++l) {
+        size_type j = adj[l];
+        if (mark[j] == m && seen[j] != stamp) {
+          seen[j] = stamp; level[j] = level[i] + 1; visit.push_back(j);
+        }
+      }
+    }
+    lev.push_back(visit.size());
+  }
+
+  // Pseudo-peripheral node of the component of s (A. George and J. W. H.
+  // Liu, ACM Trans. Math. Softw. 5(3), 1979). The level structure of the
+  // returned node is left in visit and lev.
+  size_type points_ordering_::pseudo_peripheral(size_type s, size_type m) {
+    bfs(s, m);
+    for (size_type it = 0; it < 10; ++it) {
+      size_type nl = lev.size() - 1, c = visit[lev[nl-1]];
+      for (size_type k = lev[nl-1]; k < lev[nl]; ++k)
+        if (degree(visit[k]) < degree(c)) c = visit[k];
+      bfs(c, m);
+      if (lev.size() - 1 <= nl) { bfs(s, m); break; }
+      s = c;
+    }
+    return s;
+  }
+
+  // Reverse Cuthill-McKee ordering of the nodes (marked m), appended to
+  // order, component by component.
+  void points_ordering_::rcm(const std::vector<size_type> &nodes,
+                             size_type m, std::vector<size_type> &order) {
+    std::vector<size_type> comp, nei, sorted(nodes);
+    std::sort(sorted.begin(), sorted.end(), [this](size_type a, size_type b)
+              { return degree(a) < degree(b); });
+    for (size_type s0 : sorted) {
+      if (mark[s0] != m) continue;
+      size_type s = pseudo_peripheral(s0, m);
+      comp.resize(0); comp.push_back(s); mark[s] = m + 1;
+      for (size_type k = 0; k < comp.size(); ++k) {
+        size_type i = comp[k];
+        nei.resize(0);
+        for (size_type l = xadj[i]; l < xadj[i+1]; ++l)
+          if (mark[adj[l]] == m)
+            { mark[adj[l]] = m + 1; nei.push_back(adj[l]); }
+        std::sort(nei.begin(), nei.end(), [this](size_type a, size_type b)
+                  { return degree(a) < degree(b); });
+        comp.insert(comp.end(), nei.begin(), nei.end());
+      }
+      order.insert(order.end(), comp.rbegin(), comp.rend());
+    }
+  }
+
+  const size_type nested_dissection_min_size = 128;
+
+  // Nested dissection ordering of the nodes, appended to order. The nodes
+  // are split by the middle level of a level structure rooted at a pseudo-
+  // peripheral node, the two parts are ordered recursively and the
+  // separator is numbered last.
+  void points_ordering_::nested_dissection
+  (const std::vector<size_type> &nodes, std::vector<size_type> &order) {
+    if (nodes.empty()) return;
+    size_type m = nmark; nmark += 2;  // marks m and m+1 (used by rcm)
+    for (size_type i : nodes) mark[i] = m;
+    if (nodes.size() <= nested_dissection_min_size)
+      { rcm(nodes, m, order); return; }
+
+    pseudo_peripheral(nodes[0], m);
+    std::vector<size_type> A, B, S;
+    if (visit.size() < nodes.size()) {        // disconnected subgraph
+      A = visit;
+      for (size_type i : nodes) if (seen[i] != stamp) B.push_back(i);
+      nested_dissection(A, order); nested_dissection(B, order);
+      return;
+    }
+    size_type nl = lev.size() - 1;
+    if (nl < 3) { rcm(nodes, m, order); return; }
+
+    size_type k = 1;
+    while (k < nl - 2 && lev[k+1] <= nodes.size() / 2) ++k;
+    for (size_type i : visit)
+      if (level[i] < k) A.push_back(i);
+      else if (level[i] > k) B.push_back(i);
+      else {
+        bool touch_B = false;   // separator nodes without neighbor in B
+        for (size_type l = xadj[i]; l < xadj[i+1] && !touch_B; ++l)
+          touch_B = (mark[adj[l]] == m && level[adj[l]] > k);
+        if (touch_B) S.push_back(i); else A.push_back(i);
+      }
+    nested_dissection(A, order);
+    nested_dissection(B, order);
+    order.insert(order.end(), S.begin(), S.end());
+  }
+
+  void reverse_cuthill_mckee_on_points(const mesh_structure &ms,
+                                       std::vector<size_type> &order) {
+    points_ordering_ po(ms);
+    std::vector<size_type> nodes(po.pts.size());
+    for (size_type i = 0; i < nodes.size(); ++i) nodes[i] = i;
+    order.resize(0); order.reserve(nodes.size());
+    po.rcm(nodes, 0, order);
+    for (size_type &i : order) i = po.pts[i];
+  }
+
+  void nested_dissection_on_points(const mesh_structure &ms,
+                                   std::vector<size_type> &order) {
+    points_ordering_ po(ms);
+    std::vector<size_type> nodes(po.pts.size());
+    for (size_type i = 0; i < nodes.size(); ++i) nodes[i] = i;
+    order.resize(0); order.reserve(nodes.size());
+    po.nested_dissection(nodes, order);
+    for (size_type &i : order) i = po.pts[i];
+  }
+
 }  /* end of namespace bgeot.                                              */
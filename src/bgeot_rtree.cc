@@ -23,100 +23,108 @@
 
 namespace bgeot {
 
-  struct rtree_node : public rtree_elt_base {
-    std::unique_ptr<rtree_elt_base> left, right;
-    rtree_node(const base_node& bmin, const base_node& bmax,
-               std::unique_ptr<rtree_elt_base> &&left_,
-               std::unique_ptr<rtree_elt_base> &&right_)
-      : rtree_elt_base(false, bmin, bmax), left(std::move(left_)),
-        right( std::move(right_)) { }
-  };
-
-  struct rtree_leaf : public rtree_elt_base {
-    rtree::pbox_cont lst;
-    rtree_leaf(const base_node& bmin, const base_node& bmax,
-               rtree::pbox_cont& lst_)
-      : rtree_elt_base(true, bmin, bmax) { lst.swap(lst_); }
-  };
-
-  /* enlarge box to hold [a..b] */
-  static void update_box(base_node& bmin, base_node& bmax,
-                         const base_node& a, const base_node& b) {
-    base_node::iterator itmin=bmin.begin(), itmax=bmax.begin();
-    for (size_type i=0; i < a.size(); ++i) {
-      itmin[i] = std::min(itmin[i], a.at(i));
-      itmax[i] = std::max(itmax[i], b.at(i));
-    }
-  }
-
-  inline static bool r1_ge_r2(const base_node& min1, const base_node& max1,
-                       const base_node& min2, const base_node& max2,
-                       scalar_type EPS) {
-    for (size_type i=0; i < min1.size(); ++i)
-      if ((min1[i] > min2[i]+EPS) || (max1[i] < max2[i]-EPS)) return false;
-    return true;
+  inline static bool r1_ge_r2(const scalar_type *min1, const scalar_type *max1,
+                              const scalar_type *min2, const scalar_type *max2,
+                              size_type N, scalar_type EPS) {
+    bool r = true;
+    for (size_type i=0; i < N; ++i)
+      r &= (min1[i] <= min2[i]+EPS) & (max1[i] >= max2[i]-EPS);
+    return r;
   }
 
-  inline static bool r1_inter_r2(const base_node& min1, const base_node& max1,
-                          const base_node& min2, const base_node& max2,
-                          scalar_type EPS) {
-    for (size_type i=0; i < min1.size(); ++i)
-      if ((max1[i] < min2[i]-EPS) || (min1[i] > max2[i]+EPS)) return false;
-    return true;
+  inline static bool r1_inter_r2(const scalar_type *min1,
+                                 const scalar_type *max1,
+                                 const scalar_type *min2,
+                                 const scalar_type *max2,
+                                 size_type N, scalar_type EPS) {
+    bool r = true;
+    for (size_type i=0; i < N; ++i)
+      r &= (max1[i] >= min2[i]-EPS) & (min1[i] <= max2[i]+EPS);
+    return r;
   }
 
-  /* some predicates for searches */
+  /* some predicates for searches. The tests on the coordinates are
+     written without branches, which allows their vectorization. */
   struct intersection_p {
-    const base_node &min, &max;
+    const scalar_type *min, *max;
+    const size_type N;
     const scalar_type EPS;
-    intersection_p(const base_node& min_, const base_node& max_, scalar_type EPS_)
-      : min(min_), max(max_), EPS(EPS_) {}
-    bool operator()(const base_node& min2, const base_node& max2) const
-    { return r1_inter_r2(min,max,min2,max2,EPS); }
-    bool accept(const base_node& min2, const base_node& max2) const
+    intersection_p(const base_node& min_, const base_node& max_,
+                   scalar_type EPS_)
+      : min(&*min_.begin()), max(&*max_.begin()), N(min_.size()),
+        EPS(EPS_) {}
+    bool operator()(const scalar_type *min2, const scalar_type *max2) const
+    { return r1_inter_r2(min,max,min2,max2,N,EPS); }
+    bool accept(const scalar_type *min2, const scalar_type *max2) const
     { return operator()(min2,max2); }
   };
 
   /* match boxes containing [min..max] */
   struct contains_p {
-    const base_node &min, &max;
+    const scalar_type *min, *max;
+    const size_type N;
     const scalar_type EPS;
     contains_p(const base_node& min_, const base_node& max_, scalar_type EPS_)
-      : min(min_), max(max_), EPS(EPS_) {}
-    bool operator()(const base_node& min2, const base_node& max2) const
-    { return r1_ge_r2(min2,max2,min,max,EPS); }
-    bool accept(const base_node& min2, const base_node& max2) const
-    { return r1_inter_r2(min,max,min2,max2,EPS); }
+      : min(&*min_.begin()), max(&*max_.begin()), N(min_.size()),
+        EPS(EPS_) {}
+    bool operator()(const scalar_type *min2, const scalar_type *max2) const
+    { return r1_ge_r2(min2,max2,min,max,N,EPS); }
+    bool accept(const scalar_type *min2, const scalar_type *max2) const
+    { return r1_inter_r2(min,max,min2,max2,N,EPS); }
   };
 
   /* match boxes contained in [min..max] */
   struct contained_p {
-    const base_node &min, &max;
+    const scalar_type *min, *max;
+    const size_type N;
     const scalar_type EPS;
-    contained_p(const base_node& min_, const base_node& max_, scalar_type EPS_)
-      : min(min_), max(max_), EPS(EPS_) {}
-    bool accept(const base_node& min2, const base_node& max2) const
-    { return r1_inter_r2(min,max,min2,max2,EPS); }
-    bool operator()(const base_node& min2, const base_node& max2) const
-    { return r1_ge_r2(min,max,min2,max2,EPS); }
+    contained_p(const base_node& min_, const base_node& max_,
+                scalar_type EPS_)
+      : min(&*min_.begin()), max(&*max_.begin()), N(min_.size()),
+        EPS(EPS_) {}
+    bool accept(const scalar_type *min2, const scalar_type *max2) const
+    { return r1_inter_r2(min,max,min2,max2,N,EPS); }
+    bool operator()(const scalar_type *min2, const scalar_type *max2) const
+    { return r1_ge_r2(min,max,min2,max2,N,EPS); }
   };
 
   /* match boxes containing P */
   struct has_point_p {
-    const base_node &P;
+    const scalar_type *P;
+    const size_type N;
     const scalar_type EPS;
-    has_point_p(const base_node& P_, scalar_type EPS_) : P(P_), EPS(EPS_) {}
-    bool operator()(const base_node& min2, const base_node& max2) const {
-      for (size_type i = 0; i < P.size(); ++i) {
-        if (P[i] < min2[i]-EPS) return false;
-        if (P[i] > max2[i]+EPS) return false;
-      }
-      return true;
+    has_point_p(const base_node& P_, scalar_type EPS_)
+      : P(&*P_.begin()), N(P_.size()), EPS(EPS_) {}
+    bool operator()(const scalar_type *min2, const scalar_type *max2) const {
+      bool r = true;
+      for (size_type i = 0; i < N; ++i)
+        r &= (P[i] >= min2[i]-EPS) & (P[i] <= max2[i]+EPS);
+      return r;
     }
-    bool accept(const base_node& min2, const base_node& max2) const
+    bool accept(const scalar_type *min2, const scalar_type *max2) const
     { return operator()(min2,max2); }
   };
 
+  static bool line_intersects_box(const base_node &org,
+                                  const base_small_vector &dirv,
+                                  const scalar_type *min2,
+                                  const scalar_type *max2) {
+    size_type N = org.size();
+    for (size_type i = 0; i < N; ++i)
+      if (dirv[i] != scalar_type(0)) {
+        scalar_type a1=(min2[i]-org[i])/dirv[i], a2=(max2[i]-org[i])/dirv[i];
+        bool interf1 = true, interf2 = true;
+        for (size_type j = 0; j < N; ++j)
+          if (j != i) {
+            scalar_type y1 = org[j] + a1*dirv[j], y2 = org[j] + a2*dirv[j];
+            if (y1 < min2[j] || y1 > max2[j]) interf1 = false;
+            if (y2 < min2[j] || y2 > max2[j]) interf2 = false;
+          }
+        if (interf1 || interf2) return true;
+      }
+    return false;
+  }
+
   /* match boxes intersecting the line passing through org and of
      direction vector dirv.*/
   struct intersect_line {
@@ -124,24 +132,9 @@ namespace bgeot {
     const base_small_vector dirv;
     intersect_line(const base_node& org_, const base_small_vector &dirv_)
       : org(org_), dirv(dirv_) {}
-    bool operator()(const base_node& min2, const base_node& max2) const {
-      size_type N = org.size();
-      GMM_ASSERT1(N == min2.size(), "Dimensions mismatch");
-      for (size_type i = 0; i < N; ++i)
-        if (dirv[i] != scalar_type(0)) {
-          scalar_type a1=(min2[i]-org[i])/dirv[i], a2=(max2[i]-org[i])/dirv[i];
-          bool interf1 = true, interf2 = true;
-          for (size_type j = 0; j < N; ++j)
-            if (j != i) {
-              scalar_type y1 = org[j] + a1*dirv[j], y2 = org[j] + a2*dirv[j];
-              if (y1 < min2[j] || y1 > max2[j]) interf1 = false;
-              if (y2 < min2[j] || y2 > max2[j]) interf2 = false;
-            }
-          if (interf1 || interf2) return true;
-        }
-      return false;
-    }
-    bool accept(const base_node& min2, const base_node& max2) const
+    bool operator()(const scalar_type *min2, const scalar_type *max2) const
+    { return line_intersects_box(org, dirv, min2, max2); }
+    bool accept(const scalar_type *min2, const scalar_type *max2) const
     { return operator()(min2,max2); }
   };
 
@@ -157,25 +150,12 @@ namespace bgeot {
                            const base_node& min_, const base_node& max_,
                            scalar_type EPS_)
       : org(org_), dirv(dirv_), min(min_), max(max_), EPS(EPS_) {}
-    bool operator()(const base_node& min2, const base_node& max2) const {
-      size_type N = org.size();
-      GMM_ASSERT1(N == min2.size(), "Dimensions mismatch");
-      if (!(r1_inter_r2(min,max,min2,max2,EPS))) return false;
-      for (size_type i = 0; i < N; ++i)
-        if (dirv[i] != scalar_type(0)) {
-          scalar_type a1=(min2[i]-org[i])/dirv[i], a2=(max2[i]-org[i])/dirv[i];
-          bool interf1 = true, interf2 = true;
-          for (size_type j = 0; j < N; ++j)
-            if (j != i) {
-              scalar_type y1 = org[j] + a1*dirv[j], y2 = org[j] + a2*dirv[j];
-              if (y1 < min2[j] || y1 > max2[j]) interf1 = false;
-              if (y2 < min2[j] || y2 > max2[j]) interf2 = false;
-            }
-          if (interf1 || interf2) return true;
-        }
-      return false;
+    bool operator()(const scalar_type *min2, const scalar_type *max2) const {
+      return r1_inter_r2(&*min.begin(), &*max.begin(), min2, max2,
+                         min.size(), EPS)
+        && line_intersects_box(org, dirv, min2, max2);
     }
-    bool accept(const base_node& min2, const base_node& max2) const
+    bool accept(const scalar_type *min2, const scalar_type *max2) const
     { return operator()(min2,max2); }
   };
 
@@ -185,222 +165,323 @@ namespace bgeot {
     if (tree_built) {
       GMM_WARNING3("Add a box when the tree is already built cancel the tree. "
                    "Unefficient operation.");
-      tree_built = false; root = std::unique_ptr<rtree_elt_base>();
+      tree_built = false;
     }
-    bi.min = &nodes[nodes.add_node(min, EPS)];
-    bi.max = &nodes[nodes.add_node(max, EPS)];
+    // For EPS = 0 the boxes are identified by their id, the search of
+    // existing nodes is useless.
+    scalar_type radius = (EPS > scalar_type(0)) ? EPS : scalar_type(-1);
+    bi.min = &nodes[nodes.add_node(min, radius)];
+    bi.max = &nodes[nodes.add_node(max, radius)];
     bi.id = (id + 1) ? id : boxes.size();
     return boxes.emplace(std::move(bi)).first->id;
   }
-  
+
   rtree::rtree(scalar_type EPS_)
-    : EPS(EPS_), boxes(box_index_topology_compare(EPS_)), tree_built(false)
+    : EPS(EPS_), boxes(box_index_topology_compare(EPS_)), N(0),
+      nb_leaf_nodes(0), build_quality(0), tree_built(false),
+      refit_needed(false)
   {}
 
   void rtree::clear() {
-    root = std::unique_ptr<rtree_elt_base>();
+    leaf_boxes.clear(); box_bounds.clear();
+    tree_nodes.clear(); node_bounds.clear();
+    nb_leaf_nodes = 0;
     boxes.clear();
     nodes.clear();
-    tree_built = false;
+    tree_built = refit_needed = false;
   }
 
-  template <typename Predicate>
-  static void find_matching_boxes_(rtree_elt_base *n, rtree::pbox_set& boxlst,
-                                   const Predicate &p) {
-    if (n->isleaf()) {
-      const rtree_leaf *rl = static_cast<rtree_leaf*>(n);
-      for (rtree::pbox_cont::const_iterator it = rl->lst.begin();
-           it != rl->lst.end(); ++it) {
-        if (p(*(*it)->min, *(*it)->max)) { boxlst.insert(*it); }
+  /* Depth first traversal with an explicit stack, whose size is bounded
+     by the depth of the tree times the number of children of a node. */
+  template <typename Predicate, typename Output>
+  void rtree::visit_matching_boxes_(const Predicate &p, Output out) const {
+    GMM_ASSERT2(tree_built, "Boxtree not initialised.");
+    GMM_ASSERT2(!refit_needed, "Boxes have been moved, refit the tree.");
+    if (tree_nodes.empty()) return;
+    size_type stack[64*CHILDREN_PER_NODE], nst = 0;
+    size_type root = tree_nodes.size() - 1;
+    if (p.accept(&node_bounds[2*N*root], &node_bounds[2*N*root+N]))
+      stack[nst++] = root;
+    while (nst) {
+      size_type i = stack[--nst];
+      const rtree_node &nd = tree_nodes[i];
+      if (i < nb_leaf_nodes) {
+        const scalar_type *b = &box_bounds[2*N*nd.first];
+        for (size_type k = 0; k < nd.nb; ++k, b += 2*N)
+          if (p(b, b+N)) out(leaf_boxes[nd.first+k]);
+      } else {
+        const scalar_type *b = &node_bounds[2*N*nd.first];
+        for (size_type k = 0; k < nd.nb; ++k, b += 2*N)
+          if (p.accept(b, b+N)) stack[nst++] = nd.first + k;
       }
-    } else {
-      const rtree_node *rn = static_cast<rtree_node*>(n);
-      if (p.accept(rn->left->rmin,rn->left->rmax))
-        bgeot::find_matching_boxes_(rn->left.get(), boxlst, p);
-      if (p.accept(rn->right->rmin,rn->right->rmax))
-        bgeot::find_matching_boxes_(rn->right.get(), boxlst, p);
     }
   }
 
-  void rtree::find_intersecting_boxes(const base_node& bmin,
-                                      const base_node& bmax,
-                                      pbox_set& boxlst) const {
-    
+  template <typename Predicate>
+  void rtree::find_matching_boxes_(const Predicate &p,
+                                   pbox_set &boxlst) const {
     boxlst.clear();
-    GMM_ASSERT2(tree_built, "Boxtree not initialised.");
-    if (root)
-      find_matching_boxes_(root.get(),boxlst,intersection_p(bmin,bmax, EPS));
+    visit_matching_boxes_(p, [&boxlst](const box_index *pb)
+                           { boxlst.insert(pb); });
   }
 
-  void rtree::find_containing_boxes(const base_node& bmin,
-                                    const base_node& bmax,
-                                    pbox_set& boxlst) const {
-    boxlst.clear();
-    GMM_ASSERT2( tree_built, "Boxtree not initialised.");
-    if (root)
-      find_matching_boxes_(root.get(), boxlst, contains_p(bmin,bmax, EPS));
+  template <typename Predicate>
+  void rtree::find_matching_boxes_(const Predicate &p,
+                                   pbox_cont &boxlst) const {
+    boxlst.resize(0);
+    visit_matching_boxes_(p, [&boxlst](const box_index *pb)
+                           { boxlst.push_back(pb); });
+    std::sort(boxlst.begin(), boxlst.end(), box_index_id_compare());
   }
 
-  void rtree::find_contained_boxes(const base_node& bmin,
-                                   const base_node& bmax,
-                                   pbox_set& boxlst) const {
-    boxlst.clear();
-    GMM_ASSERT2(tree_built, "Boxtree not initialised.");
-    if (root)
-      find_matching_boxes_(root.get(), boxlst, contained_p(bmin,bmax, EPS));
+  template <typename Predicate>
+  void rtree::find_matching_boxes_(const Predicate &p,
+                                   std::vector<size_type> &idvec) const {
+    idvec.resize(0);
+    visit_matching_boxes_(p, [&idvec](const box_index *pb)
+                           { idvec.push_back(pb->id); });
+    std::sort(idvec.begin(), idvec.end());
   }
 
-  void rtree::find_boxes_at_point(const base_node& P, pbox_set& boxlst) const {
-    boxlst.clear();
-    GMM_ASSERT2(tree_built, "Boxtree not initialised.");
-    if (root)
-      find_matching_boxes_(root.get(), boxlst, has_point_p(P, EPS));
+#define RTREE_QUERIES_(OUTPUT)                                               \
+  void rtree::find_intersecting_boxes(const base_node& bmin,                 \
+                                      const base_node& bmax,                 \
+                                      OUTPUT &boxlst) const                  \
+  { find_matching_boxes_(intersection_p(bmin,bmax, EPS), boxlst); }          \
+                                                                             \
+  void rtree::find_containing_boxes(const base_node& bmin,                   \
+                                    const base_node& bmax,                   \
+                                    OUTPUT &boxlst) const                    \
+  { find_matching_boxes_(contains_p(bmin,bmax, EPS), boxlst); }              \
+                                                                             \
+  void rtree::find_contained_boxes(const base_node& bmin,                    \
+                                   const base_node& bmax,                    \
+                                   OUTPUT &boxlst) const                     \
+  { find_matching_boxes_(contained_p(bmin,bmax, EPS), boxlst); }             \
+                                                                             \
+  void rtree::find_boxes_at_point(const base_node& P,                        \
+                                  OUTPUT &boxlst) const                      \
+  { find_matching_boxes_(has_point_p(P, EPS), boxlst); }                     \
+                                                                             \
+  void rtree::find_line_intersecting_boxes(const base_node& org,             \
+                                           const base_small_vector& dirv,    \
+                                           OUTPUT &boxlst) const             \
+  { find_matching_boxes_(intersect_line(org, dirv), boxlst); }               \
+                                                                             \
+  void rtree::find_line_intersecting_boxes(const base_node& org,             \
+                                           const base_small_vector& dirv,    \
+                                           const base_node& bmin,            \
+                                           const base_node& bmax,            \
+                                           OUTPUT &boxlst) const {           \
+    find_matching_boxes_                                                     \
+      (intersect_line_and_box(org, dirv, bmin, bmax, EPS), boxlst);          \
   }
 
-  void rtree::find_line_intersecting_boxes(const base_node& org,
-                                           const base_small_vector& dirv,
-                                           pbox_set& boxlst) const {
-    boxlst.clear();
-    GMM_ASSERT2(tree_built, "Boxtree not initialised.");
-    if (root)
-      find_matching_boxes_(root.get(),boxlst,intersect_line(org, dirv));
-  }
+  RTREE_QUERIES_(rtree::pbox_set)
+  RTREE_QUERIES_(rtree::pbox_cont)
+  RTREE_QUERIES_(std::vector<size_type>)
 
-  void rtree::find_line_intersecting_boxes(const base_node& org,
-                                           const base_small_vector& dirv,
-                                           const base_node& bmin,
-                                           const base_node& bmax,
-                                           pbox_set& boxlst) const {
-    boxlst.clear();
-    GMM_ASSERT2(tree_built, "Boxtree not initialised.");
-    if (root)
-      find_matching_boxes_(root.get(), boxlst,
-                           intersect_line_and_box(org, dirv, bmin, bmax, EPS));
-  }
+#undef RTREE_QUERIES_
 
   /*
-     try to split at the approximate center of the box. Could be much more
-     sophisticated
+     Sort-Tile-Recursive ordering (S.T. Leutenegger, M.A. Lopez and
+     J. Edgington, 1997) of the items ind[i0..i1) of centers c, for pages
+     of M items : sort along the direction d, cut into slabs of a whole
+     number of pages and sort each slab along the next directions.
   */
-  static bool split_test(const rtree::pbox_cont& b,
-                         const base_node& bmin, const base_node& bmax,
-                         unsigned dir, scalar_type& split_v) {
-    scalar_type v = bmin[dir] + (bmax[dir] - bmin[dir])/2; split_v = v;
-    size_type cnt = 0;
-    for (rtree::pbox_cont::const_iterator it = b.begin(); it!=b.end(); ++it) {
-      if ((*it)->max->at(dir) < v) {
-        if (cnt == 0) split_v = (*it)->max->at(dir);
-        else split_v = std::max((*it)->max->at(dir),split_v);
-        cnt++;
+  static void str_sort(std::vector<size_type> &ind, size_type i0,
+                       size_type i1, const std::vector<scalar_type> &c,
+                       size_type N, size_type d, size_type M) {
+    std::sort(ind.begin()+i0, ind.begin()+i1,
+              [&c, N, d](size_type i, size_type j)
+              { return c[i*N+d] < c[j*N+d]; });
+    size_type n = i1 - i0;
+    if (d+1 >= N || n <= M) return;
+    size_type P = (n + M - 1) / M;
+    size_type S = size_type(std::ceil(std::pow(scalar_type(P), scalar_type(1)
+                                               / scalar_type(N-d)) - 1E-10));
+    size_type slab = ((P + S - 1) / S) * M;
+    for (size_type i = i0; i < i1; i += slab)
+      str_sort(ind, i, std::min(i + slab, i1), c, N, d+1, M);
+  }
+
+  /* Compute the bounds of the node nd at position j of node_bounds from
+     the bounds of its children. bounds and node_bounds may be the same
+     vector. */
+  static void fit_node(const std::vector<scalar_type> &bounds,
+                       const rtree_node &nd, size_type N, size_type j,
+                       std::vector<scalar_type> &node_bounds) {
+    size_type b = 2*N*nd.first;
+    for (size_type l = 0; l < 2*N; ++l) node_bounds[j+l] = bounds[b+l];
+    for (size_type k = 1; k < nd.nb; ++k) {
+      b += 2*N;
+      for (size_type l = 0; l < N; ++l) {
+        node_bounds[j+l] = std::min(node_bounds[j+l], bounds[b+l]);
+        node_bounds[j+N+l] = std::max(node_bounds[j+N+l], bounds[b+N+l]);
       }
     }
-    return (cnt > 0 && cnt < b.size());
   }
 
-  /*
-     there are many flavors of rtree ... this one is more or less a quadtree
-     where splitting does not occurs at predefined positions (hence the
-     split_test function above).
-     Regions of the tree do not overlap (box are splitted).
-  */
-  static std::unique_ptr<rtree_elt_base> build_tree_(rtree::pbox_cont b,
-                                                     const base_node& bmin,
-                                                     const base_node& bmax,
-                                                     unsigned last_dir) {
-    size_type N=bmin.size();
-    scalar_type split_v(0);
-    unsigned split_dir = unsigned((last_dir+1)%N);
-    bool split_ok = false;
-    if (b.size() > rtree_elt_base::RECTS_PER_LEAF) {
-      for (size_type itry=0; itry < N; ++itry) {
-        if (split_test(b, bmin, bmax, split_dir, split_v))
-          { split_ok = true; break; }
-        split_dir = unsigned((split_dir+1)%N);
-      }
+  /* Add the parent nodes of the n items of bounds starting at first,
+     grouped by M. */
+  static void pack_level(const std::vector<scalar_type> &bounds,
+                         size_type first, size_type n, size_type N,
+                         size_type M, std::vector<rtree_node> &tree_nodes,
+                         std::vector<scalar_type> &node_bounds) {
+    for (size_type i = 0; i < n; i += M) {
+      rtree_node nd; nd.first = first + i; nd.nb = std::min(M, n - i);
+      tree_nodes.push_back(nd);
+      size_type j = node_bounds.size();
+      node_bounds.resize(j + 2*N);
+      fit_node(bounds, nd, N, j, node_bounds);
     }
-    if (split_ok) {
-      size_type cnt1=0,cnt2=0;
-      for (rtree::pbox_cont::const_iterator it = b.begin();
-           it != b.end(); ++it) {
-        if ((*it)->min->at(split_dir) < split_v) cnt1++;
-        if ((*it)->max->at(split_dir) > split_v) cnt2++;
+  }
+
+  scalar_type rtree::quality_() const {
+    if (tree_nodes.empty()) return scalar_type(0);
+    scalar_type m(0), mroot(0);
+    size_type root = tree_nodes.size() - 1;
+    for (size_type l = 0; l < N; ++l)
+      mroot += node_bounds[2*N*root+N+l] - node_bounds[2*N*root+l];
+    for (size_type i = 0; i < root; ++i)
+      for (size_type l = 0; l < N; ++l)
+        m += node_bounds[2*N*i+N+l] - node_bounds[2*N*i+l];
+    return (mroot > scalar_type(0)) ? m / mroot : scalar_type(0);
+  }
+
+  void rtree::build_tree() {
+    if (!tree_built) {
+      getfem::local_guard lock = locks_.get_lock();
+      leaf_boxes.resize(0); box_bounds.resize(0);
+      tree_nodes.resize(0); node_bounds.resize(0);
+      nb_leaf_nodes = 0;
+      size_type nb = boxes.size();
+      refit_needed = false;
+      if (nb == 0) { tree_built = true; return; }
+      N = boxes.begin()->min->size();
+
+      // Leaves
+      std::vector<scalar_type> c(nb*N);
+      std::vector<size_type> ind(nb);
+      pbox_cont b(nb);
+      size_type i = 0;
+      for (box_cont::const_iterator it=boxes.begin(); it != boxes.end();
+           ++it, ++i) {
+        GMM_ASSERT1(it->min->size() == N && it->max->size() == N,
+                    "Boxes should have the same dimension");
+        b[i] = &(*it); ind[i] = i;
+        for (size_type k = 0; k < N; ++k)
+          c[i*N+k] = ((*it->min)[k] + (*it->max)[k]) / scalar_type(2);
       }
-      assert(cnt1); assert(cnt2);
-      GMM_ASSERT1(cnt1+cnt2 >= b.size(), "internal error");
-      rtree::pbox_cont v1(cnt1), v2(cnt2);
-      base_node bmin1(bmax), bmax1(bmin);
-      base_node bmin2(bmax), bmax2(bmin);
-      cnt1 = cnt2 = 0;
-      for (rtree::pbox_cont::const_iterator it = b.begin();
-           it != b.end(); ++it) {
-        if ((*it)->min->at(split_dir) < split_v) {
-          v1[cnt1++] = *it;
-          update_box(bmin1,bmax1,*(*it)->min,*(*it)->max);
-        }
-        if ((*it)->max->at(split_dir) > split_v) {
-          v2[cnt2++] = *it;
-          update_box(bmin2,bmax2,*(*it)->min,*(*it)->max);
+      str_sort(ind, 0, nb, c, N, 0, RECTS_PER_LEAF);
+      leaf_boxes.resize(nb); box_bounds.resize(2*N*nb);
+      for (i = 0; i < nb; ++i) {
+        leaf_boxes[i] = b[ind[i]];
+        for (size_type k = 0; k < N; ++k) {
+          box_bounds[2*N*i+k] = (*leaf_boxes[i]->min)[k];
+          box_bounds[2*N*i+N+k] = (*leaf_boxes[i]->max)[k];
         }
       }
-      for (size_type k=0; k < N; ++k) {
-        bmin1[k] = std::max(bmin1[k],bmin[k]);
-        bmax1[k] = std::min(bmax1[k],bmax[k]);
-        bmin2[k] = std::max(bmin2[k],bmin[k]);
-        bmax2[k] = std::min(bmax2[k],bmax[k]);
+      pack_level(box_bounds, 0, nb, N, RECTS_PER_LEAF,
+                 tree_nodes, node_bounds);
+      nb_leaf_nodes = tree_nodes.size();
+
+      // Upper levels. The nodes of a level are ordered in the same way
+      // before being grouped.
+      size_type first = 0, n = nb_leaf_nodes;
+      std::vector<rtree_node> level;
+      std::vector<scalar_type> level_bounds;
+      while (n > 1) {
+        c.resize(n*N); ind.resize(n);
+        for (i = 0; i < n; ++i) {
+          ind[i] = i;
+          for (size_type k = 0; k < N; ++k)
+            c[i*N+k] = (node_bounds[2*N*(first+i)+k]
+                        + node_bounds[2*N*(first+i)+N+k]) / scalar_type(2);
+        }
+        str_sort(ind, 0, n, c, N, 0, CHILDREN_PER_NODE);
+        level.assign(tree_nodes.begin()+first, tree_nodes.end());
+        level_bounds.assign(node_bounds.begin()+2*N*first, node_bounds.end());
+        for (i = 0; i < n; ++i) {
+          tree_nodes[first+i] = level[ind[i]];
+          std::copy(level_bounds.begin() + 2*N*ind[i],
+                    level_bounds.begin() + 2*N*(ind[i]+1),
+                    node_bounds.begin() + 2*N*(first+i));
+        }
+        pack_level(node_bounds, first, n, N, CHILDREN_PER_NODE,
+                   tree_nodes, node_bounds);
+        first += n; n = tree_nodes.size() - first;
       }
-      bmax1[split_dir] = std::min(bmax1[split_dir], split_v);
-      bmin2[split_dir] = std::max(bmin2[split_dir], split_v);
-      assert(cnt1 == v1.size()); assert(cnt2 == v2.size());
-      return std::make_unique<rtree_node>
-        (bmin, bmax,
-         build_tree_(v1, bmin1, bmax1, split_dir),
-         build_tree_(v2, bmin2, bmax2, split_dir));
-    } else {
-      return std::make_unique<rtree_leaf>(bmin, bmax, b);
+      build_quality = quality_();
+      tree_built = true;
     }
+    else if (refit_needed) refit();
   }
 
-  void rtree::build_tree() {
-    if (!tree_built) {
-      if (boxes.size() == 0) { tree_built = true; return; }
+  void rtree::move_box(size_type id, const base_node &min,
+                       const base_node &max) {
+    GMM_ASSERT1(EPS == scalar_type(0), "Boxes can be moved only for EPS = 0");
+    box_index bi; bi.id = id; bi.min = bi.max = nullptr;
+    box_cont::iterator it = boxes.find(bi);
+    GMM_ASSERT1(it != boxes.end(), "Nonexistent box " << id);
+    GMM_ASSERT1(min.size() == it->min->size() && max.size() == min.size(),
+                "Dimensions mismatch");
+    // The nodes are owned by the tree. For EPS = 0 they are not shared
+    // between boxes.
+    gmm::copy(min, const_cast<base_node &>(*(it->min)));
+    gmm::copy(max, const_cast<base_node &>(*(it->max)));
+    nodes.resort();
+    if (tree_built) refit_needed = true;
+  }
+
+  bool rtree::refit(scalar_type max_degradation) {
+    if (!tree_built) { build_tree(); return true; }
+    {
       getfem::local_guard lock = locks_.get_lock();
-      assert(root == 0);
-      pbox_cont b(boxes.size());
-      pbox_cont::iterator b_it = b.begin();
-      base_node bmin(*boxes.begin()->min), bmax(*boxes.begin()->max);
-      for (box_cont::const_iterator it=boxes.begin(); it != boxes.end(); ++it) {
-        update_box(bmin,bmax,*(*it).min,*(*it).max);
-        *b_it++ = &(*it);
+      size_type nb = leaf_boxes.size();
+      for (size_type i = 0; i < nb; ++i) {
+        const scalar_type *pmin = &*(leaf_boxes[i]->min->begin());
+        const scalar_type *pmax = &*(leaf_boxes[i]->max->begin());
+        std::copy(pmin, pmin+N, box_bounds.begin() + 2*N*i);
+        std::copy(pmax, pmax+N, box_bounds.begin() + 2*N*i+N);
       }
-      root = build_tree_(b, bmin, bmax, 0);
-      tree_built = true;
+      // The children of a node are stored before it.
+      for (size_type i = 0; i < tree_nodes.size(); ++i)
+        fit_node((i < nb_leaf_nodes) ? box_bounds : node_bounds,
+                 tree_nodes[i], N, 2*N*i, node_bounds);
+      refit_needed = false;
+      if (quality_() <= max_degradation * build_quality) return false;
+      tree_built = false;
     }
+    build_tree();
+    return true;
   }
 
-  static void dump_tree_(rtree_elt_base *p, int level, size_type& count) {
-    if (!p) return;
-    for (int i=0; i < level; ++i) cout << "  ";
-    cout << "span=" << p->rmin << ".." << p->rmax << " ";
-    if (p->isleaf()) {
-      rtree_leaf *rl = static_cast<rtree_leaf*>(p);
-      cout << "Leaf [" << rl->lst.size() << " elts] = ";
-      for (size_type i=0; i < rl->lst.size(); ++i)
-        cout << " " << rl->lst[i]->id;
+  void rtree::dump_tree_(size_type i, int level, size_type& count) const {
+    for (int l=0; l < level; ++l) cout << "  ";
+    cout << "span=";
+    for (size_type k=0; k < N; ++k) cout << " " << node_bounds[2*N*i+k];
+    cout << " ..";
+    for (size_type k=0; k < N; ++k) cout << " " << node_bounds[2*N*i+N+k];
+    const rtree_node &nd = tree_nodes[i];
+    if (i < nb_leaf_nodes) {
+      cout << " Leaf [" << nd.nb << " elts] = ";
+      for (size_type k=0; k < nd.nb; ++k)
+        cout << " " << leaf_boxes[nd.first+k]->id;
       cout << "\n";
-      count += rl->lst.size();
+      count += nd.nb;
     } else {
-      cout << "Node\n";
-      const rtree_node *rn = static_cast<rtree_node*>(p);
-      if (rn->left) { dump_tree_(rn->left.get(), level+1, count); }
-      if (rn->right) { dump_tree_(rn->right.get(), level+1, count); }
+      cout << " Node\n";
+      for (size_type k=0; k < nd.nb; ++k)
+        dump_tree_(nd.first+k, level+1, count);
     }
   }
 
   void rtree::dump() {
     cout << "tree dump follows\n";
-    if (!root) build_tree();
+    build_tree();
     size_type count = 0;
-    dump_tree_(root.get(), 0, count);
+    if (!tree_nodes.empty()) dump_tree_(tree_nodes.size()-1, 0, count);
     cout << " --- end of tree dump, nb of rectangles: " << boxes.size()
          << ", rectangle ref in tree: " << count << "\n";
   }
@@ -133,8 +133,40 @@ namespace bgeot {
     */
     bool invert(const base_node& n, base_node& n_ref, bool &converged, 
                 scalar_type IN_EPS=1e-12, bool project_into_element=false);
+
+    /**
+       Inversion of the geometric transformation for a batch of nb points.
+
+       The points are stored in structure of arrays form: xreal[k*nb+i] is
+       the k-th coordinate of the i-th point, and the reference coordinates
+       are returned in the same form in xref. For linear transformations,
+       the inversion is done on all the points at once, with contiguous
+       loops on the points. For non-linear ones, the Newton iteration of
+       the scalar version is done point by point with shared workspaces.
+       The torus transformations are inverted as by invert.
+
+       @return the number of points inside the convex.
+
+       @param isin on output, isin[i] is true if the point i is inside
+       the convex.
+
+       @param converged on output, converged[i] is true if the geometric
+       transformation could be inverted at point i.
+    */
+    size_type invert_points(size_type nb, const base_vector &xreal,
+                            base_vector &xref, std::vector<bool> &isin,
+                            std::vector<bool> &converged,
+                            scalar_type IN_EPS=1e-12,
+                            bool project_into_element=false);
   private:
     bool invert_lin(const base_node& n, base_node& n_ref, scalar_type IN_EPS);
+    void invert_lin_points(size_type nb, const base_vector &xreal,
+                           base_vector &xref, std::vector<bool> &isin,
+                           scalar_type IN_EPS);
+    void invert_nonlin_points(size_type nb, const base_vector &xreal,
+                              base_vector &xref, std::vector<bool> &isin,
+                              std::vector<bool> &converged,
+                              scalar_type IN_EPS, bool project_into_element);
     bool invert_nonlin(const base_node& n, base_node& n_ref,
                        scalar_type IN_EPS, bool &converged, bool throw_except,
                        bool project_into_element);
@@ -181,21 +213,24 @@ namespace bgeot {
     mutable kdtree tree;
     scalar_type EPS;
     geotrans_inv_convex gic;
+    size_type points_version; // incremented at each change of the points
   public :
-    void clear(void) { tree.clear(); }
+    void clear(void) { tree.clear(); ++points_version; }
     /// Add the points contained in c to the list of points.
     template<class CONT> void add_points(const CONT &c) {
       tree.reserve(std::distance(c.begin(),c.end()));
       typename CONT::const_iterator it = c.begin(), ite = c.end();
       for (; it != ite; ++it) tree.add_point(*it);
+      ++points_version;
     }
 
     /// Number of points.
     size_type nb_points(void) const { return tree.nb_points(); }
     /// Add point p to the list of points.
-    size_type add_point(base_node p) { return tree.add_point(p); }
+    size_type add_point(base_node p)
+    { ++points_version; return tree.add_point(p); }
     void add_point_with_id(base_node p,size_type id)
-    { tree.add_point_with_id(p,id); }
+    { ++points_version; tree.add_point_with_id(p,id); }
       
     /// Find all the points present in the box between min and max.
     size_type points_in_box(kdtree_tab_type &ipts,
@@ -233,7 +268,7 @@ namespace bgeot {
                                CONT1 &pftab, CONT2 &itab,
                                bool bruteforce=false);
       
-    geotrans_inv(scalar_type EPS_ = 10E-12) : EPS(EPS_) {}
+    geotrans_inv(scalar_type EPS_ = 10E-12) : EPS(EPS_), points_version(0) {}
   };
 
 
@@ -254,12 +289,18 @@ namespace bgeot {
     else boxpts = tree.points();
     /* and invert the geotrans, and check if the obtained point is 
        inside the reference convex */
-    for (size_type l = 0; l < boxpts.size(); ++l) {
-      // base_node pt_ref;
-      if (gic.invert(boxpts[l].n, pftab[nbpt], EPS)) {
+    size_type nb = boxpts.size(), N = min.size(), P = pgt->dim();
+    base_vector xreal(N*nb), xref;
+    std::vector<bool> isin, converged;
+    for (size_type l = 0; l < nb; ++l)
+      for (size_type k = 0; k < N; ++k) xreal[k*nb+l] = boxpts[l].n[k];
+    gic.invert_points(nb, xreal, xref, isin, converged, EPS);
+    for (size_type l = 0; l < nb; ++l)
+      if (isin[l]) {
+        pftab[nbpt].resize(P);
+        for (size_type k = 0; k < P; ++k) pftab[nbpt][k] = xref[k*nb+l];
         itab[nbpt++] = boxpts[l].i;
       }
-    }
     return nbpt;
   }
 
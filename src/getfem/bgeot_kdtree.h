@@ -73,6 +73,9 @@ namespace bgeot {
   quickly for the list of points lying in a given box. Note that
   this is not a dynamic structure: once you start to call
   kdtree::points_in_box, you should not use anymore kdtree::add_point.
+  The points can however be moved (kdtree::move_point), the tree being
+  then refitted instead of rebuilt (kdtree::refit, to be called before
+  the next query).
 
   Here is an example of use (which tries to find the mapping between
   the dof of the mesh_fem and the node numbers of its mesh):
@@ -103,8 +106,10 @@ namespace bgeot {
     dim_type N; /* dimension of points */
     std::unique_ptr<kdtree_elt_base> tree;
     kdtree_tab_type pts;
+    std::vector<scalar_type> refit_ws;
+    bool refit_needed;
   public:
-    kdtree() : N(0) {}
+    kdtree() : N(0), refit_needed(false) {}
 
     kdtree(const kdtree&) = delete;
     kdtree &operator = (const kdtree&) = delete;
@@ -127,6 +132,22 @@ namespace bgeot {
     }
     size_type nb_points() const { return pts.size(); }
     const kdtree_tab_type &points() const { return pts; }
+    /** Move the k-th point of points() (whose index is points()[k].i) to
+        the position n. refit() has to be called before the next query. */
+    void move_point(size_type k, const base_node &n) {
+      GMM_ASSERT2(N == n.size(), "invalid dimension");
+      gmm::copy(n, pts[k].n);
+      if (tree) refit_needed = true;
+    }
+    /** Update the tree after some points have been moved, keeping its
+        topology. The quality of the tree is measured by the mean overlap
+        of the children of its nodes in their splitting direction, relative
+        to the extent of the node. The tree is rebuilt when it exceeds
+        max_overlap. Return true if the tree has been rebuilt. */
+    bool refit(scalar_type max_overlap = scalar_type(0.1));
+    /** Build the tree if it is not built yet. The queries build it
+        otherwise, so it has to be called before concurrent queries. */
+    void build_tree();
     /* fills ipts with the indexes of points in the box
        [min,max] */
     void points_in_box(kdtree_tab_type &ipts,
@@ -268,6 +268,18 @@ namespace bgeot {
   void APIDECL cuthill_mckee_on_convexes(const bgeot::mesh_structure &ms,
                                          std::vector<size_type> &cmk);
 
+  /** Return the reverse Cuthill-McKee ordering of the points of a mesh
+      structure (the points used by no convex are omitted), two points
+      being connected if they share a convex. */
+  void APIDECL reverse_cuthill_mckee_on_points(const mesh_structure &ms,
+                                               std::vector<size_type> &order);
+
+  /** Return a nested dissection ordering of the points of a mesh
+      structure (the points used by no convex are omitted). The separators
+      are built from level structures of the connectivity graph. */
+  void APIDECL nested_dissection_on_points(const mesh_structure &ms,
+                                           std::vector<size_type> &order);
+
   template<class ITER>
     bool mesh_structure::is_convex_having_points(size_type ic,
                                               short_type nb, ITER pit) const {
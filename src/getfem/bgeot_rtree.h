@@ -77,20 +77,25 @@ namespace bgeot {
     }
   };
 
-  struct rtree_elt_base {
-    enum { RECTS_PER_LEAF=8 };
-    bool isleaf_;
-    bool isleaf() const { return isleaf_; }
-    base_node rmin, rmax;
-    rtree_elt_base(bool leaf, const base_node& rmin_, const base_node& rmax_)
-      : isleaf_(leaf), rmin(rmin_), rmax(rmax_) {}
-    virtual ~rtree_elt_base() {}
+  /* Node of the packed tree : range of its children in the next level
+     (boxes for the nodes of the lowest level). */
+  struct rtree_node {
+    size_type first, nb;
   };
 
   /** Balanced tree of n-dimensional rectangles.
    *
    * This is not a dynamic structure. Once a query has been made on the
-   * tree, new boxes should not be added.
+   * tree, new boxes should not be added. For EPS = 0, the existing boxes
+   * can however be moved (move_box) and the tree be refitted (refit),
+   * which keeps its topology and is much cheaper than a rebuild for
+   * boxes following a moving geometry.
+   *
+   * The tree is bulk loaded with the Sort-Tile-Recursive algorithm and
+   * stored in flat arrays, level by level, the children of a node being
+   * contiguous. The queries do not allocate memory when the output is a
+   * std::vector whose capacity is sufficient (pbox_cont or vector of
+   * indices). The results are sorted by box id.
    *
    * CAUTION : For EPS > 0, nearly identically boxes are eliminated
    *           For EPS = 0 all boxes are stored.
@@ -127,58 +132,77 @@ namespace bgeot {
                                       pbox_set& boxlst) const;
 
     void find_intersecting_boxes(const base_node& bmin, const base_node& bmax,
-                                 std::vector<size_type>& idvec) {
-      pbox_set bs;
-      find_intersecting_boxes(bmin, bmax, bs);
-      pbox_set_to_idvec(bs, idvec);
-    }
+                                 pbox_cont& boxlst) const;
     void find_containing_boxes(const base_node& bmin, const base_node& bmax,
-                               std::vector<size_type>& idvec) {
-      pbox_set bs;
-      find_containing_boxes(bmin, bmax, bs);
-      pbox_set_to_idvec(bs, idvec);
-    }
+                               pbox_cont& boxlst) const;
+    void find_contained_boxes(const base_node& bmin, const base_node& bmax,
+                              pbox_cont& boxlst) const;
+    void find_boxes_at_point(const base_node& P, pbox_cont& boxlst) const;
+    void find_line_intersecting_boxes(const base_node& org,
+                                      const base_small_vector& dirv,
+                                      pbox_cont& boxlst) const;
+    void find_line_intersecting_boxes(const base_node& org,
+                                      const base_small_vector& dirv,
+                                      const base_node& bmin,
+                                      const base_node& bmax,
+                                      pbox_cont& boxlst) const;
+
+    void find_intersecting_boxes(const base_node& bmin, const base_node& bmax,
+                                 std::vector<size_type>& idvec) const;
+    void find_containing_boxes(const base_node& bmin, const base_node& bmax,
+                               std::vector<size_type>& idvec) const;
     void find_contained_boxes(const base_node& bmin,
                               const base_node& bmax,
-                              std::vector<size_type>& idvec) {
-      pbox_set bs;
-      find_contained_boxes(bmin, bmax, bs);
-      pbox_set_to_idvec(bs, idvec);
-    }
+                              std::vector<size_type>& idvec) const;
     void find_boxes_at_point(const base_node& P,
-                             std::vector<size_type>& idvec) const
-    { pbox_set bs; find_boxes_at_point(P, bs);  pbox_set_to_idvec(bs, idvec); }
+                             std::vector<size_type>& idvec) const;
     void find_line_intersecting_boxes(const base_node& org,
                                       const base_small_vector& dirv,
-                                      std::vector<size_type>& idvec) {
-      pbox_set bs;
-      find_line_intersecting_boxes(org, dirv, bs);
-      pbox_set_to_idvec(bs, idvec);
-    }
+                                      std::vector<size_type>& idvec) const;
     void find_line_intersecting_boxes(const base_node& org,
                                       const base_small_vector& dirv,
                                       const base_node& bmin,
                                       const base_node& bmax,
-                                      std::vector<size_type>& idvec) {
-      pbox_set bs;
-      find_line_intersecting_boxes(org, dirv, bmin, bmax, bs);
-      pbox_set_to_idvec(bs, idvec);
-    }
+                                      std::vector<size_type>& idvec) const;
 
     void dump();
     void build_tree();
+
+    /** Change the bounds of the box of index id (only for EPS = 0). The
+        tree has to be refitted before the next query. */
+    void move_box(size_type id, const base_node &min, const base_node &max);
+    /** Update the bounds of the nodes of the tree after some boxes have
+        been moved, keeping its topology. The quality of the tree is
+        measured by the sum of the extents of its nodes divided by the
+        extent of the root. The tree is rebuilt if this ratio exceeds
+        max_degradation times its value at the last build. Return true if
+        the tree has been rebuilt. */
+    bool refit(scalar_type max_degradation = scalar_type(1.5));
   private:
-    void pbox_set_to_idvec(pbox_set bs, std::vector<size_type>& idvec) const {
-      idvec.reserve(bs.size()); idvec.resize(0);
-      for (pbox_set::const_iterator it=bs.begin(); it != bs.end(); ++it)
-        idvec.push_back((*it)->id);
-    }
+    enum { RECTS_PER_LEAF=8, CHILDREN_PER_NODE=8 };
+    template <typename Predicate, typename Output>
+    void visit_matching_boxes_(const Predicate &p, Output out) const;
+    template <typename Predicate>
+    void find_matching_boxes_(const Predicate &p, pbox_set &boxlst) const;
+    template <typename Predicate>
+    void find_matching_boxes_(const Predicate &p, pbox_cont &boxlst) const;
+    template <typename Predicate>
+    void find_matching_boxes_(const Predicate &p,
+                              std::vector<size_type> &idvec) const;
+    void dump_tree_(size_type i, int level, size_type &count) const;
+    scalar_type quality_() const;
 
     const scalar_type EPS;
     node_tab nodes;
     box_cont boxes;
-    std::unique_ptr<rtree_elt_base> root;
-    bool tree_built;
+    size_type N;                        // dimension of the boxes
+    std::vector<const box_index *> leaf_boxes; // boxes in the order of leaves
+    std::vector<scalar_type> box_bounds;  // min and max of leaf_boxes
+    std::vector<rtree_node> tree_nodes;   // nodes by level, root at the end
+    std::vector<scalar_type> node_bounds; // min and max of tree_nodes
+    size_type nb_leaf_nodes;              // nodes whose children are boxes
+    scalar_type build_quality;            // quality_() at the last build
+    bool tree_built, refit_needed;
     getfem::lock_factory locks_;
   };
 
@@ -151,6 +151,19 @@ namespace detail {
     detail::equal_resize_spec(a, b, AlgoC{}, AlgoT{});
   }
 
+  /**Set the values of a vector or a matrix to zero. The sparsity pattern of
+     a column matrix of rsvectors is kept (explicit zeros).*/
+  template<class T>
+  void clear_values_keeping_pattern(T &a){
+    gmm::clear(a);
+  }
+
+  template<class T>
+  void clear_values_keeping_pattern(gmm::col_matrix<gmm::rsvector<T>> &a){
+    for (size_type j = 0; j < gmm::mat_ncols(a); ++j)
+      gmm::clear_values(a[j]);
+  }
+
   /**Takes a matrix or vector, or vector of matrices or vectors and
   creates an empty copy on each thread. When the
   thread computations are done (in the destructor), accumulates
@@ -159,12 +172,14 @@ namespace detail {
   class accumulated_distro
   {
     T& original;
-    omp_distribute<T> distributed;
+    std::unique_ptr<omp_distribute<T>> own_distributed;
+    omp_distribute<T> &distributed;
 
   public:
 
     explicit accumulated_distro(T& l)
-      : original{l}{
+      : original{l}, own_distributed{new omp_distribute<T>()},
+        distributed{*own_distributed}{
       if (distributed.num_threads() == 1) return;
       //intentionally skipping thread 0, as accumulated_distro will
       //use original for it
@@ -173,6 +188,20 @@ namespace detail {
       }
     }
 
+    /**Same as above, except that the thread copies are taken from storage,
+    kept by the caller from one use to the next, so that the copies keep
+    their addresses (and their sparsity pattern if keep_pattern is true).
+    T has to be a single vector or matrix.*/
+    accumulated_distro(T& l, omp_distribute<T> &storage, bool keep_pattern)
+      : original{l}, distributed{storage}{
+      if (distributed.num_threads() == 1) return;
+      for(size_type t = 1; t != distributed.num_threads(); ++t){
+        if (keep_pattern) clear_values_keeping_pattern(distributed(t));
+        else gmm::clear(distributed(t));
+        equal_resize(distributed(t), original);
+      }
+    }
+
     T& get(){
       if (distributed.num_threads() == 1 ||
           distributed.this_thread() == 0) return original;
@@ -489,7 +489,7 @@ namespace getfem {
         : ind_boundary(ib), ind_element(ie), ind_face(iff), mean_normal(n) {}
     };
 
-    bgeot::rtree element_boxes;                  // influence boxes
+    bgeot::rtree element_boxes;  // influence boxes, refitted between calls
     std::vector<influence_box> element_boxes_info;
 
     //
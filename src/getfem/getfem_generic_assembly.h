@@ -255,11 +255,69 @@ namespace getfem {
   void ga_undefine_function(const std::string &name);
   bool ga_function_exists(const std::string &name);
 
+  //=========================================================================
+  // Execution statistics of the compiled assembly instructions.
+  //=========================================================================
+
+  /** Statistics collected by a ga_workspace whose profiling is enabled
+      (see ga_workspace::set_profiling). The entries are identified by the
+      type of the instruction, the (sub-)expression it has been compiled
+      from and the stage of execution: "begin" (first integration point
+      after a change of integration method), "element" (once per element)
+      or "point" (each integration point). */
+  class ga_profiling_data {
+  public:
+    struct entry {
+      std::string instruction, expression, stage;
+      size_type nb_calls;
+      scalar_type time; // Cumulative execution time in seconds
+    };
+
+  private:
+    typedef std::tuple<std::string, std::string, std::string> key_type;
+    std::map<key_type, std::pair<size_type, scalar_type>> stats;
+
+  public:
+    void add(const entry &e);
+    void add(const ga_profiling_data &pd);
+    void clear() { stats.clear(); }
+    bool empty() const { return stats.empty(); }
+    /** Entries sorted by decreasing cumulative time. */
+    void report(std::vector<entry> &entries) const;
+    void print(std::ostream &os) const;
+  };
+
+  /** Counters of the successive calls to ga_workspace::assembly(), showing
+      the reuse of the compiled instructions between them. */
+  struct ga_assembly_statistics {
+    size_type nb_assemblies = 0;   // Calls to assembly()
+    size_type nb_compilations = 0; // Instruction sets compiled
+    size_type nb_parallel_assemblies = 0; // Colored or atomic ones
+    // Element matrices added at the positions stored at a previous
+    // assembly, or whose positions had to be computed (fixed sparsity
+    // pattern, see ga_workspace::set_fixed_sparsity_pattern)
+    size_type nb_pattern_hits = 0, nb_pattern_misses = 0;
+    // Elements executed by batches (see
+    // ga_workspace::set_element_batch_size)
+    size_type nb_batched_elements = 0;
+    void add(const ga_assembly_statistics &s) {
+      nb_assemblies += s.nb_assemblies;
+      nb_compilations += s.nb_compilations;
+      nb_parallel_assemblies += s.nb_parallel_assemblies;
+      nb_pattern_hits += s.nb_pattern_hits;
+      nb_pattern_misses += s.nb_pattern_misses;
+      nb_batched_elements += s.nb_batched_elements;
+    }
+    void clear() { *this = ga_assembly_statistics(); }
+  };
+
   //=========================================================================
   // Structure dealing with user defined environment : constant, variables,
   // functions, operators.
   //=========================================================================
 
+  struct ga_instruction_set;
+
   class ga_workspace {
 
     const model *md;
@@ -375,6 +433,49 @@ namespace getfem {
     base_vector unreduced_V, cached_V;
     base_tensor assemb_t;
     bool include_empty_int_pts = false;
+    bool colored_assembly = false;
+    bool fixed_pattern = false;
+    bool atomic_assembly = false;
+    bool profile_instructions = false;
+    bool size_specialized = true;
+    size_type batch_size = 0;
+    ga_profiling_data profiling_stats;
+    ga_assembly_statistics assembly_stats;
+
+    // Instruction set compiled by assembly() for a given order and
+    // condensation option, kept for the next calls. It is valid as long as
+    // the expressions, the variables, the assembly targets, the values of
+    // the fixed size data (evaluated at compile time) and the meshes,
+    // mesh_ims and mesh_fems involved are unchanged. The cache is not
+    // copied together with the workspace. The temporary intervals of the
+    // unreduced variables are referenced by the cached instructions, so they
+    // are only cleared together with the cache. Additional instruction sets
+    // are compiled for the other threads in case of colored assembly.
+    struct compiled_assembly : public context_dependencies {
+      std::shared_ptr<ga_instruction_set> gis;
+      std::vector<std::shared_ptr<ga_instruction_set>> thread_gis;
+      std::vector<const void *> targets;
+      std::vector<std::string> fixed_size_names;
+      std::vector<model_real_plain_vector> fixed_size_values;
+
+      void update_from_context() const {}
+      void clear();
+      compiled_assembly() {}
+      compiled_assembly(const compiled_assembly &) : context_dependencies() {}
+      compiled_assembly &operator =(const compiled_assembly &)
+      { clear(); return *this; }
+    };
+    std::map<std::pair<size_type, bool>, compiled_assembly> compiled_assemblies;
+
+    void assembly_targets(std::vector<const void *> &targets,
+                          size_type order, bool condensation) const;
+    bool is_compiled_assembly_valid(const compiled_assembly &ca,
+                                    size_type order, bool condensation) const;
+    ga_instruction_set &compiled_instructions(size_type order,
+                                              bool condensation);
+    bool colored_instructions(size_type order, bool condensation,
+                              std::vector<ga_instruction_set *> &gisl,
+                              std::vector<const mesh_fem *> &mfs);
 
   public:
     // setter functions
@@ -544,7 +645,7 @@ namespace getfem {
 
     void add_elementary_transformation(const std::string &name,
                                        pelementary_transformation ptrans)
-    { elem_transformations[name] = ptrans; }
+    { elem_transformations[name] = ptrans; clear_compiled_assemblies(); }
 
     bool elementary_transformation_exists(const std::string &name) const;
 
@@ -569,6 +670,107 @@ namespace getfem {
     void set_include_empty_int_points(bool include);
     bool include_empty_int_points() const;
 
+    /** Colored parallel assembly: when the assembly is called outside a
+        parallel section with more than one thread, the elements are
+        colored such that the elements of a same color share no degree of
+        freedom and each color is assembled concurrently, the threads
+        writing directly in the assembled matrix or vector (no thread local
+        copies to be summed up). It applies only to assembly terms whose
+        test functions are fem variables or im_data without interpolate
+        transformations, nor secondary domains and without condensation.
+        The standard sequential assembly is used otherwise. */
+    void set_colored_parallel_assembly(bool colored)
+    { colored_assembly = colored; }
+    bool colored_parallel_assembly() const { return colored_assembly; }
+
+    /** Fixed sparsity pattern: the sparsity pattern of the assembled matrix
+        is kept between two calls to assembly(2) (only its values are set
+        to zero when the matrix is owned by the workspace) and the whole
+        element matrices are inserted, whatever their values, so that the
+        first assembly computes the complete pattern. Each matrix assembly
+        instruction stores the positions of the entries of the element
+        matrices in the columns of the assembled matrix, the next
+        assemblies only add the element values at these positions, without
+        any search nor reallocation. The positions stored while the
+        pattern is being built may be shifted by later insertions, they
+        are computed again by the next assembly, so that the positions are
+        reused from the third assembly (see assembly_statistics()). This
+        costs some memory (about the size of the elementary matrices of the
+        whole mesh) and is useful for repeated assemblies (Newton
+        iterations, time steps). Only available for the default
+        model_real_sparse_matrix format. */
+    void set_fixed_sparsity_pattern(bool fixed)
+    { if (fixed != fixed_pattern) clear_compiled_assemblies();
+      fixed_pattern = fixed; }
+    bool fixed_sparsity_pattern() const { return fixed_pattern; }
+
+    /** Atomic parallel assembly: as for the colored parallel assembly, the
+        threads write directly in the assembled vector and matrix but the
+        elements are not colored, the contributions being added with atomic
+        operations. The matrix assembly uses the fixed sparsity pattern
+        mechanism (see set_fixed_sparsity_pattern): the assembly is
+        sequential if the assembled matrix is empty, in order to compute
+        its pattern, and the element matrices having entries out of the
+        pattern of the assembled matrix are added sequentially after the
+        parallel execution. It has priority over
+        the colored parallel assembly and has the same restrictions. */
+    void set_atomic_parallel_assembly(bool atomic)
+    { if (atomic != atomic_assembly) clear_compiled_assemblies();
+      atomic_assembly = atomic; }
+    bool atomic_parallel_assembly() const { return atomic_assembly; }
+
+    /** Profiling of the assembly: when enabled, the instructions compiled
+        by assembly() record their number of calls and their cumulative
+        execution time. The statistics of the successive assemblies are
+        accumulated in profiling_data() until it is cleared. It slows down
+        the assembly and is intended for the optimization of expressions. */
+    void set_profiling(bool profiling)
+    { if (profiling != profile_instructions) clear_compiled_assemblies();
+      profile_instructions = profiling; }
+    bool profiling() const { return profile_instructions; }
+
+    /** Use of instructions specialized for the tensor sizes known at the
+        compilation of the expressions (additions, multiplications by a
+        scalar and matrix products of small tensors without test
+        functions), whose loops are unrolled. Enabled by default, it can be
+        disabled to compare them with the generic instructions. */
+    void set_size_specialized_instructions(bool specialized)
+    { if (specialized != size_specialized) clear_compiled_assemblies();
+      size_specialized = specialized; }
+    bool size_specialized_instructions() const { return size_specialized; }
+
+    /** Element-batched execution of the assembly: the consecutive elements
+        of a region having the same geometric transformation, integration
+        method and finite element methods are executed by batches of nb
+        elements. The last instructions of each expression on an
+        integration point (products by a scalar, contractions, tensor
+        products, additions, copies of the test functions and assembly
+        instructions) are executed on the whole batch with a
+        structure-of-arrays storage of their operands, in loops on the
+        elements of the batch, instead of once per element. The other
+        instructions are executed element by element as usual. A value of
+        nb less than 2 disables it (default). It is not used by the colored
+        and atomic parallel assemblies, with interpolate transformations
+        nor with the profiling. */
+    void set_element_batch_size(size_type nb) { batch_size = nb; }
+    size_type element_batch_size() const { return batch_size; }
+    const ga_profiling_data &profiling_data() const { return profiling_stats; }
+    ga_profiling_data &profiling_data() { return profiling_stats; }
+
+    /** Number of calls to assembly() and of compilations of instruction
+        sets, accumulated until cleared. */
+    const ga_assembly_statistics &assembly_statistics() const
+    { return assembly_stats; }
+    ga_assembly_statistics &assembly_statistics() { return assembly_stats; }
+
+    /** Drop the instruction sets kept by assembly(). It is done
+        automatically when expressions or variables are added or when one
+        of the involved meshes, mesh_ims or mesh_fems is modified. */
+    void clear_compiled_assemblies() {
+      compiled_assemblies.clear();
+      clear_temporary_variable_intervals();
+    }
+
     size_type nb_primary_dof() const { return nb_prim_dof; }
     size_type nb_internal_dof() const { return nb_intern_dof; }
     size_type first_internal_dof() const { return first_intern_dof; }
@@ -642,8 +844,6 @@ namespace getfem {
   // Intermediate structure for user function manipulation
   //=========================================================================
 
-  struct ga_instruction_set;
-
   class ga_function {
     mutable ga_workspace local_workspace;
     std::string expr;
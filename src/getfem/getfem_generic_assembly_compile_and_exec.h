@@ -70,6 +70,58 @@ namespace getfem {
 
   typedef std::shared_ptr<ga_instruction> pga_instruction;
 
+  // Operand of an instruction executed on a batch of elements: a tensor or
+  // a scalar (possibly a component of a tensor).
+  struct ga_batch_operand {
+    base_tensor *t = nullptr;
+    scalar_type *s = nullptr;
+    size_type size() const { return t ? t->size() : (s ? 1 : 0); }
+    scalar_type *data() const { return t ? t->data() : s; }
+    ga_batch_operand() {}
+    ga_batch_operand(const base_tensor &t_)
+      : t(const_cast<base_tensor *>(&t_)) {}
+    ga_batch_operand(const scalar_type &s_)
+      : s(const_cast<scalar_type *>(&s_)) {}
+  };
+
+  // Instructions which can be part of an element-batched execution (see
+  // ga_workspace::set_element_batch_size). The instructions computing a
+  // tensor or a scalar (result) from their operands only are executed on a
+  // whole batch of nb elements by exec_batch, with a structure-of-arrays
+  // storage: the component i of an operand for the element b of the batch
+  // is stored at i*nb+b. The other ones (assembly instructions) have no
+  // result and are executed element by element by exec, with the values of
+  // their operands restored. batch_operands returns false if the
+  // instruction cannot be executed in these conditions. The assembly
+  // instructions whose operands are a tensor and its weight and which add
+  // the weighted tensors of the integration points of an element may be
+  // executed once per element on the sum of the weighted tensors, with a
+  // single integration point of weight one (batch_sum_on_points).
+  struct ga_batched_instruction {
+    virtual bool batch_operands(std::vector<ga_batch_operand> &operands,
+                                ga_batch_operand &result) const = 0;
+    virtual bool batch_sum_on_points() const { return false; }
+    virtual void exec_batch(scalar_type * /* result */,
+                            const std::vector<const scalar_type *> &
+                            /* operands */, size_type /* nb */) const {}
+    virtual ~ga_batched_instruction() {}
+  };
+
+  // Splitting of the instructions executed on each integration point for
+  // the element-batched execution: the batched instructions, at the indices
+  // positions, are executed after the other ones, the ones with a result
+  // being executed on the whole batch (see ga_batched_instruction). No
+  // instruction is batched if positions is empty.
+  struct ga_batch_plan {
+    bool analyzed = false;
+    std::vector<size_type> positions;
+    std::vector<bool> is_batched; // For each instruction
+    std::vector<ga_batched_instruction *> instructions;
+    std::vector<std::vector<ga_batch_operand>> operands;
+    std::vector<ga_batch_operand> results;
+    std::vector<const mesh_fem *> mfs; // Fems defining the element types
+  };
+
   struct gauss_pt_corresp { // For neighbor interpolation transformation
     bgeot::pgeometric_trans pgt1, pgt2;
     papprox_integration pai;
@@ -79,6 +131,24 @@ namespace getfem {
   bool operator <(const gauss_pt_corresp &gpc1,
                   const gauss_pt_corresp &gpc2);
 
+  // List of elements (or faces of elements, with the face number, or
+  // short_type(-1) for the whole element) on which the instructions
+  // are executed.
+  typedef std::vector<std::pair<size_type, short_type>> ga_element_list;
+
+  // Elements of a region sorted by colors, two elements of a same color
+  // sharing no basic dof of the mesh_fems mfs (see ga_exec_colored).
+  struct ga_colored_elements {
+    ga_element_list source;        // Element list which has been colored
+    std::vector<const mesh_fem *> mfs;
+    ga_element_list elts;          // Elements sorted by colors
+    std::vector<size_type> groups; // Index in elts of the first entry of
+                                   // each convex (the faces of a convex
+                                   // are kept together), plus the end
+    std::vector<size_type> colors; // Index in groups of the first convex of
+                                   // each color, plus the end
+  };
+
   struct ga_instruction_set {
 
     papprox_integration pai;       // Current approximation method
@@ -95,7 +165,41 @@ namespace getfem {
     std::map<gauss_pt_corresp, bgeot::pstored_point_tab> neighbor_corresp;
     std::set<std::pair<std::string,std::string>> unreduced_terms;
 
+    // Atomic additions into the assembled vectors and matrices, set during
+    // an atomic parallel execution only (see ga_exec_colored). The element
+    // matrices having entries out of the current sparsity pattern of the
+    // assembled matrix cannot be added concurrently. They are stored and
+    // added after the parallel execution.
+    bool atomic_scatter = false;
+    struct deferred_elem_matrix {
+      model_real_sparse_matrix *K;
+      std::vector<size_type> dofs1, dofs2;
+      base_vector elem;
+    };
+    std::vector<deferred_elem_matrix> deferred_matrices;
+
+    // Number of element matrices added at the positions stored by the
+    // matrix assembly instructions (fixed sparsity pattern) and number of
+    // those for which the positions had to be computed again.
+    size_type nb_pattern_hits = 0, nb_pattern_misses = 0;
+    // Number of elements executed by batches (see ga_element_batch).
+    size_type nb_batched_elements = 0;
+
+    // Collection of the execution statistics of the instructions (see
+    // ga_workspace::set_profiling), to be set before the compilation.
+    bool profiling = false;
+    // Use of the size specialized instructions (see
+    // ga_workspace::set_size_specialized_instructions), to be set before
+    // the compilation.
+    bool size_specialized = true;
+    struct instruction_profile {
+      size_type nb_calls = 0;
+      scalar_type time = 0;   // Cumulative execution time in seconds
+    };
+
     scalar_type ONE=1;
+    // Products of scalar factors computed by the fused instructions
+    std::list<scalar_type> fused_factors;
 
     using region_mim_tuple = std::tuple<const mesh_im *, const mesh_region *, psecondary_domain>;
     struct region_mim : public region_mim_tuple {
@@ -195,6 +299,17 @@ namespace getfem {
         instructions;        // Instructions executed on each
                              // integration/interpolation point
       std::map<scalar_type, std::list<pga_tree_node> > node_list;
+      ga_colored_elements colored_elements; // For ga_exec_colored only
+      ga_batch_plan batch_plan; // For the element-batched execution only
+      // Tensors of the nodes reused for equivalent nodes, which may be read
+      // by the instructions of the following expressions.
+      std::set<const base_tensor *> reused_tensors;
+
+      // Execution statistics of the three instruction lists and the
+      // (sub-)expression each instruction comes from, if gis.profiling.
+      std::vector<instruction_profile>
+        begin_profiles, elt_profiles, profiles;
+      std::vector<std::string> begin_origins, elt_origins, origins;
 
       region_mim_instructions(): m(0), im(0) {}
     };
@@ -213,9 +328,30 @@ namespace getfem {
 
   
   void ga_exec(ga_instruction_set &gis, ga_workspace &workspace);
+  // Parallel execution of a set of instruction sets compiled from the same
+  // workspace, one per thread. The elements of each region are colored such
+  // that two elements of the same color share no basic dof of the mesh_fems
+  // mfs. The elements of a color are then executed concurrently, the threads
+  // writing directly in the assembled matrix and vector. Only valid for
+  // assembly terms whose test functions are defined on mfs or on im_data,
+  // without interpolate transformations nor secondary domains.
+  // If atomic is true, no coloring is done (mfs is ignored) and the threads
+  // add their contributions with atomic operations (the matrix assembly
+  // instructions have to be compiled with the fixed sparsity pattern).
+  void ga_exec_colored(const std::vector<ga_instruction_set *> &gisl,
+                       ga_workspace &workspace,
+                       const std::vector<const mesh_fem *> &mfs,
+                       bool atomic = false);
   void ga_function_exec(ga_instruction_set &gis);
   void ga_compile(ga_workspace &workspace, ga_instruction_set &gis,
                   size_type order, bool condensation=false);
+  // Update the extension of the variables defined on reduced fems before
+  // a new execution of an already compiled instruction set.
+  void ga_update_extended_vars(const ga_workspace &workspace,
+                               ga_instruction_set &gis);
+  // Add the execution statistics of a profiled instruction set to pd and
+  // reset them.
+  void ga_collect_profiling(ga_instruction_set &gis, ga_profiling_data &pd);
   void ga_compile_function(ga_workspace &workspace,
                            ga_instruction_set &gis, bool scalar);
   void ga_compile_interpolation(ga_workspace &workspace,
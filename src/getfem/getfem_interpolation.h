@@ -53,21 +53,38 @@ namespace getfem {
   /*                                                                       */
   /* ********************************************************************* */
 
-  class mesh_trans_inv : public bgeot::geotrans_inv {
+  /** Distribution of a set of points on the convexes of a mesh.
+
+      The search is done in parallel on the convexes and its result is
+      stored in a compressed (CSR-like) form : the points of the convex cv
+      are the entries cvx_first[cv] to cvx_first[cv+1]-1 of cvx_pts_tab,
+      sorted by increasing index. The distribution is kept as long as the
+      mesh, the points and the parameters of distribute() are unchanged, so
+      that a mesh_trans_inv can be reused for repeated transfers.
+  */
+  class mesh_trans_inv : public bgeot::geotrans_inv,
+                         public context_dependencies {
 
   protected :
-    typedef std::set<size_type>::const_iterator set_iterator;
     typedef std::map<size_type,size_type>::const_iterator map_iterator;
 
     const mesh &msh;
-    std::vector<std::set<size_type> > pts_cvx;
+    std::vector<size_type> cvx_first, cvx_pts_tab;
     std::vector<base_node> ref_coords;
     std::map<size_type,size_type> ids;
 
+    // Parameters of the last distribution.
+    mutable bool distributed;
+    int distributed_extrapolation;
+    size_type distributed_points_version;
+    dal::bit_vector distributed_cvs;
+
   public :
 
+    void update_from_context() const { distributed = false; }
+
     size_type nb_points_on_convex(size_type i) const
-    { return pts_cvx[i].size(); }
+    { return (i+1 < cvx_first.size()) ? cvx_first[i+1] - cvx_first[i] : 0; }
     void points_on_convex(size_type i, std::vector<size_type> &itab) const;
     size_type point_on_convex(size_type cv, size_type i) const;
     const std::vector<base_node> &reference_coords(void) const { return ref_coords; }
@@ -90,7 +107,9 @@ namespace getfem {
     void distribute(int extrapolation = 0,
                     mesh_region rg_source=mesh_region::all_convexes());
     mesh_trans_inv(const mesh &m, double EPS_ = 1E-12)
-      : bgeot::geotrans_inv(EPS_), msh(m) {}
+      : bgeot::geotrans_inv(EPS_), msh(m), distributed(false),
+        distributed_extrapolation(0), distributed_points_version(0)
+    { add_dependency(m); }
   };
 
 
@@ -259,6 +278,60 @@ namespace getfem {
                      mesh_region rg_source=mesh_region::all_convexes(),
                      mesh_region rg_target=mesh_region::all_convexes());
 
+  /**
+     @brief Transfer operator from mf_source onto mf_target.
+
+     The interpolation matrix of mf_source on mf_target (see the matrix
+     version of interpolation()) is built at the first use and kept until
+     one of the two mesh_fems or one of their meshes is modified. It can
+     then be applied to vectors having several components per dof (the
+     components of a dof being contiguous, as for interpolation()) and to
+     batches of fields stored in the columns of a dense matrix. The
+     products are shared between the threads.
+   */
+  class interpolation_operator : public context_dependencies {
+  protected :
+    const mesh_fem &mf_source, &mf_target;
+    int extrapolation;
+    double EPS;
+    mesh_region rg_source, rg_target;
+    mutable gmm::csr_matrix<scalar_type> M;
+    mutable bool built;
+
+    void build() const;
+    template <typename VECTU, typename VECTV>
+    void mult_(const VECTU &U, const VECTV &V, size_type q) const;
+
+  public :
+    void update_from_context() const { built = false; }
+    /** Interpolation matrix, built if necessary. */
+    const gmm::csr_matrix<scalar_type> &matrix() const;
+    /** True if the matrix is built and up to date. */
+    bool is_built() const { context_check(); return built; }
+    size_type nrows() const { return gmm::mat_nrows(matrix()); }
+    size_type ncols() const { return gmm::mat_ncols(matrix()); }
+    const mesh_fem &source() const { return mf_source; }
+    const mesh_fem &target() const { return mf_target; }
+
+    /** V = M*U, where U and V can have q components per dof, with
+        q = U.size() / ncols(). */
+    template <typename VECTU, typename VECTV>
+    void apply(const VECTU &U, VECTV &V) const;
+    /** Transfer of a batch of fields : each column of U is a field on
+        mf_source (with possibly several components per dof) and the
+        corresponding column of V is set to its interpolation. */
+    template <typename T>
+    void apply(const gmm::dense_matrix<T> &U, gmm::dense_matrix<T> &V) const;
+
+    interpolation_operator(const mesh_fem &mf_source_,
+                           const mesh_fem &mf_target_,
+                           int extrapolation_ = 0, double EPS_ = 1E-10,
+                           mesh_region rg_source_
+                           = mesh_region::all_convexes(),
+                           mesh_region rg_target_
+                           = mesh_region::all_convexes());
+  };
+
 
   /* --------------------------- Implementation ---------------------------*/
 
@@ -740,6 +813,42 @@ namespace getfem {
                     rg_source, rg_target);
   }
 
+  /* Product of the interpolation matrix by a field having q components
+     per dof, the components being interleaved. */
+  template <typename VECTU, typename VECTV>
+  void interpolation_operator::mult_(const VECTU &U, const VECTV &V_,
+                                     size_type q) const {
+    VECTV &V = const_cast<VECTV &>(V_);
+    if (q == 1)
+      gmm::mult(M, U, V);
+    else
+      for (size_type c = 0; c < q; ++c)
+        gmm::mult(M, gmm::sub_vector(U, gmm::sub_slice(c, M.ncols(), q)),
+                  gmm::sub_vector(V, gmm::sub_slice(c, M.nrows(), q)));
+  }
+
+  template <typename VECTU, typename VECTV>
+  void interpolation_operator::apply(const VECTU &U, VECTV &V) const {
+    matrix();
+    size_type q = M.ncols() ? gmm::vect_size(U) / M.ncols() : 0;
+    GMM_ASSERT1(q != 0 && gmm::vect_size(U) == q * M.ncols()
+                && gmm::vect_size(V) == q * M.nrows(), "Dimensions mismatch");
+    mult_(U, V, q);
+  }
+
+  template <typename T>
+  void interpolation_operator::apply(const gmm::dense_matrix<T> &U,
+                                     gmm::dense_matrix<T> &V) const {
+    matrix();
+    size_type nu = gmm::mat_nrows(U), nf = gmm::mat_ncols(U);
+    size_type q = M.ncols() ? nu / M.ncols() : 0;
+    GMM_ASSERT1(q != 0 && nu == q * M.ncols()
+                && gmm::mat_nrows(V) == q * M.nrows()
+                && gmm::mat_ncols(V) == nf, "Dimensions mismatch");
+    for (size_type f = 0; f < nf; ++f)
+      mult_(gmm::mat_const_col(U, f), gmm::mat_col(V, f), q);
+  }
+
 
   /**Interpolate mesh_fem data to im_data.
    The qdim of mesh_fem must be equal to im_data nb_tensor_elem.
@@ -454,6 +454,14 @@ namespace getfem {
     /** Pack the mesh : renumber convexes and nodes such that there
         is no holes in their numbering. Do NOT do the Cuthill-McKee. */
     void optimize_structure(bool with_renumbering = true);
+    /** Pack the mesh and renumber the convexes along a Hilbert space
+        filling curve (passing through the barycenters of their vertices)
+        and the points in the order of their first use by the convexes,
+        in order to improve the memory locality of the loops on elements.
+        The regions are renumbered accordingly. As for any change of the
+        mesh, the mesh_fem and mesh_im objects keep only their default
+        elements on the renumbered convexes. */
+    void optimize_layout();
     /// Return the list of convex IDs for a Cuthill-McKee ordering
     const std::vector<size_type> &cuthill_mckee_ordering() const;
     /// Erase the mesh.
@@ -140,6 +140,16 @@ namespace getfem {
     value_type operator [](size_type ii) const { return *(begin() + ii);}
   };
 
+  /** Renumbering of the degrees of freedom of a mesh_fem done after their
+      enumeration. The reverse Cuthill-McKee ordering reduces the bandwidth
+      of the assembled matrices, which improves the locality of the
+      matrix-vector products and of the incomplete factorizations. The
+      nested dissection ordering reduces the fill-in of the direct
+      factorizations.
+  */
+  enum dof_renumbering_type { DOF_RENUMBERING_NONE, DOF_RENUMBERING_RCM,
+                              DOF_RENUMBERING_NESTED_DISSECTION };
+
   /** Describe a finite element method linked to a mesh.
    *
    *  @see mesh
@@ -175,6 +185,11 @@ namespace getfem {
     std::vector<size_type> dof_partition;
     mutable gmm::uint64_type v_num_update, v_num;
     bool use_reduction;    /* A reduction matrix is applied or not.       */
+    dof_renumbering_type dof_renumbering;
+    /* Index of the dofs of the enumeration without renumbering in the    */
+    /* renumbered enumeration (empty if no renumbering is done).          */
+    mutable std::vector<size_type> renumbered_dof;
+    void renumber_dof() const;
 
   public :
     typedef base_node point_type;
@@ -222,6 +237,15 @@ namespace getfem {
     void reduce_to_basic_dof(const dal::bit_vector &kept_basic_dof);
     void reduce_to_basic_dof(const std::set<size_type> &kept_basic_dof);
 
+    /** Set the renumbering of the basic dofs (DOF_RENUMBERING_NONE,
+        DOF_RENUMBERING_RCM or DOF_RENUMBERING_NESTED_DISSECTION). The
+        reduction and extension matrices, if any, are permuted accordingly.
+    */
+    void set_dof_renumbering(dof_renumbering_type t);
+    /// Return the renumbering of the basic dofs.
+    dof_renumbering_type get_dof_renumbering() const
+    { return dof_renumbering; }
+
     /// Validate or invalidate the reduction (keeping the reduction matrices).
     void set_reduction(bool r) {
       if (r != use_reduction) {
@@ -649,6 +673,15 @@ namespace getfem {
   /** Dummy mesh_fem for default parameter of functions. */
   const mesh_fem &dummy_mesh_fem();
 
+  /** Fills the columns of @param B with the rigid body modes of a vector
+      field described by @param mf (translations, and rotations if the
+      qdim of mf is equal to the dimension of the mesh), computed on the
+      points of the dofs. The number of rows of B is mf.nb_dof(). Used as
+      near nullspace by the algebraic multigrid preconditioner for
+      elasticity problems.
+  */
+  void rigid_body_modes(const mesh_fem &mf, base_matrix &B);
+
 
   /** Given a mesh_fem @param mf and a vector @param vec of size equal to
    *  mf.nb_basic_dof(), the output vector @param coeff will contain the
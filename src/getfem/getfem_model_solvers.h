@@ -81,31 +81,134 @@ namespace getfem {
   struct abstract_linear_solver {
     typedef MAT MATRIX;
     typedef VECT VECTOR;
+    typedef gmm::dense_matrix<typename gmm::linalg_traits<VECT>::value_type>
+      MULTI_VECTOR;
+    /** Version of the sparsity structure of the matrices given to the next
+        solves (see model::tangent_matrix_structure_version), set by the
+        model solvers, or size_type(-1) if unknown. */
+    size_type structure_version = size_type(-1);
     virtual void operator ()(const MAT &, VECT &, const VECT &,
                              gmm::iteration &) const = 0;
+    /** Solve for the right hand sides which are the columns of B, the
+        columns of X being the initial guesses and the solutions. By
+        default, each column is solved separately. The direct solvers
+        factorize the matrix once and the iterative ones build the
+        preconditioner once. */
+    virtual void solve_multiple(const MAT &M, MULTI_VECTOR &X,
+                                const MULTI_VECTOR &B,
+                                gmm::iteration &iter) const {
+      solve_columns(X, B, iter, [&](VECT &x, const VECT &b,
+                                    gmm::iteration &it)
+                    { (*this)(M, x, b, it); });
+    }
     virtual ~abstract_linear_solver() {}
+
+    // Calls solve(x, b, iter) for each column. The number of iterations is
+    // the total one and the solve has converged if it has for all columns.
+    template <typename SOLVE>
+    static void solve_columns(MULTI_VECTOR &X, const MULTI_VECTOR &B,
+                              gmm::iteration &iter, SOLVE solve) {
+      size_type n = gmm::mat_nrows(B), nrhs = gmm::mat_ncols(B), nit = 0;
+      GMM_ASSERT1(gmm::mat_nrows(X) == n && gmm::mat_ncols(X) == nrhs,
+                  "dimensions mismatch");
+      VECT x(n), b(n);
+      bool conv = true;
+      for (size_type j = 0; j < nrhs; ++j) {
+        gmm::copy(gmm::mat_col(X, j), x);
+        gmm::copy(gmm::mat_const_col(B, j), b);
+        iter.set_iteration(0);
+        solve(x, b, iter);
+        conv = conv && iter.converged();
+        nit += iter.get_iteration();
+        gmm::copy(x, gmm::mat_col(X, j));
+      }
+      iter.set_iteration(nit);
+      iter.enforce_converged(conv);
+    }
   };
 
   template <typename MAT, typename VECT>
   struct linear_solver_cg_preconditioned_ildlt
     : public abstract_linear_solver<MAT, VECT> {
+    typedef typename abstract_linear_solver<MAT, VECT>::MULTI_VECTOR
+      MULTI_VECTOR;
     void operator ()(const MAT &M, VECT &x, const VECT &b,
                      gmm::iteration &iter)  const {
       gmm::ildlt_precond<MAT> P(M);
       gmm::cg(M, x, b, P, iter);
       if (!iter.converged()) GMM_WARNING2("cg did not converge!");
     }
+    void solve_multiple(const MAT &M, MULTI_VECTOR &X, const MULTI_VECTOR &B,
+                        gmm::iteration &iter) const {
+      gmm::ildlt_precond<MAT> P(M);
+      gmm::block_cg(M, X, B, P, iter);
+      if (!iter.converged()) GMM_WARNING2("block cg did not converge!");
+    }
+  };
+
+  template <typename MAT, typename VECT>
+  struct linear_solver_pipelined_cg_preconditioned_ildlt
+    : public abstract_linear_solver<MAT, VECT> {
+    typedef typename abstract_linear_solver<MAT, VECT>::MULTI_VECTOR
+      MULTI_VECTOR;
+    void operator ()(const MAT &M, VECT &x, const VECT &b,
+                     gmm::iteration &iter)  const {
+      gmm::ildlt_precond<MAT> P(M);
+      gmm::pipelined_cg(M, x, b, P, iter);
+      if (!iter.converged()) GMM_WARNING2("cg did not converge!");
+    }
+    void solve_multiple(const MAT &M, MULTI_VECTOR &X, const MULTI_VECTOR &B,
+                        gmm::iteration &iter) const {
+      gmm::ildlt_precond<MAT> P(M);
+      gmm::block_cg(M, X, B, P, iter);
+      if (!iter.converged()) GMM_WARNING2("block cg did not converge!");
+    }
   };
 
   template <typename MAT, typename VECT>
   struct linear_solver_gmres_preconditioned_ilu
     : public abstract_linear_solver<MAT, VECT> {
+    typedef typename abstract_linear_solver<MAT, VECT>::MULTI_VECTOR
+      MULTI_VECTOR;
     void operator ()(const MAT &M, VECT &x, const VECT &b,
                      gmm::iteration &iter)  const {
       gmm::ilu_precond<MAT> P(M);
       gmm::gmres(M, x, b, P, 500, iter);
       if (!iter.converged()) GMM_WARNING2("gmres did not converge!");
     }
+    void solve_multiple(const MAT &M, MULTI_VECTOR &X, const MULTI_VECTOR &B,
+                        gmm::iteration &iter) const {
+      gmm::ilu_precond<MAT> P(M);
+      this->solve_columns(X, B, iter, [&](VECT &x, const VECT &b,
+                                          gmm::iteration &it)
+                          { gmm::gmres(M, x, b, P, 500, it); });
+      if (!iter.converged()) GMM_WARNING2("gmres did not converge!");
+    }
+  };
+
+  template <typename MAT, typename VECT>
+  struct linear_solver_gmres_cgs2_preconditioned_ilu
+    : public abstract_linear_solver<MAT, VECT> {
+    typedef typename abstract_linear_solver<MAT, VECT>::MULTI_VECTOR
+      MULTI_VECTOR;
+    void operator ()(const MAT &M, VECT &x, const VECT &b,
+                     gmm::iteration &iter)  const {
+      typedef typename gmm::linalg_traits<MAT>::value_type T;
+      gmm::ilu_precond<MAT> P(M);
+      gmm::classical_gram_schmidt<T> orth(500, gmm::vect_size(x));
+      gmm::gmres(M, x, b, P, 500, iter, orth);
+      if (!iter.converged()) GMM_WARNING2("gmres did not converge!");
+    }
+    void solve_multiple(const MAT &M, MULTI_VECTOR &X, const MULTI_VECTOR &B,
+                        gmm::iteration &iter) const {
+      typedef typename gmm::linalg_traits<MAT>::value_type T;
+      gmm::ilu_precond<MAT> P(M);
+      gmm::classical_gram_schmidt<T> orth(500, gmm::mat_nrows(B));
+      this->solve_columns(X, B, iter, [&](VECT &x, const VECT &b,
+                                          gmm::iteration &it)
+                          { gmm::gmres(M, x, b, P, 500, it, orth); });
+      if (!iter.converged()) GMM_WARNING2("gmres did not converge!");
+    }
   };
 
   template <typename MAT, typename VECT>
@@ -122,42 +225,373 @@ namespace getfem {
   template <typename MAT, typename VECT>
   struct linear_solver_gmres_preconditioned_ilut
     : public abstract_linear_solver<MAT, VECT> {
+    typedef typename abstract_linear_solver<MAT, VECT>::MULTI_VECTOR
+      MULTI_VECTOR;
     void operator ()(const MAT &M, VECT &x, const VECT &b,
                      gmm::iteration &iter)  const {
       gmm::ilut_precond<MAT> P(M, 40, 1E-7);
       gmm::gmres(M, x, b, P, 500, iter);
       if (!iter.converged()) GMM_WARNING2("gmres did not converge!");
     }
+    void solve_multiple(const MAT &M, MULTI_VECTOR &X, const MULTI_VECTOR &B,
+                        gmm::iteration &iter) const {
+      gmm::ilut_precond<MAT> P(M, 40, 1E-7);
+      this->solve_columns(X, B, iter, [&](VECT &x, const VECT &b,
+                                          gmm::iteration &it)
+                          { gmm::gmres(M, x, b, P, 500, it); });
+      if (!iter.converged()) GMM_WARNING2("gmres did not converge!");
+    }
   };
 
   template <typename MAT, typename VECT>
   struct linear_solver_gmres_preconditioned_ilutp
     : public abstract_linear_solver<MAT, VECT> {
+    typedef typename abstract_linear_solver<MAT, VECT>::MULTI_VECTOR
+      MULTI_VECTOR;
     void operator ()(const MAT &M, VECT &x, const VECT &b,
                      gmm::iteration &iter)  const {
       gmm::ilutp_precond<MAT> P(M, 20, 1E-7);
       gmm::gmres(M, x, b, P, 500, iter);
       if (!iter.converged()) GMM_WARNING2("gmres did not converge!");
     }
+    void solve_multiple(const MAT &M, MULTI_VECTOR &X, const MULTI_VECTOR &B,
+                        gmm::iteration &iter) const {
+      gmm::ilutp_precond<MAT> P(M, 20, 1E-7);
+      this->solve_columns(X, B, iter, [&](VECT &x, const VECT &b,
+                                          gmm::iteration &it)
+                          { gmm::gmres(M, x, b, P, 500, it); });
+      if (!iter.converged()) GMM_WARNING2("gmres did not converge!");
+    }
   };
 
+  /** Near nullspace used by the algebraic multigrid preconditioner: the
+      rigid body modes if the model has a single unknown variable which is
+      a vector field of the dimension of the mesh (elasticity), nothing
+      otherwise (the constant vector is then used). */
+  void amg_near_nullspace(const model &md, base_matrix &B,
+                          size_type &block_size);
+
   template <typename MAT, typename VECT>
-  struct linear_solver_superlu
-    : public abstract_linear_solver<MAT, VECT> {
+  struct linear_solver_amg_base : public abstract_linear_solver<MAT, VECT> {
+    typedef typename gmm::linalg_traits<MAT>::value_type T;
+    typedef typename abstract_linear_solver<MAT, VECT>::MULTI_VECTOR
+      MULTI_VECTOR;
+    gmm::dense_matrix<T> B; // Near nullspace
+    gmm::amg_parameters param;
+
+    void build_precond(gmm::amg_precond<MAT> &P, const MAT &M) const {
+      if (gmm::mat_nrows(B) == gmm::mat_nrows(M))
+        P.build_with(M, B);
+      else { // The model has changed, the constant vector is used
+        gmm::amg_parameters p(param); p.block_size = 1;
+        P = gmm::amg_precond<MAT>(p);
+        P.build_with(M);
+      }
+    }
+
+    linear_solver_amg_base(const model &md) {
+      base_matrix BB;
+      amg_near_nullspace(md, BB, param.block_size);
+      gmm::resize(B, gmm::mat_nrows(BB), gmm::mat_ncols(BB));
+      gmm::copy(BB, B);
+    }
+  };
+
+  template <typename MAT, typename VECT>
+  struct linear_solver_cg_preconditioned_amg
+    : public linear_solver_amg_base<MAT, VECT> {
+    typedef typename linear_solver_amg_base<MAT, VECT>::MULTI_VECTOR
+      MULTI_VECTOR;
+    void operator ()(const MAT &M, VECT &x, const VECT &b,
+                     gmm::iteration &iter)  const {
+      gmm::amg_precond<MAT> P(this->param);
+      this->build_precond(P, M);
+      gmm::cg(M, x, b, P, iter);
+      if (!iter.converged()) GMM_WARNING2("cg did not converge!");
+    }
+    void solve_multiple(const MAT &M, MULTI_VECTOR &X, const MULTI_VECTOR &B_,
+                        gmm::iteration &iter) const {
+      gmm::amg_precond<MAT> P(this->param);
+      this->build_precond(P, M);
+      gmm::block_cg(M, X, B_, P, iter);
+      if (!iter.converged()) GMM_WARNING2("block cg did not converge!");
+    }
+    linear_solver_cg_preconditioned_amg(const model &md)
+      : linear_solver_amg_base<MAT, VECT>(md) {}
+  };
+
+  template <typename MAT, typename VECT>
+  struct linear_solver_pipelined_cg_preconditioned_amg
+    : public linear_solver_amg_base<MAT, VECT> {
+    typedef typename linear_solver_amg_base<MAT, VECT>::MULTI_VECTOR
+      MULTI_VECTOR;
+    void operator ()(const MAT &M, VECT &x, const VECT &b,
+                     gmm::iteration &iter)  const {
+      gmm::amg_precond<MAT> P(this->param);
+      this->build_precond(P, M);
+      gmm::pipelined_cg(M, x, b, P, iter);
+      if (!iter.converged()) GMM_WARNING2("cg did not converge!");
+    }
+    void solve_multiple(const MAT &M, MULTI_VECTOR &X, const MULTI_VECTOR &B_,
+                        gmm::iteration &iter) const {
+      gmm::amg_precond<MAT> P(this->param);
+      this->build_precond(P, M);
+      gmm::block_cg(M, X, B_, P, iter);
+      if (!iter.converged()) GMM_WARNING2("block cg did not converge!");
+    }
+    linear_solver_pipelined_cg_preconditioned_amg(const model &md)
+      : linear_solver_amg_base<MAT, VECT>(md) {}
+  };
+
+  template <typename MAT, typename VECT>
+  struct linear_solver_gmres_preconditioned_amg
+    : public linear_solver_amg_base<MAT, VECT> {
+    typedef typename linear_solver_amg_base<MAT, VECT>::MULTI_VECTOR
+      MULTI_VECTOR;
     void operator ()(const MAT &M, VECT &x, const VECT &b,
                      gmm::iteration &iter)  const {
-      double rcond;
+      gmm::amg_precond<MAT> P(this->param);
+      this->build_precond(P, M);
+      gmm::gmres(M, x, b, P, 500, iter);
+      if (!iter.converged()) GMM_WARNING2("gmres did not converge!");
+    }
+    void solve_multiple(const MAT &M, MULTI_VECTOR &X, const MULTI_VECTOR &B_,
+                        gmm::iteration &iter) const {
+      gmm::amg_precond<MAT> P(this->param);
+      this->build_precond(P, M);
+      this->solve_columns(X, B_, iter, [&](VECT &x, const VECT &b,
+                                           gmm::iteration &it)
+                          { gmm::gmres(M, x, b, P, 500, it); });
+      if (!iter.converged()) GMM_WARNING2("gmres did not converge!");
+    }
+    linear_solver_gmres_preconditioned_amg(const model &md)
+      : linear_solver_amg_base<MAT, VECT>(md) {}
+  };
+
+  // The factorization is kept by the solver object. When the next matrix
+  // has the same sparsity pattern (Newton iterations, time steps), the
+  // column permutation and the elimination tree are reused and only the
+  // numerical factorization is done. The patterns are compared when the
+  // structure version is unchanged or unknown.
+  template <typename MAT, typename VECT>
+  struct linear_solver_superlu
+    : public abstract_linear_solver<MAT, VECT> {
+    typedef typename gmm::linalg_traits<MAT>::value_type T;
+    typedef typename abstract_linear_solver<MAT, VECT>::MULTI_VECTOR
+      MULTI_VECTOR;
+    mutable gmm::SuperLU_factor<T> factor;
+    mutable gmm::csc_matrix<T> csc_M; // Factorized matrix
+    mutable bool factorized = false;
+    mutable size_type factorized_version = size_type(-1);
+    // Number of factorizations and of those reusing the symbolic one
+    mutable size_type nb_factorizations = 0, nb_numerical_factorizations = 0;
+
+    bool factorize(const MAT &M, gmm::iteration &iter) const {
       /*gmm::HarwellBoeing_IO::write("test.hb", M);
       std::fstream f("bbb", std::ios::out);
       for (unsigned i=0; i < gmm::vect_size(b); ++i) f << b[i] << "\n";*/
-      int info = SuperLU_solve(M, x, b, rcond);
-      iter.enforce_converged(info == 0);
-      if (iter.get_noisy()) cout << "condition number: " << 1.0/rcond<< endl;
+      gmm::csc_matrix<T> A(gmm::mat_nrows(M), gmm::mat_ncols(M));
+      gmm::copy(M, A);
+      size_type version = this->structure_version;
+      bool same_pattern = factorized
+        && (version == size_type(-1) || version == factorized_version)
+        && A.nr == csc_M.nr && A.nc == csc_M.nc
+        && A.jc == csc_M.jc && A.ir == csc_M.ir;
+      std::swap(A, csc_M);
+      factorized = false;
+      try {
+        factor.build_with(csc_M, 3, same_pattern, iter.get_noisy() != 0);
+      } catch (const gmm::gmm_error &e) {
+        GMM_WARNING1("SuperLU factorization failed: " << e.what());
+        iter.enforce_converged(false);
+        return false;
+      }
+      factorized = true;
+      factorized_version = version;
+      ++nb_factorizations;
+      if (same_pattern) ++nb_numerical_factorizations;
+      if (iter.get_noisy()) {
+        cout << "SuperLU " << (same_pattern ? "numerical " : "")
+             << "factorization" << endl;
+        cout << "condition number: " << 1.0/factor.rcond() << endl;
+      }
+      return true;
+    }
+
+    void operator ()(const MAT &M, VECT &x, const VECT &b,
+                     gmm::iteration &iter)  const {
+      if (!factorize(M, iter)) return;
+      factor.solve(x, b);
+      iter.enforce_converged(true);
+    }
+
+    void solve_multiple(const MAT &M, MULTI_VECTOR &X, const MULTI_VECTOR &B,
+                        gmm::iteration &iter) const {
+      if (!factorize(M, iter)) return;
+      factor.solve_multiple(X, B);
+      iter.enforce_converged(true);
+    }
+  };
+
+  template <typename T> struct single_precision_type_
+  { typedef float type; };
+  template <typename T> struct single_precision_type_<std::complex<T> >
+  { typedef std::complex<float> type; };
+
+  // Single precision factorization used as a preconditioner.
+  template <typename TS> struct single_precision_precond_ {
+    const gmm::SuperLU_factor<TS> &factor;
+    single_precision_precond_(const gmm::SuperLU_factor<TS> &f)
+      : factor(f) {}
+  };
+
+  template <typename TS, typename V1, typename V2> inline
+  void mult(const single_precision_precond_<TS> &P, const V1 &v1, V2 &v2)
+  { P.factor.solve(v2, v1); }
+
+  // Mixed precision solver. The matrix is factorized in single precision
+  // with SuperLU (half the memory of the factors) and the double precision
+  // accuracy is recovered with an iterative refinement. If the refinement
+  // does not converge, gmres preconditioned by the single precision
+  // factorization is used. The double precision factorization is used
+  // when the matrix cannot be represented in single precision or when
+  // both fail.
+  template <typename MAT, typename VECT>
+  struct linear_solver_superlu_mixed
+    : public abstract_linear_solver<MAT, VECT> {
+    typedef typename gmm::linalg_traits<MAT>::value_type T;
+    typedef typename gmm::number_traits<T>::magnitude_type R;
+    typedef typename single_precision_type_<T>::type TS;
+    typedef typename gmm::number_traits<TS>::magnitude_type RS;
+    mutable gmm::SuperLU_factor<TS> factor;
+    mutable gmm::csc_matrix<TS> csc_M; // Factorized matrix
+    mutable bool factorized = false;
+    linear_solver_superlu<MAT, VECT> double_solver;
+    size_type max_refinement = 30;
+    // Number of solves done by iterative refinement, by gmres and with
+    // the double precision factorization
+    mutable size_type nb_refinement_solves = 0, nb_gmres_solves = 0;
+    mutable size_type nb_double_solves = 0;
+    typedef typename abstract_linear_solver<MAT, VECT>::MULTI_VECTOR
+      MULTI_VECTOR;
+
+    // Single precision factorization. Returns false if the double
+    // precision has to be used.
+    bool factorize(const MAT &M, gmm::iteration &iter) const {
+      gmm::csc_matrix<T> A(gmm::mat_nrows(M), gmm::mat_ncols(M));
+      gmm::copy(M, A);
+      R amax(0);
+      for (size_type k = 0; k < A.pr.size(); ++k)
+        amax = std::max(amax, gmm::abs(A.pr[k]));
+      if (amax > R(std::numeric_limits<RS>::max()) / R(2)) {
+        GMM_WARNING2("matrix out of the single precision range, "
+                     "double precision factorization is used");
+        factorized = false;
+        return false;
+      }
+
+      bool same_pattern = factorized && A.nr == csc_M.nr && A.nc == csc_M.nc
+        && A.jc == csc_M.jc && A.ir == csc_M.ir;
+      std::swap(csc_M.jc, A.jc); std::swap(csc_M.ir, A.ir);
+      csc_M.pr.resize(A.pr.size());
+      for (size_type k = 0; k < A.pr.size(); ++k) csc_M.pr[k] = TS(A.pr[k]);
+      csc_M.nr = A.nr; csc_M.nc = A.nc;
+      factorized = false;
+      try {
+        factor.build_with(csc_M, 3, same_pattern);
+      } catch (const gmm::gmm_error &e) {
+        GMM_WARNING2("single precision SuperLU factorization failed: "
+                     << e.what() << ", double precision is used");
+        return false;
+      }
+      factorized = true;
+      if (iter.get_noisy())
+        cout << "Single precision SuperLU " << (same_pattern ? "numerical " : "")
+             << "factorization" << endl;
+      return true;
+    }
+
+    // Iterative refinement of x, which is the solution given by the single
+    // precision factorization, then gmres if it does not converge.
+    bool refine(const MAT &M, VECT &x, const VECT &b,
+                gmm::iteration &iter) const {
+      size_type n = gmm::vect_size(b);
+      // Stopping criterion of the iterative refinement (as in LAPACK dsgesv)
+      R eps = std::numeric_limits<R>::epsilon();
+      R cte = gmm::sqrt(R(n)) * eps * gmm::mat_norminf(M);
+      VECT r(n), d(n);
+      R res(0), res0(0);
+      size_type nit = 0;
+      bool conv = false;
+      for (; nit < max_refinement; ++nit) {
+        gmm::mult(M, gmm::scaled(x, T(-1)), b, r);
+        res = gmm::vect_norminf(r);
+        if (res <= cte * gmm::vect_norminf(x)) { conv = true; break; }
+        if (nit > 0 && res > res0 / R(2)) break; // Too slow contraction
+        res0 = res;
+        factor.solve(d, r);
+        gmm::add(d, x);
+      }
+      if (iter.get_noisy()) cout << nit << " refinement steps" << endl;
+      if (conv) ++nb_refinement_solves;
+
+      if (!conv) {
+        // gmres is stopped on the preconditioned residual, so that the
+        // stopping criterion is checked after each restart cycle.
+        single_precision_precond_<TS> P(factor);
+        size_type nit_gmres = 0;
+        for (size_type k = 0; !conv && k < 20; ++k) {
+          gmm::iteration iter_gmres(R(10) * eps, 0, 50);
+          gmm::gmres(M, x, b, P, 50, iter_gmres);
+          nit_gmres += iter_gmres.get_iteration();
+          gmm::mult(M, gmm::scaled(x, T(-1)), b, r);
+          conv = (gmm::vect_norminf(r) <= cte * gmm::vect_norminf(x));
+        }
+        if (iter.get_noisy())
+          cout << "gmres preconditioned by the single precision factor, "
+               << nit_gmres << " iterations" << endl;
+        if (conv) ++nb_gmres_solves;
+      }
+      if (!conv)
+        GMM_WARNING2("mixed precision solve did not converge, "
+                     "double precision factorization is used");
+      return conv;
+    }
+
+    void operator ()(const MAT &M, VECT &x, const VECT &b,
+                     gmm::iteration &iter)  const {
+      if (factorize(M, iter)) {
+        factor.solve(x, b);
+        if (refine(M, x, b, iter)) { iter.enforce_converged(true); return; }
+      }
+      ++nb_double_solves;
+      double_solver(M, x, b, iter);
+    }
+
+    void solve_multiple(const MAT &M, MULTI_VECTOR &X, const MULTI_VECTOR &B,
+                        gmm::iteration &iter) const {
+      if (factorize(M, iter)) {
+        factor.solve_multiple(X, B);
+        size_type n = gmm::mat_nrows(B);
+        VECT x(n), b(n);
+        bool conv = true;
+        for (size_type j = 0; conv && j < gmm::mat_ncols(B); ++j) {
+          gmm::copy(gmm::mat_col(X, j), x);
+          gmm::copy(gmm::mat_const_col(B, j), b);
+          conv = refine(M, x, b, iter);
+          gmm::copy(x, gmm::mat_col(X, j));
+        }
+        if (conv) { iter.enforce_converged(true); return; }
+      }
+      ++nb_double_solves;
+      double_solver.solve_multiple(M, X, B, iter);
     }
   };
 
   template <typename MAT, typename VECT>
   struct linear_solver_dense_lu : public abstract_linear_solver<MAT, VECT> {
+    typedef typename abstract_linear_solver<MAT, VECT>::MULTI_VECTOR
+      MULTI_VECTOR;
     void operator ()(const MAT &M, VECT &x, const VECT &b,
                      gmm::iteration &iter) const {
       typedef typename gmm::linalg_traits<MAT>::value_type T;
@@ -166,24 +600,55 @@ namespace getfem {
       gmm::lu_solve(MM, x, b);
       iter.enforce_converged(true);
     }
+    void solve_multiple(const MAT &M, MULTI_VECTOR &X, const MULTI_VECTOR &B,
+                        gmm::iteration &iter) const {
+      typedef typename gmm::linalg_traits<MAT>::value_type T;
+      size_type n = gmm::mat_nrows(M);
+      gmm::dense_matrix<T> MM(n, n);
+      gmm::copy(M, MM);
+      gmm::lapack_ipvt ipvt(n);
+      size_type info = gmm::lu_factor(MM, ipvt);
+      GMM_ASSERT1(!info, "Singular system, pivot = " << info);
+      VECT x(n), b(n);
+      for (size_type j = 0; j < gmm::mat_ncols(B); ++j) {
+        gmm::copy(gmm::mat_const_col(B, j), b);
+        gmm::lu_solve(MM, ipvt, x, b);
+        gmm::copy(x, gmm::mat_col(X, j));
+      }
+      iter.enforce_converged(true);
+    }
   };
 
 #ifdef GMM_USES_MUMPS
   template <typename MAT, typename VECT>
   struct linear_solver_mumps : public abstract_linear_solver<MAT, VECT> {
+    typedef typename abstract_linear_solver<MAT, VECT>::MULTI_VECTOR
+      MULTI_VECTOR;
     void operator ()(const MAT &M, VECT &x, const VECT &b,
                      gmm::iteration &iter) const {
       bool ok = gmm::MUMPS_solve(M, x, b, false);
       iter.enforce_converged(ok);
     }
+    void solve_multiple(const MAT &M, MULTI_VECTOR &X, const MULTI_VECTOR &B,
+                        gmm::iteration &iter) const {
+      bool ok = gmm::MUMPS_solve_multiple(M, X, B, false);
+      iter.enforce_converged(ok);
+    }
   };
   template <typename MAT, typename VECT>
   struct linear_solver_mumps_sym : public abstract_linear_solver<MAT, VECT> {
+    typedef typename abstract_linear_solver<MAT, VECT>::MULTI_VECTOR
+      MULTI_VECTOR;
     void operator ()(const MAT &M, VECT &x, const VECT &b,
                      gmm::iteration &iter) const {
       bool ok = gmm::MUMPS_solve(M, x, b, true);
       iter.enforce_converged(ok);
     }
+    void solve_multiple(const MAT &M, MULTI_VECTOR &X, const MULTI_VECTOR &B,
+                        gmm::iteration &iter) const {
+      bool ok = gmm::MUMPS_solve_multiple(M, X, B, true);
+      iter.enforce_converged(ok);
+    }
   };
 #endif
 
@@ -191,6 +656,8 @@ namespace getfem {
   template <typename MAT, typename VECT>
   struct linear_solver_distributed_mumps
     : public abstract_linear_solver<MAT, VECT> {
+    typedef typename abstract_linear_solver<MAT, VECT>::MULTI_VECTOR
+      MULTI_VECTOR;
     void operator ()(const MAT &M, VECT &x, const VECT &b,
                      gmm::iteration &iter) const {
       double tt_ref=MPI_Wtime();
@@ -198,11 +665,18 @@ namespace getfem {
       iter.enforce_converged(ok);
       if (MPI_IS_MASTER()) cout<<"UNSYMMETRIC MUMPS time "<< MPI_Wtime() - tt_ref<<endl;
     }
+    void solve_multiple(const MAT &M, MULTI_VECTOR &X, const MULTI_VECTOR &B,
+                        gmm::iteration &iter) const {
+      bool ok = gmm::MUMPS_solve_multiple(M, X, B, false, true);
+      iter.enforce_converged(ok);
+    }
   };
 
   template <typename MAT, typename VECT>
   struct linear_solver_distributed_mumps_sym
     : public abstract_linear_solver<MAT, VECT> {
+    typedef typename abstract_linear_solver<MAT, VECT>::MULTI_VECTOR
+      MULTI_VECTOR;
     void operator ()(const MAT &M, VECT &x, const VECT &b,
                      gmm::iteration &iter) const {
       double tt_ref=MPI_Wtime();
@@ -210,6 +684,11 @@ namespace getfem {
       iter.enforce_converged(ok);
       if (MPI_IS_MASTER()) cout<<"SYMMETRIC MUMPS time "<< MPI_Wtime() - tt_ref<<endl;
     }
+    void solve_multiple(const MAT &M, MULTI_VECTOR &X, const MULTI_VECTOR &B,
+                        gmm::iteration &iter) const {
+      bool ok = gmm::MUMPS_solve_multiple(M, X, B, true, true);
+      iter.enforce_converged(ok);
+    }
   };
 #endif
 
@@ -667,6 +1146,9 @@ namespace getfem {
     std::shared_ptr<abstract_linear_solver<MATRIX, VECTOR>> p;
     if (bgeot::casecmp(name, "superlu") == 0)
       return std::make_shared<linear_solver_superlu<MATRIX, VECTOR>>();
+    else if (bgeot::casecmp(name, "superlu/mixed") == 0
+             || bgeot::casecmp(name, "superlu_mixed") == 0)
+      return std::make_shared<linear_solver_superlu_mixed<MATRIX, VECTOR>>();
     else if (bgeot::casecmp(name, "dense_lu") == 0)
       return std::make_shared<linear_solver_dense_lu<MATRIX, VECTOR>>();
     else if (bgeot::casecmp(name, "mumps") == 0) {
@@ -684,15 +1166,32 @@ namespace getfem {
     else if (bgeot::casecmp(name, "cg/ildlt") == 0)
       return std::make_shared
         <linear_solver_cg_preconditioned_ildlt<MATRIX, VECTOR>>();
+    else if (bgeot::casecmp(name, "pipelined_cg/ildlt") == 0)
+      return std::make_shared
+        <linear_solver_pipelined_cg_preconditioned_ildlt<MATRIX, VECTOR>>();
     else if (bgeot::casecmp(name, "gmres/ilu") == 0)
       return std::make_shared
         <linear_solver_gmres_preconditioned_ilu<MATRIX, VECTOR>>();
+    else if (bgeot::casecmp(name, "gmres_cgs2/ilu") == 0)
+      return std::make_shared
+        <linear_solver_gmres_cgs2_preconditioned_ilu<MATRIX, VECTOR>>();
     else if (bgeot::casecmp(name, "gmres/ilut") == 0)
       return std::make_shared
         <linear_solver_gmres_preconditioned_ilut<MATRIX, VECTOR>>();
     else if (bgeot::casecmp(name, "gmres/ilutp") == 0)
       return std::make_shared
         <linear_solver_gmres_preconditioned_ilutp<MATRIX, VECTOR>>();
+    else if (bgeot::casecmp(name, "cg/amg") == 0
+             || bgeot::casecmp(name, "cg_amg") == 0)
+      return std::make_shared
+        <linear_solver_cg_preconditioned_amg<MATRIX, VECTOR>>(md);
+    else if (bgeot::casecmp(name, "pipelined_cg/amg") == 0)
+      return std::make_shared
+        <linear_solver_pipelined_cg_preconditioned_amg<MATRIX, VECTOR>>(md);
+    else if (bgeot::casecmp(name, "gmres/amg") == 0
+             || bgeot::casecmp(name, "gmres_amg") == 0)
+      return std::make_shared
+        <linear_solver_gmres_preconditioned_amg<MATRIX, VECTOR>>(md);
     else if (bgeot::casecmp(name, "auto") == 0)
       return default_linear_solver<MATRIX, VECTOR>(md);
     else
@@ -121,6 +121,13 @@ namespace getfem {
     bool is_linear_;
     bool is_symmetric_;
     bool is_coercive_;
+    bool colored_assembly_, atomic_assembly_, fixed_pattern_, ga_profiling_;
+    bool structure_frozen_;
+    mutable bool frozen_structure_valid_;
+    mutable size_type structure_version_;
+    mutable size_t structure_hash_;
+    mutable bool structure_hash_valid_, structure_hash_to_be_done_;
+    mutable ga_profiling_data ga_profiling_stats;
     mutable model_real_sparse_matrix
       rTM,          // tangent matrix (only primary variables), real version
       internal_rTM; // coupling matrix between internal and primary vars (no empty rows)
@@ -383,6 +390,35 @@ namespace getfem {
 
     mutable std::list<gen_expr> generic_expressions;
 
+    // Workspaces of the generic assembly kept from one call of assembly()
+    // to the next, in order for their compiled instructions to be reused
+    // (one workspace per partition, or a single one for the colored and
+    // atomic parallel assemblies), together with the vectors and matrices
+    // they assemble into. They are dropped when the generic expressions,
+    // the assembly options or the sizes of the model change. Not copied
+    // with the model.
+    struct ga_assembly_cache {
+      std::string key;
+      std::vector<std::shared_ptr<ga_workspace>> workspaces;
+      model_real_plain_vector res0, res1;
+      model_real_sparse_matrix intern_mat;
+      std::shared_ptr<omp_distribute<model_real_sparse_matrix>>
+        tangent_matrix_distro, intern_mat_distro;
+      std::shared_ptr<omp_distribute<model_real_plain_vector>>
+        res0_distro, res1_distro;
+      void clear() {
+        key.clear(); workspaces.clear();
+        tangent_matrix_distro.reset(); intern_mat_distro.reset();
+        res0_distro.reset(); res1_distro.reset();
+      }
+      ga_assembly_cache() {}
+      ga_assembly_cache(const ga_assembly_cache &) {}
+      ga_assembly_cache &operator =(const ga_assembly_cache &)
+      { clear(); return *this; }
+    };
+    mutable ga_assembly_cache ga_cache;
+    mutable ga_assembly_statistics ga_assembly_stats;
+
     // Groups of variables for interpolation on different meshes
     // generic assembly
     std::map<std::string, std::vector<std::string> > variable_groups;
@@ -391,6 +427,12 @@ namespace getfem {
     
 
     virtual void actualize_sizes() const;
+    // The structure of the tangent matrix may have changed: the version is
+    // incremented once and the next hash is not compared to the stored one.
+    void structure_changed() const {
+      if (structure_hash_valid_)
+        { ++structure_version_; structure_hash_valid_ = false; }
+    }
     bool check_name_validity(const std::string &name, bool assert=true) const;
     void brick_init(size_type ib, build_version version,
                     size_type rhs_ind = 0) const;
@@ -511,13 +553,13 @@ namespace getfem {
     /** Disable a brick.  */
     void disable_brick(size_type ib) {
       GMM_ASSERT1(valid_bricks[ib], "Inexistent brick");
-      active_bricks.del(ib);
+      active_bricks.del(ib); structure_changed();
     }
 
     /** Enable a brick.  */
     void enable_brick(size_type ib) {
       GMM_ASSERT1(valid_bricks[ib], "Inexistent brick");
-      active_bricks.add(ib);
+      active_bricks.add(ib); structure_changed();
     }
 
     /** Disable a variable (and its attached mutlipliers). */
@@ -579,6 +621,74 @@ namespace getfem {
     /** Return true if all the model terms are linear. */
     bool is_linear() const { return is_linear_; }
 
+    /** Use the colored parallel assembly of the generic assembly terms
+        instead of the assembly of thread local matrices and vectors (see
+        ga_workspace::set_colored_parallel_assembly). Not used for models
+        with internal variables. */
+    void set_colored_parallel_assembly(bool colored)
+    { colored_assembly_ = colored; }
+    bool colored_parallel_assembly() const { return colored_assembly_; }
+
+    /** Use the atomic parallel assembly of the generic assembly terms
+        (see ga_workspace::set_atomic_parallel_assembly). Not used for
+        models with internal variables. */
+    void set_atomic_parallel_assembly(bool atomic)
+    { atomic_assembly_ = atomic; }
+    bool atomic_parallel_assembly() const { return atomic_assembly_; }
+
+    /** Fixed sparsity pattern of the generic assembly terms (see
+        ga_workspace::set_fixed_sparsity_pattern): the sparsity structure
+        of the tangent matrix is kept between two assemblies, as for
+        set_structure_frozen, and the element matrices are added at the
+        positions computed by the previous assemblies. The atomic parallel
+        assembly also keeps the structure of the tangent matrix. */
+    void set_fixed_sparsity_pattern(bool fixed)
+    { fixed_pattern_ = fixed; frozen_structure_valid_ = false; }
+    bool fixed_sparsity_pattern() const { return fixed_pattern_; }
+
+    /** Profiling of the generic assembly terms (see
+        ga_workspace::set_profiling). The statistics of the successive
+        assemblies are accumulated until clear_generic_assembly_profiling()
+        is called. */
+    void set_generic_assembly_profiling(bool profiling)
+    { ga_profiling_ = profiling; }
+    bool generic_assembly_profiling() const { return ga_profiling_; }
+    const ga_profiling_data &generic_assembly_profiling_data() const
+    { return ga_profiling_stats; }
+    void clear_generic_assembly_profiling() { ga_profiling_stats.clear(); }
+
+    /** Number of generic assemblies and of compilations of instruction
+        sets done by assembly(), accumulated until
+        clear_generic_assembly_statistics() is called. The instructions
+        are compiled at the first assembly and reused as long as the
+        generic expressions, the assembly options and the sizes of the
+        model are unchanged. */
+    const ga_assembly_statistics &generic_assembly_statistics() const
+    { return ga_assembly_stats; }
+    void clear_generic_assembly_statistics() { ga_assembly_stats.clear(); }
+
+    /** Structure frozen state: the sparsity structure of the tangent matrix
+        is kept between two assemblies, only its values are set to zero.
+        This avoids the reallocation of the columns at each iteration of a
+        Newton algorithm. The structure is rebuilt when the sizes of the
+        model are actualized (change of a mesh_fem, of a variable ...).
+        The entries of the structure which are not assembled remain as
+        explicit zeros. */
+    void set_structure_frozen(bool frozen)
+    { structure_frozen_ = frozen; frozen_structure_valid_ = false; }
+    bool structure_frozen() const { return structure_frozen_; }
+    /** Counter incremented each time the sparsity structure of the
+        tangent matrix (stored entries, explicit zeros included) may have
+        changed: when the sizes of the model are actualized, when a brick
+        is added, deleted, enabled, disabled or changed, and when the
+        structure given by the last assembly differs from the one of the
+        previous call. The structures are compared with a hash, computed
+        only when the version is asked after an assembly. The model solvers
+        give it to the linear solver (see
+        abstract_linear_solver::structure_version), which may then keep its
+        symbolic factorization. */
+    size_type tangent_matrix_structure_version() const;
+
     /** Total number of degrees of freedom in the model. */
     size_type nb_dof(bool with_internal=false) const;
 
@@ -1109,6 +1219,7 @@ namespace getfem {
         GMM_ASSERT1(name.compare("neighbor_element"), "neighbor_element is a "
                     "reserved interpolate transformation name");
        transformations[name] = ptrans;
+       ga_cache.clear();
     }
 
     /** Get a pointer to the interpolate transformation `name`.
@@ -1132,6 +1243,7 @@ namespace getfem {
     void add_elementary_transformation(const std::string &name,
                                        pelementary_transformation ptrans) {
        elem_transformations[name] = ptrans;
+       ga_cache.clear();
     }
 
     /** Get a pointer to the elementary transformation `name`.
@@ -1159,6 +1271,7 @@ namespace getfem {
       if (interpolate_transformation_exists(name))
         GMM_ASSERT1(false, "An interpolate transformation with the same "
                     "name already exists");secondary_domains[name] = ptrans;
+      ga_cache.clear();
     }
 
     /** Get a pointer to the interpolate transformation `name`.
@@ -373,7 +373,8 @@ namespace getfem
     std::set<size_type>::const_iterator it;
   };
 
-  enum class thread_behaviour {true_threads, partition_threads};
+  enum class thread_behaviour {true_threads, partition_threads,
+                               dynamic_partition_threads};
 
   /**
     A singleton that Manages partitions on individual threads.
@@ -393,9 +394,19 @@ namespace getfem
     /**Sets the behaviour for the full program: either partitioning parallel loops
        according to the number of true threads, specified by the user,
        or to the number of the fixed partitions equal to the max concurrency of the system.
-       The later makes the partitioning independent of the number of the threads set*/
+       The later makes the partitioning independent of the number of the threads set.
+       With dynamic_partition_threads, the partitions are not statically distributed
+       to the threads: each thread takes the next unprocessed partition when it is
+       done with the previous one, which balances the load when the cost of the
+       partitions is uneven. It is intended to be used with a number of partitions
+       (see set_nb_partitions) larger than the number of threads*/
     void set_behaviour(thread_behaviour);
 
+    /**Load balance of the last parallel execution iterating over partitions:
+       mean busy time of the threads divided by the maximal one
+       (1 for a perfect balance)*/
+    double get_load_balance() const;
+
     /**active partition on the thread. If number of threads is equal to the
     max concurrency of the system, then it's also the index of the actual thread*/
     size_type get_current_partition() const;
@@ -426,6 +437,8 @@ namespace getfem
 
     void update_partitions();
 
+    void update_load_balance();
+
     omp_distribute<std::set<size_type>, true_thread_policy> partitions;
     omp_distribute<size_type, true_thread_policy> current_partition;
     std::atomic<size_type> nb_user_threads;
@@ -433,6 +446,9 @@ namespace getfem
     std::atomic<bool> partitions_updated{false};
     size_type nb_partitions;
     bool partitions_set_by_user = false;
+    std::atomic<size_type> next_partition{0}; // for dynamic_partition_threads
+    std::vector<double> busy_times; // of each thread, last parallel execution
+    double load_balance = 1.;
 
     static partition_master instance;
   };
@@ -93,7 +93,15 @@ namespace gmm {
       gmm::copy(A,csc_A);
       build_with(csc_A, permc_spec);
     }
-    void build_with(const gmm::csc_matrix<T> &A, int permc_spec = 3);
+    /** Do the factorization of the supplied sparse matrix. If same_pattern
+        is true, the matrix is assumed to have the same sparsity pattern as
+        the previously factorized one: the column permutation and the
+        elimination tree are kept and only the numerical factorization is
+        done (SuperLU SamePattern option). If condition_number is true, the
+        reciprocal condition number of the matrix is estimated (see
+        rcond()). */
+    void build_with(const gmm::csc_matrix<T> &A, int permc_spec = 3,
+                    bool same_pattern = false, bool condition_number = false);
     template <typename VECTX, typename VECTB> 
     /** After factorization, do the triangular solves.
        transp = LU_NOTRANSP   -> solves Ax = B
@@ -106,10 +114,28 @@ namespace gmm {
       gmm::copy(sol(),const_cast<VECTX &>(X));
     }
     void solve(int transp=LU_NOTRANSP) const;
+    /** After factorization, do the triangular solves for nrhs right hand
+        sides stored column by column in B (nrhs times the size of the
+        matrix), the solutions being stored in the same way in X. */
+    void solve_multiple(T *X, const T *B, size_type nrhs,
+                        int transp=LU_NOTRANSP) const;
+    /** Same as above, the right hand sides being the columns of B. */
+    template <typename MATX, typename MATB>
+    void solve_multiple(const MATX &X, const MATB &B,
+                        int transp=LU_NOTRANSP) const {
+      size_type n = gmm::mat_nrows(B), nrhs = gmm::mat_ncols(B);
+      gmm::dense_matrix<T> BB(n, nrhs), XX(n, nrhs);
+      gmm::copy(B, BB);
+      if (n && nrhs) solve_multiple(&(XX(0, 0)), &(BB(0, 0)), nrhs, transp);
+      gmm::copy(XX, const_cast<MATX &>(X));
+    }
     std::vector<T> &sol() const;
     std::vector<T> &rhs() const;
     SuperLU_factor();
     float memsize() const;
+    /** Estimate of the reciprocal condition number of the matrix computed
+        by the last factorization, 0 if it has not been requested. */
+    double rcond() const;
     SuperLU_factor(const SuperLU_factor& other);
     SuperLU_factor& operator=(const SuperLU_factor& other);
   };
@@ -200,8 +200,8 @@ namespace getfem {
   void multi_contact_frame::clear_aux_info() {
     boundary_points = std::vector<base_node>();
     boundary_points_info = std::vector<boundary_point>();
-    element_boxes.clear();
-    element_boxes_info = std::vector<influence_box>();
+    // element_boxes and element_boxes_info are kept to be refitted by the
+    // next call to compute_influence_boxes.
     potential_pairs = std::vector<std::vector<face_info> >();
   }
 
@@ -556,6 +556,8 @@ namespace getfem {
     bool avert = false;
     base_matrix G;
     model_real_plain_vector coeff;
+    std::vector<base_node> boxes_min, boxes_max;
+    std::vector<influence_box> boxes_info;
 
     for (size_type i = 0; i < contact_boundaries.size(); ++i)
       if (!is_slave_boundary(i)) {
@@ -644,12 +646,34 @@ namespace getfem {
             { bmin[k] -= release_distance; bmax[k] += release_distance; }
 
           // Store the influence box and additional information.
-          element_boxes.add_box(bmin, bmax, element_boxes_info.size());
+          boxes_min.push_back(bmin); boxes_max.push_back(bmax);
           n_mean /= gmm::vect_norm2(n_mean);
-          element_boxes_info.push_back(influence_box(i, cv, v.f(), n_mean));
+          boxes_info.push_back(influence_box(i, cv, v.f(), n_mean));
         }
       }
-    element_boxes.build_tree();
+
+    // If the boxes correspond to the same faces as at the previous call,
+    // the existing tree is refitted instead of being rebuilt.
+    bool same_faces = (element_boxes.nb_boxes() == boxes_info.size()
+                       && element_boxes_info.size() == boxes_info.size());
+    for (size_type j = 0; same_faces && j < boxes_info.size(); ++j)
+      same_faces = (boxes_info[j].ind_boundary
+                    == element_boxes_info[j].ind_boundary
+                    && boxes_info[j].ind_element
+                    == element_boxes_info[j].ind_element
+                    && boxes_info[j].ind_face
+                    == element_boxes_info[j].ind_face);
+    if (same_faces) {
+      for (size_type j = 0; j < boxes_info.size(); ++j)
+        element_boxes.move_box(j, boxes_min[j], boxes_max[j]);
+      element_boxes.refit();
+    } else {
+      element_boxes.clear();
+      for (size_type j = 0; j < boxes_info.size(); ++j)
+        element_boxes.add_box(boxes_min[j], boxes_max[j], j);
+      element_boxes.build_tree();
+    }
+    element_boxes_info.swap(boxes_info);
   }
 
   void multi_contact_frame::compute_potential_contact_pairs_influence_boxes() {
@@ -67,8 +67,13 @@ namespace getfem {
     if (noisy() > 2) cout << "starting linear solver" << endl;
     gmm::iteration iter(maxres_solve, (noisy() >= 2) ? noisy() - 2 : 0,
                         40000);
-    (*lsolver)(A, g1, L1, iter);
-    iter.init(); (*lsolver)(A, g2, L2, iter); // (can be optimised)
+    // both systems are solved with the same factorization or preconditioner
+    size_type n = gmm::vect_size(L1);
+    base_matrix X(n, 2), B(n, 2);
+    gmm::copy(g1, gmm::mat_col(X, 0)); gmm::copy(g2, gmm::mat_col(X, 1));
+    gmm::copy(L1, gmm::mat_col(B, 0)); gmm::copy(L2, gmm::mat_col(B, 1));
+    lsolver->solve_multiple(A, X, B, iter);
+    gmm::copy(gmm::mat_col(X, 0), g1); gmm::copy(gmm::mat_col(X, 1), g2);
     if (noisy() > 2) cout << "linear solver done" << endl;
   }
 
@@ -24,6 +24,10 @@
 #include "getfem/getfem_generic_assembly_semantic.h"
 #include "getfem/getfem_generic_assembly_compile_and_exec.h"
 #include "getfem/getfem_generic_assembly_functions_and_operators.h"
+#include <chrono>
+#if defined(__GNUC__)
+# include <cxxabi.h>
+#endif
 
 // #define GA_USES_BLAS // not so interesting, at least for debian blas
 
@@ -841,10 +845,22 @@ namespace getfem {
     {}
   };
 
-  struct ga_instruction_copy_val_base : public ga_instruction {
+  struct ga_instruction_copy_val_base
+    : public ga_instruction, public ga_batched_instruction {
     base_tensor &t;
     const base_tensor &Z;
     size_type qdim;
+    // Plain copy for qdim == 1, which the derived instructions may not be
+    virtual bool batch_operands(std::vector<ga_batch_operand> &operands,
+                                ga_batch_operand &result) const {
+      operands = {Z}; result = t;
+      return qdim == 1
+        && typeid(*this) == typeid(ga_instruction_copy_val_base);
+    }
+    virtual void exec_batch(scalar_type *pt,
+                            const std::vector<const scalar_type *> &operands,
+                            size_type nb) const
+    { std::copy(operands[0], operands[0] + t.size()*nb, pt); }
     // Z(ndof,target_dim) --> t(Qmult*ndof,Qmult*target_dim)
     virtual int exec() {
       GA_DEBUG_INFO("Instruction: value of test functions");
@@ -903,6 +919,12 @@ namespace getfem {
   };
 
   struct ga_instruction_copy_grad_base : public ga_instruction_copy_val_base {
+    virtual bool batch_operands(std::vector<ga_batch_operand> &operands,
+                                ga_batch_operand &result) const {
+      operands = {Z}; result = t;
+      return qdim == 1
+        && typeid(*this) == typeid(ga_instruction_copy_grad_base);
+    }
     // Z(ndof,target_dim,N) --> t(Qmult*ndof,Qmult*target_dim,N)
     virtual int exec() {
       GA_DEBUG_INFO("Instruction: gradient of test functions");
@@ -965,10 +987,37 @@ namespace getfem {
       : ga_instruction_copy_val_base(tt,Z_,q) {}
   };
 
-  struct ga_instruction_copy_vect_val_base : public ga_instruction {
+  // Batched version of the copies of ga_instruction_copy_vect_val_base and
+  // ga_instruction_copy_vect_grad_base (N = 1 for the values). The other
+  // components of t are zero in the storage of the batch.
+  static void ga_batch_copy_vect_base
+  (scalar_type *pt, const scalar_type *pZ, size_type ndof, size_type qdim,
+   size_type s, size_type N, size_type nb) {
+    size_type sss = s+1, ssss = s*qdim;
+    for (size_type l = 0; l < N; ++l)
+      for (size_type i = 0; i < ndof; ++i, pZ += nb)
+        for (size_type j = 0; j < qdim; ++j) {
+          scalar_type *p = pt + (ssss*l + i*qdim + j*sss)*nb;
+          for (size_type b = 0; b < nb; ++b) p[b] = pZ[b];
+        }
+  }
+
+  struct ga_instruction_copy_vect_val_base
+    : public ga_instruction, public ga_batched_instruction {
     base_tensor &t;
     const base_tensor &Z;
     size_type qdim;
+    virtual bool batch_operands(std::vector<ga_batch_operand> &operands,
+                                ga_batch_operand &result) const {
+      operands = {Z}; result = t;
+      return typeid(*this) == typeid(ga_instruction_copy_vect_val_base);
+    }
+    virtual void exec_batch(scalar_type *pt,
+                            const std::vector<const scalar_type *> &operands,
+                            size_type nb) const {
+      ga_batch_copy_vect_base(pt, operands[0], Z.sizes()[0], qdim,
+                              t.sizes()[0], 1, nb);
+    }
     // Z(ndof) --> t(qdim*ndof,qdim*target_dim)
     virtual int exec() {
       GA_DEBUG_INFO("Instruction: vectorized value of test functions");
@@ -997,6 +1046,17 @@ namespace getfem {
 
   struct ga_instruction_copy_vect_grad_base
     : public ga_instruction_copy_vect_val_base {
+    virtual bool batch_operands(std::vector<ga_batch_operand> &operands,
+                                ga_batch_operand &result) const {
+      operands = {Z}; result = t;
+      return typeid(*this) == typeid(ga_instruction_copy_vect_grad_base);
+    }
+    virtual void exec_batch(scalar_type *pt,
+                            const std::vector<const scalar_type *> &operands,
+                            size_type nb) const {
+      ga_batch_copy_vect_base(pt, operands[0], Z.sizes()[0], qdim,
+                              t.sizes()[0], Z.sizes()[2], nb);
+    }
     // Z(ndof,N) --> t(qdim*ndof,qdim,N)
     virtual int exec() {
       GA_DEBUG_INFO("Instruction: vectorized gradient of test functions");
@@ -1657,9 +1717,19 @@ namespace getfem {
   };
 
 
-  struct ga_instruction_add : public ga_instruction {
+  struct ga_instruction_add
+    : public ga_instruction, public ga_batched_instruction {
     base_tensor &t;
     const base_tensor &tc1, &tc2;
+    virtual bool batch_operands(std::vector<ga_batch_operand> &operands,
+                                ga_batch_operand &result) const
+    { operands = {tc1, tc2}; result = t; return true; }
+    virtual void exec_batch(scalar_type *pt,
+                            const std::vector<const scalar_type *> &operands,
+                            size_type nb) const {
+      const scalar_type *p1 = operands[0], *p2 = operands[1];
+      for (size_type i = 0; i < t.size()*nb; ++i) pt[i] = p1[i] + p2[i];
+    }
     virtual int exec() {
       GA_DEBUG_INFO("Instruction: addition");
       GA_DEBUG_ASSERT(t.size() == tc1.size(),
@@ -1704,9 +1774,19 @@ namespace getfem {
       : t(t_), tc1(tc1_), coeff(coeff_) {}
   };
 
-  struct ga_instruction_sub : public ga_instruction {
+  struct ga_instruction_sub
+    : public ga_instruction, public ga_batched_instruction {
     base_tensor &t;
     const base_tensor &tc1, &tc2;
+    virtual bool batch_operands(std::vector<ga_batch_operand> &operands,
+                                ga_batch_operand &result) const
+    { operands = {tc1, tc2}; result = t; return true; }
+    virtual void exec_batch(scalar_type *pt,
+                            const std::vector<const scalar_type *> &operands,
+                            size_type nb) const {
+      const scalar_type *p1 = operands[0], *p2 = operands[1];
+      for (size_type i = 0; i < t.size()*nb; ++i) pt[i] = p1[i] - p2[i];
+    }
     virtual int exec() {
       GA_DEBUG_INFO("Instruction: subtraction");
       GA_DEBUG_ASSERT(t.size() == tc1.size() && t.size() == tc2.size(),
@@ -1748,9 +1828,17 @@ namespace getfem {
       : t(t_), pnode(pnode_), ctx(ctx_), nbpt(nbpt_), ipt(ipt_) {}
   };
 
-  struct ga_instruction_copy_tensor : public ga_instruction {
+  struct ga_instruction_copy_tensor
+    : public ga_instruction, public ga_batched_instruction {
     base_tensor &t;
     const base_tensor &tc1;
+    virtual bool batch_operands(std::vector<ga_batch_operand> &operands,
+                                ga_batch_operand &result) const
+    { operands = {tc1}; result = t; return true; }
+    virtual void exec_batch(scalar_type *pt,
+                            const std::vector<const scalar_type *> &operands,
+                            size_type nb) const
+    { std::copy(operands[0], operands[0] + tc1.size()*nb, pt); }
     virtual int exec() {
       GA_DEBUG_INFO("Instruction: tensor copy");
       std::copy(tc1.begin(), tc1.end(), t.begin());
@@ -2038,9 +2126,19 @@ namespace getfem {
       : t(t_), tc1(tc1_) {}
   };
 
-  struct ga_instruction_scalar_add : public ga_instruction {
+  struct ga_instruction_scalar_add
+    : public ga_instruction, public ga_batched_instruction {
     scalar_type &t;
     const scalar_type &c, &d;
+    virtual bool batch_operands(std::vector<ga_batch_operand> &operands,
+                                ga_batch_operand &result) const
+    { operands = {c, d}; result = t; return true; }
+    virtual void exec_batch(scalar_type *pt,
+                            const std::vector<const scalar_type *> &operands,
+                            size_type nb) const {
+      const scalar_type *pc = operands[0], *pd = operands[1];
+      for (size_type b = 0; b < nb; ++b) pt[b] = pc[b] + pd[b];
+    }
     virtual int exec() {
       GA_DEBUG_INFO("Instruction: scalar addition");
       t = c + d;
@@ -2051,9 +2149,19 @@ namespace getfem {
       : t(t_), c(c_), d(d_) {}
   };
 
-  struct ga_instruction_scalar_sub : public ga_instruction {
+  struct ga_instruction_scalar_sub
+    : public ga_instruction, public ga_batched_instruction {
     scalar_type &t;
     const scalar_type &c, &d;
+    virtual bool batch_operands(std::vector<ga_batch_operand> &operands,
+                                ga_batch_operand &result) const
+    { operands = {c, d}; result = t; return true; }
+    virtual void exec_batch(scalar_type *pt,
+                            const std::vector<const scalar_type *> &operands,
+                            size_type nb) const {
+      const scalar_type *pc = operands[0], *pd = operands[1];
+      for (size_type b = 0; b < nb; ++b) pt[b] = pc[b] - pd[b];
+    }
     virtual int exec() {
       GA_DEBUG_INFO("Instruction: scalar subtraction");
       t = c - d;
@@ -2064,7 +2172,8 @@ namespace getfem {
       : t(t_), c(c_), d(d_) {}
   };
 
-  struct ga_instruction_scalar_scalar_mult : public ga_instruction {
+  struct ga_instruction_scalar_scalar_mult
+    : public ga_instruction, public ga_batched_instruction {
     scalar_type &t;
     const scalar_type &c, &d;
     virtual int exec() {
@@ -2072,6 +2181,15 @@ namespace getfem {
       t = c * d;
       return 0;
     }
+    virtual bool batch_operands(std::vector<ga_batch_operand> &operands,
+                                ga_batch_operand &result) const
+    { operands = {c, d}; result = t; return true; }
+    virtual void exec_batch(scalar_type *pt,
+                            const std::vector<const scalar_type *> &operands,
+                            size_type nb) const {
+      const scalar_type *pc = operands[0], *pd = operands[1];
+      for (size_type b = 0; b < nb; ++b) pt[b] = pc[b] * pd[b];
+    }
     ga_instruction_scalar_scalar_mult(scalar_type &t_, const scalar_type &c_,
                                       const  scalar_type &d_)
       : t(t_), c(c_), d(d_) {}
@@ -2090,7 +2208,8 @@ namespace getfem {
       : t(t_), c(c_), d(d_) {}
   };
 
-  struct ga_instruction_scalar_mult : public ga_instruction {
+  struct ga_instruction_scalar_mult
+    : public ga_instruction, public ga_batched_instruction {
     base_tensor &t, &tc1;
     const scalar_type &c;
     virtual int exec() {
@@ -2098,11 +2217,54 @@ namespace getfem {
       gmm::copy(gmm::scaled(tc1.as_vector(), c), t.as_vector());
       return 0;
     }
+    virtual bool batch_operands(std::vector<ga_batch_operand> &operands,
+                                ga_batch_operand &result) const
+    { operands = {tc1, c}; result = t; return true; }
+    virtual void exec_batch(scalar_type *pt,
+                            const std::vector<const scalar_type *> &operands,
+                            size_type nb) const {
+      const scalar_type *p1 = operands[0], *pc = operands[1];
+      for (size_type i = 0; i < t.size(); ++i, pt += nb, p1 += nb)
+        for (size_type b = 0; b < nb; ++b) pt[b] = pc[b] * p1[b];
+    }
     ga_instruction_scalar_mult(base_tensor &t_, base_tensor &tc1_,
                                const scalar_type &c_)
       : t(t_), tc1(tc1_), c(c_) {}
   };
 
+  // Result of the fusion of an addition (or subtraction with sign = -1)
+  // with the multiplication of its second operand by a scalar.
+  struct ga_instruction_add_scaled
+    : public ga_instruction, public ga_batched_instruction {
+    base_tensor &t;
+    const base_tensor &tc1, &tc2;
+    const scalar_type &c;
+    const scalar_type sign;
+    virtual bool batch_operands(std::vector<ga_batch_operand> &operands,
+                                ga_batch_operand &result) const
+    { operands = {tc1, tc2, c}; result = t; return true; }
+    virtual void exec_batch(scalar_type *pt,
+                            const std::vector<const scalar_type *> &operands,
+                            size_type nb) const {
+      const scalar_type *p1 = operands[0], *p2 = operands[1];
+      const scalar_type *pc = operands[2];
+      for (size_type i = 0; i < t.size(); ++i, pt += nb, p1 += nb, p2 += nb)
+        for (size_type b = 0; b < nb; ++b) pt[b] = p1[b] + sign*pc[b]*p2[b];
+    }
+    virtual int exec() {
+      GA_DEBUG_INFO("Instruction: addition of a scaled tensor");
+      GA_DEBUG_ASSERT(t.size() == tc1.size() && t.size() == tc2.size(),
+                      "internal error");
+      gmm::add(tc1.as_vector(), gmm::scaled(tc2.as_vector(), sign*c),
+               t.as_vector());
+      return 0;
+    }
+    ga_instruction_add_scaled(base_tensor &t_, const base_tensor &tc1_,
+                              const base_tensor &tc2_, const scalar_type &c_,
+                              scalar_type sign_)
+      : t(t_), tc1(tc1_), tc2(tc2_), c(c_), sign(sign_) {}
+  };
+
   struct ga_instruction_scalar_div : public ga_instruction {
     base_tensor &t, &tc1;
     const scalar_type &c;
@@ -2454,6 +2616,173 @@ namespace getfem {
       : t(t_), tc1(tc1_), tc2(tc2_), n(n_) {}
   };
 
+  // Specialized versions of some instructions for tensors whose size is
+  // known when the expression is compiled (no test function). The size is
+  // a template parameter so that the loops are fully unrolled. The size is
+  // checked at execution since it may change for variable groups, in which
+  // case the generic instruction is used.
+  template<int N> struct ga_instruction_add_fixed
+    : public ga_instruction_add {
+    virtual int exec() {
+      if (t.size() != N) return ga_instruction_add::exec();
+      GA_DEBUG_INFO("Instruction: addition of size " << N);
+      GA_DEBUG_ASSERT(tc1.size() == N && tc2.size() == N, "Wrong sizes");
+      for (int i = 0; i < N; ++i) t[i] = tc1[i] + tc2[i];
+      return 0;
+    }
+    ga_instruction_add_fixed(base_tensor &t_, const base_tensor &tc1_,
+                             const base_tensor &tc2_)
+      : ga_instruction_add(t_, tc1_, tc2_) {}
+  };
+
+  template<int N> struct ga_instruction_sub_fixed
+    : public ga_instruction_sub {
+    virtual int exec() {
+      if (t.size() != N) return ga_instruction_sub::exec();
+      GA_DEBUG_INFO("Instruction: subtraction of size " << N);
+      GA_DEBUG_ASSERT(tc1.size() == N && tc2.size() == N, "Wrong sizes");
+      for (int i = 0; i < N; ++i) t[i] = tc1[i] - tc2[i];
+      return 0;
+    }
+    ga_instruction_sub_fixed(base_tensor &t_, const base_tensor &tc1_,
+                             const base_tensor &tc2_)
+      : ga_instruction_sub(t_, tc1_, tc2_) {}
+  };
+
+  template<int N> struct ga_instruction_scalar_mult_fixed
+    : public ga_instruction_scalar_mult {
+    virtual int exec() {
+      if (t.size() != N) return ga_instruction_scalar_mult::exec();
+      GA_DEBUG_INFO("Instruction: multiplication of a tensor of size " << N
+                    << " by a scalar " << c);
+      GA_DEBUG_ASSERT(tc1.size() == N, "Wrong sizes");
+      const scalar_type a = c;
+      for (int i = 0; i < N; ++i) t[i] = a * tc1[i];
+      return 0;
+    }
+    ga_instruction_scalar_mult_fixed(base_tensor &t_, base_tensor &tc1_,
+                                     const scalar_type &c_)
+      : ga_instruction_scalar_mult(t_, tc1_, c_) {}
+  };
+
+  // Performs Amj Bjk -> Cmk for A of size S1xN and B of size NxS2.
+  template<int S1, int N, int S2> struct ga_instruction_matrix_mult_fixed
+    : public ga_instruction_matrix_mult {
+    virtual int exec() {
+      if (n != N || tc1.size() != S1*N || tc2.size() != N*S2)
+        return ga_instruction_matrix_mult::exec();
+      GA_DEBUG_INFO("Instruction: order one contraction of sizes "
+                    << S1 << "x" << N << " and " << N << "x" << S2);
+      GA_DEBUG_ASSERT(t.size() == S1*S2, "Wrong sizes");
+      for (int k = 0; k < S2; ++k)
+        for (int i = 0; i < S1; ++i) {
+          scalar_type a(0);
+          for (int j = 0; j < N; ++j) a += tc1[i+j*S1] * tc2[j+k*N];
+          t[i+k*S1] = a;
+        }
+      return 0;
+    }
+    ga_instruction_matrix_mult_fixed(base_tensor &t_, base_tensor &tc1_,
+                                     base_tensor &tc2_)
+      : ga_instruction_matrix_mult(t_, tc1_, tc2_, N) {}
+  };
+
+  pga_instruction ga_instruction_add_switch
+  (base_tensor &t, const base_tensor &tc1, const base_tensor &tc2,
+   bool fixed) {
+    if (fixed)
+      switch(t.size()) {
+      case 2 : return std::make_shared<ga_instruction_add_fixed<2>>
+                      (t, tc1, tc2);
+      case 3 : return std::make_shared<ga_instruction_add_fixed<3>>
+                      (t, tc1, tc2);
+      case 4 : return std::make_shared<ga_instruction_add_fixed<4>>
+                      (t, tc1, tc2);
+      case 6 : return std::make_shared<ga_instruction_add_fixed<6>>
+                      (t, tc1, tc2);
+      case 9 : return std::make_shared<ga_instruction_add_fixed<9>>
+                      (t, tc1, tc2);
+      default: break;
+      }
+    return std::make_shared<ga_instruction_add>(t, tc1, tc2);
+  }
+
+  pga_instruction ga_instruction_sub_switch
+  (base_tensor &t, const base_tensor &tc1, const base_tensor &tc2,
+   bool fixed) {
+    if (fixed)
+      switch(t.size()) {
+      case 2 : return std::make_shared<ga_instruction_sub_fixed<2>>
+                      (t, tc1, tc2);
+      case 3 : return std::make_shared<ga_instruction_sub_fixed<3>>
+                      (t, tc1, tc2);
+      case 4 : return std::make_shared<ga_instruction_sub_fixed<4>>
+                      (t, tc1, tc2);
+      case 6 : return std::make_shared<ga_instruction_sub_fixed<6>>
+                      (t, tc1, tc2);
+      case 9 : return std::make_shared<ga_instruction_sub_fixed<9>>
+                      (t, tc1, tc2);
+      default: break;
+      }
+    return std::make_shared<ga_instruction_sub>(t, tc1, tc2);
+  }
+
+  pga_instruction ga_instruction_scalar_mult_switch
+  (base_tensor &t, base_tensor &tc1, const scalar_type &c, bool fixed) {
+    if (fixed)
+      switch(t.size()) {
+      case 2 : return std::make_shared<ga_instruction_scalar_mult_fixed<2>>
+                      (t, tc1, c);
+      case 3 : return std::make_shared<ga_instruction_scalar_mult_fixed<3>>
+                      (t, tc1, c);
+      case 4 : return std::make_shared<ga_instruction_scalar_mult_fixed<4>>
+                      (t, tc1, c);
+      case 6 : return std::make_shared<ga_instruction_scalar_mult_fixed<6>>
+                      (t, tc1, c);
+      case 9 : return std::make_shared<ga_instruction_scalar_mult_fixed<9>>
+                      (t, tc1, c);
+      default: break;
+      }
+    return std::make_shared<ga_instruction_scalar_mult>(t, tc1, c);
+  }
+
+  template<int N> pga_instruction ga_instruction_matrix_mult_switch_
+  (base_tensor &t, base_tensor &tc1, base_tensor &tc2) {
+    switch(tc1.size() / N + 10 * (tc2.size() / N)) {
+    case 11 : return std::make_shared<ga_instruction_matrix_mult_fixed<1,N,1>>
+                     (t, tc1, tc2);
+    case 12 : return std::make_shared<ga_instruction_matrix_mult_fixed<1,N,2>>
+                     (t, tc1, tc2);
+    case 13 : return std::make_shared<ga_instruction_matrix_mult_fixed<1,N,3>>
+                     (t, tc1, tc2);
+    case 21 : return std::make_shared<ga_instruction_matrix_mult_fixed<2,N,1>>
+                     (t, tc1, tc2);
+    case 22 : return std::make_shared<ga_instruction_matrix_mult_fixed<2,N,2>>
+                     (t, tc1, tc2);
+    case 23 : return std::make_shared<ga_instruction_matrix_mult_fixed<2,N,3>>
+                     (t, tc1, tc2);
+    case 31 : return std::make_shared<ga_instruction_matrix_mult_fixed<3,N,1>>
+                     (t, tc1, tc2);
+    case 32 : return std::make_shared<ga_instruction_matrix_mult_fixed<3,N,2>>
+                     (t, tc1, tc2);
+    case 33 : return std::make_shared<ga_instruction_matrix_mult_fixed<3,N,3>>
+                     (t, tc1, tc2);
+    default : return std::make_shared<ga_instruction_matrix_mult>
+                     (t, tc1, tc2, N);
+    }
+  }
+
+  pga_instruction ga_instruction_matrix_mult_switch
+  (base_tensor &t, base_tensor &tc1, base_tensor &tc2, size_type n,
+   bool fixed) {
+    if (fixed && tc1.size() % n == 0 && tc2.size() % n == 0
+        && tc1.size() <= 3*n && tc2.size() <= 3*n) {
+      if (n == 2) return ga_instruction_matrix_mult_switch_<2>(t, tc1, tc2);
+      if (n == 3) return ga_instruction_matrix_mult_switch_<3>(t, tc1, tc2);
+    }
+    return std::make_shared<ga_instruction_matrix_mult>(t, tc1, tc2, n);
+  }
+
   // Performs Amij Bnjk -> Cmnik. To be optimized
   struct ga_instruction_matrix_mult_spec : public ga_instruction {
     base_tensor &t, &tc1, &tc2;
@@ -2512,10 +2841,56 @@ namespace getfem {
       : t(t_), tc1(tc1_), tc2(tc2_), n(n_), m(m_), p(p_) {}
   };
 
+  // Performs Ani Bmi -> Cmn for nb elements in the structure-of-arrays
+  // storage of ga_batched_instruction, A and B of sizes s1 x nn and
+  // s2 x nn.
+  static void ga_batch_contraction
+  (scalar_type *pt, const scalar_type *p1, const scalar_type *p2,
+   size_type s1, size_type s2, size_type nn, size_type nb) {
+    size_type s1_nb = s1*nb, s2_nb = s2*nb;
+    for (size_type i = 0; i < s1; ++i)
+      for (size_type j = 0; j < s2; ++j, pt += nb) {
+        const scalar_type *it1 = p1 + i*nb, *it2 = p2 + j*nb;
+        for (size_type b = 0; b < nb; ++b) pt[b] = it1[b] * it2[b];
+        for (size_type k = 1; k < nn; ++k) {
+          it1 += s1_nb; it2 += s2_nb;
+          for (size_type b = 0; b < nb; ++b) pt[b] += it1[b] * it2[b];
+        }
+      }
+  }
+
+  // Same as ga_batch_contraction for a vectorized second tensor of type 2,
+  // nn being n*q (see ga_instruction_contraction_opt0_2).
+  static void ga_batch_contraction_opt0_2
+  (scalar_type *pt, const scalar_type *p1, const scalar_type *p2,
+   size_type s1, size_type s2, size_type n, size_type q, size_type nb) {
+    size_type s2_q = s2/q, s1_qq = s1*q*nb, s2_qq = s2*q*nb;
+    for (size_type i = 0; i < s1; ++i)
+      for (size_type j = 0; j < s2_q; ++j)
+        for (size_type l = 0; l < q; ++l, pt += nb) {
+          const scalar_type *it1 = p1 + (i+l*s1)*nb, *it2 = p2 + j*q*nb;
+          for (size_type b = 0; b < nb; ++b) pt[b] = it1[b] * it2[b];
+          for (size_type m = 1; m < n; ++m) {
+            it1 += s1_qq; it2 += s2_qq;
+            for (size_type b = 0; b < nb; ++b) pt[b] += it1[b] * it2[b];
+          }
+        }
+  }
+
   // Performs Ani Bmi -> Cmn
-  struct ga_instruction_contraction : public ga_instruction {
+  struct ga_instruction_contraction
+    : public ga_instruction, public ga_batched_instruction {
     base_tensor &t, &tc1, &tc2;
     size_type nn;
+    virtual bool batch_operands(std::vector<ga_batch_operand> &operands,
+                                ga_batch_operand &result) const
+    { operands = {tc1, tc2}; result = t; return true; }
+    virtual void exec_batch(scalar_type *pt,
+                            const std::vector<const scalar_type *> &operands,
+                            size_type nb) const {
+      ga_batch_contraction(pt, operands[0], operands[1], tc1.size()/nn,
+                           tc2.size()/nn, nn, nb);
+    }
     virtual int exec() {
       GA_DEBUG_INFO("Instruction: contraction operation of size " << nn);
 #if GA_USES_BLAS
@@ -2554,9 +2929,19 @@ namespace getfem {
   };
 
   // Performs Ani Bmi -> Cmn
-  struct ga_instruction_contraction_opt0_2 : public ga_instruction {
+  struct ga_instruction_contraction_opt0_2
+    : public ga_instruction, public ga_batched_instruction {
     base_tensor &t, &tc1, &tc2;
     size_type n, q;
+    virtual bool batch_operands(std::vector<ga_batch_operand> &operands,
+                                ga_batch_operand &result) const
+    { operands = {tc1, tc2}; result = t; return true; }
+    virtual void exec_batch(scalar_type *pt,
+                            const std::vector<const scalar_type *> &operands,
+                            size_type nb) const {
+      ga_batch_contraction_opt0_2(pt, operands[0], operands[1],
+                                  tc1.size()/(n*q), tc2.size()/(n*q), n, q, nb);
+    }
     virtual int exec() {
       GA_DEBUG_INFO("Instruction: contraction operation of size " << n*q <<
                     " optimized for vectorized second tensor of type 2");
@@ -2594,9 +2979,19 @@ namespace getfem {
 
   // Performs Ani Bmi -> Cmn
   template <int N>
-  struct ga_instruction_contraction_opt0_2_unrolled : public ga_instruction {
+  struct ga_instruction_contraction_opt0_2_unrolled
+    : public ga_instruction, public ga_batched_instruction {
     base_tensor &t, &tc1, &tc2;
     size_type q;
+    virtual bool batch_operands(std::vector<ga_batch_operand> &operands,
+                                ga_batch_operand &result) const
+    { operands = {tc1, tc2}; result = t; return true; }
+    virtual void exec_batch(scalar_type *pt,
+                            const std::vector<const scalar_type *> &operands,
+                            size_type nb) const {
+      ga_batch_contraction_opt0_2(pt, operands[0], operands[1],
+                                  tc1.size()/(N*q), tc2.size()/(N*q), N, q, nb);
+    }
     virtual int exec() {
       GA_DEBUG_INFO("Instruction: unrolled contraction operation of size " << N*q
                     << " optimized for vectorized second tensor of type 2");
@@ -2629,8 +3024,18 @@ namespace getfem {
 
   // Performs Ani Bmi -> Cmn
   template <int N, int Q>
-  struct ga_instruction_contraction_opt0_2_dunrolled : public ga_instruction {
+  struct ga_instruction_contraction_opt0_2_dunrolled
+    : public ga_instruction, public ga_batched_instruction {
     base_tensor &t, &tc1, &tc2;
+    virtual bool batch_operands(std::vector<ga_batch_operand> &operands,
+                                ga_batch_operand &result) const
+    { operands = {tc1, tc2}; result = t; return true; }
+    virtual void exec_batch(scalar_type *pt,
+                            const std::vector<const scalar_type *> &operands,
+                            size_type nb) const {
+      ga_batch_contraction_opt0_2(pt, operands[0], operands[1],
+                                  tc1.size()/(N*Q), tc2.size()/(N*Q), N, Q, nb);
+    }
     virtual int exec() {
       GA_DEBUG_INFO("Instruction: unrolled contraction operation of size " << N*Q
                     << " optimized for vectorized second tensor of type 2");
@@ -2862,8 +3267,17 @@ namespace getfem {
 
   // Performs Ani Bmi -> Cmn. Unrolled operation.
   template<int N> struct ga_instruction_contraction_unrolled
-    : public ga_instruction {
+    : public ga_instruction, public ga_batched_instruction {
     base_tensor &t, &tc1, &tc2;
+    virtual bool batch_operands(std::vector<ga_batch_operand> &operands,
+                                ga_batch_operand &result) const
+    { operands = {tc1, tc2}; result = t; return true; }
+    virtual void exec_batch(scalar_type *pt,
+                            const std::vector<const scalar_type *> &operands,
+                            size_type nb) const {
+      ga_batch_contraction(pt, operands[0], operands[1], tc1.size()/N,
+                           tc2.size()/N, N, nb);
+    }
     virtual int exec() {
       GA_DEBUG_INFO("Instruction: unrolled contraction operation of size " << N);
       size_type s1 = tc1.size()/N, s2 = tc2.size()/N;
@@ -2942,8 +3356,17 @@ namespace getfem {
   // Performs Ani Bmi -> Cmn. Automatically doubly unrolled operation
   // (for uniform meshes).
   template<int N, int S2> struct ga_ins_red_d_unrolled
-    : public ga_instruction {
+    : public ga_instruction, public ga_batched_instruction {
     base_tensor &t, &tc1, &tc2;
+    virtual bool batch_operands(std::vector<ga_batch_operand> &operands,
+                                ga_batch_operand &result) const
+    { operands = {tc1, tc2}; result = t; return true; }
+    virtual void exec_batch(scalar_type *pt,
+                            const std::vector<const scalar_type *> &operands,
+                            size_type nb) const {
+      ga_batch_contraction(pt, operands[0], operands[1], tc1.size()/N, S2, N,
+                           nb);
+    }
     virtual int exec() {
       GA_DEBUG_INFO("Instruction: doubly unrolled contraction operation of size "
                     << S2 << "x" << N);
@@ -3478,9 +3901,31 @@ namespace getfem {
       : t(t_), tc1(tc1_), tc2(tc2_), nn(n_) {}
   };
 
+  // Performs Aij Bkl -> Cijkl for nb elements in the structure-of-arrays
+  // storage of ga_batched_instruction, A and B of sizes s1 and s2.
+  static void ga_batch_simple_tmult
+  (scalar_type *pt, const scalar_type *p1, const scalar_type *p2,
+   size_type s1, size_type s2, size_type nb) {
+    for (size_type j = 0; j < s2; ++j, p2 += nb) {
+      const scalar_type *it1 = p1;
+      for (size_type i = 0; i < s1; ++i, pt += nb, it1 += nb)
+        for (size_type b = 0; b < nb; ++b) pt[b] = it1[b] * p2[b];
+    }
+  }
+
   // Performs Aij Bkl -> Cijkl
-  struct ga_instruction_simple_tmult : public ga_instruction {
+  struct ga_instruction_simple_tmult
+    : public ga_instruction, public ga_batched_instruction {
     base_tensor &t, &tc1, &tc2;
+    virtual bool batch_operands(std::vector<ga_batch_operand> &operands,
+                                ga_batch_operand &result) const
+    { operands = {tc1, tc2}; result = t; return true; }
+    virtual void exec_batch(scalar_type *pt,
+                            const std::vector<const scalar_type *> &operands,
+                            size_type nb) const {
+      ga_batch_simple_tmult(pt, operands[0], operands[1], tc1.size(),
+                            tc2.size(), nb);
+    }
     virtual int exec() {
       GA_DEBUG_INFO("Instruction: simple tensor product");
       size_type s1 = tc1.size();
@@ -3509,8 +3954,16 @@ namespace getfem {
 
   // Performs Aij Bkl -> Cijkl, partially unrolled version
   template<int S1> struct ga_instruction_simple_tmult_unrolled
-  : public ga_instruction {
+  : public ga_instruction, public ga_batched_instruction {
     base_tensor &t, &tc1, &tc2;
+    virtual bool batch_operands(std::vector<ga_batch_operand> &operands,
+                                ga_batch_operand &result) const
+    { operands = {tc1, tc2}; result = t; return true; }
+    virtual void exec_batch(scalar_type *pt,
+                            const std::vector<const scalar_type *> &operands,
+                            size_type nb) const {
+      ga_batch_simple_tmult(pt, operands[0], operands[1], S1, tc2.size(), nb);
+    }
     virtual int exec() {
       size_type s2 = tc2.size();
       GA_DEBUG_ASSERT(tc1.size() == S1,
@@ -4131,7 +4584,15 @@ namespace getfem {
       : t(t_), E(E_), coeff(coeff_) {}
   };
 
-  struct ga_instruction_vector_assembly_mf : public ga_instruction
+  inline void ga_atomic_add(scalar_type &a, const scalar_type &b) {
+#ifdef GETFEM_HAS_OPENMP
+    #pragma omp atomic
+#endif
+    a += b;
+  }
+
+  struct ga_instruction_vector_assembly_mf
+    : public ga_instruction, public ga_batched_instruction
   {
     const base_tensor &t;
     base_vector &VI, &Vi;
@@ -4143,6 +4604,11 @@ namespace getfem {
     const size_type &nbpt, &ipt;
     base_vector elem;
     const bool interpolate;
+    ga_instruction_set *pgis = nullptr; // For atomic additions only
+    virtual bool batch_operands(std::vector<ga_batch_operand> &operands,
+                                ga_batch_operand &) const
+    { operands = {t, coeff}; return !interpolate; }
+    virtual bool batch_sum_on_points() const { return true; }
     virtual int exec() {
       GA_DEBUG_INFO("Instruction: vector term assembly for fem variable");
       bool empty_weight = (coeff == scalar_type(0));
@@ -4167,9 +4633,15 @@ namespace getfem {
                         I->first() << "+"<< mf->nb_basic_dof());
         auto itr = elem.cbegin();
         auto itw = V.begin() + I->first();
-        for (const auto &dof : mf->ind_scalar_basic_dof_of_element(cv_1))
-          for (size_type q = 0; q < qmult; ++q)
+        if (pgis && pgis->atomic_scatter) {
+          for (const auto &dof : mf->ind_scalar_basic_dof_of_element(cv_1))
+            for (size_type q = 0; q < qmult; ++q)
+              ga_atomic_add(*(itw+dof+q), *itr++);
+        } else {
+          for (const auto &dof : mf->ind_scalar_basic_dof_of_element(cv_1))
+            for (size_type q = 0; q < qmult; ++q)
               *(itw+dof+q) += *itr++;
+        }
         GMM_ASSERT1(itr == elem.end(), "Internal error");
       }
       return 0;
@@ -4199,7 +4671,8 @@ namespace getfem {
     const bool false_=false;
   };
 
-  struct ga_instruction_vector_assembly_imd : public ga_instruction {
+  struct ga_instruction_vector_assembly_imd
+    : public ga_instruction, public ga_batched_instruction {
     const base_tensor &t;
     base_vector &V;
     const fem_interpolation_context &ctx;
@@ -4208,6 +4681,9 @@ namespace getfem {
     scalar_type &coeff;
     const size_type &ipt;
     const bool initialize;
+    virtual bool batch_operands(std::vector<ga_batch_operand> &operands,
+                                ga_batch_operand &) const
+    { operands = {t, coeff}; return true; }
     virtual int exec() {
       GA_DEBUG_INFO("Instruction: vector term assembly for im_data variable");
       size_type cv = ctx.convex_num();
@@ -4233,11 +4709,16 @@ namespace getfem {
     {}
   };
 
-  struct ga_instruction_vector_assembly : public ga_instruction {
+  struct ga_instruction_vector_assembly
+    : public ga_instruction, public ga_batched_instruction {
     const base_tensor &t;
     base_vector &V;
     const gmm::sub_interval &I;
     scalar_type &coeff;
+    virtual bool batch_operands(std::vector<ga_batch_operand> &operands,
+                                ga_batch_operand &) const
+    { operands = {t, coeff}; return true; }
+    virtual bool batch_sum_on_points() const { return true; }
     virtual int exec() {
       GA_DEBUG_INFO("Instruction: vector term assembly for "
                     "fixed size variable");
@@ -4297,7 +4778,8 @@ namespace getfem {
   inline void add_elem_matrix
   (MAT &K, const std::vector<size_type> &dofs1,
    const std::vector<size_type> &dofs2, std::vector<size_type> &/*dofs1_sort*/,
-   base_vector &elem, scalar_type threshold, size_type /* N */) {
+   base_vector &elem, scalar_type threshold, size_type /* N */,
+   std::vector<size_type> * /* slots */ = nullptr) {
     base_vector::const_iterator it = elem.cbegin();
     for (const size_type &dof2 : dofs2)
       for (const size_type &dof1 : dofs1) {
@@ -4314,14 +4796,46 @@ namespace getfem {
   //   return  int((*the_indto_sort)[aa]) - int((*the_indto_sort)[bb]);
   // }
 
-  inline void add_elem_matrix
+  // If slots is given, the positions of the entries in the columns of K are
+  // stored in it and, if all of them are still valid, the element matrix is
+  // directly added at these positions (fixed sparsity pattern). The whole
+  // element matrix is then inserted whatever the threshold, in order for
+  // the pattern to be independent of the values. Return true if the stored
+  // positions have been used.
+  inline bool add_elem_matrix
   (gmm::col_matrix<gmm::rsvector<scalar_type>> &K,
    const std::vector<size_type> &dofs1, const std::vector<size_type> &dofs2,
    std::vector<size_type> &dofs1_sort,
-   base_vector &elem, scalar_type threshold, size_type N) {
+   base_vector &elem, scalar_type threshold, size_type N,
+   std::vector<size_type> *slots = nullptr) {
 
     size_type s1 = dofs1.size();
 
+    if (slots) {
+      bool valid = (slots->size() == s1 * dofs2.size());
+      auto its = slots->cbegin();
+      for (const size_type &dof2 : dofs2) {
+        if (!valid) break;
+        const std::vector<gmm::elt_rsvector_<scalar_type>> &col = K[dof2];
+        for (const size_type &dof1 : dofs1) {
+          if (*its >= col.size() || col[*its].c != dof1)
+            { valid = false; break; }
+          ++its;
+        }
+      }
+      if (valid) {
+        its = slots->cbegin();
+        base_vector::const_iterator it = elem.cbegin();
+        for (const size_type &dof2 : dofs2) {
+          std::vector<gmm::elt_rsvector_<scalar_type>> &col = K[dof2];
+          for (size_type i = 0; i < s1; ++i, ++its, ++it)
+            col[*its].e += *it;
+        }
+        return true;
+      }
+      threshold = scalar_type(-1);
+    }
+
     dofs1_sort.resize(s1);
     for (size_type i = 0; i < s1; ++i) { // insertion sort
       size_type j = i, k = j-1;
@@ -4399,6 +4913,58 @@ namespace getfem {
         }
       }
     }
+
+    if (slots) { // positions of the entries, now all present in K
+      slots->resize(s1 * dofs2.size());
+      auto its = slots->begin();
+      for (const size_type &dof2 : dofs2) {
+        const std::vector<gmm::elt_rsvector_<scalar_type>> &col = K[dof2];
+        for (const size_type &dof1 : dofs1) {
+          auto itc = std::lower_bound
+            (col.begin(), col.end(), dof1,
+             [](const gmm::elt_rsvector_<scalar_type> &e, size_type c)
+             { return e.c < c; });
+          *its++ = size_type(itc - col.begin());
+        }
+      }
+    }
+    return false;
+  }
+
+
+  // Concurrent addition of an element matrix into K, whose sparsity pattern
+  // is not modified. The positions of the entries are taken from slots (and
+  // updated if necessary). Return false, without any addition, if some
+  // entries are not in the sparsity pattern of K.
+  inline bool add_elem_matrix_atomic
+  (gmm::col_matrix<gmm::rsvector<scalar_type>> &K,
+   const std::vector<size_type> &dofs1, const std::vector<size_type> &dofs2,
+   const base_vector &elem, std::vector<size_type> &slots) {
+    size_type s1 = dofs1.size();
+    slots.resize(s1 * dofs2.size(), size_type(-1));
+    auto its = slots.begin();
+    for (const size_type &dof2 : dofs2) {
+      const std::vector<gmm::elt_rsvector_<scalar_type>> &col = K[dof2];
+      for (const size_type &dof1 : dofs1) {
+        if (*its >= col.size() || col[*its].c != dof1) {
+          auto itc = std::lower_bound
+            (col.begin(), col.end(), dof1,
+             [](const gmm::elt_rsvector_<scalar_type> &e, size_type c)
+             { return e.c < c; });
+          if (itc == col.end() || itc->c != dof1) return false;
+          *its = size_type(itc - col.begin());
+        }
+        ++its;
+      }
+    }
+    its = slots.begin();
+    base_vector::const_iterator it = elem.cbegin();
+    for (const size_type &dof2 : dofs2) {
+      std::vector<gmm::elt_rsvector_<scalar_type>> &col = K[dof2];
+      for (size_type i = 0; i < s1; ++i, ++its, ++it)
+        ga_atomic_add(col[*its].e, *it);
+    }
+    return true;
   }
 
 
@@ -4502,14 +5068,50 @@ namespace getfem {
     for (size_type i=0; i < size; ++i) dofs[i] += i;
   }
 
-  struct ga_instruction_matrix_assembly_base : public ga_instruction {
+  struct ga_instruction_matrix_assembly_base
+    : public ga_instruction, public ga_batched_instruction {
     const base_tensor &t;
     const fem_interpolation_context &ctx1, &ctx2;
     const scalar_type &alpha1, &alpha2, &coeff;
     const size_type &nbpt, &ipt;
     base_vector elem;
     bool interpolate;
+    virtual bool batch_operands(std::vector<ga_batch_operand> &operands,
+                                ga_batch_operand &) const
+    { operands = {t, coeff}; return !interpolate && &ctx1 == &ctx2; }
+    virtual bool batch_sum_on_points() const { return true; }
     std::vector<size_type> dofs1, dofs2, dofs1_sort;
+    // Positions of the entries of the element matrices in the assembled
+    // matrix, for each element and each call to add_elem_matrix (fixed
+    // sparsity pattern option of the workspace).
+    bool use_slots = false;
+    std::vector<std::vector<size_type>> slots;
+    std::vector<size_type> *slots_of_element(size_type k = 0) {
+      size_type cv = ctx1.convex_num();
+      if (!use_slots || interpolate || &ctx1 != &ctx2
+          || cv == size_type(-1)) return nullptr;
+      size_type i = cv*3 + k; // At most three calls for a same element
+      if (slots.size() <= i) slots.resize(i+1);
+      return &(slots[i]);
+    }
+    ga_instruction_set *pgis = nullptr; // Set if use_slots
+    void add_element_matrix(model_real_sparse_matrix &K,
+                            const std::vector<size_type> &d1,
+                            const std::vector<size_type> &d2,
+                            scalar_type threshold, size_type N,
+                            size_type k = 0) {
+      std::vector<size_type> *pslots = slots_of_element(k);
+      bool in_pattern;
+      if (pgis && pgis->atomic_scatter) {
+        in_pattern = pslots && add_elem_matrix_atomic(K, d1, d2, elem, *pslots);
+        if (!in_pattern)
+          pgis->deferred_matrices.push_back({&K, d1, d2, elem});
+      } else
+        in_pattern = add_elem_matrix(K, d1, d2, dofs1_sort, elem, threshold,
+                                     N, pslots);
+      if (pslots) ++(in_pattern ? pgis->nb_pattern_hits
+                                : pgis->nb_pattern_misses);
+    }
     void add_tensor_to_element_matrix(bool initialize, bool empty_weight) {
       if (initialize) {
         if (empty_weight) elem.resize(0);
@@ -4558,7 +5160,7 @@ namespace getfem {
         GA_DEBUG_ASSERT(I1->size() && I2->size(), "Internal error");
 
         scalar_type ninf = gmm::vect_norminf(elem);
-        if (ninf == scalar_type(0)) return 0;
+        if (ninf == scalar_type(0) && !use_slots) return 0;
 
         size_type s1 = t.sizes()[0], s2 = t.sizes()[1];
         size_type cv1 = ctx1.convex_num(), cv2 = ctx2.convex_num();
@@ -4571,10 +5173,10 @@ namespace getfem {
                              mf1->ind_scalar_basic_dof_of_element(cv1));
         if (mf1 == mf2 && cv1 == cv2) {
           if (ifirst1 == ifirst2) {
-            add_elem_matrix(K, dofs1, dofs1, dofs1_sort, elem, ninf*1E-14, N);
+            add_element_matrix(K, dofs1, dofs1, ninf*1E-14, N);
           } else {
             populate_dofs_vector(dofs2, dofs1.size(), ifirst2 - ifirst1, dofs1);
-            add_elem_matrix(K, dofs1, dofs2, dofs1_sort, elem, ninf*1E-14, N);
+            add_element_matrix(K, dofs1, dofs2, ninf*1E-14, N);
           }
         } else {
           N = std::max(N, ctx2.N());
@@ -4582,7 +5184,7 @@ namespace getfem {
           if (qmult2 > 1) qmult2 /= mf2->fem_of_element(cv2)->target_dim();
           populate_dofs_vector(dofs2, s2, ifirst2, qmult2,        // --> dofs2
                                mf2->ind_scalar_basic_dof_of_element(cv2));
-          add_elem_matrix(K, dofs1, dofs2, dofs1_sort, elem, ninf*1E-14, N);
+          add_element_matrix(K, dofs1, dofs2, ninf*1E-14, N);
         }
       }
       return 0;
@@ -4663,6 +5265,8 @@ namespace getfem {
     const im_data *imd1;
     const mesh_fem * const mf2__, * const &mf2;
     const bool &reduced_mf2; // ref to mf2->is_reduced()
+    // One term for each integration point
+    virtual bool batch_sum_on_points() const { return false; }
     virtual int exec() {
       GA_DEBUG_INFO("Instruction: matrix term assembly");
       if (!ctx1.is_convex_num_valid() || !ctx2.is_convex_num_valid()) return 0;
@@ -4671,7 +5275,7 @@ namespace getfem {
       add_tensor_to_element_matrix(true, empty_weight); // t --> elem
 
       scalar_type ninf = gmm::vect_norminf(elem);
-      if (ninf == scalar_type(0)) return 0;
+      if (ninf == scalar_type(0) && !use_slots) return 0;
 
       model_real_sparse_matrix &K = reduced_mf2 ? Kxu : Kxr;
       GA_DEBUG_ASSERT(I1->size() && I2->size(), "Internal error");
@@ -4685,7 +5289,7 @@ namespace getfem {
       if (qmult2 > 1) qmult2 /= mf2->fem_of_element(cv2)->target_dim();
       populate_dofs_vector(dofs2, s2, ifirst2, qmult2,     // --> dofs2
                            mf2->ind_scalar_basic_dof_of_element(cv2));
-      add_elem_matrix(K, dofs1, dofs2, dofs1_sort, elem, ninf*1E-14, ctx2.N());
+      add_element_matrix(K, dofs1, dofs2, ninf*1E-14, ctx2.N());
       return 0;
     }
 
@@ -4724,6 +5328,8 @@ namespace getfem {
     const mesh_fem * const &mf1, *const mf1__;
     const bool &reduced_mf1; // ref to mf1->is_reduced()
     const im_data *imd2;
+    // One term for each integration point
+    virtual bool batch_sum_on_points() const { return false; }
     virtual int exec() {
       GA_DEBUG_INFO("Instruction: matrix term assembly");
       if (!ctx1.is_convex_num_valid() || !ctx2.is_convex_num_valid()) return 0;
@@ -4732,7 +5338,7 @@ namespace getfem {
       add_tensor_to_element_matrix(true, empty_weight); // t --> elem
 
       scalar_type ninf = gmm::vect_norminf(elem);
-      if (ninf == scalar_type(0)) return 0;
+      if (ninf == scalar_type(0) && !use_slots) return 0;
 
       model_real_sparse_matrix &K = reduced_mf1 ? Kux : Krx;
       GA_DEBUG_ASSERT(I1->size() && I2->size(), "Internal error");
@@ -4746,7 +5352,7 @@ namespace getfem {
       populate_dofs_vector(dofs1, s1, ifirst1, qmult1,     // --> dofs1
                            mf1->ind_scalar_basic_dof_of_element(cv1));
       populate_contiguous_dofs_vector(dofs2, s2, ifirst2); // --> dofs2
-      add_elem_matrix(K, dofs1, dofs2, dofs1_sort, elem, ninf*1E-14, ctx1.N());
+      add_element_matrix(K, dofs1, dofs2, ninf*1E-14, ctx1.N());
       return 0;
     }
 
@@ -4785,6 +5391,8 @@ namespace getfem {
     model_real_sparse_matrix &K;
     const gmm::sub_interval &I1, &I2;
     const im_data *imd1, *imd2;
+    // One term for each integration point
+    virtual bool batch_sum_on_points() const { return false; }
     virtual int exec() {
       GA_DEBUG_INFO("Instruction: matrix term assembly");
       GA_DEBUG_ASSERT(I1.size() && I2.size(), "Internal error");
@@ -4841,7 +5449,7 @@ namespace getfem {
         GA_DEBUG_ASSERT(I1.size() && I2.size(), "Internal error");
 
         scalar_type ninf = gmm::vect_norminf(elem);
-        if (ninf == scalar_type(0)) return 0;
+        if (ninf == scalar_type(0) && !use_slots) return 0;
 
         size_type cv1 = ctx1.convex_num(), cv2 = ctx2.convex_num(), N=ctx1.N();
         if (cv1 == size_type(-1)) return 0;
@@ -4851,18 +5459,18 @@ namespace getfem {
 
         if (pmf2 == pmf1 && cv1 == cv2) {
           if (I1.first() == I2.first()) {
-            add_elem_matrix(K, dofs1, dofs1, dofs1_sort, elem, ninf*1E-14, N);
+            add_element_matrix(K, dofs1, dofs1, ninf*1E-14, N);
           } else {
             populate_dofs_vector(dofs2, dofs1.size(), I2.first() - I1.first(),
                                  dofs1);
-            add_elem_matrix(K, dofs1, dofs2, dofs1_sort, elem, ninf*1E-14, N);
+            add_element_matrix(K, dofs1, dofs2, ninf*1E-14, N);
           }
         } else {
           if (cv2 == size_type(-1)) return 0;
           auto &ct2 = pmf2->ind_scalar_basic_dof_of_element(cv2);
           GA_DEBUG_ASSERT(ct2.size() == t.sizes()[1], "Internal error");
           populate_dofs_vector(dofs2, ct2.size(), I2.first(), ct2);
-          add_elem_matrix(K, dofs1, dofs2, dofs1_sort, elem, ninf*1E-14, N);
+          add_element_matrix(K, dofs1, dofs2, ninf*1E-14, N);
         }
       }
       return 0;
@@ -4902,7 +5510,7 @@ namespace getfem {
         GA_DEBUG_ASSERT(I1.size() && I2.size(), "Internal error");
 
         scalar_type ninf = gmm::vect_norminf(elem);
-        if (ninf == scalar_type(0)) return 0;
+        if (ninf == scalar_type(0) && !use_slots) return 0;
         size_type s1 = t.sizes()[0], s2 = t.sizes()[1], N = ctx1.N();
 
         size_type cv1 = ctx1.convex_num(), cv2 = ctx2.convex_num();
@@ -4913,7 +5521,7 @@ namespace getfem {
                              pmf1->ind_scalar_basic_dof_of_element(cv1));
 
         if (pmf2 == pmf1 && cv1 == cv2 && I1.first() == I2.first()) {
-          add_elem_matrix(K, dofs1, dofs1, dofs1_sort, elem, ninf*1E-14, N);
+          add_element_matrix(K, dofs1, dofs1, ninf*1E-14, N);
         } else {
           if (pmf2 == pmf1 && cv1 == cv2) {
             populate_dofs_vector(dofs2, dofs1.size(), I2.first() - I1.first(),
@@ -4925,7 +5533,7 @@ namespace getfem {
             populate_dofs_vector(dofs2, s2, I2.first(), qmult2,      // --> dofs2
                                  pmf2->ind_scalar_basic_dof_of_element(cv2));
           }
-          add_elem_matrix(K, dofs1, dofs2, dofs1_sort, elem, ninf*1E-14, N);
+          add_element_matrix(K, dofs1, dofs2, ninf*1E-14, N);
         }
       }
       return 0;
@@ -4976,7 +5584,7 @@ namespace getfem {
         GA_DEBUG_ASSERT(I1.size() && I2.size(), "Internal error");
 
         scalar_type ninf = gmm::vect_norminf(elem) * 1E-14;
-        if (ninf == scalar_type(0)) return 0;
+        if (ninf == scalar_type(0) && !use_slots) return 0;
         size_type N = ctx1.N();
         size_type cv1 = ctx1.convex_num(), cv2 = ctx2.convex_num();
         size_type i1 = I1.first(), i2 = I2.first();
@@ -4991,14 +5599,14 @@ namespace getfem {
                                pmf2->ind_scalar_basic_dof_of_element(cv2));
         }
         std::vector<size_type> &dofs2_ = same_dofs ? dofs1 : dofs2;
-        add_elem_matrix(K, dofs1, dofs2_, dofs1_sort, elem, ninf, N);
+        add_element_matrix(K, dofs1, dofs2_, ninf, N);
         for (size_type i = 0; i < ss1; ++i) (dofs1[i])++;
         if (!same_dofs) for (size_type i = 0; i < ss2; ++i) (dofs2[i])++;
-        add_elem_matrix(K, dofs1, dofs2_, dofs1_sort, elem, ninf, N);
+        add_element_matrix(K, dofs1, dofs2_, ninf, N, 1);
         if (QQ >= 3) {
           for (size_type i = 0; i < ss1; ++i) (dofs1[i])++;
           if (!same_dofs) for (size_type i = 0; i < ss2; ++i) (dofs2[i])++;
-          add_elem_matrix(K, dofs1, dofs2_, dofs1_sort, elem, ninf, N);
+          add_element_matrix(K, dofs1, dofs2_, ninf, N, 2);
         }
       }
       return 0;
@@ -5272,6 +5880,15 @@ namespace getfem {
     }
   }
 
+  void ga_update_extended_vars(const ga_workspace &workspace,
+                               ga_instruction_set &gis) {
+    for (auto &&var : gis.really_extended_vars) {
+      const mesh_fem *mf = workspace.associated_mf(var.first);
+      GMM_ASSERT1(mf && mf->is_reduced(), "Internal error");
+      mf->extend_vector(workspace.value(var.first), var.second);
+    }
+  }
+
   static void ga_clear_node_list
   (pga_tree_node pnode, std::map<scalar_type,
    std::list<pga_tree_node> > &node_list) {
@@ -5284,14 +5901,116 @@ namespace getfem {
       ga_clear_node_list(pnode->children[i], node_list);
   }
 
-  // workspace argument  is not const because of declaration of temporary
-  // unreduced variables
+  // Attributes the instructions of rmi having no origin yet to the
+  // expression expr (profiling only).
+  static void ga_set_instruction_origins
+  (ga_instruction_set::region_mim_instructions &rmi, const std::string &expr) {
+    auto set_origins = [&expr](const std::vector<pga_instruction> &il,
+                               std::vector<std::string> &origins) {
+      origins.resize(il.size());
+      for (std::string &origin : origins)
+        if (origin.empty()) origin = expr;
+    };
+    set_origins(rmi.begin_instructions, rmi.begin_origins);
+    set_origins(rmi.elt_instructions, rmi.elt_origins);
+    set_origins(rmi.instructions, rmi.origins);
+  }
+
+  // Peephole fusion of instructions at the integration points. If the
+  // tensor of the node pnode has been computed by the last instruction of
+  // rmi as the product of a tensor by a scalar, this instruction is removed
+  // and its operand and scalar factor are returned, for the consumer of the
+  // tensor to apply the factor itself. The tensor of pnode is then no longer
+  // computed, so pnode is removed from the nodes available for reuse. The
+  // caller has to check that no other instruction reads this tensor.
+  static bool ga_extract_scalar_mult
+  (const pga_tree_node pnode, ga_instruction_set::region_mim_instructions &rmi,
+   base_tensor *&tc, const scalar_type *&c) {
+    if (pnode->t.is_copied || rmi.instructions.empty()) return false;
+    auto pgsm = std::dynamic_pointer_cast<ga_instruction_scalar_mult>
+      (rmi.instructions.back());
+    if (!pgsm || &(pgsm->t) != &(pnode->tensor())) return false;
+    // The consumer reads the operand with the shape of the tensor of pnode
+    if (pgsm->tc1.sizes() != pnode->tensor().sizes()) return false;
+    tc = &(pgsm->tc1); c = &(pgsm->c);
+    rmi.instructions.pop_back();
+    if (rmi.origins.size() > rmi.instructions.size()) // profiling
+      rmi.origins.resize(rmi.instructions.size());
+    rmi.node_list[pnode->hash_value].remove(pnode);
+    return true;
+  }
+
+  // Fusion of the last instruction of rmi, computing the tensor of pnode,
+  // with the multiplication by a scalar computing its operand, if it is the
+  // previous instruction:
+  //   t1 = a*t0; t = b*t1   -->   c = a*b; t = c*t0
+  //   t1 = a*t0; t = t2 + t1 (or t2 - t1)   -->   t = t2 + a*t0 (t2 - a*t0)
+  // The intermediary tensor t1 is not computed anymore.
+  static void ga_fuse_instructions
+  (const pga_tree_node pnode, ga_instruction_set &gis,
+   ga_instruction_set::region_mim_instructions &rmi) {
+    if (pnode->t.is_copied || rmi.instructions.size() < 2) return;
+    pga_instruction pgai = rmi.instructions.back();
+    const base_tensor *tc1 = 0, *tc2 = 0;
+    auto pgsm = std::dynamic_pointer_cast<ga_instruction_scalar_mult>(pgai);
+    auto pgad = std::dynamic_pointer_cast<ga_instruction_add>(pgai);
+    auto pgsb = std::dynamic_pointer_cast<ga_instruction_sub>(pgai);
+    if (pgsm && &(pgsm->t) == &(pnode->tensor()))
+      tc1 = &(pgsm->tc1);
+    else if (pgad && &(pgad->t) == &(pnode->tensor()))
+      { tc1 = &(pgad->tc2); tc2 = &(pgad->tc1); }
+    else if (pgsb && &(pgsb->t) == &(pnode->tensor()))
+      { tc1 = &(pgsb->tc2); tc2 = &(pgsb->tc1); }
+    else return;
+
+    // Child computing the operand tc1, whose tensor has to be read only by
+    // the last instruction.
+    pga_tree_node pchild = 0;
+    for (const pga_tree_node &child : pnode->children)
+      if (&(child->tensor()) == tc1) {
+        if (pchild) return;
+        pchild = child;
+      }
+    if (!pchild || (tc2 && tc2 == tc1)) return;
+
+    rmi.instructions.pop_back();
+    base_tensor *tc; const scalar_type *c;
+    if (!ga_extract_scalar_mult(pchild, rmi, tc, c)) {
+      rmi.instructions.push_back(std::move(pgai));
+      return;
+    }
+    if (pgsm) {
+      gis.fused_factors.push_back(scalar_type(0));
+      scalar_type &ab = gis.fused_factors.back();
+      rmi.instructions.push_back
+        (std::make_shared<ga_instruction_scalar_scalar_mult>(ab, *c,
+                                                             pgsm->c));
+      rmi.instructions.push_back
+        (ga_instruction_scalar_mult_switch
+         (pnode->tensor(), *tc, ab,
+          gis.size_specialized && pnode->test_function_type == 0));
+    } else
+      rmi.instructions.push_back
+        (std::make_shared<ga_instruction_add_scaled>
+         (pnode->tensor(), *tc2, *tc, *c,
+          pgad ? scalar_type(1) : scalar_type(-1)));
+  }
+
   static void ga_compile_node(const pga_tree_node pnode,
                               ga_workspace &workspace,
                               ga_instruction_set &gis,
                               ga_instruction_set::region_mim_instructions &rmi,
                               const mesh &m, bool function_case,
-                              ga_if_hierarchy &if_hierarchy) {
+                              ga_if_hierarchy &if_hierarchy);
+
+  // workspace argument  is not const because of declaration of temporary
+  // unreduced variables
+  static void ga_compile_node_(const pga_tree_node pnode,
+                               ga_workspace &workspace,
+                               ga_instruction_set &gis,
+                               ga_instruction_set::region_mim_instructions &rmi,
+                               const mesh &m, bool function_case,
+                               ga_if_hierarchy &if_hierarchy) {
 
     if (pnode->node_type == GA_NODE_PREDEF_FUNC ||
         pnode->node_type == GA_NODE_OPERATOR ||
@@ -5314,6 +6033,8 @@ namespace getfem {
     fem_interpolation_context *pctx1 = 0, *pctx2 = 0;
     bool tensor_to_clear = false;
     bool tensor_to_adapt = false;
+    // Size specialized instructions for the tensors of fixed size
+    bool fixed_size = gis.size_specialized && pnode->test_function_type == 0;
 
     if (pnode->test_function_type) {
       if (pnode->name_test1.size())
@@ -5406,9 +6127,11 @@ namespace getfem {
         // cout << " and "; ga_print_node(pnode1, cout); cout << endl;
         if (sub_tree_are_equal(pnode, pnode1, workspace, 1)) {
           pnode->t.set_to_copy(pnode1->t);
+          rmi.reused_tensors.insert(&(pnode1->tensor()));
           return;
         }
         if (sub_tree_are_equal(pnode, pnode1, workspace, 2)) {
+          rmi.reused_tensors.insert(&(pnode1->tensor()));
           // cout << "confirmed with transpose" << endl;
           if (pnode->nb_test_functions() == 2) {
             if (pgai) { // resize instruction if needed
@@ -6528,8 +7251,9 @@ namespace getfem {
            pgai = std::make_shared<ga_instruction_scalar_add>
              (pnode->tensor()[0], child0->tensor()[0], child1->tensor()[0]);
          } else {
-           pgai = std::make_shared<ga_instruction_add>
-             (pnode->tensor(), child0->tensor(), child1->tensor());
+           pgai = ga_instruction_add_switch
+             (pnode->tensor(), child0->tensor(), child1->tensor(),
+              fixed_size);
          }
          if (child0->t.sparsity() == child1->t.sparsity()
              && child0->t.qdim() == child1->t.qdim())
@@ -6546,8 +7270,9 @@ namespace getfem {
            pgai = std::make_shared<ga_instruction_scalar_sub>
              (pnode->tensor()[0], child0->tensor()[0], child1->tensor()[0]);
          } else {
-           pgai = std::make_shared<ga_instruction_sub>
-             (pnode->tensor(), child0->tensor(), child1->tensor());
+           pgai = ga_instruction_sub_switch
+             (pnode->tensor(), child0->tensor(), child1->tensor(),
+              fixed_size);
          }
          if (child0->t.sparsity() == child1->t.sparsity()
              && child0->t.qdim() == child1->t.qdim())
@@ -6561,8 +7286,9 @@ namespace getfem {
            pgai = std::make_shared<ga_instruction_scalar_scalar_mult>
              (pnode->tensor()[0], child0->tensor()[0], minus);
          } else {
-           pgai = std::make_shared<ga_instruction_scalar_mult>
-             (pnode->tensor(), child0->tensor(), minus);
+           pgai = ga_instruction_scalar_mult_switch
+             (pnode->tensor(), child0->tensor(), minus,
+              fixed_size);
          }
          pnode->t.set_sparsity(child0->t.sparsity(), child0->t.qdim());
          rmi.instructions.push_back(std::move(pgai));
@@ -6589,13 +7315,15 @@ namespace getfem {
              }
              else if (child0->tensor().size() == 1) {
                pnode->t.set_sparsity(child1->t.sparsity(), child1->t.qdim());
-               pgai = std::make_shared<ga_instruction_scalar_mult>
-                 (pnode->tensor(), child1->tensor(), child0->tensor()[0]);
+               pgai = ga_instruction_scalar_mult_switch
+                 (pnode->tensor(), child1->tensor(), child0->tensor()[0],
+                  fixed_size);
              }
              else if (child1->tensor().size() == 1) {
                pnode->t.set_sparsity(child0->t.sparsity(), child0->t.qdim());
-               pgai = std::make_shared<ga_instruction_scalar_mult>
-                 (pnode->tensor(), child0->tensor(), child1->tensor()[0]);
+               pgai = ga_instruction_scalar_mult_switch
+                 (pnode->tensor(), child0->tensor(), child1->tensor()[0],
+                  fixed_size);
              }
              else if (pnode->test_function_type < 3) {
                if (tps0 == 1) {
@@ -6683,8 +7411,9 @@ namespace getfem {
                      (pnode->tensor(), child0->tensor(), child1->tensor());
                } else {
                  if (child1->test_function_type == 0)
-                   pgai = std::make_shared<ga_instruction_matrix_mult>
-                     (pnode->tensor(), child0->tensor(), child1->tensor(), s2);
+                   pgai = ga_instruction_matrix_mult_switch
+                     (pnode->tensor(), child0->tensor(), child1->tensor(), s2,
+                      fixed_size);
                  else
                    pgai = std::make_shared<ga_instruction_matrix_mult_spec>
                      (pnode->tensor(), child0->tensor(), child1->tensor(),
@@ -6706,8 +7435,9 @@ namespace getfem {
                       tps1, tps0);
                } else {
                  if (child1->test_function_type == 0)
-                   pgai = std::make_shared<ga_instruction_matrix_mult>
-                     (pnode->tensor(), child0->tensor(), child1->tensor(), s2);
+                   pgai = ga_instruction_matrix_mult_switch
+                     (pnode->tensor(), child0->tensor(), child1->tensor(), s2,
+                      fixed_size);
                  else if (child1->test_function_type == 2)
                    pgai = std::make_shared<ga_instruction_matrix_mult_spec>
                      (pnode->tensor(), child0->tensor(), child1->tensor(),
@@ -7158,7 +7888,23 @@ namespace getfem {
       }
     }
     rmi.node_list[pnode->hash_value].push_back(pnode);
-  } // ga_compile_node
+  } // ga_compile_node_
+
+  static void ga_compile_node(const pga_tree_node pnode,
+                              ga_workspace &workspace,
+                              ga_instruction_set &gis,
+                              ga_instruction_set::region_mim_instructions &rmi,
+                              const mesh &m, bool function_case,
+                              ga_if_hierarchy &if_hierarchy) {
+    ga_compile_node_(pnode, workspace, gis, rmi, m, function_case,
+                     if_hierarchy);
+    ga_fuse_instructions(pnode, gis, rmi);
+    if (gis.profiling) { // The children have already set their origins
+      std::stringstream ss;
+      ga_print_node(pnode, ss);
+      ga_set_instruction_origins(rmi, ss.str());
+    }
+  }
 
   void ga_compile_function(ga_workspace &workspace,
                            ga_instruction_set &gis, bool scalar) {
@@ -7277,6 +8023,7 @@ namespace getfem {
                                 ga_instruction_set &gis) {
     gis.transformations.clear();
     gis.all_instructions.clear();
+    gis.fused_factors.clear();
     for (size_type i = 0; i < workspace.nb_trees(); ++i) {
       const ga_workspace::tree_description &td = workspace.tree_info(i);
       if (td.operation != ga_workspace::ASSEMBLY) {
@@ -7355,8 +8102,8 @@ namespace getfem {
                   ga_instruction_set &gis, size_type order, bool condensation) {
     gis.transformations.clear();
     gis.all_instructions.clear();
+    gis.fused_factors.clear();
     gis.unreduced_terms.clear();
-    workspace.clear_temporary_variable_intervals();
 
     std::map<const ga_instruction_set::region_mim, condensation_description>
       condensations;
@@ -7506,6 +8253,24 @@ namespace getfem {
               }
             } else { // Addition of an assembly instruction
               pga_instruction pgai;
+              // Fusion of a final multiplication by a scalar with the
+              // assembly instruction: the element vector or matrix is
+              // accumulated from the operand with the product of the
+              // coefficients (see ga_extract_scalar_mult).
+              base_tensor *pt_asm = &(root->tensor()), *tc;
+              scalar_type *pcoeff_asm = &(gis.coeff);
+              const scalar_type *c;
+              if (order > 0 && !condensation
+                  && ga_extract_scalar_mult(root, rmi, tc, c)) {
+                gis.fused_factors.push_back(scalar_type(0));
+                pcoeff_asm = &(gis.fused_factors.back());
+                rmi.instructions.push_back
+                  (std::make_shared<ga_instruction_scalar_scalar_mult>
+                   (*pcoeff_asm, gis.coeff, *c));
+                pt_asm = tc;
+              }
+              base_tensor &t_asm = *pt_asm;
+              scalar_type &coeff_asm = *pcoeff_asm;
               switch(order) {
               case 0: {
                 workspace.assembled_tensor() = root->tensor();
@@ -7544,9 +8309,9 @@ namespace getfem {
                       &vgi = rmi.interpolate_infos[intn1]
                                 .groups_info[root->name_test1];
                     pgai = std::make_shared<ga_instruction_vector_assembly_mf>
-                           (root->tensor(), Vr, Vu, ctx,
+                           (t_asm, Vr, Vu, ctx,
                             vgi.I, vgi.mf, vgi.reduced_mf,
-                            gis.coeff, gis.nbpt, gis.ipt, interpolate);
+                            coeff_asm, gis.nbpt, gis.ipt, interpolate);
                     for (const std::string &name
                          : workspace.variable_group(root->name_test1))
                       gis.unreduced_terms.emplace(name, "");
@@ -7558,8 +8323,8 @@ namespace getfem {
                                      (root->name_test1)
                          : workspace.interval_of_variable(root->name_test1);
                     pgai = std::make_shared<ga_instruction_vector_assembly_mf>
-                           (root->tensor(), V, ctx, I, *mf,
-                            gis.coeff, gis.nbpt, gis.ipt, interpolate);
+                           (t_asm, V, ctx, I, *mf,
+                            coeff_asm, gis.nbpt, gis.ipt, interpolate);
                     if (mf->is_reduced())
                       gis.unreduced_terms.emplace(root->name_test1, "");
                   }
@@ -7570,15 +8335,15 @@ namespace getfem {
                   if (!workspace.is_internal_variable(root->name_test1) ||
                       condensation)
                     pgai = std::make_shared<ga_instruction_vector_assembly_imd>
-                           (root->tensor(), Vr, gis.ctx,
+                           (t_asm, Vr, gis.ctx,
                             workspace.interval_of_variable(root->name_test1),
-                            *imd, gis.coeff, gis.ipt);
+                            *imd, coeff_asm, gis.ipt);
                     // Variable root->name_test1 can be internal or not
                 } else {
                   pgai = std::make_shared<ga_instruction_vector_assembly>
-                         (root->tensor(), Vr,
+                         (t_asm, Vr,
                           workspace.interval_of_variable(root->name_test1),
-                          gis.coeff);
+                          coeff_asm);
                 }
                 break;
               }
@@ -7643,23 +8408,23 @@ namespace getfem {
                   if (mf1->get_qdim() == 1 && mf2->get_qdim() == 1)
                     pgai = std::make_shared
                       <ga_instruction_matrix_assembly_standard_scalar>
-                      (root->tensor(), Krr, ctx1, ctx2, I1, I2, mf1, mf2,
-                       alpha1, alpha2, gis.coeff, gis.nbpt, gis.ipt);
+                      (t_asm, Krr, ctx1, ctx2, I1, I2, mf1, mf2,
+                       alpha1, alpha2, coeff_asm, gis.nbpt, gis.ipt);
                   else if (root->sparsity() == 10 && root->t.qdim() == 2)
                     pgai = std::make_shared
                       <ga_instruction_matrix_assembly_standard_vector_opt10<2>>
-                      (root->tensor(), Krr, ctx1, ctx2, I1, I2, mf1, mf2,
-                       alpha1, alpha2, gis.coeff, gis.nbpt, gis.ipt);
+                      (t_asm, Krr, ctx1, ctx2, I1, I2, mf1, mf2,
+                       alpha1, alpha2, coeff_asm, gis.nbpt, gis.ipt);
                   else if (root->sparsity() == 10 && root->t.qdim() == 3)
                     pgai = std::make_shared
                       <ga_instruction_matrix_assembly_standard_vector_opt10<3>>
-                      (root->tensor(), Krr, ctx1, ctx2, I1, I2, mf1, mf2,
-                       alpha1, alpha2, gis.coeff, gis.nbpt, gis.ipt);
+                      (t_asm, Krr, ctx1, ctx2, I1, I2, mf1, mf2,
+                       alpha1, alpha2, coeff_asm, gis.nbpt, gis.ipt);
                   else
                     pgai = std::make_shared
                       <ga_instruction_matrix_assembly_standard_vector>
-                      (root->tensor(), Krr, ctx1, ctx2, I1, I2, mf1, mf2,
-                       alpha1, alpha2, gis.coeff, gis.nbpt, gis.ipt);
+                      (t_asm, Krr, ctx1, ctx2, I1, I2, mf1, mf2,
+                       alpha1, alpha2, coeff_asm, gis.nbpt, gis.ipt);
                 } else if (condensation &&
                            workspace.is_internal_variable(root->name_test1) &&
                            workspace.is_internal_variable(root->name_test2)) {
@@ -7683,11 +8448,11 @@ namespace getfem {
                       (std::make_shared<base_tensor>(s1,s2));
                     CC.KQQ(q1,q2) = gis.condensation_tensors.back().get();
                     pgai = std::make_shared<ga_instruction_copy_vect>
-                      (CC.KQQ(q1,q2)->as_vector(), root->tensor().as_vector());
+                      (CC.KQQ(q1,q2)->as_vector(), t_asm.as_vector());
                   } else {
                     // addition instruction to the previously allocated matrix
                     pgai = std::make_shared<ga_instruction_add_to>
-                      (*CC.KQQ(q1,q2), root->tensor());
+                      (*CC.KQQ(q1,q2), t_asm);
                   }
                   rmi.instructions.push_back(std::move(pgai));
                 } else if (condensation &&
@@ -7711,18 +8476,18 @@ namespace getfem {
                   if (!CC.KQJ(q1,j2)) {
                     // allocate a new matrix. Here we do not know the size as
                     // it may change dynamically, but for now, just use the
-                    // size of root->tensor()
+                    // size of t_asm
                     gis.condensation_tensors.push_back
-                      (std::make_shared<base_tensor>(root->tensor()));
-                    GMM_ASSERT1(root->tensor().size(0) == s1, "Internal error");
+                      (std::make_shared<base_tensor>(t_asm));
+                    GMM_ASSERT1(t_asm.size(0) == s1, "Internal error");
                     CC.KQJ(q1,j2) = gis.condensation_tensors.back().get();
                     pgai = std::make_shared<ga_instruction_copy_vect>
-                      (CC.KQJ(q1,j2)->as_vector(), root->tensor().as_vector());
+                      (CC.KQJ(q1,j2)->as_vector(), t_asm.as_vector());
                   } else {
                     // an extra matrix for this entry has already been
                     // allocated, so just add the current tensor to it
                     pgai = std::make_shared<ga_instruction_add_to>
-                      (*CC.KQJ(q1,j2), root->tensor());
+                      (*CC.KQJ(q1,j2), t_asm);
                   }
                   rmi.instructions.push_back(std::move(pgai));
                 } else if (condensation &&
@@ -7745,19 +8510,19 @@ namespace getfem {
                   if (!CC.KIQ(i1,q2)) {
                     // allocate a new matrix. Here we do not know the size as
                     // it may change dynamically, but for now, just use the
-                    // size of root->tensor()
+                    // size of t_asm
                     gis.condensation_tensors.push_back
-                      (std::make_shared<base_tensor>(root->tensor()));
-                    GMM_ASSERT1(root->tensor().size(1) == s2,
+                      (std::make_shared<base_tensor>(t_asm));
+                    GMM_ASSERT1(t_asm.size(1) == s2,
                                 "Internal error");
                     CC.KIQ(i1,q2) = gis.condensation_tensors.back().get();
                     pgai = std::make_shared<ga_instruction_copy_vect>
-                      (CC.KIQ(i1,q2)->as_vector(), root->tensor().as_vector());
+                      (CC.KIQ(i1,q2)->as_vector(), t_asm.as_vector());
                   } else {
                     // an extra matrix for this entry has already been
                     // allocated, so just add the current tensor to it
                     pgai = std::make_shared<ga_instruction_add_to>
-                      (*CC.KIQ(i1,q2), root->tensor());
+                      (*CC.KIQ(i1,q2), t_asm);
                   }
                   rmi.instructions.push_back(std::move(pgai));
                 } else if (!workspace.is_internal_variable(root->name_test1) &&
@@ -7788,9 +8553,9 @@ namespace getfem {
                                    .groups_info[root->name_test2];
                       pgai = std::make_shared
                              <ga_instruction_matrix_assembly_mf_mf>
-                             (root->tensor(), Krr, Kru, Kur, Kuu, ctx1, ctx2,
+                             (t_asm, Krr, Kru, Kur, Kuu, ctx1, ctx2,
                               vgi1, vgi2,
-                              gis.coeff, gis.nbpt, gis.ipt, interpolate);
+                              coeff_asm, gis.nbpt, gis.ipt, interpolate);
                     } else {
                       const gmm::sub_interval &I2 = mf2 && mf2->is_reduced()
                         ? workspace.temporary_interval_of_variable
@@ -7799,14 +8564,14 @@ namespace getfem {
                       if (mf2)
                         pgai = std::make_shared
                                <ga_instruction_matrix_assembly_mf_mf>
-                               (root->tensor(), Krx, Kux,  ctx1, ctx2,
+                               (t_asm, Krx, Kux,  ctx1, ctx2,
                                 vgi1, I2, *mf2, alpha2,
-                                gis.coeff, gis.nbpt, gis.ipt, interpolate);
+                                coeff_asm, gis.nbpt, gis.ipt, interpolate);
                       else // for global variable imd2 == 0
                         pgai = std::make_shared
                                <ga_instruction_matrix_assembly_mf_imd>
-                               (root->tensor(), Krr, Kur, ctx1, ctx2,
-                                vgi1, I2, imd2, alpha2, gis.coeff, gis.ipt);
+                               (t_asm, Krr, Kur, ctx1, ctx2,
+                                vgi1, I2, imd2, alpha2, coeff_asm, gis.ipt);
                     }
                   } else { // !has_var_group1
                     const gmm::sub_interval &I1 = mf1 && mf1->is_reduced()
@@ -7820,14 +8585,14 @@ namespace getfem {
                       if (mf1)
                         pgai = std::make_shared
                                <ga_instruction_matrix_assembly_mf_mf>
-                               (root->tensor(), Kxr, Kxu, ctx1, ctx2,
+                               (t_asm, Kxr, Kxu, ctx1, ctx2,
                                 I1, *mf1, alpha1, vgi2,
-                                gis.coeff, gis.nbpt, gis.ipt, interpolate);
+                                coeff_asm, gis.nbpt, gis.ipt, interpolate);
                       else // for global variable imd1 == 0
                         pgai = std::make_shared
                                <ga_instruction_matrix_assembly_imd_mf>
-                               (root->tensor(), Krr, Kru, ctx1, ctx2,
-                                I1, imd1, alpha1, vgi2, gis.coeff, gis.ipt);
+                               (t_asm, Krr, Kru, ctx1, ctx2,
+                                I1, imd1, alpha1, vgi2, coeff_asm, gis.ipt);
                     } else { // !has_var_group2
                       const gmm::sub_interval &I2 = mf2 && mf2->is_reduced()
                         ? workspace.temporary_interval_of_variable
@@ -7836,36 +8601,50 @@ namespace getfem {
                       if (mf1 && mf2)
                         pgai = std::make_shared
                                <ga_instruction_matrix_assembly_mf_mf>
-                               (root->tensor(), Kxx, ctx1, ctx2,
+                               (t_asm, Kxx, ctx1, ctx2,
                                 I1, *mf1, alpha1, I2, *mf2, alpha2,
-                                gis.coeff, gis.nbpt, gis.ipt, interpolate);
+                                coeff_asm, gis.nbpt, gis.ipt, interpolate);
                       else if (mf1) // for global variable imd2 == 0
                         pgai = std::make_shared
                                <ga_instruction_matrix_assembly_mf_imd>
-                               (root->tensor(), Kxr, ctx1, ctx2,
+                               (t_asm, Kxr, ctx1, ctx2,
                                 I1, *mf1, alpha1, I2, imd2, alpha2,
-                                gis.coeff, gis.ipt);
+                                coeff_asm, gis.ipt);
                       else if (mf2)
                         pgai = std::make_shared
                                <ga_instruction_matrix_assembly_imd_mf>
-                               (root->tensor(), Krx, ctx1, ctx2,
+                               (t_asm, Krx, ctx1, ctx2,
                                 I1, imd1, alpha1, I2, *mf2, alpha2,
-                                gis.coeff, gis.ipt);
+                                coeff_asm, gis.ipt);
                       else
                         pgai = std::make_shared
                                <ga_instruction_matrix_assembly_imd_imd>
-                               (root->tensor(), Krr, ctx1, ctx2,
+                               (t_asm, Krr, ctx1, ctx2,
                                 I1, imd1, alpha1, I2, imd2, alpha2,
-                                gis.coeff, gis.ipt);
+                                coeff_asm, gis.ipt);
                     }
                   }
                 } // if (!simple)
                 break;
               } // case 2
               } // switch(order)
+              bool atomic = workspace.atomic_parallel_assembly();
+              if (pgai && order == 1 && atomic) {
+                auto pgva = std::dynamic_pointer_cast
+                            <ga_instruction_vector_assembly_mf>(pgai);
+                if (pgva) pgva->pgis = &gis;
+              }
+              if (pgai && order == 2
+                  && (workspace.fixed_sparsity_pattern() || atomic)) {
+                auto pgma = std::dynamic_pointer_cast
+                            <ga_instruction_matrix_assembly_base>(pgai);
+                if (pgma) { pgma->use_slots = true; pgma->pgis = &gis; }
+              }
               if (pgai)
                 rmi.instructions.push_back(std::move(pgai));
             }
+            if (gis.profiling)
+              ga_set_instruction_origins(rmi, ga_tree_to_string(trees.back()));
           } // if (root)
         } // if (td.order == order || td.order == size_type(-1))
       } // for (const ga_workspace::tree_description &td : trees_of_current_phase)
@@ -8191,10 +8970,627 @@ namespace getfem {
     gic.finalize();
   }
 
+  // List of the elements (or faces of elements) of a region integrated by
+  // mim, in the order of the region.
+  static void ga_region_elements
+  (const mesh_region &region, const mesh &m, const mesh_im &mim,
+   ga_element_list &elts) {
+    elts.resize(0);
+    for (getfem::mr_visitor v(region, m, true); !v.finished(); ++v)
+      if (mim.convex_index().is_in(v.cv()))
+        elts.emplace_back(v.cv(), v.f());
+  }
+
+  // Visitor of a range of an element list, with the interface of mr_visitor.
+  class ga_element_list_visitor {
+    ga_element_list::const_iterator it, ite;
+  public:
+    ga_element_list_visitor(ga_element_list::const_iterator it_begin,
+                            ga_element_list::const_iterator it_end)
+      : it(it_begin), ite(it_end) {}
+    bool finished() const { return it == ite; }
+    size_type cv() const { return it->first; }
+    short_type f() const { return it->second; }
+    ga_element_list_visitor &operator ++() { ++it; return *this; }
+  };
+
+  // Execution of a list of instructions, with the collection of the
+  // execution statistics if prof is not null (of the same size as il).
+  static inline void ga_exec_instructions
+  (const std::vector<pga_instruction> &il,
+   std::vector<ga_instruction_set::instruction_profile> *prof) {
+    if (!prof) {
+      for (size_type j = 0; j < il.size(); ++j) j += il[j]->exec();
+    } else {
+      for (size_type j = 0; j < il.size(); ++j) {
+        ga_instruction_set::instruction_profile &p = (*prof)[j];
+        auto t0 = std::chrono::steady_clock::now();
+        j += il[j]->exec();
+        p.time += std::chrono::duration<scalar_type>
+          (std::chrono::steady_clock::now() - t0).count();
+        ++(p.nb_calls);
+      }
+    }
+  }
+
+  // Statistics vectors of the three instruction lists of rmi, null if the
+  // instruction set is not profiled.
+  static void ga_profiles_of
+  (ga_instruction_set &gis, ga_instruction_set::region_mim_instructions &rmi,
+   std::vector<ga_instruction_set::instruction_profile> *&profb,
+   std::vector<ga_instruction_set::instruction_profile> *&profe,
+   std::vector<ga_instruction_set::instruction_profile> *&prof) {
+    profb = profe = prof = 0;
+    if (gis.profiling) {
+      rmi.begin_profiles.resize(rmi.begin_instructions.size());
+      rmi.elt_profiles.resize(rmi.elt_instructions.size());
+      rmi.profiles.resize(rmi.instructions.size());
+      profb = &(rmi.begin_profiles);
+      profe = &(rmi.elt_profiles);
+      prof = &(rmi.profiles);
+    }
+  }
+
+  static bool ga_batch_reused_result(const ga_batch_operand &result,
+                                     const std::set<const base_tensor *> &ts) {
+    for (const base_tensor *t : ts)
+      if (result.t == t || (result.s && t->size() && result.s >= t->data()
+                            && result.s < t->data() + t->size()))
+        return true;
+    return false;
+  }
+
+  // Splitting of the instructions on each integration point of rmi for the
+  // element-batched execution. The instructions of an expression being
+  // compiled in postfix order and followed by its assembly instruction, the
+  // tensors computed by a sequence of batched instructions ending with an
+  // assembly instruction are only read by the following instructions of
+  // the sequence, except the tensors of the nodes reused for equivalent
+  // nodes, which end the sequence. The sequences keep their first
+  // instruction having a result and the following ones. The interpolate
+  // transformations are excluded, their instructions depending on the
+  // current element in a way not described by the operands.
+  static void ga_batch_analysis
+  (ga_instruction_set::region_mim_instructions &rmi) {
+    ga_batch_plan &plan = rmi.batch_plan;
+    const auto &gil = rmi.instructions;
+    plan = ga_batch_plan();
+    plan.analyzed = true;
+    if (!(rmi.interpolate_infos.empty())) return;
+
+    std::vector<ga_batch_operand> operands;
+    std::vector<bool> has_result(gil.size()), is_batched(gil.size());
+    bool in_sequence = false;
+    for (size_type j = gil.size(); j > 0; --j) {
+      auto *pbi = dynamic_cast<ga_batched_instruction *>(gil[j-1].get());
+      ga_batch_operand result;
+      if (!pbi || !(pbi->batch_operands(operands, result)))
+        in_sequence = false;
+      else if (!(result.data()))
+        is_batched[j-1] = in_sequence = true;
+      else if (in_sequence
+               && !ga_batch_reused_result(result, rmi.reused_tensors))
+        is_batched[j-1] = has_result[j-1] = true;
+      else
+        in_sequence = false;
+    }
+    bool started = false, computation = false;
+    for (size_type j = 0; j < gil.size(); ++j) {
+      if (!is_batched[j]) { started = false; continue; }
+      if (has_result[j]) started = computation = true;
+      if (!started) is_batched[j] = false; // Leading assembly instruction
+    }
+    if (!computation) return;
+
+    plan.is_batched = is_batched;
+    for (size_type j = 0; j < gil.size(); ++j)
+      if (is_batched[j]) {
+        auto *pbi = dynamic_cast<ga_batched_instruction *>(gil[j].get());
+        plan.positions.push_back(j);
+        plan.instructions.push_back(pbi);
+        plan.operands.emplace_back();
+        plan.results.emplace_back();
+        pbi->batch_operands(plan.operands.back(), plan.results.back());
+      }
+    for (const auto &pfp : rmi.pfps) plan.mfs.push_back(pfp.first);
+  }
+
+  // Element-batched execution of the instructions of rmi (see
+  // ga_workspace::set_element_batch_size). The consecutive elements having
+  // the same geometric transformation, integration method and fems are
+  // gathered in batches of at most nb elements. The instructions which are
+  // not batched (see ga_batch_analysis) are executed element by element as
+  // usual, and the operands of the batched ones which they compute are
+  // stored for each element and each integration point, the component i
+  // for the element b of the batch at i*nb+b. When the batch is complete,
+  // the results of the batched instructions are computed on the whole batch
+  // for each integration point, then the assembly instructions are executed
+  // element by element, with the values of their operands and the current
+  // element and integration point restored, or once per element on the sum
+  // on the integration points of their weighted tensors when possible.
+  class ga_element_batch {
+    ga_instruction_set &gis;
+    const std::vector<pga_instruction> &gil;
+    ga_batch_plan &plan;
+    const mesh &m;
+    const mesh_im &mim;
+    const size_type nb;
+
+    // Type of the elements of the current batch
+    bgeot::pgeometric_trans pgt = 0;
+    pintegration_method pim = 0;
+    size_type nbpt = 0;
+    std::vector<pfem> pfs, new_pfs;
+
+    struct batch_element {
+      size_type cv;
+      short_type f;
+      base_matrix G;
+      bgeot::pgeotrans_precomp pgp;
+    };
+    std::vector<batch_element> elts;
+    size_type nb_elts = 0;
+    std::vector<bool> executed; // Integration points of the elements on
+                                // which the instructions are executed
+    bool batched_elt = false;   // The current element is in the batch
+
+    // Storage of the operands and results of the batched part, for all the
+    // integration points and elements of the batch.
+    struct batch_slot {
+      ga_batch_operand op;
+      scalar_type *data;
+      size_type size;
+      bool gathered;  // Operand computed before the batched part
+      base_vector values;
+    };
+    std::vector<batch_slot> slots;
+    std::vector<std::vector<std::pair<size_type, size_type>>> locations;
+    std::vector<size_type> result_slots;
+    std::vector<const scalar_type *> pointers;
+    std::vector<base_vector> sums; // For the assembly instructions
+    std::vector<bool> summed;
+    bool bound = false;
+
+    bool overlap(const batch_slot &sl, const scalar_type *p,
+                 size_type n) const
+    { return p < sl.data + sl.size && sl.data < p + n; }
+
+    // Slots of the operands and results of the batched part, for the
+    // tensors of the current batch.
+    bool bind() {
+      slots.resize(0);
+      locations.assign(plan.instructions.size(), {});
+      result_slots.assign(plan.instructions.size(), size_type(-1));
+      for (size_type k = 0; k < plan.instructions.size(); ++k) {
+        for (const ga_batch_operand &op : plan.operands[k]) {
+          scalar_type *p = op.data();
+          size_type n = op.size(), is = 0, offset = 0;
+          if (!p || n == 0) return false;
+          for (; is < slots.size(); ++is) {
+            const batch_slot &sl = slots[is];
+            if (!sl.gathered && p >= sl.data && p + n <= sl.data + sl.size)
+              { offset = size_type(p - sl.data); break; }
+            if (sl.gathered && p == sl.data && n == sl.size) break;
+            if (!sl.gathered && overlap(sl, p, n)) return false;
+          }
+          if (is == slots.size())
+            slots.push_back(batch_slot{op, p, n, true, base_vector()});
+          locations[k].emplace_back(is, offset);
+        }
+        const ga_batch_operand &res = plan.results[k];
+        if (res.data()) {
+          scalar_type *p = res.data();
+          size_type n = res.size();
+          if (n == 0) return false;
+          for (const batch_slot &sl : slots)
+            if (overlap(sl, p, n)) return false;
+          result_slots[k] = slots.size();
+          slots.push_back(batch_slot{res, p, n, false, base_vector()});
+        }
+      }
+      for (batch_slot &sl : slots) {
+        sl.values.resize(sl.size*nbpt*nb);
+        gmm::clear(sl.values);
+      }
+      return true;
+    }
+
+  public:
+    bool active() const { return nb > 1 && !(plan.positions.empty()); }
+
+    // Called for each element (or face) before its context is set. Returns
+    // true if the previous batch has been executed, the context having then
+    // to be set again.
+    bool begin_element(size_type cv, short_type f) {
+      pintegration_method pim_new = mim.int_method_of_element(cv);
+      if (pim_new->type() != IM_APPROX) { batched_elt = false; return false; }
+      papprox_integration pai = pim_new->approx_method();
+      size_type nbpt_new = (f == short_type(-1)) ? pai->nb_points_on_convex()
+                                                 : pai->nb_points_on_face(f);
+      batched_elt = !(pai->is_built_on_the_fly()) && nbpt_new > 0
+                    && !(plan.positions.empty());
+      new_pfs.resize(plan.mfs.size());
+      for (size_type i = 0; i < plan.mfs.size(); ++i)
+        new_pfs[i] = plan.mfs[i]->convex_index().is_in(cv)
+                   ? plan.mfs[i]->fem_of_element(cv) : 0;
+      bgeot::pgeometric_trans pgt_new = m.trans_of_convex(cv);
+      bool same_type = batched_elt && nb_elts < nb && pgt_new == pgt
+                       && pim_new == pim && nbpt_new == nbpt && new_pfs == pfs;
+      bool flushed = false;
+      if (!same_type && nb_elts) { flush(); flushed = true; }
+      pgt = pgt_new; pim = pim_new; nbpt = nbpt_new; pfs.swap(new_pfs);
+      return flushed;
+    }
+
+    // Called for each element (or face) with its context set.
+    void add_element(size_type cv, short_type f, const base_matrix &G,
+                     bgeot::pgeotrans_precomp pgp) {
+      if (!batched_elt) return;
+      if (elts.size() <= nb_elts) elts.resize(nb_elts+1);
+      batch_element &elt = elts[nb_elts++];
+      elt.cv = cv; elt.f = f; elt.pgp = pgp;
+      gmm::resize(elt.G, gmm::mat_nrows(G), gmm::mat_ncols(G));
+      gmm::copy(G, elt.G);
+      executed.resize(nb*nbpt);
+      std::fill(executed.begin() + (nb_elts-1)*nbpt,
+                executed.begin() + nb_elts*nbpt, false);
+    }
+
+    // Called instead of the execution of the instructions on an
+    // integration point.
+    void exec_point() {
+      if (!batched_elt) { ga_exec_instructions(gil, 0); return; }
+      for (size_type j = 0; j < gil.size(); ++j)
+        if (!(plan.is_batched[j])) j += gil[j]->exec();
+      if (!bound && !bind()) { // Not a valid batched part, batching disabled.
+        for (size_type k = 0; k < plan.positions.size(); ++k)
+          gil[plan.positions[k]]->exec(); // Not read by the other ones
+        plan.positions.clear();
+        batched_elt = false;
+        nb_elts = 0;
+        return;
+      }
+      bound = true;
+      size_type b = nb_elts-1, ipt = gis.ipt;
+      for (batch_slot &sl : slots)
+        if (sl.gathered) {
+          GMM_ASSERT1(sl.op.data() == sl.data && sl.op.size() == sl.size,
+                      "Internal error");
+          scalar_type *v = &(sl.values[ipt*sl.size*nb + b]);
+          for (size_type i = 0; i < sl.size; ++i, v += nb) *v = sl.data[i];
+        }
+      executed[b*nbpt+ipt] = true;
+    }
+
+    // Values of the operands of the batched instruction k for the current
+    // element and integration point.
+    void restore_operands(size_type k, size_type b, size_type ipt) {
+      for (size_type l = 0; l < locations[k].size(); ++l) {
+        const batch_slot &sl = slots[locations[k][l].first];
+        const ga_batch_operand &op = plan.operands[k][l];
+        const scalar_type *v
+          = &(sl.values[(ipt*sl.size+locations[k][l].second)*nb + b]);
+        scalar_type *p = op.data();
+        for (size_type i = 0; i < op.size(); ++i, v += nb) p[i] = *v;
+      }
+    }
+
+    // Execution of the batched part on the current batch.
+    void flush() {
+      if (nb_elts == 0) return;
+      const size_type nbi = plan.instructions.size();
+      // Sums on the integration points of the weighted tensors of the
+      // assembly instructions allowing it, computed on each integration
+      // point after the results.
+      sums.resize(nbi);
+      for (size_type k = 0; k < nbi; ++k)
+        if (result_slots[k] == size_type(-1)
+            && plan.instructions[k]->batch_sum_on_points())
+          sums[k].assign(plan.operands[k][0].size()*nb, scalar_type(0));
+      for (size_type ipt = 0; ipt < nbpt; ++ipt)
+        for (size_type k = 0; k < nbi; ++k)
+          if (result_slots[k] != size_type(-1)) {
+            pointers.resize(0);
+            for (const auto &loc : locations[k]) {
+              const batch_slot &sl = slots[loc.first];
+              pointers.push_back(&(sl.values[(ipt*sl.size+loc.second)*nb]));
+            }
+            batch_slot &sl = slots[result_slots[k]];
+            plan.instructions[k]->exec_batch(&(sl.values[ipt*sl.size*nb]),
+                                             pointers, nb);
+          } else if (plan.instructions[k]->batch_sum_on_points()) {
+            const batch_slot &slt = slots[locations[k][0].first];
+            const batch_slot &slc = slots[locations[k][1].first];
+            const scalar_type *pt
+              = &(slt.values[(ipt*slt.size+locations[k][0].second)*nb]);
+            const scalar_type *pc
+              = &(slc.values[(ipt*slc.size+locations[k][1].second)*nb]);
+            auto it = sums[k].begin();
+            size_type n = plan.operands[k][0].size();
+            for (size_type i = 0; i < n; ++i, pt += nb)
+              for (size_type b = 0; b < nb; ++b, ++it) *it += pc[b] * pt[b];
+          }
+
+      for (size_type b = 0; b < nb_elts; ++b) {
+        const batch_element &elt = elts[b];
+        gis.ctx.change(elt.pgp, 0, 0, elt.G, elt.cv, elt.f);
+        bool all_points = true; // The sums can be used
+        for (size_type ipt = 0; ipt < nbpt; ++ipt)
+          if (!executed[b*nbpt+ipt]) all_points = false;
+        summed.assign(nbi, false);
+        if (all_points) { // As a single integration point of weight one
+          gis.nbpt = 1; gis.ipt = 0;
+          for (size_type k = 0; k < nbi; ++k)
+            if (result_slots[k] == size_type(-1)
+                && plan.instructions[k]->batch_sum_on_points()) {
+              const ga_batch_operand &op = plan.operands[k][0];
+              const scalar_type *v = &(sums[k][b]);
+              scalar_type *p = op.data();
+              for (size_type i = 0; i < op.size(); ++i, v += nb) p[i] = *v;
+              *(plan.operands[k][1].data()) = scalar_type(1);
+              gil[plan.positions[k]]->exec();
+              summed[k] = true;
+            }
+        }
+        gis.nbpt = nbpt;
+        for (gis.ipt = 0; gis.ipt < nbpt; ++(gis.ipt)) {
+          if (!executed[b*nbpt+gis.ipt]) continue;
+          for (size_type k = 0; k < nbi; ++k)
+            if (result_slots[k] == size_type(-1) && !(summed[k])) {
+              restore_operands(k, b, gis.ipt);
+              gil[plan.positions[k]]->exec();
+            }
+        }
+      }
+      gis.nb_batched_elements += nb_elts;
+      nb_elts = 0;
+      bound = false;
+    }
+
+    ga_element_batch(ga_instruction_set &gis_,
+                     ga_instruction_set::region_mim_instructions &rmi,
+                     const mesh_im &mim_, size_type nb_)
+      : gis(gis_), gil(rmi.instructions), plan(rmi.batch_plan), m(*(rmi.m)),
+        mim(mim_), nb(nb_) {
+      if (nb > 1 && !(plan.analyzed)) ga_batch_analysis(rmi);
+    }
+  };
+
+  // Execution of the instructions of rmi on the elements (or faces of
+  // elements) of the mesh integrated with mim visited by v (a mr_visitor
+  // or a ga_element_list_visitor), by batches of elements if batch is not
+  // null.
+  template <typename VISITOR>
+  static void ga_exec_elements
+  (ga_instruction_set &gis,
+   ga_instruction_set::region_mim_instructions &rmi,
+   const mesh_im &mim, bool include_empty_int_pts, VISITOR &v,
+   ga_element_batch *batch = 0) {
+    const getfem::mesh &m = *(rmi.m);
+    const auto &gilb = rmi.begin_instructions;
+    const auto &gile = rmi.elt_instructions;
+    const auto &gil = rmi.instructions;
+    std::vector<ga_instruction_set::instruction_profile> *profb, *profe, *prof;
+    ga_profiles_of(gis, rmi, profb, profe, prof);
+    base_matrix G1;
+    base_small_vector un;
+    scalar_type J1(0);
+
+    size_type old_cv = size_type(-1);
+    bgeot::pgeometric_trans pgt = 0, pgt_old = 0;
+    pintegration_method pim = 0;
+    papprox_integration pai = 0;
+    bgeot::pstored_point_tab pspt = 0, old_pspt = 0;
+    bgeot::pgeotrans_precomp pgp = 0;
+    bool first_gp = true;
+    for (; !v.finished(); ++v) {
+      const size_type cv = v.cv();
+      const short_type f = v.f();
+      if (!mim.convex_index().is_in(cv)) continue;
+      // cout << "proceed with elt " << cv << " face " << f << endl;
+      if (batch && batch->begin_element(cv, f))
+        old_cv = size_type(-1); // The context has been changed
+      if (cv != old_cv) {
+        pgt = m.trans_of_convex(cv);
+        pim = mim.int_method_of_element(cv);
+        m.points_of_convex(cv, G1);
+
+        if (pim->type() == IM_NONE) continue;
+        GMM_ASSERT1(pim->type() == IM_APPROX, "Sorry, exact methods "
+                    "cannot be used in high level generic assembly");
+        pai = pim->approx_method();
+        pspt = pai->pintegration_points();
+        if (pspt->size()) {
+          if (pgp && gis.pai == pai && pgt_old == pgt) {
+            gis.ctx.change(pgp, 0, 0, G1, cv, f);
+          } else {
+            if (pai->is_built_on_the_fly()) {
+              gis.ctx.change(pgt, 0, (*pspt)[0], G1, cv, f);
+              pgp = 0;
+            } else {
+              pgp = gis.gp_pool(pgt, pspt);
+              gis.ctx.change(pgp, 0, 0, G1, cv, f);
+            }
+            pgt_old = pgt; gis.pai = pai;
+          }
+          if (gis.need_elt_size)
+            gis.elt_size = convex_radius_estimate(pgt, G1)*scalar_type(2);
+        }
+        old_cv = cv;
+      } else {
+        if (pim->type() == IM_NONE) continue;
+        gis.ctx.set_face_num(f);
+      }
+      if (pspt != old_pspt) { first_gp = true; old_pspt = pspt; }
+      if (pspt->size()) {
+        // iterations on Gauss points
+        size_type first_ind = 0;
+        if (f != short_type(-1)) {
+          gis.nbpt = pai->nb_points_on_face(f);
+          first_ind = pai->ind_first_point_on_face(f);
+        } else {
+          gis.nbpt = pai->nb_points_on_convex();
+        }
+        if (batch) batch->add_element(cv, f, G1, pgp);
+        for (gis.ipt = 0; gis.ipt < gis.nbpt; ++(gis.ipt)) {
+          if (pgp) gis.ctx.set_ii(first_ind+gis.ipt);
+          else gis.ctx.set_xref((*pspt)[first_ind+gis.ipt]);
+          if (gis.ipt == 0 || !(pgt->is_linear())) {
+            J1 = gis.ctx.J();
+            // Computation of unit normal vector in case of a boundary
+            if (f != short_type(-1)) {
+              gis.Normal.resize(G1.nrows());
+              un.resize(pgt->dim());
+              gmm::copy(pgt->normals()[f], un);
+              gmm::mult(gis.ctx.B(), un, gis.Normal);
+              scalar_type nup = gmm::vect_norm2(gis.Normal);
+              J1 *= nup;
+              gmm::scale(gis.Normal, 1.0/nup);
+              gmm::clean(gis.Normal, 1e-13);
+            } else gis.Normal.resize(0);
+          }
+          auto ipt_coeff = pai->coeff(first_ind+gis.ipt);
+          gis.coeff = J1 * ipt_coeff;
+          bool enable_ipt = (gmm::abs(ipt_coeff) > 0.0 ||
+                             include_empty_int_pts);
+          if (!enable_ipt) gis.coeff = scalar_type(0);
+          if (first_gp) {
+            ga_exec_instructions(gilb, profb);
+            first_gp = false;
+          }
+          if (gis.ipt == 0)
+            ga_exec_instructions(gile, profe);
+          if (enable_ipt || gis.ipt == 0 || gis.ipt == gis.nbpt-1) {
+            if (batch) batch->exec_point();
+            else ga_exec_instructions(gil, prof);
+          }
+          GA_DEBUG_INFO("");
+        }
+      }
+    }
+    if (batch) batch->flush();
+  }
+
+  // Greedy coloring of the convexes of elts such that two convexes of a
+  // same color share no basic dof of the mesh_fems mfs.
+  static void ga_color_elements(const ga_element_list &elts,
+                                const std::vector<const mesh_fem *> &mfs,
+                                ga_colored_elements &ce) {
+    std::vector<size_type> dof_shift(mfs.size()+1, 0);
+    for (size_type k = 0; k < mfs.size(); ++k)
+      dof_shift[k+1] = dof_shift[k] + mfs[k]->nb_basic_dof();
+
+    std::vector<std::vector<bool>> used_dofs;   // for each color
+    std::vector<std::vector<size_type>> groups; // entries of each color
+    std::vector<size_type> dofs;
+    for (size_type i = 0; i < elts.size(); ) {
+      size_type cv = elts[i].first, j = i;
+      while (j < elts.size() && elts[j].first == cv) ++j;
+
+      dofs.resize(0);
+      for (size_type k = 0; k < mfs.size(); ++k)
+        if (mfs[k]->convex_index().is_in(cv))
+          for (const size_type &dof : mfs[k]->ind_basic_dof_of_element(cv))
+            dofs.push_back(dof_shift[k] + dof);
+
+      size_type c = 0;
+      for (; c < used_dofs.size(); ++c) {
+        bool free = true;
+        for (const size_type &dof : dofs)
+          if (used_dofs[c][dof]) { free = false; break; }
+        if (free) break;
+      }
+      if (c == used_dofs.size()) {
+        used_dofs.emplace_back(dof_shift.back(), false);
+        groups.emplace_back();
+      }
+      for (const size_type &dof : dofs) used_dofs[c][dof] = true;
+      for (size_type k = i; k < j; ++k) groups[c].push_back(k);
+      groups[c].push_back(size_type(-1)); // end of convex
+      i = j;
+    }
+
+    ce.source = elts;
+    ce.mfs = mfs;
+    ce.elts.resize(0);
+    ce.groups.resize(0);
+    ce.colors.resize(0);
+    for (const auto &group : groups) {
+      ce.colors.push_back(ce.groups.size());
+      bool new_convex = true;
+      for (const size_type &k : group) {
+        if (k == size_type(-1)) { new_convex = true; continue; }
+        if (new_convex) ce.groups.push_back(ce.elts.size());
+        new_convex = false;
+        ce.elts.push_back(elts[k]);
+      }
+    }
+    ce.colors.push_back(ce.groups.size());
+    ce.groups.push_back(ce.elts.size());
+  }
+
+  void ga_exec_colored(const std::vector<ga_instruction_set *> &gisl,
+                       ga_workspace &workspace,
+                       const std::vector<const mesh_fem *> &mfs_,
+                       bool atomic) {
+    // No dof of a mesh_fem in the coloring gives a single color
+    const std::vector<const mesh_fem *> no_mfs, &mfs = atomic ? no_mfs : mfs_;
+    ga_instruction_set &gis = *(gisl[0]);
+    GMM_ASSERT1(gis.transformations.empty(), "Internal error");
+    size_type nbth = gisl.size();
+    bool include_empty_int_pts = workspace.include_empty_int_points();
+    ga_element_list elts;
+    std::vector<ga_instruction_set::region_mim_instructions *> rmis(nbth);
+    for (ga_instruction_set *pgis : gisl) pgis->atomic_scatter = atomic;
+
+    for (auto &instr : gis.all_instructions) {
+      GMM_ASSERT1(!(instr.first.psd()), "Internal error");
+      const getfem::mesh_im &mim = *(instr.first.mim());
+      const getfem::mesh &m = *(instr.second.m);
+      GMM_ASSERT1(&m == &(mim.linked_mesh()), "Incompatibility of meshes");
+
+      ga_colored_elements &ce = instr.second.colored_elements;
+      ga_region_elements(*(instr.first.region()), m, mim, elts);
+      if (elts != ce.source || mfs != ce.mfs)
+        ga_color_elements(elts, mfs, ce);
+
+      for (size_type t = 0; t < nbth; ++t)
+        rmis[t] = &(gisl[t]->all_instructions.at(instr.first));
+
+      size_type g0(0), g1(0);
+      auto exec_slice = [&](size_type t) {
+        size_type nt = std::min(nbth, true_thread_policy::num_threads());
+        if (t >= nt) return;
+        size_type gb = g0 + ((g1-g0)*t)/nt, ge = g0 + ((g1-g0)*(t+1))/nt;
+        if (gb < ge) {
+          ga_element_list_visitor v(ce.elts.begin() + ce.groups[gb],
+                                    ce.elts.begin() + ce.groups[ge]);
+          ga_exec_elements(*(gisl[t]), *(rmis[t]), mim, include_empty_int_pts,
+                           v);
+        }
+      };
+      for (size_type c = 0; c+1 < ce.colors.size(); ++c) {
+        g0 = ce.colors[c]; g1 = ce.colors[c+1];
+        GETFEM_OMP_PARALLEL_NO_PARTITION
+          (exec_slice(true_thread_policy::this_thread()))
+      }
+    }
+
+    std::vector<size_type> dofs1_sort;
+    for (ga_instruction_set *pgis : gisl) {
+      pgis->atomic_scatter = false;
+      for (auto &dm : pgis->deferred_matrices)
+        add_elem_matrix(*(dm.K), dm.dofs1, dm.dofs2, dofs1_sort,
+                        dm.elem, scalar_type(-1), 0);
+      pgis->deferred_matrices.clear();
+    }
+  }
+
   void ga_exec(ga_instruction_set &gis, ga_workspace &workspace) {
     base_matrix G1, G2;
     base_small_vector un;
     scalar_type J1(0), J2(0);
+    gis.atomic_scatter = false;
 
     for (const std::string &t : gis.transformations)
       workspace.interpolate_transformation(t)->init(workspace);
@@ -8223,99 +9619,21 @@ namespace getfem {
         const mesh_region &region = *(instr.first.region());
 
         // iteration on elements (or faces of elements)
-        size_type old_cv = size_type(-1);
-        bgeot::pgeometric_trans pgt = 0, pgt_old = 0;
-        pintegration_method pim = 0;
-        papprox_integration pai = 0;
-        bgeot::pstored_point_tab pspt = 0, old_pspt = 0;
-        bgeot::pgeotrans_precomp pgp = 0;
-        bool first_gp = true;
-        for (getfem::mr_visitor v(region, m, true); !v.finished(); ++v) {
-          if (mim.convex_index().is_in(v.cv())) {
-            // cout << "proceed with elt " << v.cv() << " face " << v.f()<<endl;
-            if (v.cv() != old_cv) {
-              pgt = m.trans_of_convex(v.cv());
-              pim = mim.int_method_of_element(v.cv());
-              m.points_of_convex(v.cv(), G1);
-
-              if (pim->type() == IM_NONE) continue;
-              GMM_ASSERT1(pim->type() == IM_APPROX, "Sorry, exact methods "
-                          "cannot be used in high level generic assembly");
-              pai = pim->approx_method();
-              pspt = pai->pintegration_points();
-              if (pspt->size()) {
-                if (pgp && gis.pai == pai && pgt_old == pgt) {
-                  gis.ctx.change(pgp, 0, 0, G1, v.cv(), v.f());
-                } else {
-                  if (pai->is_built_on_the_fly()) {
-                    gis.ctx.change(pgt, 0, (*pspt)[0], G1, v.cv(), v.f());
-                    pgp = 0;
-                  } else {
-                    pgp = gis.gp_pool(pgt, pspt);
-                    gis.ctx.change(pgp, 0, 0, G1, v.cv(), v.f());
-                  }
-                  pgt_old = pgt; gis.pai = pai;
-                }
-                if (gis.need_elt_size)
-                  gis.elt_size = convex_radius_estimate(pgt, G1)*scalar_type(2);
-              }
-              old_cv = v.cv();
-            } else {
-              if (pim->type() == IM_NONE) continue;
-              gis.ctx.set_face_num(v.f());
-            }
-            if (pspt != old_pspt) { first_gp = true; old_pspt = pspt; }
-            if (pspt->size()) {
-              // iterations on Gauss points
-              size_type first_ind = 0;
-              if (v.f() != short_type(-1)) {
-                gis.nbpt = pai->nb_points_on_face(v.f());
-                first_ind = pai->ind_first_point_on_face(v.f());
-              } else {
-                gis.nbpt = pai->nb_points_on_convex();
-              }
-              for (gis.ipt = 0; gis.ipt < gis.nbpt; ++(gis.ipt)) {
-                if (pgp) gis.ctx.set_ii(first_ind+gis.ipt);
-                else gis.ctx.set_xref((*pspt)[first_ind+gis.ipt]);
-                if (gis.ipt == 0 || !(pgt->is_linear())) {
-                  J1 = gis.ctx.J();
-                  // Computation of unit normal vector in case of a boundary
-                  if (v.f() != short_type(-1)) {
-                    gis.Normal.resize(G1.nrows());
-                    un.resize(pgt->dim());
-                    gmm::copy(pgt->normals()[v.f()], un);
-                    gmm::mult(gis.ctx.B(), un, gis.Normal);
-                    scalar_type nup = gmm::vect_norm2(gis.Normal);
-                    J1 *= nup;
-                    gmm::scale(gis.Normal, 1.0/nup);
-                    gmm::clean(gis.Normal, 1e-13);
-                  } else gis.Normal.resize(0);
-                }
-                auto ipt_coeff = pai->coeff(first_ind+gis.ipt);
-                gis.coeff = J1 * ipt_coeff;
-                bool enable_ipt = (gmm::abs(ipt_coeff) > 0.0 ||
-                                   workspace.include_empty_int_points());
-                if (!enable_ipt) gis.coeff = scalar_type(0);
-                if (first_gp) {
-                  for (size_type j=0; j < gilb.size(); ++j) j+=gilb[j]->exec();
-                  first_gp = false;
-                }
-                if (gis.ipt == 0) {
-                  for (size_type j=0; j < gile.size(); ++j) j+=gile[j]->exec();
-                }
-                if (enable_ipt || gis.ipt == 0 || gis.ipt == gis.nbpt-1) {
-                  for (size_type j=0; j < gil.size(); ++j) j+=gil[j]->exec();
-                }
-                GA_DEBUG_INFO("");
-              }
-            }
-          }
-        }
+        getfem::mr_visitor v(region, m, true);
+        ga_element_batch batch(gis, instr.second, mim,
+                               gis.profiling ? 0
+                                             : workspace.element_batch_size());
+        ga_exec_elements(gis, instr.second, mim,
+                         workspace.include_empty_int_points(), v,
+                         batch.active() ? &batch : 0);
         GA_DEBUG_INFO("-----------------------------");
 
       } else { // Integration on the product of two domains (secondary domain)
 
         auto &sdi = instr.second.secondary_domain_infos;
+        std::vector<ga_instruction_set::instruction_profile>
+          *profb, *profe, *prof;
+        ga_profiles_of(gis, instr.second, profb, profe, prof);
         const mesh_region &region1 = *(instr.first.region());
 
         // iteration on elements (or faces of elements)
@@ -8461,18 +9779,13 @@ namespace getfem {
                       if (!enable_ipt) gis.coeff = scalar_type(0);
 
                       if (first_gp) {
-                        for (size_type j=0; j < gilb.size(); ++j)
-                          j+=gilb[j]->exec();
+                        ga_exec_instructions(gilb, profb);
                         first_gp = false;
                       }
-                      if (gis.ipt == 0) {
-                        for (size_type j=0; j < gile.size(); ++j)
-                          j+=gile[j]->exec();
-                      }
-                      if (enable_ipt || gis.ipt == 0 || gis.ipt == gis.nbpt-1) {
-                        for (size_type j=0; j < gil.size(); ++j)
-                          j+=gil[j]->exec();
-                      }
+                      if (gis.ipt == 0)
+                        ga_exec_instructions(gile, profe);
+                      if (enable_ipt || gis.ipt == 0 || gis.ipt == gis.nbpt-1)
+                        ga_exec_instructions(gil, prof);
                       GA_DEBUG_INFO("");
                     }
                   }
@@ -8490,5 +9803,47 @@ namespace getfem {
       workspace.interpolate_transformation(t)->finalize();
   }
 
+  static std::string ga_instruction_name(const ga_instruction &instr) {
+    const char *name = typeid(instr).name();
+#if defined(__GNUC__)
+    int status = 0;
+    char *dname = abi::__cxa_demangle(name, 0, 0, &status);
+    if (status == 0 && dname) {
+      std::string res(dname);
+      free(dname);
+      if (res.compare(0, 8, "getfem::") == 0) res.erase(0, 8);
+      return res;
+    }
+#endif
+    return std::string(name);
+  }
+
+  void ga_collect_profiling(ga_instruction_set &gis, ga_profiling_data &pd) {
+    for (auto &instr : gis.all_instructions) {
+      auto &rmi = instr.second;
+      auto collect = [&pd](const std::vector<pga_instruction> &il,
+                           std::vector<ga_instruction_set::instruction_profile>
+                           &profiles,
+                           const std::vector<std::string> &origins,
+                           const char *stage) {
+        for (size_type j = 0; j < profiles.size() && j < il.size(); ++j) {
+          if (profiles[j].nb_calls == 0) continue;
+          ga_profiling_data::entry e;
+          e.instruction = ga_instruction_name(*(il[j]));
+          e.expression = (j < origins.size()) ? origins[j] : std::string();
+          e.stage = stage;
+          e.nb_calls = profiles[j].nb_calls;
+          e.time = profiles[j].time;
+          pd.add(e);
+          profiles[j] = ga_instruction_set::instruction_profile();
+        }
+      };
+      collect(rmi.begin_instructions, rmi.begin_profiles, rmi.begin_origins,
+              "begin");
+      collect(rmi.elt_instructions, rmi.elt_profiles, rmi.elt_origins,
+              "element");
+      collect(rmi.instructions, rmi.profiles, rmi.origins, "point");
+    }
+  }
 
 } /* end of namespace */
@@ -26,6 +26,53 @@
 
 namespace getfem {
 
+  //=========================================================================
+  // Execution statistics of the compiled assembly instructions.
+  //=========================================================================
+
+  void ga_profiling_data::add(const entry &e) {
+    auto &stat = stats[key_type(e.instruction, e.expression, e.stage)];
+    stat.first += e.nb_calls;
+    stat.second += e.time;
+  }
+
+  void ga_profiling_data::add(const ga_profiling_data &pd) {
+    for (const auto &stat : pd.stats) {
+      auto &s = stats[stat.first];
+      s.first += stat.second.first;
+      s.second += stat.second.second;
+    }
+  }
+
+  void ga_profiling_data::report(std::vector<entry> &entries) const {
+    entries.resize(0);
+    for (const auto &stat : stats) {
+      entry e;
+      e.instruction = std::get<0>(stat.first);
+      e.expression = std::get<1>(stat.first);
+      e.stage = std::get<2>(stat.first);
+      e.nb_calls = stat.second.first;
+      e.time = stat.second.second;
+      entries.push_back(e);
+    }
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const entry &e1, const entry &e2)
+                     { return e1.time > e2.time; });
+  }
+
+  void ga_profiling_data::print(std::ostream &os) const {
+    std::vector<entry> entries;
+    report(entries);
+    scalar_type total(0);
+    for (const entry &e : entries) total += e.time;
+    os << "Generic assembly profiling, total instruction time: " << total
+       << " s" << endl;
+    for (const entry &e : entries)
+      os << std::setw(12) << e.time << " s " << std::setw(10) << e.nb_calls
+         << " calls  " << std::setw(7) << e.stage << "  " << e.instruction
+         << "  [" << e.expression << "]" << endl;
+  }
+
   //=========================================================================
   // Structure dealing with user defined environment : constant, variables,
   // functions, operators.
@@ -76,6 +123,7 @@ namespace getfem {
     GMM_ASSERT1(nb_intern_dof == 0 || I.last() < first_intern_dof,
                 "The provided interval overlaps with internal dofs");
     nb_prim_dof = std::max(nb_prim_dof, I.last());
+    clear_compiled_assemblies();
     variables.emplace(name, var_description(true, &mf, 0, I, &VV, 1));
   }
 
@@ -85,6 +133,7 @@ namespace getfem {
     GMM_ASSERT1(nb_intern_dof == 0 || I.last() <= first_intern_dof,
                 "The provided interval overlaps with internal dofs");
     nb_prim_dof = std::max(nb_prim_dof, I.last());
+    clear_compiled_assemblies();
     variables.emplace(name, var_description(true, 0, &imd, I, &VV, 1));
   }
 
@@ -97,6 +146,7 @@ namespace getfem {
     first_intern_dof = std::min(first_intern_dof, I.first());
     nb_intern_dof += first_intern_dof + nb_intern_dof
                    - std::min(first_intern_dof + nb_intern_dof, I.last());
+    clear_compiled_assemblies();
     variables.emplace(name, var_description(true, 0, &imd, I, &VV, 1, true));
   }
 
@@ -106,6 +156,7 @@ namespace getfem {
     GMM_ASSERT1(nb_intern_dof == 0 || I.last() <= first_intern_dof,
                 "The provided interval overlaps with internal dofs");
     nb_prim_dof = std::max(nb_prim_dof, I.last());
+    clear_compiled_assemblies();
     variables.emplace(name, var_description(true, 0, 0, I, &VV,
                                             dim_type(gmm::vect_size(VV))));
   }
@@ -117,12 +168,14 @@ namespace getfem {
                              << "has zero degrees of freedom");
     size_type Q = gmm::vect_size(VV)/mf.nb_dof();
     if (Q == 0) Q = size_type(1);
+    clear_compiled_assemblies();
     variables.emplace(name, var_description(false, &mf, 0,
                                             gmm::sub_interval(), &VV, Q));
   }
 
   void ga_workspace::add_fixed_size_constant
   (const std::string &name, const model_real_plain_vector &VV) {
+    clear_compiled_assemblies();
     variables.emplace(name, var_description(false, 0, 0,
                                             gmm::sub_interval(), &VV,
                                             gmm::vect_size(VV)));
@@ -130,6 +183,7 @@ namespace getfem {
 
   void ga_workspace::add_im_data(const std::string &name, const im_data &imd,
                                  const model_real_plain_vector &VV) {
+    clear_compiled_assemblies();
     variables.emplace(name, var_description
       (false, 0, &imd, gmm::sub_interval(), &VV,
        gmm::vect_size(VV)/(imd.nb_filtered_index() * imd.nb_tensor_elem())));
@@ -354,6 +408,7 @@ namespace getfem {
       GMM_ASSERT1(name != "neighbor_element", "neighbor_element is a "
                   "reserved interpolate transformation name");
     transformations[name] = ptrans;
+    clear_compiled_assemblies();
   }
 
   bool ga_workspace::interpolate_transformation_exists
@@ -402,6 +457,7 @@ namespace getfem {
       GMM_ASSERT1(false, "An interpolate transformation with the same "
                   "name already exists");
     secondary_domains[name] = psecdom;
+    clear_compiled_assemblies();
   }
 
   bool ga_workspace::secondary_domain_exists
@@ -444,6 +500,7 @@ namespace getfem {
                               bool function_expr, operation_type op_type,
                               const std::string varname_interpolation) {
     if (tree.root) {
+      clear_compiled_assemblies();
       // cout << "add tree with tests functions of " <<  tree.root->name_test1
       //     << " and " << tree.root->name_test2 << endl;
       //     ga_print_node(tree.root, cout); cout << endl;
@@ -779,6 +836,7 @@ namespace getfem {
       ms.insert(&(mf->linked_mesh()));
     }
     variable_groups[group_name] = nl;
+    clear_compiled_assemblies();
   }
 
 
@@ -794,6 +852,170 @@ namespace getfem {
   }
 
 
+  void ga_workspace::compiled_assembly::clear() {
+    gis.reset();
+    thread_gis.clear();
+    targets.clear();
+    fixed_size_names.clear();
+    fixed_size_values.clear();
+    clear_dependencies();
+    state = CONTEXT_NORMAL;
+  }
+
+  // Objects referenced by the instructions compiled for the given order,
+  // which have to be unchanged for the instructions to be reused.
+  void ga_workspace::assembly_targets(std::vector<const void *> &tg,
+                                      size_type order,
+                                      bool condensation) const {
+    tg.clear();
+    if (order == 2) tg.push_back(K.get());
+    if (order == 1 || condensation) tg.push_back(V.get());
+    if (condensation) tg.push_back(KQJpr.get());
+    for (const auto &var : variables) tg.push_back(var.second.V);
+    const ga_workspace *w = this;
+    while (w->parent_workspace) w = w->parent_workspace;
+    tg.push_back(w->md);
+    tg.push_back(w);
+  }
+
+  bool ga_workspace::is_compiled_assembly_valid
+  (const compiled_assembly &ca, size_type order, bool condensation) const {
+    if (!(ca.gis) || !(ca.is_context_valid()) || ca.context_check())
+      return false;
+    std::vector<const void *> tg;
+    assembly_targets(tg, order, condensation);
+    if (tg != ca.targets) return false;
+    // Fixed size data are evaluated as constants at compile time
+    for (size_type i = 0; i < ca.fixed_size_names.size(); ++i) {
+      const std::string &name = ca.fixed_size_names[i];
+      if (!variable_exists(name)) return false;
+      const model_real_plain_vector &VV = value(name);
+      const model_real_plain_vector &VC = ca.fixed_size_values[i];
+      if (gmm::vect_size(VV) != gmm::vect_size(VC)) return false;
+      for (size_type j = 0; j < gmm::vect_size(VV); ++j)
+        if (VV[j] != VC[j]) return false;
+    }
+    return true;
+  }
+
+  ga_instruction_set &
+  ga_workspace::compiled_instructions(size_type order, bool condensation) {
+    std::pair<size_type, bool> key(order, condensation);
+    {
+      compiled_assembly &ca = compiled_assemblies[key];
+      if (is_compiled_assembly_valid(ca, order, condensation)) {
+        ga_update_extended_vars(*this, *(ca.gis));
+        return *(ca.gis);
+      }
+    }
+
+    // The temporary intervals of the unreduced variables are shared by all
+    // the sets and are not updated when a reduced mesh_fem is modified.
+    // If a set is out of date, all of them are dropped with the intervals.
+    bool out_of_date = false;
+    for (const auto &p : compiled_assemblies)
+      if (p.second.gis
+          && !is_compiled_assembly_valid(p.second, p.first.first,
+                                         p.first.second))
+        { out_of_date = true; break; }
+    if (out_of_date) clear_compiled_assemblies();
+
+    compiled_assembly &ca = compiled_assemblies[key];
+    ca.clear();
+    ca.gis = std::make_shared<ga_instruction_set>();
+    ca.gis->profiling = profile_instructions;
+    ca.gis->size_specialized = size_specialized;
+    ga_compile(*this, *(ca.gis), order, condensation);
+    ++assembly_stats.nb_compilations;
+    assembly_targets(ca.targets, order, condensation);
+
+    std::set<var_trans_pair> vars;
+    for (const tree_description &td : trees) {
+      ca.add_dependency(*(td.mim));
+      ca.add_dependency(*(td.m));
+      if (td.ptree && td.ptree->root)
+        ga_extract_variables(td.ptree->root, *this, *(td.m), vars, false);
+      if (td.ptree && td.ptree->secondary_domain.size())
+        ca.add_dependency
+          (secondary_domain(td.ptree->secondary_domain)->mim());
+      vars.insert(var_trans_pair(td.name_test1, ""));
+      vars.insert(var_trans_pair(td.name_test2, ""));
+    }
+    std::set<std::string> names;
+    for (const var_trans_pair &vt : vars)
+      if (variable_group_exists(vt.varname)) {
+        for (const std::string &t : variable_group(vt.varname))
+          names.insert(t);
+      } else if (vt.varname.size() && variable_exists(vt.varname))
+        names.insert(vt.varname);
+    for (const std::string &name : names) {
+      const mesh_fem *mf = associated_mf(name);
+      const im_data *imd = associated_im_data(name);
+      if (mf) ca.add_dependency(*mf);
+      else if (imd) ca.add_dependency(*imd);
+      else {
+        ca.fixed_size_names.push_back(name);
+        ca.fixed_size_values.push_back(value(name));
+      }
+    }
+    return *(ca.gis);
+  }
+
+  bool ga_workspace::colored_instructions
+  (size_type order, bool condensation, std::vector<ga_instruction_set *> &gisl,
+   std::vector<const mesh_fem *> &mfs) {
+    size_type nbth = true_thread_policy::num_threads();
+    if (!(colored_assembly || atomic_assembly) || order == 0 || condensation
+        || nbth < 2 || me_is_multithreaded_now())
+      return false;
+    compiled_assembly &ca
+      = compiled_assemblies[std::make_pair(order, condensation)];
+    if (!(ca.gis) || !(ca.gis->transformations.empty())) return false;
+    if (atomic_assembly && order == 2 && gmm::nnz(*K) == 0)
+      return false; // Sequential assembly to build the sparsity pattern
+
+    mfs.clear();
+    for (const tree_description &td : trees) {
+      if (td.order != order) continue;
+      if (!(td.interpolate_name_test1.empty())
+          || !(td.interpolate_name_test2.empty())
+          || (td.ptree && td.ptree->secondary_domain.size()))
+        return false;
+      for (const std::string *name : {&(td.name_test1), &(td.name_test2)}) {
+        if (name->empty()) continue;
+        if (variable_group_exists(*name)) return false;
+        const mesh_fem *mf = associated_mf(*name);
+        if (mf) {
+          if (std::find(mfs.begin(), mfs.end(), mf) == mfs.end())
+            mfs.push_back(mf);
+        } else if (!associated_im_data(*name))
+          return false;
+      }
+    }
+
+    if (ca.thread_gis.size() + 1 < nbth) {
+      for (size_type i = ca.thread_gis.size(); i + 1 < nbth; ++i) {
+        ca.thread_gis.push_back(std::make_shared<ga_instruction_set>());
+        ca.thread_gis.back()->profiling = profile_instructions;
+        ca.thread_gis.back()->size_specialized = size_specialized;
+        ga_compile(*this, *(ca.thread_gis.back()), order, condensation);
+        ++assembly_stats.nb_compilations;
+      }
+    } else
+      for (size_type i = 0; i + 1 < nbth; ++i)
+        ga_update_extended_vars(*this, *(ca.thread_gis[i]));
+
+    gisl.assign(1, ca.gis.get());
+    for (size_type i = 0; i + 1 < nbth; ++i)
+      gisl.push_back(ca.thread_gis[i].get());
+    return true;
+  }
+
+  static void clear_values_keeping_pattern(model_real_sparse_matrix &K) {
+    for (size_type j = 0; j < gmm::mat_ncols(K); ++j)
+      gmm::clear_values(K[j]);
+  }
+
   void ga_workspace::assembly(size_type order, bool condensation) {
 
     const ga_workspace *w = this;
@@ -801,16 +1023,22 @@ namespace getfem {
     if (w->md) w->md->nb_dof(); // To eventually call actualize_sizes()
 
     GA_TIC;
-    ga_instruction_set gis;
-    ga_compile(*this, gis, order, condensation);
+    ++assembly_stats.nb_assemblies;
+    ga_instruction_set &gis = compiled_instructions(order, condensation);
     GA_TOCTIC("Compile time");
 
     size_type nb_tot_dof = condensation ? nb_prim_dof + nb_intern_dof
                                         : nb_prim_dof;
     if (order == 2) {
       if (K.use_count()) {
-        gmm::clear(*K);
-        gmm::resize(*K, nb_prim_dof, nb_prim_dof);
+        if ((fixed_pattern || atomic_assembly)
+            && gmm::mat_nrows(*K) == nb_prim_dof
+            && gmm::mat_ncols(*K) == nb_prim_dof)
+          clear_values_keeping_pattern(*K);
+        else {
+          gmm::clear(*K);
+          gmm::resize(*K, nb_prim_dof, nb_prim_dof);
+        }
       } // else
       // We trust that the caller has provided a matrix large enough for the
       // terms to be assembled (can actually be smaller than the full matrix)
@@ -852,9 +1080,25 @@ namespace getfem {
     gmm::clear(assembled_tensor().as_vector());
 
     GA_TOCTIC("Init time");
-    ga_exec(gis, *this);     // --> unreduced_V, *V,
+    std::vector<ga_instruction_set *> gisl;
+    std::vector<const mesh_fem *> colored_mfs;
+    if (colored_instructions(order, condensation, gisl, colored_mfs)) {
+      ++assembly_stats.nb_parallel_assemblies;
+      ga_exec_colored(gisl, *this, colored_mfs, atomic_assembly);
+    } else
+      ga_exec(gis, *this);     // --> unreduced_V, *V,
     GA_TOCTIC("Exec time");  //     unreduced_K, *K
 
+    if (gisl.empty()) gisl.push_back(&gis);
+    for (ga_instruction_set *pgis : gisl) {
+      if (profile_instructions) ga_collect_profiling(*pgis, profiling_stats);
+      assembly_stats.nb_pattern_hits += pgis->nb_pattern_hits;
+      assembly_stats.nb_pattern_misses += pgis->nb_pattern_misses;
+      assembly_stats.nb_batched_elements += pgis->nb_batched_elements;
+      pgis->nb_pattern_hits = pgis->nb_pattern_misses = 0;
+      pgis->nb_batched_elements = 0;
+    }
+
     if (order == 0) {
       MPI_SUM_VECTOR(assemb_t.as_vector());
     } else if (order == 1 || (order == 2 && condensation)) {
@@ -963,7 +1207,8 @@ namespace getfem {
     }
   }
 
-  void ga_workspace::clear_expressions() { trees.clear(); }
+  void ga_workspace::clear_expressions()
+  { trees.clear(); clear_compiled_assemblies(); }
 
   void ga_workspace::print(std::ostream &str) {
     for (size_type i = 0; i < trees.size(); ++i)
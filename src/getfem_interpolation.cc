@@ -37,96 +37,218 @@ namespace getfem {
 
   void mesh_trans_inv::points_on_convex(size_type cv,
                                         std::vector<size_type> &itab) const {
-    itab.resize(pts_cvx[cv].size()); size_type j = 0;
-    for (set_iterator it = pts_cvx[cv].begin(); it != pts_cvx[cv].end(); ++it)
-      itab[j++] = *it;
+    size_type nb = nb_points_on_convex(cv);
+    itab.resize(nb);
+    if (nb) std::copy(cvx_pts_tab.begin() + cvx_first[cv],
+                      cvx_pts_tab.begin() + cvx_first[cv+1], itab.begin());
   }
 
   size_type mesh_trans_inv::point_on_convex(size_type cv, size_type i) const {
-    set_iterator it = pts_cvx[cv].begin();
-    for (size_type j = 0; it != pts_cvx[cv].end() && j < i; ++it, ++j);
-    GMM_ASSERT1(it != pts_cvx[cv].end(), "internal error");    
-    return *it;
+    GMM_ASSERT1(i < nb_points_on_convex(cv), "internal error");
+    return cvx_pts_tab[cvx_first[cv] + i];
   }
 
+  /* A point found by a convex during the search. */
+  struct mti_candidate {
+    size_type ind, cv, iref;
+    scalar_type isin;
+  };
+
+  /* Candidates found by a block of convexes, with their reference
+     coordinates. */
+  struct mti_candidate_block {
+    std::vector<mti_candidate> cands;
+    std::vector<scalar_type> refs;
+  };
+
   void mesh_trans_inv::distribute(int extrapolation, mesh_region rg_source) {
 
     rg_source.from_mesh(msh);
     rg_source.error_if_not_convexes();
     bool all_convexes = (rg_source.id() == mesh_region::all_convexes().id());
 
+    context_check();
+    if (distributed && extrapolation == distributed_extrapolation
+        && points_version == distributed_points_version
+        && rg_source.index() == distributed_cvs) return;
+
     size_type nbpts = nb_points();
     size_type nbcvx = msh.nb_allocated_convex();
     ref_coords.resize(nbpts);
     std::vector<double> dist(nbpts);
     std::vector<size_type> cvx_pts(nbpts);
-    pts_cvx.clear(); pts_cvx.resize(nbcvx);
-    base_node min, max, pt_ref; /* bound of the box enclosing the convex */
-    bgeot::kdtree_tab_type boxpts;
     dal::bit_vector npt, cv_on_bound;
     npt.add(0, nbpts);
     scalar_type mult = scalar_type(1);
 
     bool projection_into_element(extrapolation == 0);
 
+    if (extrapolation == 2)
+      for (dal::bv_visitor j(rg_source.index()); !j.finished(); ++j)
+        for (short_type f = 0; f < msh.nb_faces_of_convex(j); ++f) {
+          size_type neighbor_cv = msh.neighbor_of_convex(j, f);
+          if (!all_convexes && neighbor_cv != size_type(-1)) {
+            // check if the neighbor is also contained in rg_source ...
+            if (!rg_source.is_in(neighbor_cv))
+              cv_on_bound.add(j); // ... if not, treat the element as a boundary one
+          }
+          else // boundary element of the overall mesh
+            cv_on_bound.add(j);
+        }
+
+    tree.build_tree(); // before the parallel search
+
+    const size_type BLOCK_SIZE = 64;
+    std::vector<size_type> cvs;
+    std::vector<mti_candidate_block> blocks;
+    std::vector<bool> to_search(nbpts);
+    // Smallest block in which a point has been found inside a convex. The
+    // convexes of the following blocks cannot be selected for this point.
+    std::unique_ptr<std::atomic<size_type>[]>
+      found_in(new std::atomic<size_type>[nbpts]);
+
     do {
-      for (dal::bv_visitor j(rg_source.index()); !j.finished(); ++j) {
-        if (mult > scalar_type(1) && !(cv_on_bound.is_in(j))) continue;
-        bgeot::pgeometric_trans pgt = msh.trans_of_convex(j);
-        bounding_box(min, max, msh.points_of_convex(j), pgt);
-        for (size_type k=0; k < min.size(); ++k) { min[k]-=EPS; max[k]+=EPS; }
-        if (extrapolation == 2) {
-          if (mult == scalar_type(1))
-            for (short_type f = 0; f < msh.nb_faces_of_convex(j); ++f) {
-              size_type neighbor_cv = msh.neighbor_of_convex(j, f);
-              if (!all_convexes && neighbor_cv != size_type(-1)) {
-                // check if the neighbor is also contained in rg_source ...
-                if (!rg_source.is_in(neighbor_cv)) 
-                  cv_on_bound.add(j); // ... if not, treat the element as a boundary one
+      cvs.resize(0);
+      for (dal::bv_visitor j(rg_source.index()); !j.finished(); ++j)
+        if (mult == scalar_type(1) || cv_on_bound.is_in(j)) cvs.push_back(j);
+      for (size_type i = 0; i < nbpts; ++i) {
+        to_search[i] = npt.is_in(i) || dist[i] > 0;
+        found_in[i].store(size_type(-1), std::memory_order_relaxed);
+      }
+      size_type nbblocks = (cvs.size() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+      blocks.resize(nbblocks);
+      std::atomic<size_type> next_block(0);
+
+      // The convexes are processed by blocks, dynamically assigned to the
+      // threads. The candidate points of a convex are inverted together
+      // (geotrans_inv_convex::invert_points).
+      auto search = [&]() {
+        bgeot::geotrans_inv_convex gic_th;
+        bgeot::kdtree_tab_type boxpts;
+        base_node min, max, pt_ref; /* bound of the box enclosing the convex */
+        std::vector<size_type> sel;
+        base_vector xreal, xref;
+        std::vector<bool> isin, converged;
+        for (size_type b = next_block++; b < nbblocks; b = next_block++) {
+          mti_candidate_block &blk = blocks[b];
+          blk.cands.resize(0); blk.refs.resize(0);
+          size_type ie = std::min(cvs.size(), (b+1)*BLOCK_SIZE);
+          for (size_type ic = b*BLOCK_SIZE; ic < ie; ++ic) {
+            size_type j = cvs[ic];
+            bgeot::pgeometric_trans pgt = msh.trans_of_convex(j);
+            bounding_box(min, max, msh.points_of_convex(j), pgt);
+            for (size_type k=0; k < min.size(); ++k)
+              { min[k]-=EPS; max[k]+=EPS; }
+            if (extrapolation == 2 && cv_on_bound.is_in(j)) {
+              scalar_type h = scalar_type(0);
+              for (size_type k=0; k < min.size(); ++k)
+                h = std::max(h, max[k] - min[k]);
+              for (size_type k=0; k < min.size(); ++k)
+                { min[k]-=mult*h; max[k]+=mult*h; }
+            }
+            points_in_box(boxpts, min, max);
+            if (boxpts.size() == 0) continue;
+            gic_th.init(msh.points_of_convex(j), pgt);
+
+            sel.resize(0);
+            for (size_type l = 0; l < boxpts.size(); ++l) {
+              size_type ind = boxpts[l].i;
+              if (to_search[ind]
+                  && found_in[ind].load(std::memory_order_relaxed) > b)
+                sel.push_back(l);
+            }
+            size_type nb = sel.size(), N = min.size(), P = pgt->dim();
+            if (nb == 0) continue;
+            xreal.resize(N*nb);
+            for (size_type l = 0; l < nb; ++l)
+              for (size_type k = 0; k < N; ++k)
+                xreal[k*nb+l] = boxpts[sel[l]].n[k];
+            gic_th.invert_points(nb, xreal, xref, isin, converged, EPS,
+                                 projection_into_element);
+            pt_ref.resize(P);
+
+            for (size_type l = 0; l < nb; ++l) {
+              size_type ind = boxpts[sel[l]].i;
+              if (extrapolation || isin[l]) {
+                for (size_type k = 0; k < P; ++k) pt_ref[k] = xref[k*nb+l];
+                mti_candidate c;
+                c.ind = ind; c.cv = j; c.iref = blk.refs.size();
+                c.isin = pgt->convex_ref()->is_in(pt_ref);
+                if (c.isin <= scalar_type(0)) {
+                  size_type bf = found_in[ind].load(std::memory_order_relaxed);
+                  while (b < bf && !found_in[ind].compare_exchange_weak
+                         (bf, b, std::memory_order_relaxed)) {}
+                }
+                blk.cands.push_back(c);
+                blk.refs.insert(blk.refs.end(), pt_ref.begin(), pt_ref.end());
               }
-              else // boundary element of the overall mesh
-                cv_on_bound.add(j);
             }
-          if (cv_on_bound.is_in(j)) {
-            scalar_type h = scalar_type(0);
-            for (size_type k=0; k < min.size(); ++k)
-              h = std::max(h, max[k] - min[k]);
-            for (size_type k=0; k < min.size(); ++k)
-              { min[k]-=mult*h; max[k]+=mult*h; }
           }
         }
-        points_in_box(boxpts, min, max);
-
-        if (boxpts.size() > 0) gic.init(msh.points_of_convex(j), pgt);
-        
-        for (size_type l = 0; l < boxpts.size(); ++l) {
-          size_type ind = boxpts[l].i;
-          if (npt[ind] || dist[ind] > 0) {
-            bool converged;
-            bool gicisin = gic.invert(boxpts[l].n, pt_ref, converged, EPS,
-                                      projection_into_element);
-            bool toadd = extrapolation || gicisin;
-            double isin = pgt->convex_ref()->is_in(pt_ref);
-            
-            if (toadd && !(npt[ind])) {
-              if (isin < dist[ind]) pts_cvx[cvx_pts[ind]].erase(ind);
-              else toadd = false;
-            }
-            if (toadd) {
-//               if (mult > 1.5) {
-//                 cout << "adding " << ind << "ref_coord = " << pt_ref
-//                      << " cv = " << j << " mult = " << mult << endl;
-//               }
-              ref_coords[ind] = pt_ref;
-              dist[ind] = isin; cvx_pts[ind] = j;
-              pts_cvx[j].insert(ind);
-              npt.sup(ind);
-            }
+      };
+      GETFEM_OMP_PARALLEL_NO_PARTITION(search())
+
+      // Merge in the order of the convexes. A point keeps the first convex
+      // containing it, an exterior point the nearest one.
+      for (const mti_candidate_block &blk : blocks)
+        for (size_type l = 0; l < blk.cands.size(); ++l) {
+          const mti_candidate &c = blk.cands[l];
+          if (npt.is_in(c.ind) || (dist[c.ind] > 0 && c.isin < dist[c.ind])) {
+            size_type P = ((l+1 < blk.cands.size()) ? blk.cands[l+1].iref
+                           : blk.refs.size()) - c.iref;
+            base_node &pr = ref_coords[c.ind];
+            pr.resize(P);
+            std::copy(blk.refs.begin() + c.iref,
+                      blk.refs.begin() + c.iref + P, pr.begin());
+            dist[c.ind] = c.isin; cvx_pts[c.ind] = c.cv;
+            npt.sup(c.ind);
           }
         }
-      }
       mult *= scalar_type(2);
     } while (npt.card() > 0 && extrapolation == 2);
+
+    // Compressed storage of the points of each convex.
+    cvx_first.assign(nbcvx+1, 0);
+    for (size_type i = 0; i < nbpts; ++i)
+      if (!npt.is_in(i)) ++cvx_first[cvx_pts[i]+1];
+    for (size_type cv = 0; cv < nbcvx; ++cv) cvx_first[cv+1] += cvx_first[cv];
+    cvx_pts_tab.resize(cvx_first[nbcvx]);
+    std::vector<size_type> pos(cvx_first.begin(), cvx_first.end()-1);
+    for (size_type i = 0; i < nbpts; ++i)
+      if (!npt.is_in(i)) cvx_pts_tab[pos[cvx_pts[i]]++] = i;
+
+    distributed = true;
+    distributed_extrapolation = extrapolation;
+    distributed_points_version = points_version;
+    distributed_cvs = rg_source.index();
+  }
+
+  interpolation_operator::interpolation_operator
+  (const mesh_fem &mf_source_, const mesh_fem &mf_target_,
+   int extrapolation_, double EPS_, mesh_region rg_source_,
+   mesh_region rg_target_)
+    : mf_source(mf_source_), mf_target(mf_target_),
+      extrapolation(extrapolation_), EPS(EPS_), rg_source(rg_source_),
+      rg_target(rg_target_), built(false) {
+    add_dependency(mf_source);
+    add_dependency(mf_target);
+  }
+
+  void interpolation_operator::build() const {
+    size_type qmult = mf_source.get_qdim() / mf_target.get_qdim();
+    gmm::row_matrix<gmm::rsvector<scalar_type> >
+      MM(mf_target.nb_dof() * qmult, mf_source.nb_dof());
+    interpolation(mf_source, mf_target, MM, extrapolation, EPS,
+                  rg_source, rg_target);
+    M.init_with(MM);
+    built = true;
+  }
+
+  const gmm::csr_matrix<scalar_type> &interpolation_operator::matrix() const {
+    getfem::local_guard lock = locks_.get_lock();
+    context_check();
+    if (!built) build();
+    return M;
   }
 }  /* end of namespace getfem.                                             */
 
@@ -249,6 +249,105 @@ namespace getfem {
     }
   }
 
+  /* Index of a point of integer coordinates X (b bits each) on the
+     Hilbert curve (J. Skilling, Programming the Hilbert curve, 2004). */
+  static gmm::uint64_type hilbert_index(std::vector<gmm::uint32_type> &X,
+                                        unsigned b) {
+    size_type n = X.size();
+    gmm::uint32_type M = gmm::uint32_type(1) << (b-1), P, Q, t;
+    for (Q = M; Q > 1; Q >>= 1) {
+      P = Q - 1;
+      for (size_type i = 0; i < n; ++i)
+        if (X[i] & Q) X[0] ^= P;
+        else { t = (X[0] ^ X[i]) & P; X[0] ^= t; X[i] ^= t; }
+    }
+    for (size_type i = 1; i < n; ++i) X[i] ^= X[i-1];
+    t = 0;
+    for (Q = M; Q > 1; Q >>= 1) if (X[n-1] & Q) t ^= Q - 1;
+    for (size_type i = 0; i < n; ++i) X[i] ^= t;
+    gmm::uint64_type h = 0;
+    for (unsigned k = b; k-- > 0; )
+      for (size_type i = 0; i < n; ++i) h = (h << 1) | ((X[i] >> k) & 1);
+    return h;
+  }
+
+  void mesh::optimize_layout() {
+    optimize_structure(false);
+    size_type nbc = nb_convex(), nbp = nb_points(), N = dim(), i, j;
+    if (nbc == 0 || N == 0) return;
+
+    // Hilbert index of the barycenter of the vertices of each convex.
+    unsigned b = unsigned(std::min(size_type(21), size_type(64) / N));
+    scalar_type cmax = scalar_type((gmm::uint32_type(1) << b) - 1);
+    base_node Pmin, Pmax, G(N);
+    bounding_box(Pmin, Pmax);
+    std::vector<gmm::uint32_type> X(N);
+    std::vector<std::pair<gmm::uint64_type, size_type> > keys(nbc);
+    for (size_type cv = 0; cv < nbc; ++cv) {
+      gmm::clear(G);
+      const ind_cv_ct &ipts = ind_points_of_convex(cv);
+      for (size_type k = 0; k < ipts.size(); ++k) gmm::add(pts[ipts[k]], G);
+      gmm::scale(G, scalar_type(1) / scalar_type(ipts.size()));
+      for (size_type k = 0; k < N; ++k) {
+        scalar_type h = Pmax[k] - Pmin[k];
+        X[k] = (h > scalar_type(0))
+          ? gmm::uint32_type(std::min(cmax, (G[k]-Pmin[k]) * cmax / h)) : 0;
+      }
+      keys[cv].first = (N == 1) ? gmm::uint64_type(X[0]) : hilbert_index(X, b);
+      keys[cv].second = cv;
+    }
+    std::stable_sort(keys.begin(), keys.end());
+
+    // Applies the ordering to the convexes with the swaps which maintain
+    // the regions.
+    std::vector<size_type> iord(nbc), iordinv(nbc);
+    for (i = 0; i < nbc; ++i) iord[i] = iordinv[i] = i;
+    for (i = 0; i < nbc; ++i) {
+      j = iordinv[keys[i].second];
+      if (i != j) {
+        swap_convex(i, j);
+        std::swap(iord[i], iord[j]);
+        std::swap(iordinv[iord[i]], iordinv[iord[j]]);
+      }
+    }
+
+    // The points are numbered in the order of their first appearance in
+    // the convexes, isolated points at the end.
+    std::vector<size_type> pord; pord.reserve(nbp);
+    dal::bit_vector seen;
+    for (size_type cv = 0; cv < nbc; ++cv) {
+      const ind_cv_ct &ipts = ind_points_of_convex(cv);
+      for (size_type k = 0; k < ipts.size(); ++k)
+        if (!seen.is_in(ipts[k])) { seen.add(ipts[k]); pord.push_back(ipts[k]); }
+    }
+    for (i = 0; i < nbp; ++i) if (!seen.is_in(i)) pord.push_back(i);
+    iord.resize(nbp); iordinv.resize(nbp);
+    for (i = 0; i < nbp; ++i) iord[i] = iordinv[i] = i;
+    for (i = 0; i < nbp; ++i) {
+      j = iordinv[pord[i]];
+      if (i != j) {
+        swap_points(i, j);
+        std::swap(iord[i], iord[j]);
+        std::swap(iordinv[iord[i]], iordinv[iord[j]]);
+      }
+    }
+
+    // The swaps only exchange the handles of the coordinates and of the
+    // index lists. They are reallocated in the new order so that they are
+    // also contiguous in memory.
+    std::vector<base_node> npts(nbp);
+    for (i = 0; i < nbp; ++i)
+      { npts[i] = base_node(N); gmm::copy(pts[i], npts[i]); }
+    for (i = 0; i < nbp; ++i) pts[i] = npts[i];
+    std::vector<ind_cv_ct> nlist(nbc);
+    for (size_type cv = 0; cv < nbc; ++cv) nlist[cv] = convex_tab[cv].pts;
+    for (size_type cv = 0; cv < nbc; ++cv) convex_tab[cv].pts.swap(nlist[cv]);
+    nlist.resize(nbp);
+    for (i = 0; i < nbp; ++i) nlist[i] = points_tab[i];
+    for (i = 0; i < nbp; ++i) points_tab[i].swap(nlist[i]);
+    touch();
+  }
+
   void mesh::translation(const base_small_vector &V)
   { pts.translation(V); touch(); }
 
@@ -443,8 +443,73 @@ namespace getfem {
       dof_structure.add_convex_noverif(pf->structure(cv), itab.begin(), cv);
     }
 
-    dof_enumeration_made = true;
     nb_total_dof = nbdof;
+    renumbered_dof.clear();
+    if (dof_renumbering != DOF_RENUMBERING_NONE) renumber_dof();
+    dof_enumeration_made = true;
+  }
+
+  // The blocks of dofs attached to a same point of dof_structure (Qdim /
+  // target_dim dofs) are kept contiguous, only the points are permuted.
+  void mesh_fem::renumber_dof() const {
+    std::vector<size_type> order;
+    if (dof_renumbering == DOF_RENUMBERING_RCM)
+      bgeot::reverse_cuthill_mckee_on_points(dof_structure, order);
+    else
+      bgeot::nested_dissection_on_points(dof_structure, order);
+
+    std::vector<size_type> bsize(nb_total_dof, 0), itab;
+    for (dal::bv_visitor cv(dof_structure.convex_index());
+         !cv.finished(); ++cv) {
+      size_type s = Qdim / f_elems[cv]->target_dim();
+      for (size_type ip : dof_structure.ind_points_of_convex(cv))
+        bsize[ip] = s;
+    }
+    renumbered_dof.assign(nb_total_dof, size_type(-1));
+    size_type d = 0;
+    for (size_type ip : order)
+      for (size_type k = 0; k < bsize[ip]; ++k) renumbered_dof[ip+k] = d++;
+    GMM_ASSERT1(d == nb_total_dof, "Internal error in dof renumbering");
+
+    bgeot::mesh_structure ms;
+    for (dal::bv_visitor cv(dof_structure.convex_index());
+         !cv.finished(); ++cv) {
+      const bgeot::mesh_structure::ind_set &ipts
+        = dof_structure.ind_points_of_convex(cv);
+      itab.resize(ipts.size());
+      for (size_type i = 0; i < ipts.size(); ++i)
+        itab[i] = renumbered_dof[ipts[i]];
+      ms.add_convex_noverif(dof_structure.structure_of_convex(cv),
+                            itab.begin(), cv);
+    }
+    dof_structure = ms;
+  }
+
+  void mesh_fem::set_dof_renumbering(dof_renumbering_type t) {
+    if (t == dof_renumbering) return;
+    if (!use_reduction) {
+      dof_renumbering = t;
+      dof_enumeration_made = false;
+      touch(); v_num = act_counter();
+      return;
+    }
+
+    // The reduction and extension matrices are expressed on the basic dofs.
+    context_check(); if (!dof_enumeration_made) enumerate_dof();
+    std::vector<size_type> old_num = renumbered_dof;
+    dof_renumbering = t;
+    enumerate_dof();
+    size_type nbd = nb_total_dof;
+    gmm::row_matrix<gmm::rsvector<scalar_type> > P(nbd, nbd);
+    for (size_type i = 0; i < nbd; ++i)
+      P(renumbered_dof.empty() ? i : renumbered_dof[i],
+        old_num.empty() ? i : old_num[i]) = scalar_type(1);
+    gmm::col_matrix<gmm::wsvector<scalar_type> >
+      RR(gmm::mat_nrows(R_), nbd);
+    gmm::row_matrix<gmm::wsvector<scalar_type> > EE(nbd, gmm::mat_ncols(E_));
+    gmm::mult(R_, gmm::transposed(P), RR);
+    gmm::mult(P, E_, EE);
+    set_reduction_matrices(RR, EE);
   }
 
   void mesh_fem::reduce_to_basic_dof(const dal::bit_vector &kept_dof) {
@@ -487,6 +552,7 @@ namespace getfem {
     mi.resize(1); mi[0] = Q;
     linked_mesh_ = &me;
     use_reduction = false;
+    dof_renumbering = DOF_RENUMBERING_NONE;
     this->add_dependency(me);
     v_num = v_num_update = act_counter();
   }
@@ -514,6 +580,8 @@ namespace getfem {
     v_num_update = mf.v_num_update;
     v_num = mf.v_num;
     use_reduction = mf.use_reduction;
+    dof_renumbering = mf.dof_renumbering;
+    renumbered_dof = mf.renumbered_dof;
   }
 
   mesh_fem::mesh_fem(const mesh_fem &mf) : context_dependencies() {
@@ -531,6 +599,7 @@ namespace getfem {
   mesh_fem::mesh_fem() {
     linked_mesh_ = 0;
     dof_enumeration_made = false;
+    dof_renumbering = DOF_RENUMBERING_NONE;
     is_uniform_ = true;
     set_qdim(1);
   }
@@ -875,6 +944,38 @@ namespace getfem {
   const mesh_fem &dummy_mesh_fem()
   { return dal::singleton<dummy_mesh_fem_>::instance().mf; }
 
+  void rigid_body_modes(const mesh_fem &mf, base_matrix &B) {
+    size_type nbd = mf.nb_basic_dof(), Q = mf.get_qdim();
+    size_type N = mf.linked_mesh().dim();
+    size_type nbr = (Q == N) ? (N*(N-1))/2 : 0;
+    base_matrix Bb(nbd, Q + nbr);
+
+    std::vector<base_node> pts(nbd / Q);
+    base_node G(N); // The rotations are centered on the mean of the points
+    for (size_type d = 0; d < nbd; d += Q)
+      { pts[d/Q] = mf.point_of_basic_dof(d); gmm::add(pts[d/Q], G); }
+    if (nbd) gmm::scale(G, scalar_type(Q) / scalar_type(nbd));
+
+    for (size_type d = 0; d < nbd; ++d) {
+      size_type q = d % Q;
+      Bb(d, q) = scalar_type(1);
+      if (nbr) {
+        base_node P = pts[d/Q] - G;
+        for (size_type i = 0, k = Q; i < N; ++i)
+          for (size_type j = i+1; j < N; ++j, ++k) {
+            if (q == i) Bb(d, k) = -P[j];
+            else if (q == j) Bb(d, k) = P[i];
+          }
+      }
+    }
+
+    if (mf.is_reduced()) {
+      gmm::resize(B, mf.nb_dof(), Q + nbr);
+      gmm::mult(mf.reduction_matrix(), Bb, B);
+    } else
+      B.swap(Bb);
+  }
+
 
   void vectorize_base_tensor(const base_tensor &t, base_matrix &vt,
                              size_type ndof, size_type qdim, size_type N) {
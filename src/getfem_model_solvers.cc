@@ -66,9 +66,13 @@ namespace getfem {
     }
 
     virtual void linear_solve(VECTOR &dr, gmm::iteration &iter) {
+      linear_solver->structure_version = structure_version();
       (*linear_solver)(K, dr, rhs, iter);
     }
 
+    // Version of the sparsity structure of K, size_type(-1) if unknown
+    virtual size_type structure_version() const { return size_type(-1); }
+
     pb_base(PLSOLVER linsolv, const MATRIX &K_, VECTOR &rhs_)
       : linear_solver(linsolv), K(K_), rhs(rhs_), state(gmm::vect_size(rhs_))
     {}
@@ -86,6 +90,8 @@ namespace getfem {
     using pb_base<PLSOLVER>::state_vector;
     using pb_base<PLSOLVER>::linear_solve;
     void compute_all() { md.assembly(model::BUILD_ALL); }
+    virtual size_type structure_version() const
+    { return md.tangent_matrix_structure_version(); }
     lin_model_pb(model &, PLSOLVER) = delete;
   };
 
@@ -129,6 +135,9 @@ namespace getfem {
 
     virtual R approx_external_load_norm() { return md.approx_external_load(); }
 
+    virtual size_type structure_version() const
+    { return md.tangent_matrix_structure_version(); }
+
     virtual void compute_tangent_matrix() {
       md.to_variables(state_vector());
       md.assembly(model::BUILD_MATRIX);
@@ -289,6 +298,27 @@ namespace getfem {
                                  model_complex_plain_vector>(md);
   }
 
+  void amg_near_nullspace(const model &md, base_matrix &B,
+                          size_type &block_size) {
+    gmm::resize(B, 0, 0); block_size = 1;
+    model::varnamelist vl;
+    md.variable_list(vl);
+    std::string unknown;
+    for (const std::string &v : vl)
+      if (!md.is_data(v) && !md.is_affine_dependent_variable(v)
+          && !md.is_internal_variable(v)) {
+        if (!unknown.empty()) return;
+        unknown = v;
+      }
+    if (unknown.empty()) return;
+    const mesh_fem *mf = md.pmesh_fem_of_variable(unknown);
+    if (!mf || mf->is_reduced() || mf->nb_dof() != md.nb_dof()
+        || mf->get_qdim() < 2
+        || mf->get_qdim() != mf->linked_mesh().dim()) return;
+    rigid_body_modes(*mf, B);
+    block_size = mf->get_qdim();
+  }
+
   void default_newton_line_search::init_search(double r, size_t git, double) {
     alpha_min_ratio = 0.9;
     alpha_min = 1e-10;
@@ -37,6 +37,11 @@ namespace getfem {
   model::model(bool comp_version) {
     init(); complex_version = comp_version;
     is_linear_ = is_symmetric_ = is_coercive_ = true;
+    colored_assembly_ = atomic_assembly_ = fixed_pattern_ = false;
+    ga_profiling_ = false;
+    structure_frozen_ = frozen_structure_valid_ = false;
+    structure_version_ = 0; structure_hash_ = 0;
+    structure_hash_valid_ = structure_hash_to_be_done_ = false;
     leading_dim = 0;
     time_integration = 0; init_step = false; time_step = scalar_type(1);
     add_interpolate_transformation
@@ -305,6 +310,8 @@ namespace getfem {
 
   void model::resize_global_system() const {
 
+    ga_cache.clear(); // The workspaces depend on the intervals of variables
+
     size_type full_size = 0;
     for (auto &&v : variables)
       if (v.second.is_variable) {
@@ -364,6 +371,8 @@ namespace getfem {
     if (actualized) return; // If multiple threads are calling the method
 
     act_size_to_be_done = false;
+    frozen_structure_valid_ = false;
+    structure_changed();
 
     std::map<std::string, std::vector<std::string> > multipliers;
     std::set<std::string> tobedone;
@@ -498,7 +507,7 @@ namespace getfem {
                   GMM_TRACE2("Generic assembly for actualize sizes");
                   {
                     gmm::clear(rTM);
-                    accumulated_distro<decltype(rTM)>  distro_rTM(rTM);
+                    accumulated_distro<model_real_sparse_matrix>  distro_rTM(rTM);
                     GETFEM_OMP_PARALLEL(
                         ga_workspace workspace(*this);
                         for (const auto &ge : generic_expressions)
@@ -947,10 +956,11 @@ namespace getfem {
   void model::add_macro(const std::string &name, const std::string &expr) {
     check_name_validity(name.substr(0, name.find("(")));
     macro_dict.add_macro(name, expr);
+    ga_cache.clear();
   }
 
   void model::del_macro(const std::string &name)
-  { macro_dict.del_macro(name); }
+  { macro_dict.del_macro(name); ga_cache.clear(); }
 
   void model::delete_brick(size_type ib) {
      GMM_ASSERT1(valid_bricks[ib], "Inexistent brick");
@@ -979,6 +989,7 @@ namespace getfem {
        is_coercive_ = is_coercive_ &&  bricks[ibb].pbr->is_coercive();
      }
      bricks[ib] = brick_description();
+     structure_changed();
   }
 
   void model::delete_variable(const std::string &varname) {
@@ -1044,6 +1055,7 @@ namespace getfem {
                                      mims, region);
     active_bricks.add(ib);
     valid_bricks.add(ib);
+    structure_changed();
 
     // The brick itself already reacts to a mesh_im change in update_brick()
     // for (size_type i = 0; i < bricks[ib].mims.size(); ++i)
@@ -1077,14 +1089,14 @@ namespace getfem {
 
   void model::add_mim_to_brick(size_type ib, const mesh_im &mim) {
     GMM_ASSERT1(valid_bricks[ib], "Inexistent brick");
-    touch_brick(ib);
+    touch_brick(ib); structure_changed();
     bricks[ib].mims.push_back(&mim);
     add_dependency(mim);
   }
 
   void model::change_terms_of_brick(size_type ib, const termlist &terms) {
     GMM_ASSERT1(valid_bricks[ib], "Inexistent brick");
-    touch_brick(ib);
+    touch_brick(ib); structure_changed();
     bricks[ib].tlist = terms;
     if (is_complex() && bricks[ib].pbr->is_complex()) {
       bricks.back().cmatlist.resize(terms.size());
@@ -1099,7 +1111,7 @@ namespace getfem {
 
   void model::change_variables_of_brick(size_type ib, const varnamelist &vl) {
     GMM_ASSERT1(valid_bricks[ib], "Inexistent brick");
-    touch_brick(ib);
+    touch_brick(ib); structure_changed();
     bricks[ib].vlist = vl;
     for (const auto &v : vl)
       GMM_ASSERT1(variables.count(v), "Undefined model variable " << v);
@@ -1115,7 +1127,7 @@ namespace getfem {
 
   void model::change_mims_of_brick(size_type ib, const mimlist &ml) {
     GMM_ASSERT1(valid_bricks[ib], "Inexistent brick");
-    touch_brick(ib);
+    touch_brick(ib); structure_changed();
     bricks[ib].mims = ml;
     for (const auto &mim : ml) add_dependency(*mim);
   }
@@ -2325,6 +2337,41 @@ namespace getfem {
 
 
 
+  template <typename MAT>
+  static void clear_values_keeping_structure(MAT &M) {
+    for (size_type j = 0; j < gmm::mat_ncols(M); ++j)
+      gmm::clear_values(M[j]);
+  }
+
+  // Hash of the sparsity structure of a column matrix: its sizes and the row
+  // indices of the stored entries of each column, explicit zeros included.
+  template <typename MAT>
+  static size_t structure_hash(const MAT &M) {
+    size_t h(0);
+    auto combine = [&h](size_type i)
+      { h ^= std::hash<size_type>()(i) + 0x9e3779b9 + (h << 6) + (h >> 2); };
+    combine(gmm::mat_nrows(M));
+    combine(gmm::mat_ncols(M));
+    for (size_type j = 0; j < gmm::mat_ncols(M); ++j) {
+      combine(M[j].nb_stored());
+      for (const auto &e : M[j]) combine(e.c);
+    }
+    return h;
+  }
+
+  size_type model::tangent_matrix_structure_version() const {
+    if (structure_hash_to_be_done_) {
+      size_t h = is_complex() ? structure_hash(cTM) : structure_hash(rTM);
+      if ((structure_hash_valid_ && h != structure_hash_)
+          || structure_version_ == 0)
+        ++structure_version_;
+      structure_hash_ = h;
+      structure_hash_valid_ = true;
+      structure_hash_to_be_done_ = false;
+    }
+    return structure_version_;
+  }
+
   void model::assembly(build_version version) {
 
     GMM_ASSERT1(version != BUILD_ON_DATA_CHANGE,
@@ -2338,12 +2385,20 @@ namespace getfem {
 #endif
 
     context_check(); if (act_size_to_be_done) actualize_sizes();
+    bool keep_structure = frozen_structure_valid_
+      && (structure_frozen_ || fixed_pattern_ || atomic_assembly_);
     if (is_complex()) {
-      if (version & BUILD_MATRIX) gmm::clear(cTM);
+      if (version & BUILD_MATRIX) {
+        if (keep_structure) clear_values_keeping_structure(cTM);
+        else gmm::clear(cTM);
+      }
       if (version & BUILD_RHS) gmm::clear(crhs);
     }
     else {
-      if (version & BUILD_MATRIX) gmm::clear(rTM);
+      if (version & BUILD_MATRIX) {
+        if (keep_structure) clear_values_keeping_structure(rTM);
+        else gmm::clear(rTM);
+      }
       if (version & BUILD_RHS) gmm::clear(rrhs);
     }
     clear_dof_constraints();
@@ -2642,46 +2697,115 @@ namespace getfem {
       if (version & BUILD_MATRIX)
         GMM_TRACE2("Global generic assembly tangent term");
 
-      // auxilliary lambda function
-      auto add_assignments_and_expressions_to_workspace =
-      [&](ga_workspace &workspace)
-      {
-        for (const auto &ad : assignments)
-          workspace.add_assignment_expression
-            (ad.varname, ad.expr, ad.region, ad.order, ad.before);
-        for (const auto &ge : generic_expressions)
-          workspace.add_expression(ge.expr, ge.mim, ge.region,
-                                   2, ge.secondary_domain);
-      };
-
       const bool with_internal = version & BUILD_WITH_INTERNAL
                                  && has_internal_variables();
-      model_real_sparse_matrix intern_mat; // temp for extracting condensation info
-      model_real_plain_vector res0, // holds the original RHS
-                              res1; // holds the condensed RHS
+      const bool parallel_target = (colored_assembly_ || atomic_assembly_)
+        && !with_internal && true_thread_policy::num_threads() > 1
+        && !me_is_multithreaded_now();
+      const size_type nb_workspaces
+        = parallel_target ? 1 : global_thread_policy::num_threads();
+
+      // The workspaces of the previous assembly are reused if they have
+      // been built for the same expressions and options
+      std::stringstream key;
+      key << nb_workspaces << ' ' << parallel_target << with_internal
+          << colored_assembly_ << atomic_assembly_ << fixed_pattern_
+          << ga_profiling_ << '\n';
+      for (const auto &ad : assignments)
+        key << ad.varname << '\n' << ad.expr << '\n' << ad.region << ' '
+            << ad.order << ' ' << ad.before << '\n';
+      for (const auto &ge : generic_expressions)
+        key << ge.expr << '\n' << &(ge.mim) << ' ' << ge.region << ' '
+            << ge.secondary_domain << '\n';
+      if (key.str() != ga_cache.key) {
+        ga_cache.clear();
+        ga_cache.key = key.str();
+        ga_cache.workspaces.resize(nb_workspaces);
+        ga_cache.tangent_matrix_distro
+          = std::make_shared<omp_distribute<model_real_sparse_matrix>>();
+        ga_cache.intern_mat_distro
+          = std::make_shared<omp_distribute<model_real_sparse_matrix>>();
+        ga_cache.res0_distro
+          = std::make_shared<omp_distribute<model_real_plain_vector>>();
+        ga_cache.res1_distro
+          = std::make_shared<omp_distribute<model_real_plain_vector>>();
+      }
+
+      // auxilliary lambda functions
+      auto workspace_of_partition = [&](size_type i) -> ga_workspace & {
+        std::shared_ptr<ga_workspace> &pws = ga_cache.workspaces[i];
+        if (!pws) {
+          pws = std::make_shared<ga_workspace>(*this);
+          pws->set_colored_parallel_assembly(colored_assembly_);
+          pws->set_atomic_parallel_assembly(atomic_assembly_);
+          pws->set_fixed_sparsity_pattern(fixed_pattern_);
+          pws->set_profiling(ga_profiling_);
+          for (const auto &ad : assignments)
+            pws->add_assignment_expression
+              (ad.varname, ad.expr, ad.region, ad.order, ad.before);
+          for (const auto &ge : generic_expressions)
+            pws->add_expression(ge.expr, ge.mim, ge.region,
+                                2, ge.secondary_domain);
+        }
+        return *pws;
+      };
+      auto collect_statistics = [&](ga_workspace &workspace) {
+        getfem::local_guard lock = locks_.get_lock();
+        if (ga_profiling_) {
+          ga_profiling_stats.add(workspace.profiling_data());
+          workspace.profiling_data().clear();
+        }
+        ga_assembly_stats.add(workspace.assembly_statistics());
+        workspace.assembly_statistics().clear();
+      };
+
+      model_real_sparse_matrix &intern_mat = ga_cache.intern_mat; // temp for extracting condensation info
+      model_real_plain_vector &res0 = ga_cache.res0, // holds the original RHS
+                              &res1 = ga_cache.res1; // holds the condensed RHS
 
       size_type full_size = gmm::vect_size(full_rrhs),
                 primary_size = gmm::vect_size(rrhs);
 
-      if ((version & BUILD_RHS) || (version & BUILD_MATRIX && with_internal))
+      if ((version & BUILD_RHS) || (version & BUILD_MATRIX && with_internal)) {
+        gmm::clear(res0);
         gmm::resize(res0, with_internal ? full_size : primary_size);
-      if (version & BUILD_MATRIX && with_internal)
+      }
+      if (version & BUILD_MATRIX && with_internal) {
+        gmm::clear(res1);
         gmm::resize(res1, full_size);
+      }
 
-      if (version & BUILD_MATRIX) {
+      if (parallel_target) {
+        // The threads write directly in res0 and rTM
+        ga_workspace &workspace = workspace_of_partition(0);
+        if (version & BUILD_RHS) {
+          workspace.set_assembled_vector(res0);
+          workspace.assembly(1);
+        }
+        if (version & BUILD_MATRIX) {
+          workspace.set_assembled_matrix(rTM);
+          workspace.assembly(2);
+        }
+        collect_statistics(workspace);
+      } else if (version & BUILD_MATRIX) {
         if (with_internal) {
+          gmm::clear(intern_mat);
           gmm::resize(intern_mat, full_size, primary_size);
-          gmm::resize(res1, full_size);
         }
-        accumulated_distro<decltype(rTM)> tangent_matrix_distro(rTM);
-        accumulated_distro<decltype(intern_mat)> intern_mat_distro(intern_mat);
-        accumulated_distro<model_real_plain_vector> res1_distro(res1);
+        accumulated_distro<model_real_sparse_matrix>
+          tangent_matrix_distro(rTM, *(ga_cache.tangent_matrix_distro),
+                                fixed_pattern_);
+        accumulated_distro<model_real_sparse_matrix>
+          intern_mat_distro(intern_mat, *(ga_cache.intern_mat_distro), false);
+        accumulated_distro<model_real_plain_vector>
+          res1_distro(res1, *(ga_cache.res1_distro), false);
 
         if (version & BUILD_RHS) { // both BUILD_RHS & BUILD_MATRIX
-          accumulated_distro<model_real_plain_vector> res0_distro(res0);
+          accumulated_distro<model_real_plain_vector>
+            res0_distro(res0, *(ga_cache.res0_distro), false);
           GETFEM_OMP_PARALLEL( // running the assembly in parallel
-            ga_workspace workspace(*this);
-            add_assignments_and_expressions_to_workspace(workspace);
+            ga_workspace &workspace
+              = workspace_of_partition(global_thread_policy::this_thread());
             workspace.set_assembled_vector(res0_distro);
             workspace.assembly(1, with_internal);
             if (with_internal) { // Condensation reads from/writes to rhs
@@ -2693,12 +2817,13 @@ namespace getfem {
             }
             workspace.set_assembled_matrix(tangent_matrix_distro);
             workspace.assembly(2, with_internal);
+            collect_statistics(workspace);
           ) // end GETFEM_OMP_PARALLEL
         } // end of res0_distro scope
         else { // only BUILD_MATRIX
           GETFEM_OMP_PARALLEL( // running the assembly in parallel
-            ga_workspace workspace(*this);
-            add_assignments_and_expressions_to_workspace(workspace);
+            ga_workspace &workspace
+              = workspace_of_partition(global_thread_policy::this_thread());
             if (with_internal) { // Condensation reads from/writes to rhs
               gmm::copy(gmm::scaled(full_rrhs, scalar_type(-1)),
                         res1_distro.get()); // initial value residual=-rhs (actually only the internal variables residual is needed)
@@ -2707,16 +2832,19 @@ namespace getfem {
             }
             workspace.set_assembled_matrix(tangent_matrix_distro);
             workspace.assembly(2, with_internal);
+            collect_statistics(workspace);
           ) // end GETFEM_OMP_PARALLEL
         }
       } // end of tangent_matrix_distro, intern_mat_distro, res1_distro scope
       else if (version & BUILD_RHS) {
-        accumulated_distro<model_real_plain_vector> res0_distro(res0);
+        accumulated_distro<model_real_plain_vector>
+          res0_distro(res0, *(ga_cache.res0_distro), false);
         GETFEM_OMP_PARALLEL( // running the assembly in parallel
-          ga_workspace workspace(*this);
-          add_assignments_and_expressions_to_workspace(workspace);
+          ga_workspace &workspace
+            = workspace_of_partition(global_thread_policy::this_thread());
           workspace.set_assembled_vector(res0_distro);
           workspace.assembly(1, with_internal);
+          collect_statistics(workspace);
         ) // end GETFEM_OMP_PARALLEL
       } // end of res0_distro scope
 
@@ -2865,6 +2993,11 @@ namespace getfem {
       approx_external_load_ = MPI_SUM_SCALAR(approx_external_load_);
     }
 
+    if (version & BUILD_MATRIX) {
+      structure_hash_to_be_done_ = true;
+      frozen_structure_valid_ = true;
+    }
+
     #if GETFEM_PARA_LEVEL > 1
     // int rk; MPI_Comm_rank(MPI_COMM_WORLD, &rk);
     if (MPI_IS_MASTER()) cout << "Assembly time " << MPI_Wtime()-t_ref << endl;
@@ -3101,6 +3234,8 @@ namespace getfem {
     bricks.resize(0);
     rTM = model_real_sparse_matrix();
     cTM = model_complex_sparse_matrix();
+    frozen_structure_valid_ = false;
+    structure_changed(); structure_hash_to_be_done_ = false;
     rrhs = model_real_plain_vector();
     crhs = model_complex_plain_vector();
   }
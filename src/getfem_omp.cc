@@ -22,6 +22,7 @@
 #include "getfem/dal_singleton.h"
 #include "getfem/getfem_locale.h"
 #include "getfem/getfem_omp.h"
+#include <chrono>
 
 #ifdef GETFEM_HAS_OPENMP
   #include <thread>
@@ -241,18 +242,18 @@ namespace getfem{
   }
 
   size_type partition_master::get_current_partition() const {
-    GMM_ASSERT2(behaviour == thread_behaviour::partition_threads ?
+    GMM_ASSERT2(behaviour != thread_behaviour::true_threads ?
                 true_thread_policy::this_thread() < nb_partitions : true,
                 "Requesting current partition for thread " <<
                 true_thread_policy::this_thread() <<
                 " while number of partitions is " << nb_partitions
                 << ".");
-    return behaviour == thread_behaviour::partition_threads ?
+    return behaviour != thread_behaviour::true_threads ?
            current_partition : true_thread_policy::this_thread();
   }
 
   size_type partition_master::get_nb_partitions() const {
-    return behaviour == thread_behaviour::partition_threads ?
+    return behaviour != thread_behaviour::true_threads ?
            nb_partitions : true_thread_policy::num_threads();
   }
 
@@ -264,6 +265,24 @@ namespace getfem{
                   << ".");
       current_partition = p;
     }
+    else if (behaviour == thread_behaviour::dynamic_partition_threads){
+      GMM_ASSERT2(p < nb_partitions, "Internal error: "
+                  << p << " is not a valid partition.");
+      current_partition = p;
+    }
+  }
+
+  double partition_master::get_load_balance() const {
+    return load_balance;
+  }
+
+  void partition_master::update_load_balance(){
+    double max_time(0), mean_time(0);
+    for (const auto &t : busy_times){
+      max_time = std::max(max_time, t);
+      mean_time += t / static_cast<double>(busy_times.size());
+    }
+    load_balance = (max_time > 0.) ? mean_time / max_time : 1.;
   }
 
   void partition_master::rewind_partitions(){
@@ -294,7 +313,7 @@ namespace getfem{
                    nb_partitions
                    << ".");
     }
-    if (behaviour == thread_behaviour::partition_threads){
+    if (behaviour != thread_behaviour::true_threads){
       for (size_type t = 0; t != n_threads; ++t){
         auto partition_size = static_cast<size_type>
                                 (std::ceil(static_cast<scalar_type>(nb_partitions) /
@@ -354,9 +373,21 @@ namespace getfem{
     if (pm.get_nb_partitions() < true_thread_policy::num_threads()){
       pm.set_nb_partitions(true_thread_policy::num_threads());
     }
+    bool dynamic = iterate_over_partitions &&
+      pm.behaviour == thread_behaviour::dynamic_partition_threads;
+    pm.next_partition = 0;
+    pm.busy_times.assign(true_thread_policy::num_threads(), 0.);
     #pragma omp parallel default(shared)
     {
-      if (iterate_over_partitions) {
+      auto start = std::chrono::steady_clock::now();
+      if (dynamic) {
+        for (size_type p = pm.next_partition++; p < pm.nb_partitions;
+             p = pm.next_partition++) {
+          pm.set_current_partition(p);
+          boilerplate.run_lambda(lambda);
+        }
+      }
+      else if (iterate_over_partitions) {
         for (auto &&partitions : partition_master::get()) {
           (void)partitions;
           boilerplate.run_lambda(lambda);
@@ -365,8 +396,14 @@ namespace getfem{
       else {
         boilerplate.run_lambda(lambda);
       }
+      std::chrono::duration<double> busy_time
+        = std::chrono::steady_clock::now() - start;
+      pm.busy_times[true_thread_policy::this_thread()] = busy_time.count();
+    }
+    if (iterate_over_partitions) {
+      pm.rewind_partitions();
+      pm.update_load_balance();
     }
-    if (iterate_over_partitions) partition_master::get().rewind_partitions();
   }
 
 
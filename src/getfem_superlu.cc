@@ -228,6 +228,7 @@ namespace gmm {
     mutable SuperLUStat_t stat;
     mutable superlu_options_t options;
     float memory_used;
+    double rcond = 0; // Estimate of the reciprocal condition number
     mutable bool is_init;
     mutable char equed;
     void free_supermatrix() {
@@ -251,12 +252,19 @@ namespace gmm {
     std::vector<R> ferr, berr;
     std::vector<T> rhs;
     std::vector<T> sol;
-    void build_with(const gmm::csc_matrix<T> &A, int permc_spec);
+    void build_with(const gmm::csc_matrix<T> &A, int permc_spec,
+                    bool same_pattern, bool condition_number);
     void solve(int transp);
+    void solve_multiple(T *x, const T *b, int nrhs, int transp);
+  protected:
+    void solve_(SuperMatrix *pSB, SuperMatrix *pSX, R *pferr, R *pberr,
+                int transp);
   };
 
   template <typename T>
-  void SuperLU_factor_impl<T>::build_with(const gmm::csc_matrix<T> &A, int permc_spec) {
+  void SuperLU_factor_impl<T>::build_with(const gmm::csc_matrix<T> &A, int permc_spec,
+                                          bool same_pattern,
+                                          bool condition_number) {
     /*
      * Get column permutation vector perm_c[], according to permc_spec:
      *   permc_spec = 0: use the natural ordering 
@@ -264,8 +272,11 @@ namespace gmm {
      *   permc_spec = 2: use minimum degree ordering on structure of A'+A
      *   permc_spec = 3: use approximate minimum degree column ordering
      */
-    free_supermatrix();
     int n = int(mat_nrows(A)), m = int(mat_ncols(A)), info = 0;
+    // perm_c and etree of the previous factorization are reused
+    same_pattern = same_pattern && is_init && perm_c.size() == size_type(n);
+    free_supermatrix();
+    is_init = false;
 
     rhs.resize(m); sol.resize(m);
     gmm::clear(rhs);
@@ -277,12 +288,13 @@ namespace gmm {
     set_default_options(&options);
     options.ColPerm = NATURAL;
     options.PrintStat = NO;
-    options.ConditionNumber = NO;
+    options.ConditionNumber = condition_number ? YES : NO;
     switch (permc_spec) {
       case 1 : options.ColPerm = MMD_ATA; break;
       case 2 : options.ColPerm = MMD_AT_PLUS_A; break;
       case 3 : options.ColPerm = COLAMD; break;
     }
+    if (same_pattern) options.Fact = SamePattern;
     StatInit(&stat);
     
     Create_CompCol_Matrix(&SA, m, n, nz, const_cast<T*>(&A.pr[0]),
@@ -297,7 +309,7 @@ namespace gmm {
     equed = 'B';
     Rscale.resize(m); Cscale.resize(n); etree.resize(n);
     ferr.resize(1); berr.resize(1);
-    R recip_pivot_gross, rcond;
+    R recip_pivot_gross, rcond_ = 0;
     perm_r.resize(m); perm_c.resize(n);
     memory_used = SuperLU_gssvx(&options, &SA, &perm_c[0], &perm_r[0], 
                                 &etree[0] /* output */, &equed /* output        */, 
@@ -309,7 +321,7 @@ namespace gmm {
                                 &SB /* rhs */, &SX /* solution                  */,
                                 &recip_pivot_gross /* reciprocal pivot growth   */
                                 /* factor max_j( norm(A_j)/norm(U_j) ).         */,  
-                                &rcond /*estimate of the reciprocal condition   */
+                                &rcond_ /*estimate of the reciprocal condition   */
                                 /* number of the matrix A after equilibration   */,
                                 &ferr[0] /* estimated forward error             */,
                                 &berr[0] /* relative backward error             */,
@@ -323,11 +335,33 @@ namespace gmm {
     
     GMM_ASSERT1(info != -333333333, "SuperLU was cancelled.");
     GMM_ASSERT1(info == 0, "SuperLU solve failed: info=" << info);
+    rcond = double(rcond_);
     is_init = true;
   }
 
   template <typename T> 
-  void SuperLU_factor_impl<T>::solve(int transp) {
+  void SuperLU_factor_impl<T>::solve(int transp)
+  { solve_(&SB, &SX, &ferr[0], &berr[0], transp); }
+
+  template <typename T> 
+  void SuperLU_factor_impl<T>::solve_multiple(T *x, const T *b, int nrhs,
+                                              int transp) {
+    int m = int(rhs.size());
+    if (nrhs <= 0 || m == 0) return;
+    // b is copied since it is modified by the equilibration
+    std::vector<T> bb(b, b + size_type(m) * size_type(nrhs));
+    std::vector<R> ferrm(nrhs), berrm(nrhs);
+    SuperMatrix SBm, SXm;
+    Create_Dense_Matrix(&SBm, m, nrhs, &bb[0], m);
+    Create_Dense_Matrix(&SXm, m, nrhs, x, m);
+    solve_(&SBm, &SXm, &ferrm[0], &berrm[0], transp);
+    Destroy_SuperMatrix_Store(&SBm);
+    Destroy_SuperMatrix_Store(&SXm);
+  }
+
+  template <typename T> 
+  void SuperLU_factor_impl<T>::solve_(SuperMatrix *pSB, SuperMatrix *pSX,
+                                      R *pferr, R *pberr, int transp) {
     options.Fact = FACTORED;
     options.IterRefine = NOREFINE;
     switch (transp) {
@@ -346,21 +380,24 @@ namespace gmm {
                   &SL /* fact L (output)*/, &SU /* fact U (output)*/, 
                   NULL /* work                                    */, 
                   0 /* lwork: superlu auto allocates (input)      */, 
-                  &SB /* rhs */, &SX /* solution                  */,
+                  pSB /* rhs */, pSX /* solution                    */,
                   &recip_pivot_gross /* reciprocal pivot growth   */
                   /* factor max_j( norm(A_j)/norm(U_j) ).         */,  
                   &rcond /*estimate of the reciprocal condition   */
                   /* number of the matrix A after equilibration   */,
-                  &ferr[0] /* estimated forward error             */,
-                  &berr[0] /* relative backward error             */,
+                  pferr /* estimated forward error                */,
+                  pberr /* relative backward error                */,
                   &stat, &info, T());
     StatFree(&stat);
     GMM_ASSERT1(info == 0, "SuperLU solve failed: info=" << info);
   }
    
   template<typename T> void 
-  SuperLU_factor<T>::build_with(const gmm::csc_matrix<T> &A, int permc_spec) {
-    ((SuperLU_factor_impl<T>*)impl.get())->build_with(A,permc_spec);
+  SuperLU_factor<T>::build_with(const gmm::csc_matrix<T> &A, int permc_spec,
+                                bool same_pattern, bool condition_number) {
+    ((SuperLU_factor_impl<T>*)impl.get())->build_with(A, permc_spec,
+                                                      same_pattern,
+                                                      condition_number);
   }
 
   template<typename T> void
@@ -368,6 +405,13 @@ namespace gmm {
     ((SuperLU_factor_impl<T>*)impl.get())->solve(transp);
   }
 
+  template<typename T> void
+  SuperLU_factor<T>::solve_multiple(T *X, const T *B, size_type nrhs,
+                                    int transp) const {
+    ((SuperLU_factor_impl<T>*)impl.get())->solve_multiple(X, B, int(nrhs),
+                                                          transp);
+  }
+
   template<typename T> std::vector<T> &
   SuperLU_factor<T>::sol() const {
     return ((SuperLU_factor_impl<T>*)impl.get())->sol;
@@ -403,6 +447,11 @@ namespace gmm {
     return impl->memory_used;
   }
 
+  template<typename T> double
+  SuperLU_factor<T>::rcond() const {
+    return impl->rcond;
+  }
+
   /*  void force_instantiation() {
     SuperLU_factor<float> a;
     SuperLU_factor<double> b;
@@ -163,19 +163,14 @@ namespace gmm {
   }
 
 
-  /** MUMPS solve interface  
-   *  Works only with sparse or skyline matrices
-   */
-  template <typename MAT, typename VECTX, typename VECTB>
-  bool MUMPS_solve(const MAT &A, const VECTX &X_, const VECTB &B,
-                   bool sym = false, bool distributed = false) {
-    VECTX &X = const_cast<VECTX &>(X_);
-
-    typedef typename linalg_traits<MAT>::value_type T;
+  // Solve for the nrhs right hand sides stored column by column in rhs,
+  // which contains the solutions on output (on all the processes).
+  template <typename MAT, typename T>
+  bool MUMPS_solve_(const MAT &A, std::vector<T> &rhs, size_type nrhs,
+                    bool sym, bool distributed) {
     typedef typename mumps_interf<T>::value_type MUMPS_T;
     GMM_ASSERT2(gmm::mat_nrows(A) == gmm::mat_ncols(A), "Non-square matrix");
-  
-    std::vector<T> rhs(gmm::vect_size(B)); gmm::copy(B, rhs);
+    GMM_ASSERT2(rhs.size() == gmm::mat_nrows(A) * nrhs, "dimensions mismatch");
 
     ij_sparse_matrix<T> AA(A, sym);
   
@@ -209,8 +204,11 @@ namespace gmm {
         id.jcn = &(AA.jcn[0]);
         id.a = (MUMPS_T*)(&(AA.a[0]));
       }
-      if (rank == 0)
+      if (rank == 0) {
         id.rhs = (MUMPS_T*)(&(rhs[0]));
+        id.nrhs = int(nrhs);
+        id.lrhs = id.n;
+      }
     }
 
     id.ICNTL(1) = -1; // output stream for error messages
@@ -240,13 +238,42 @@ namespace gmm {
     mumps_interf<T>::mumps_c(id);
 
 #ifdef GMM_USES_MPI
-    MPI_Bcast(&(rhs[0]),id.n,gmm::mpi_type(T()),0,MPI_COMM_WORLD);
+    MPI_Bcast(&(rhs[0]), int(rhs.size()), gmm::mpi_type(T()), 0,
+              MPI_COMM_WORLD);
 #endif
 
-    gmm::copy(rhs, X);
+    return ok;
+  }
 
+  /** MUMPS solve interface  
+   *  Works only with sparse or skyline matrices
+   */
+  template <typename MAT, typename VECTX, typename VECTB>
+  bool MUMPS_solve(const MAT &A, const VECTX &X_, const VECTB &B,
+                   bool sym = false, bool distributed = false) {
+    VECTX &X = const_cast<VECTX &>(X_);
+    typedef typename linalg_traits<MAT>::value_type T;
+    std::vector<T> rhs(gmm::vect_size(B)); gmm::copy(B, rhs);
+    bool ok = MUMPS_solve_(A, rhs, 1, sym, distributed);
+    gmm::copy(rhs, X);
     return ok;
+  }
 
+  /** MUMPS solve interface for several right hand sides (the columns of
+   *  B) which share the analysis and the factorization.
+   *  Works only with sparse or skyline matrices
+   */
+  template <typename MAT, typename MATX, typename MATB>
+  bool MUMPS_solve_multiple(const MAT &A, const MATX &X_, const MATB &B,
+                            bool sym = false, bool distributed = false) {
+    MATX &X = const_cast<MATX &>(X_);
+    typedef typename linalg_traits<MAT>::value_type T;
+    if (gmm::mat_ncols(B) == 0) return true;
+    gmm::dense_matrix<T> rhs(gmm::mat_nrows(B), gmm::mat_ncols(B));
+    gmm::copy(B, rhs);
+    bool ok = MUMPS_solve_(A, rhs, gmm::mat_ncols(B), sym, distributed);
+    gmm::copy(rhs, X);
+    return ok;
   }
 
 
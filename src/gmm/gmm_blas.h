@@ -252,6 +252,42 @@ namespace gmm {
   ///@cond DOXY_SHOW_ALL_FUNCTIONS
   
 
+  /* ******************************************************************** */
+  /*		Multithreading of the basic kernels            		  */
+  /* ******************************************************************** */
+
+  // When GETFEM_HAS_OPENMP is defined, the scalar products, norms and
+  // additions of large dense vectors and the products of large matrices by
+  // dense vectors are shared between the threads (outside of a parallel
+  // region only). The reductions are done in a fixed order, so that the
+  // results do not depend on the scheduling. For the scalar products and
+  // the norms, the partial sums are computed on blocks of fixed size, so
+  // that the results do not depend on the number of threads either.
+
+  const size_type omp_vect_min_size = 16384; // Minimal size for vectors
+  const size_type omp_mat_min_size = 2048;   // Minimal size for matrices
+  const size_type omp_block_size = 4096;     // Size of the reduction blocks
+
+  inline bool omp_kernel_enabled(size_type n, size_type nmin) {
+#ifdef GETFEM_HAS_OPENMP
+    return n >= nmin && omp_get_max_threads() > 1 && !omp_in_parallel();
+#else
+    GMM_NOPERATION(n); GMM_NOPERATION(nmin);
+    return false;
+#endif
+  }
+
+  // The reduction by blocks is also used when a parallel region is
+  // already active (in a sequential way) to give the same results.
+  inline bool omp_reduction_enabled(size_type n) {
+#ifdef GETFEM_HAS_OPENMP
+    return n >= omp_vect_min_size;
+#else
+    GMM_NOPERATION(n);
+    return false;
+#endif
+  }
+
   /* ******************************************************************** */
   /*		Scalar product                             		  */
   /* ******************************************************************** */
@@ -387,12 +423,51 @@ namespace gmm {
   template <typename IT1, typename IT2> inline
   typename strongest_numeric_type<typename std::iterator_traits<IT1>::value_type,
 				  typename std::iterator_traits<IT2>::value_type>::T
-  vect_sp_dense_(IT1 it, IT1 ite, IT2 it2) {
+  vect_sp_dense_(IT1 it, IT1 ite, IT2 it2, std::input_iterator_tag,
+		 std::input_iterator_tag) {
     typename strongest_numeric_type<typename std::iterator_traits<IT1>::value_type,
       typename std::iterator_traits<IT2>::value_type>::T res(0);
     for (; it != ite; ++it, ++it2) res += (*it) * (*it2);
     return res;
   }
+
+  template <typename IT1, typename IT2> inline
+  typename strongest_numeric_type<typename std::iterator_traits<IT1>::value_type,
+				  typename std::iterator_traits<IT2>::value_type>::T
+  vect_sp_dense_(IT1 it, IT1 ite, IT2 it2, std::random_access_iterator_tag,
+		 std::random_access_iterator_tag) {
+    typedef typename strongest_numeric_type<typename std::iterator_traits<IT1>
+      ::value_type, typename std::iterator_traits<IT2>::value_type>::T T;
+    size_type n = size_type(ite - it);
+    if (!omp_reduction_enabled(n))
+      return vect_sp_dense_(it, ite, it2, std::input_iterator_tag(),
+			    std::input_iterator_tag());
+    long nb = long((n + omp_block_size - 1) / omp_block_size);
+    std::vector<T> partial(nb);
+#ifdef GETFEM_HAS_OPENMP
+    #pragma omp parallel for schedule(static) \
+      if (omp_kernel_enabled(n, omp_vect_min_size))
+#endif
+    for (long b = 0; b < nb; ++b) {
+      size_type i0 = size_type(b) * omp_block_size;
+      size_type i1 = std::min(n, i0 + omp_block_size);
+      partial[b] = vect_sp_dense_(it + i0, it + i1, it2 + i0,
+				  std::input_iterator_tag(),
+				  std::input_iterator_tag());
+    }
+    T res(0);
+    for (long b = 0; b < nb; ++b) res += partial[b];
+    return res;
+  }
+
+  template <typename IT1, typename IT2> inline
+  typename strongest_numeric_type<typename std::iterator_traits<IT1>::value_type,
+				  typename std::iterator_traits<IT2>::value_type>::T
+  vect_sp_dense_(IT1 it, IT1 ite, IT2 it2) {
+    return vect_sp_dense_(it, ite, it2,
+			  typename std::iterator_traits<IT1>::iterator_category(),
+			  typename std::iterator_traits<IT2>::iterator_category());
+  }
   
   template <typename IT1, typename V> inline
     typename strongest_numeric_type<typename std::iterator_traits<IT1>::value_type,
@@ -518,6 +593,17 @@ namespace gmm {
     return vect_sp(ps, v1, gmm::conjugated(v2));
   }
 
+  /** Several hermitian products with a matrix :
+      res[k] = vect_hp(ps, *(v1[k]), *(v2[k])) for k < nb. For a
+      distributed scalar product, the global reductions are merged into a
+      single one (see mpi_distributed_matrix). */
+  template <typename MATSP, typename V1, typename V2, typename T> inline
+  void vect_hp_multiple(const MATSP &ps, const V1 *const *v1,
+			const V2 *const *v2, T *res, size_type nb) {
+    for (size_type k = 0; k < nb; ++k)
+      res[k] = vect_hp(ps, *(v1[k]), *(v2[k]));
+  }
+
   /* ******************************************************************** */
   /*		Trace of a matrix                             		  */
   /* ******************************************************************** */
@@ -537,19 +623,53 @@ namespace gmm {
   /*		Euclidean norm                             		  */
   /* ******************************************************************** */
 
-  /** squared Euclidean norm of a vector. */
-  template <typename V>
-  typename number_traits<typename linalg_traits<V>::value_type>
+  template <typename IT>
+  typename number_traits<typename std::iterator_traits<IT>::value_type>
   ::magnitude_type
-  vect_norm2_sqr(const V &v) {
-    typedef typename linalg_traits<V>::value_type T;
+  vect_norm2_sqr_(IT it, IT ite, std::input_iterator_tag) {
+    typedef typename std::iterator_traits<IT>::value_type T;
     typedef typename number_traits<T>::magnitude_type R;
-    auto it = vect_const_begin(v), ite = vect_const_end(v);
     R res(0);
     for (; it != ite; ++it) res += gmm::abs_sqr(*it);
     return res;
   }
 
+  template <typename IT>
+  typename number_traits<typename std::iterator_traits<IT>::value_type>
+  ::magnitude_type
+  vect_norm2_sqr_(IT it, IT ite, std::random_access_iterator_tag) {
+    typedef typename std::iterator_traits<IT>::value_type T;
+    typedef typename number_traits<T>::magnitude_type R;
+    size_type n = size_type(ite - it);
+    if (!omp_reduction_enabled(n))
+      return vect_norm2_sqr_(it, ite, std::input_iterator_tag());
+    long nb = long((n + omp_block_size - 1) / omp_block_size);
+    std::vector<R> partial(nb);
+#ifdef GETFEM_HAS_OPENMP
+    #pragma omp parallel for schedule(static) \
+      if (omp_kernel_enabled(n, omp_vect_min_size))
+#endif
+    for (long b = 0; b < nb; ++b) {
+      size_type i0 = size_type(b) * omp_block_size;
+      size_type i1 = std::min(n, i0 + omp_block_size);
+      partial[b] = vect_norm2_sqr_(it + i0, it + i1,
+				   std::input_iterator_tag());
+    }
+    R res(0);
+    for (long b = 0; b < nb; ++b) res += partial[b];
+    return res;
+  }
+
+  /** squared Euclidean norm of a vector. */
+  template <typename V>
+  typename number_traits<typename linalg_traits<V>::value_type>
+  ::magnitude_type
+  vect_norm2_sqr(const V &v) {
+    typedef typename linalg_traits<V>::const_iterator IT;
+    return vect_norm2_sqr_(vect_const_begin(v), vect_const_end(v),
+		   typename std::iterator_traits<IT>::iterator_category());
+  }
+
   /** Euclidean norm of a vector. */
   template <typename V> inline
    typename number_traits<typename linalg_traits<V>::value_type>
@@ -1452,10 +1572,41 @@ namespace gmm {
   }
 
   template <typename IT1, typename IT2, typename IT3>
-    void add_full_(IT1 it1, IT2 it2, IT3 it3, IT3 ite) {
+  void add_full_(IT1 it1, IT2 it2, IT3 it3, IT3 ite, std::input_iterator_tag,
+		 std::input_iterator_tag, std::input_iterator_tag) {
     for (; it3 != ite; ++it3, ++it2, ++it1) *it3 = *it1 + *it2;
   }
 
+  template <typename IT1, typename IT2, typename IT3>
+  void add_full_(IT1 it1, IT2 it2, IT3 it3, IT3 ite,
+		 std::random_access_iterator_tag,
+		 std::random_access_iterator_tag,
+		 std::random_access_iterator_tag) {
+    size_type n = size_type(ite - it3);
+    if (!omp_kernel_enabled(n, omp_vect_min_size))
+      return add_full_(it1, it2, it3, ite, std::input_iterator_tag(),
+		       std::input_iterator_tag(), std::input_iterator_tag());
+    long nb = long((n + omp_block_size - 1) / omp_block_size);
+#ifdef GETFEM_HAS_OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (long b = 0; b < nb; ++b) {
+      size_type i0 = size_type(b) * omp_block_size;
+      size_type i1 = std::min(n, i0 + omp_block_size);
+      add_full_(it1 + i0, it2 + i0, it3 + i0, it3 + i1,
+		std::input_iterator_tag(), std::input_iterator_tag(),
+		std::input_iterator_tag());
+    }
+  }
+
+  template <typename IT1, typename IT2, typename IT3>
+    void add_full_(IT1 it1, IT2 it2, IT3 it3, IT3 ite) {
+    add_full_(it1, it2, it3, ite,
+	      typename std::iterator_traits<IT1>::iterator_category(),
+	      typename std::iterator_traits<IT2>::iterator_category(),
+	      typename std::iterator_traits<IT3>::iterator_category());
+  }
+
   template <typename IT1, typename IT2, typename IT3>
     void add_almost_full_(IT1 it1, IT1 ite1, IT2 it2, IT3 it3, IT3 ite3) {
     IT3 it = it3;
@@ -1539,11 +1690,37 @@ namespace gmm {
 	       typename linalg_traits<L2>::index_sorted>::bool_type());
   }
 
+  template <typename IT1, typename IT2>
+  void add_dense_(IT1 it1, IT2 it2, IT2 ite, std::input_iterator_tag,
+		  std::input_iterator_tag)
+  { for (; it2 != ite; ++it2, ++it1) *it2 += *it1; }
+
+  template <typename IT1, typename IT2>
+  void add_dense_(IT1 it1, IT2 it2, IT2 ite, std::random_access_iterator_tag,
+		  std::random_access_iterator_tag) {
+    size_type n = size_type(ite - it2);
+    if (!omp_kernel_enabled(n, omp_vect_min_size))
+      return add_dense_(it1, it2, ite, std::input_iterator_tag(),
+			std::input_iterator_tag());
+    long nb = long((n + omp_block_size - 1) / omp_block_size);
+#ifdef GETFEM_HAS_OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (long b = 0; b < nb; ++b) {
+      size_type i0 = size_type(b) * omp_block_size;
+      size_type i1 = std::min(n, i0 + omp_block_size);
+      add_dense_(it1 + i0, it2 + i0, it2 + i1, std::input_iterator_tag(),
+		 std::input_iterator_tag());
+    }
+  }
+
   template <typename L1, typename L2>
   void add(const L1& l1, L2& l2, abstract_dense, abstract_dense) {
-    auto it1 = vect_const_begin(l1); 
-    auto it2 = vect_begin(l2), ite = vect_end(l2);
-    for (; it2 != ite; ++it2, ++it1) *it2 += *it1;
+    typedef typename linalg_traits<L1>::const_iterator IT1;
+    typedef typename linalg_traits<L2>::iterator IT2;
+    add_dense_(vect_const_begin(l1), vect_begin(l2), vect_end(l2),
+	       typename std::iterator_traits<IT1>::iterator_category(),
+	       typename std::iterator_traits<IT2>::iterator_category());
   }
 
   template <typename L1, typename L2>
@@ -1699,8 +1876,38 @@ namespace gmm {
     }
   }
 
+  // Product by rows shared between the threads.
+  template <typename L1, typename L2, typename L3>
+  void mult_by_row_omp_(const L1& l1, const L2& l2, L3& l3, bool add) {
+    auto it = vect_begin(l3);
+    long nr = long(mat_nrows(l1));
+#ifdef GETFEM_HAS_OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (long i = 0; i < nr; ++i) {
+      auto aux = vect_sp(mat_const_row(l1, size_type(i)), l2);
+      if (add) *(it + i) += aux; else *(it + i) = aux;
+    }
+  }
+
+  template <typename L1, typename L2, typename L3>
+  bool mult_by_row_omp_(const L1& l1, const L2& l2, L3& l3, bool add,
+			std::random_access_iterator_tag) {
+    if (!omp_kernel_enabled(mat_nrows(l1), omp_mat_min_size)) return false;
+    mult_by_row_omp_(l1, l2, l3, add);
+    return true;
+  }
+
+  template <typename L1, typename L2, typename L3>
+  bool mult_by_row_omp_(const L1&, const L2&, L3&, bool,
+			std::input_iterator_tag) { return false; }
+
   template <typename L1, typename L2, typename L3>
   void mult_by_row(const L1& l1, const L2& l2, L3& l3, abstract_dense) {
+    typedef typename linalg_traits<L3>::iterator IT3;
+    if (mult_by_row_omp_(l1, l2, l3, false,
+		  typename std::iterator_traits<IT3>::iterator_category()))
+      return;
     typename linalg_traits<L3>::iterator it=vect_begin(l3), ite=vect_end(l3);
     auto itr = mat_row_const_begin(l1); 
     for (; it != ite; ++it, ++itr)
@@ -1709,9 +1916,77 @@ namespace gmm {
 		    typename linalg_traits<L2>::storage_type());
   }
 
+  // Product by columns shared between the threads, for matrices whose
+  // columns are dense. Each thread accumulates the contribution of a range
+  // of columns in a private vector, released at the end of the product.
+  // The sum of the private vectors is done in the order of the threads, so
+  // that the result does not depend on the scheduling.
+  template <typename L1, typename L2, typename L3>
+  void mult_add_by_col_omp_(const L1& l1, const L2& l2, L3& l3) {
+#ifdef GETFEM_HAS_OPENMP
+    typedef typename linalg_traits<L3>::value_type T;
+    size_type nc = mat_ncols(l1), nr = vect_size(l3);
+    std::vector<std::vector<T> > acc(omp_get_max_threads());
+    auto it = vect_begin(l3);
+    #pragma omp parallel
+    {
+      size_type nt = size_type(omp_get_num_threads());
+      size_type t = size_type(omp_get_thread_num());
+      acc[t].assign(nr, T(0));
+      for (size_type j = (nc*t)/nt; j < (nc*(t+1))/nt; ++j)
+	add(scaled(mat_const_col(l1, j), l2[j]), acc[t]);
+      #pragma omp barrier
+      #pragma omp for schedule(static)
+      for (long i = 0; i < long(nr); ++i) {
+	T aux(0);
+	for (size_type k = 0; k < nt; ++k) aux += acc[k][i];
+	*(it + i) += aux;
+      }
+    }
+#else
+    GMM_NOPERATION(l1); GMM_NOPERATION(l2); GMM_NOPERATION(l3);
+#endif
+  }
+
+  template <typename L1, typename L2, typename L3>
+  bool mult_add_by_col_omp_(const L1& l1, const L2& l2, L3& l3,
+			    abstract_dense) {
+    if (!omp_kernel_enabled(std::min(mat_nrows(l1), mat_ncols(l1)),
+			    omp_mat_min_size)) return false;
+    mult_add_by_col_omp_(l1, l2, l3);
+    return true;
+  }
+
+  // The sparse columns are not shared: the private vectors would cost
+  // more than the product itself.
+  template <typename L1, typename L2, typename L3, typename ST>
+  bool mult_add_by_col_omp_(const L1&, const L2&, L3&, ST)
+  { return false; }
+
+  template <typename L1, typename L2, typename L3>
+  bool mult_add_by_col_omp_(const L1& l1, const L2& l2, L3& l3,
+			    abstract_dense, std::random_access_iterator_tag) {
+    typedef typename linalg_traits<L1>::const_sub_col_type COL;
+    return mult_add_by_col_omp_(l1, l2, l3,
+				typename linalg_traits<COL>::storage_type());
+  }
+
+  template <typename L1, typename L2, typename L3, typename ST>
+  bool mult_add_by_col_omp_(const L1&, const L2&, L3&, ST,
+			    std::input_iterator_tag) { return false; }
+
+  template <typename L1, typename L2, typename L3>
+  bool mult_add_by_col_try_omp_(const L1& l1, const L2& l2, L3& l3) {
+    typedef typename linalg_traits<L3>::iterator IT3;
+    return mult_add_by_col_omp_(l1, l2, l3,
+		  typename linalg_traits<L3>::storage_type(),
+		  typename std::iterator_traits<IT3>::iterator_category());
+  }
+
   template <typename L1, typename L2, typename L3>
   void mult_by_col(const L1& l1, const L2& l2, L3& l3, abstract_dense) {
     clear(l3);
+    if (mult_add_by_col_try_omp_(l1, l2, l3)) return;
     size_type nc = mat_ncols(l1);
     for (size_type i = 0; i < nc; ++i)
       add(scaled(mat_const_col(l1, i), l2[i]), l3);
@@ -1822,6 +2097,10 @@ namespace gmm {
 
   template <typename L1, typename L2, typename L3>
   void mult_add_by_row(const L1& l1, const L2& l2, L3& l3, abstract_dense) {
+    typedef typename linalg_traits<L3>::iterator IT3;
+    if (mult_by_row_omp_(l1, l2, l3, true,
+		  typename std::iterator_traits<IT3>::iterator_category()))
+      return;
     auto it=vect_begin(l3), ite=vect_end(l3);
     auto itr = mat_row_const_begin(l1);
     for (; it != ite; ++it, ++itr)
@@ -1830,6 +2109,7 @@ namespace gmm {
 
   template <typename L1, typename L2, typename L3>
   void mult_add_by_col(const L1& l1, const L2& l2, L3& l3, abstract_dense) {
+    if (mult_add_by_col_try_omp_(l1, l2, l3)) return;
     size_type nc = mat_ncols(l1);
     for (size_type i = 0; i < nc; ++i)
       add(scaled(mat_const_col(l1, i), l2[i]), l3);
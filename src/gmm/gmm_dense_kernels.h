@@ -0,0 +1,409 @@
+/* -*- c++ -*- (enables emacs c++ mode) */
+/*===========================================================================
+
+ Copyright (C) 2026 agent
+
+ This file is a part of GetFEM
+
+ GetFEM  is  free software;  you  can  redistribute  it  and/or modify it
+ under  the  terms  of the  GNU  Lesser General Public License as published
+ by  the  Free Software Foundation;  either version 3 of the License,  or
+ (at your option) any later version along with the GCC Runtime Library
+ Exception either version 3.1 or (at your option) any later version.
+ This program  is  distributed  in  the  hope  that it will be useful,  but
+ WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ or  FITNESS  FOR  A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ License and GCC Runtime Library Exception for more details.
+ You  should  have received a copy of the GNU Lesser General Public License
+ along  with  this program;  if not, write to the Free Software Foundation,
+ Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA.
+
+ As a special exception, you  may use  this file  as it is a part of a free
+ software  library  without  restriction.  Specifically,  if   other  files
+ instantiate  templates  or  use macros or inline functions from this file,
+ or  you compile this  file  and  link  it  with other files  to produce an
+ executable, this file  does  not  by itself cause the resulting executable
+ to be covered  by the GNU Lesser General Public License.  This   exception
+ does not  however  invalidate  any  other  reasons why the executable file
+ might be covered by the GNU Lesser General Public License.
+
+===========================================================================*/
+
+/**@file gmm_dense_kernels.h
+   @author  agent <agent@local>
+   @date October 18, 2026.
+   @brief Cache blocked dense matrix-matrix and matrix-vector products.
+
+   The products of dense_matrix<double> and dense_matrix<std::complex<double>
+   > are done with these kernels when no BLAS is interfaced. The matrix-
+   matrix product follows the organisation of K. Goto and R. van de Geijn,
+   Anatomy of high-performance matrix multiplication, ACM Trans. Math.
+   Softw. 34(3), 2008: blocks of the operands are copied in contiguous
+   panels which stay in the caches and a small register tile of the result
+   is computed by a fixed size kernel that the compiler vectorizes.
+*/
+
+#ifndef GMM_DENSE_KERNELS_H__
+#define GMM_DENSE_KERNELS_H__
+
+#include "gmm_blas.h"
+#include "gmm_interface.h"
+#include "gmm_matrix.h"
+
+namespace gmm {
+
+  /* ******************************************************************** */
+  /*		Blocked matrix-matrix product                   	  */
+  /* ******************************************************************** */
+
+  /** Operation applied to an operand of dense_gemm. */
+  enum dense_op_type { DENSE_N, DENSE_T, DENSE_C };
+
+  // Sizes of the register tile (mr x nr) and of the blocks of op(A)
+  // (mc x kc, kept in the L2 cache) and op(B) (kc x nc). For complex
+  // numbers, the real and imaginary parts are stored separately in the
+  // panels to avoid the complex multiplication of the library.
+  template <typename T> struct dense_kernel_sizes {
+    typedef T R;
+    static const size_type ncomp = 1, mr = 4, nr = 4;
+    static const size_type mc = 96, kc = 256, nc = 2048;
+  };
+
+  template <typename T> struct dense_kernel_sizes<std::complex<T> > {
+    typedef T R;
+    static const size_type ncomp = 2, mr = 4, nr = 2;
+    static const size_type mc = 64, kc = 192, nc = 1024;
+  };
+
+  const size_type dense_gemm_min_size = 32768; // min. value of m*n*k
+  const size_type omp_gemm_min_size = 128;    // min. value of min(m, n)
+
+  template <typename T> inline
+  T dense_op_elt_(const T *A, size_type ld, dense_op_type op,
+                  size_type i, size_type j) {
+    switch (op) {
+    case DENSE_N : return A[i + j*ld];
+    case DENSE_T : return A[j + i*ld];
+    default : return gmm::conj(A[j + i*ld]);
+    }
+  }
+
+  template <typename T> inline void dense_pack_(T *p, T v) { *p = v; }
+  template <typename T> inline void dense_pack_(T *p, std::complex<T> v)
+  { p[0] = v.real(); p[1] = v.imag(); }
+  template <typename T> inline void dense_unpack_(const T *p, T &v)
+  { v = *p; }
+  template <typename T> inline
+  void dense_unpack_(const T *p, std::complex<T> &v)
+  { v = std::complex<T>(p[0], p[1]); }
+
+  // Copy of op(A)(i0:i0+m, k0:k0+k) in panels of mr rows (completed with
+  // zeros), each panel being stored column by column.
+  template <typename T, typename R>
+  void dense_pack_A_(const T *A, size_type lda, dense_op_type op,
+                     size_type i0, size_type k0, size_type m, size_type k,
+                     R *pa) {
+    typedef dense_kernel_sizes<T> S;
+    for (size_type ip = 0; ip < m; ip += S::mr)
+      for (size_type l = 0; l < k; ++l, pa += S::mr*S::ncomp)
+        for (size_type i = 0; i < S::mr; ++i)
+          dense_pack_(pa + i*S::ncomp, (ip+i < m)
+                      ? dense_op_elt_(A, lda, op, i0+ip+i, k0+l) : T(0));
+  }
+
+  // Copy of op(B)(k0:k0+k, j0:j0+n) in panels of nr columns (completed
+  // with zeros), each panel being stored row by row.
+  template <typename T, typename R>
+  void dense_pack_B_(const T *B, size_type ldb, dense_op_type op,
+                     size_type k0, size_type j0, size_type k, size_type n,
+                     R *pb) {
+    typedef dense_kernel_sizes<T> S;
+    for (size_type jp = 0; jp < n; jp += S::nr)
+      for (size_type l = 0; l < k; ++l, pb += S::nr*S::ncomp)
+        for (size_type j = 0; j < S::nr; ++j)
+          dense_pack_(pb + j*S::ncomp, (jp+j < n)
+                      ? dense_op_elt_(B, ldb, op, k0+l, j0+jp+j) : T(0));
+  }
+
+  // ab = (mr x k panel of A) * (k x nr panel of B), real case.
+  template <size_type MR, size_type NR, typename R>
+  void dense_micro_kernel_(size_type k, const R *a, const R *b, R *ab,
+                           std::integral_constant<size_type, 1>) {
+    R c[MR*NR];
+    for (size_type l = 0; l < MR*NR; ++l) c[l] = R(0);
+    for (size_type l = 0; l < k; ++l, a += MR, b += NR)
+      for (size_type j = 0; j < NR; ++j) {
+        R bj = b[j];
+        for (size_type i = 0; i < MR; ++i) c[i+j*MR] += a[i] * bj;
+      }
+    for (size_type l = 0; l < MR*NR; ++l) ab[l] = c[l];
+  }
+
+  // Complex case, with the real and imaginary parts stored separately.
+  template <size_type MR, size_type NR, typename R>
+  void dense_micro_kernel_(size_type k, const R *a, const R *b, R *ab,
+                           std::integral_constant<size_type, 2>) {
+    R cr[MR*NR], ci[MR*NR];
+    for (size_type l = 0; l < MR*NR; ++l) cr[l] = ci[l] = R(0);
+    for (size_type l = 0; l < k; ++l, a += 2*MR, b += 2*NR)
+      for (size_type j = 0; j < NR; ++j) {
+        R br = b[2*j], bi = b[2*j+1];
+        for (size_type i = 0; i < MR; ++i) {
+          cr[i+j*MR] += a[2*i] * br - a[2*i+1] * bi;
+          ci[i+j*MR] += a[2*i] * bi + a[2*i+1] * br;
+        }
+      }
+    for (size_type l = 0; l < MR*NR; ++l)
+      { ab[2*l] = cr[l]; ab[2*l+1] = ci[l]; }
+  }
+
+  // C(ic:ic+mb, jc:jc+nb) += alpha * packed A * packed B.
+  template <typename T, typename R>
+  void dense_macro_kernel_(size_type mb, size_type nb, size_type kb,
+                           const R *pa, const R *pb, T alpha, T *C,
+                           size_type ldc) {
+    typedef dense_kernel_sizes<T> S;
+    const size_type MR = S::mr, NR = S::nr, NC = S::ncomp;
+    long njr = long((nb + NR - 1) / NR);
+#ifdef GETFEM_HAS_OPENMP
+    #pragma omp parallel for schedule(static) \
+      if (omp_kernel_enabled(std::min(mb, nb), omp_gemm_min_size))
+#endif
+    for (long jr = 0; jr < njr; ++jr) {
+      R ab[MR*NR*NC];
+      size_type j0 = size_type(jr)*NR, nj = std::min(NR, nb - j0);
+      for (size_type i0 = 0; i0 < mb; i0 += MR) {
+        size_type ni = std::min(MR, mb - i0);
+        dense_micro_kernel_<MR, NR>(kb, pa + i0*kb*NC, pb + j0*kb*NC, ab,
+                                    std::integral_constant<size_type, NC>());
+        for (size_type j = 0; j < nj; ++j)
+          for (size_type i = 0; i < ni; ++i) {
+            T v; dense_unpack_(ab + (i+j*MR)*NC, v);
+            C[i0 + i + (j0 + j)*ldc] += alpha * v;
+          }
+      }
+    }
+  }
+
+  /** C = alpha op(A) op(B) (+ C if add is true) for column major arrays,
+      op(A) being a m x k matrix and op(B) a k x n matrix. */
+  template <typename T>
+  void dense_gemm(size_type m, size_type n, size_type k, T alpha,
+                  const T *A, size_type lda, dense_op_type opa,
+                  const T *B, size_type ldb, dense_op_type opb,
+                  T *C, size_type ldc, bool add = false) {
+    typedef dense_kernel_sizes<T> S;
+    typedef typename S::R R;
+    if (!add)
+      for (size_type j = 0; j < n; ++j)
+        std::fill(C + j*ldc, C + j*ldc + m, T(0));
+    if (!m || !n || !k) return;
+
+    if (m*n*k < dense_gemm_min_size) { // Small matrices, no packing
+      for (size_type j = 0; j < n; ++j)
+        for (size_type l = 0; l < k; ++l) {
+          T b = alpha * dense_op_elt_(B, ldb, opb, l, j);
+          if (b == T(0)) continue;
+          T *c = C + j*ldc;
+          if (opa == DENSE_N) {
+            const T *a = A + l*lda;
+            for (size_type i = 0; i < m; ++i) c[i] += a[i] * b;
+          }
+          else
+            for (size_type i = 0; i < m; ++i)
+              c[i] += dense_op_elt_(A, lda, opa, i, l) * b;
+        }
+      return;
+    }
+
+    std::vector<R> pa(S::mc*S::kc*S::ncomp),
+      pb(std::min(S::nc, ((n + S::nr - 1)/S::nr)*S::nr)*S::kc*S::ncomp);
+    for (size_type jc = 0; jc < n; jc += S::nc) {
+      size_type nb = std::min(S::nc, n - jc);
+      for (size_type pc = 0; pc < k; pc += S::kc) {
+        size_type kb = std::min(S::kc, k - pc);
+        dense_pack_B_(B, ldb, opb, pc, jc, kb, nb, &pb[0]);
+        for (size_type ic = 0; ic < m; ic += S::mc) {
+          size_type mb = std::min(S::mc, m - ic);
+          dense_pack_A_(A, lda, opa, ic, pc, mb, kb, &pa[0]);
+          dense_macro_kernel_(mb, nb, kb, &pa[0], &pb[0], alpha,
+                              C + ic + jc*ldc, ldc);
+        }
+      }
+    }
+  }
+
+  /* ******************************************************************** */
+  /*		Blocked matrix-vector product                   	  */
+  /* ******************************************************************** */
+
+  const size_type dense_gemv_block = 512;
+
+  // y(i0:i1) += A(i0:i1, :) x, four columns at a time.
+  template <typename T>
+  void dense_gemv_block_(size_type i0, size_type i1, size_type n,
+                         const T *A, size_type lda, const T *x, T *y) {
+    size_type j = 0;
+    for (; j + 4 <= n; j += 4) {
+      const T *a0 = A + j*lda, *a1 = a0 + lda, *a2 = a1 + lda, *a3 = a2 + lda;
+      T x0 = x[j], x1 = x[j+1], x2 = x[j+2], x3 = x[j+3];
+      for (size_type i = i0; i < i1; ++i)
+        y[i] += a0[i] * x0 + a1[i] * x1 + a2[i] * x2 + a3[i] * x3;
+    }
+    for (; j < n; ++j) {
+      const T *a = A + j*lda; T xj = x[j];
+      for (size_type i = i0; i < i1; ++i) y[i] += a[i] * xj;
+    }
+  }
+
+  template <typename T>
+  void dense_gemv_block_(size_type i0, size_type i1, size_type n,
+                         const std::complex<T> *A_, size_type lda,
+                         const std::complex<T> *x, std::complex<T> *y_) {
+    const T *A = reinterpret_cast<const T *>(A_);
+    T *y = reinterpret_cast<T *>(y_);
+    size_type j = 0;
+    for (; j + 2 <= n; j += 2) {
+      const T *a0 = A + 2*j*lda, *a1 = a0 + 2*lda;
+      T x0r = x[j].real(), x0i = x[j].imag();
+      T x1r = x[j+1].real(), x1i = x[j+1].imag();
+      for (size_type i = i0; i < i1; ++i) {
+        y[2*i] += a0[2*i] * x0r - a0[2*i+1] * x0i
+          + a1[2*i] * x1r - a1[2*i+1] * x1i;
+        y[2*i+1] += a0[2*i] * x0i + a0[2*i+1] * x0r
+          + a1[2*i] * x1i + a1[2*i+1] * x1r;
+      }
+    }
+    for (; j < n; ++j) {
+      const T *a = A + 2*j*lda;
+      T xr = x[j].real(), xi = x[j].imag();
+      for (size_type i = i0; i < i1; ++i) {
+        y[2*i] += a[2*i] * xr - a[2*i+1] * xi;
+        y[2*i+1] += a[2*i] * xi + a[2*i+1] * xr;
+      }
+    }
+  }
+
+  /** y = A x (+ y if add is true) for a m x n column major array A. The
+      rows are treated by blocks which stay in the L1 cache, the blocks
+      being shared between the threads. */
+  template <typename T>
+  void dense_gemv(size_type m, size_type n, const T *A, size_type lda,
+                  const T *x, T *y, bool add = false) {
+    if (!add) std::fill(y, y + m, T(0));
+    if (!m || !n) return;
+    long nb = long((m + dense_gemv_block - 1) / dense_gemv_block);
+#ifdef GETFEM_HAS_OPENMP
+    #pragma omp parallel for schedule(static) \
+      if (omp_kernel_enabled(std::min(m, n), omp_mat_min_size))
+#endif
+    for (long ib = 0; ib < nb; ++ib) {
+      size_type i0 = size_type(ib) * dense_gemv_block;
+      dense_gemv_block_(i0, std::min(m, i0 + dense_gemv_block), n,
+                        A, lda, x, y);
+    }
+  }
+
+  /* ******************************************************************** */
+  /*   Products of dense matrices of double and complex<double> when no   */
+  /*   BLAS is interfaced.                                                */
+  /* ******************************************************************** */
+
+#if !defined(GETFEM_USES_BLAS) && !defined(GMM_USES_BLAS) \
+  && !defined(GMM_USES_LAPACK) && !defined(GMM_USES_ATLAS)
+
+# define gmm_dense_gemv_kernel(base_type)                                  \
+  inline void mult_spec(const dense_matrix<base_type > &A,                 \
+                        const std::vector<base_type > &x,                  \
+                        std::vector<base_type > &y, col_major) {           \
+    size_type m = mat_nrows(A), n = mat_ncols(A);                          \
+    if (m && n) dense_gemv(m, n, &A(0,0), m, &x[0], &y[0]);                \
+    else gmm::clear(y);                                                    \
+  }                                                                        \
+  inline void mult_add_spec(const dense_matrix<base_type > &A,             \
+                            const std::vector<base_type > &x,              \
+                            std::vector<base_type > &y, col_major) {       \
+    size_type m = mat_nrows(A), n = mat_ncols(A);                          \
+    if (m && n) dense_gemv(m, n, &A(0,0), m, &x[0], &y[0], true);          \
+  }
+
+  gmm_dense_gemv_kernel(double)
+  gmm_dense_gemv_kernel(std::complex<double>)
+
+  // Call of dense_gemm for C = op(A) op(B).
+# define gmm_dense_gemm_call(opa, opb)                                     \
+  size_type m = mat_nrows(C), n = mat_ncols(C);                            \
+  size_type k = (opa == DENSE_N) ? mat_ncols(A) : mat_nrows(A);            \
+  if (m && n && k)                                                         \
+    dense_gemm(m, n, k, T(1), &A(0,0), mat_nrows(A), opa,                  \
+               &B(0,0), mat_nrows(B), opb, &C(0,0), m);                    \
+  else gmm::clear(C);
+
+# define gmm_dense_gemm_kernel_nn(base_type)                               \
+  inline void mult_spec(const dense_matrix<base_type > &A,                 \
+                        const dense_matrix<base_type > &B,                 \
+                        dense_matrix<base_type > &C, c_mult) {             \
+    typedef base_type T;                                                   \
+    gmm_dense_gemm_call(DENSE_N, DENSE_N)                                  \
+  }
+
+# define gmm_dense_gemm_kernel_tn(base_type, is_const)                     \
+  inline void mult_spec(                                                   \
+         const transposed_col_ref<is_const<base_type > *> &A_,             \
+         const dense_matrix<base_type > &B,                                \
+         dense_matrix<base_type > &C, rcmult) {                            \
+    typedef base_type T;                                                   \
+    const dense_matrix<base_type > &A = *(linalg_origin(A_));              \
+    gmm_dense_gemm_call(DENSE_T, DENSE_N)                                  \
+  }
+
+# define gmm_dense_gemm_kernel_nt(base_type, is_const)                     \
+  inline void mult_spec(const dense_matrix<base_type > &A,                 \
+         const transposed_col_ref<is_const<base_type > *> &B_,             \
+         dense_matrix<base_type > &C, r_mult) {                            \
+    typedef base_type T;                                                   \
+    const dense_matrix<base_type > &B = *(linalg_origin(B_));              \
+    gmm_dense_gemm_call(DENSE_N, DENSE_T)                                  \
+  }
+
+# define gmm_dense_gemm_kernel_tt(base_type, is_const, is_const2)          \
+  inline void mult_spec(                                                   \
+         const transposed_col_ref<is_const<base_type > *> &A_,             \
+         const transposed_col_ref<is_const2<base_type > *> &B_,            \
+         dense_matrix<base_type > &C, r_mult) {                            \
+    typedef base_type T;                                                   \
+    const dense_matrix<base_type > &A = *(linalg_origin(A_));              \
+    const dense_matrix<base_type > &B = *(linalg_origin(B_));              \
+    gmm_dense_gemm_call(DENSE_T, DENSE_T)                                  \
+  }
+
+# define gmm_dense_gemm_kernel_cn(base_type)                               \
+  inline void mult_spec(                                                   \
+      const conjugated_col_matrix_const_ref<dense_matrix<base_type > > &A_,\
+      const dense_matrix<base_type > &B,                                   \
+      dense_matrix<base_type > &C, rcmult) {                               \
+    typedef base_type T;                                                   \
+    const dense_matrix<base_type > &A = *(linalg_origin(A_));              \
+    gmm_dense_gemm_call(DENSE_C, DENSE_N)                                  \
+  }
+
+# define gmm_dense_gemm_kernels(base_type)                                 \
+  gmm_dense_gemm_kernel_nn(base_type)                                      \
+  gmm_dense_gemm_kernel_tn(base_type, dense_matrix)                        \
+  gmm_dense_gemm_kernel_tn(base_type, const dense_matrix)                  \
+  gmm_dense_gemm_kernel_nt(base_type, dense_matrix)                        \
+  gmm_dense_gemm_kernel_nt(base_type, const dense_matrix)                  \
+  gmm_dense_gemm_kernel_tt(base_type, dense_matrix, dense_matrix)          \
+  gmm_dense_gemm_kernel_tt(base_type, const dense_matrix, dense_matrix)    \
+  gmm_dense_gemm_kernel_tt(base_type, dense_matrix, const dense_matrix)    \
+  gmm_dense_gemm_kernel_tt(base_type, const dense_matrix, const dense_matrix) \
+  gmm_dense_gemm_kernel_cn(base_type)
+
+  gmm_dense_gemm_kernels(double)
+  gmm_dense_gemm_kernels(std::complex<double>)
+
+#endif
+
+}
+
+#endif //  GMM_DENSE_KERNELS_H__
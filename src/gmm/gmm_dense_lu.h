@@ -155,6 +155,79 @@ namespace gmm {
     }
     return info;
   }
+
+  /** Right looking blocked LU factorization with partial pivoting (the
+      equivalent of LAPACK's dgetrf) of a column major dense_matrix. The
+      columns are factorized by panels of dense_lu_block columns and the
+      trailing matrix is updated with the blocked matrix-matrix product
+      dense_gemm. As for LAPACK, the factorization is completed when a
+      pivot vanishes and the index of the first vanishing pivot is returned.
+  */
+  const size_type dense_lu_block = 32;
+
+  template <typename T>
+  size_type lu_factor_blocked(dense_matrix<T> &A, lapack_ipvt &ipvt) {
+    typedef typename number_traits<T>::magnitude_type R;
+    size_type info(0), M(mat_nrows(A)), N(mat_ncols(A));
+    size_type NN = std::min(M, N);
+
+    GMM_ASSERT2(ipvt.size()+1 >= NN, "IPVT too small");
+    if (NN == 0) return 0;
+    T *a = &A(0,0);
+
+    for (size_type j0 = 0; j0 < NN; j0 += dense_lu_block) {
+      size_type j1 = std::min(NN, j0 + dense_lu_block), jb = j1 - j0;
+
+      for (size_type j = j0; j < j1; ++j) {	   /* panel factorization. */
+	T *cj = a + j*M;
+	R max = gmm::abs(cj[j]); size_type jp = j;
+	for (size_type i = j+1; i < M; ++i)
+	  if (gmm::abs(cj[i]) > max) { jp = i; max = gmm::abs(cj[i]); }
+	ipvt.set(j, jp + 1);
+	if (max == R(0)) { if (!info) info = j + 1; continue; }
+	if (jp != j)
+	  for (size_type k = j0; k < j1; ++k) std::swap(a[j+k*M], a[jp+k*M]);
+	T pinv = T(1) / cj[j];
+	for (size_type i = j+1; i < M; ++i) cj[i] *= pinv;
+	for (size_type k = j+1; k < j1; ++k) {
+	  T *ck = a + k*M, akj = ck[j];
+	  if (akj != T(0))
+	    for (size_type i = j+1; i < M; ++i) ck[i] -= cj[i] * akj;
+	}
+      }
+
+      for (size_type j = j0; j < j1; ++j) {	   /* interchanges outside */
+	size_type jp = ipvt.get(j) - 1;	   /* the panel.           */
+	if (jp != j) {
+	  for (size_type k = 0; k < j0; ++k) std::swap(a[j+k*M], a[jp+k*M]);
+	  for (size_type k = j1; k < N; ++k) std::swap(a[j+k*M], a[jp+k*M]);
+	}
+      }
+
+      if (j1 < N) {
+	for (size_type k = j1; k < N; ++k) {	   /* U12 = L11^-1 A12.    */
+	  T *ck = a + k*M;
+	  for (size_type j = j0; j < j1; ++j) {
+	    T v = ck[j];
+	    if (v != T(0))
+	      for (size_type i = j+1; i < j1; ++i) ck[i] -= a[i+j*M] * v;
+	  }
+	}
+	if (j1 < M)				   /* A22 -= L21 U12.      */
+	  dense_gemm(M-j1, N-j1, jb, T(-1), a + j1 + j0*M, M, DENSE_N,
+		     a + j0 + j1*M, M, DENSE_N, a + j1 + j1*M, M, true);
+      }
+    }
+    return info;
+  }
+
+#ifndef GMM_USES_LAPACK
+  inline size_type lu_factor(dense_matrix<double> &A, lapack_ipvt &ipvt)
+  { return lu_factor_blocked(A, ipvt); }
+  inline size_type lu_factor(dense_matrix<std::complex<double> > &A,
+			     lapack_ipvt &ipvt)
+  { return lu_factor_blocked(A, ipvt); }
+#endif
   
   /** LU Solve : Solve equation Ax=b, given an LU factored matrix.*/
   //  Thanks to Valient Gough for this routine!
@@ -141,6 +141,146 @@ namespace gmm {
     }
   }
 
+  /* ******************************************************************** */
+  /*   Blocked Householder QR factorization                               */
+  /* ******************************************************************** */
+
+  // The product H_0 ... H_{b-1} of the reflectors of a block is represented
+  // by I - V T V^H (compact WY representation, R. Schreiber and C. Van
+  // Loan, SIAM J. Sci. Stat. Comput. 10(1), 1989), where V (mv x b) stores
+  // the Householder vectors and T is upper triangular. The updates of the
+  // trailing matrix are then done with the blocked matrix-matrix product.
+  const size_type dense_qr_block = 32;
+
+  // gmm_dense_Householder.h may be incomplete here since it includes this
+  // file through gmm_kernel.h.
+  template <typename VECT> void house_vector(const VECT &VV);
+
+  // Computes V (with the unit diagonal) from the lower part of the columns
+  // j0 to j0+b of QR and T (b x b).
+  template <typename T>
+  void qr_block_reflector_(const dense_matrix<T> &QR, size_type j0,
+                           size_type b, std::vector<T> &V,
+                           std::vector<T> &TT) {
+    typedef typename number_traits<T>::magnitude_type R;
+    size_type m = mat_nrows(QR), mv = m - j0;
+    V.assign(mv*b, T(0)); TT.assign(b*b, T(0));
+    for (size_type j = 0; j < b; ++j) {
+      T *vj = &V[j*mv];
+      vj[j] = T(1);
+      for (size_type i = j+1; i < mv; ++i) vj[i] = QR(j0+i, j0+j);
+      R nv = R(0);
+      for (size_type i = j; i < mv; ++i) nv += gmm::abs_sqr(vj[i]);
+      T tau = T(R(2) / nv), *tj = &TT[j*b];
+      for (size_type k = 0; k < j; ++k) {   // z = V(:, 0:j)^H v_j
+        const T *vk = &V[k*mv]; T z(0);
+        for (size_type i = j; i < mv; ++i) z += gmm::conj(vk[i]) * vj[i];
+        tj[k] = z;
+      }
+      for (size_type k = 0; k < j; ++k) {   // T(0:j, j) = -tau T z
+        T z(0);
+        for (size_type l = k; l < j; ++l) z += TT[k+l*b] * tj[l];
+        tj[k] = z;
+      }
+      for (size_type k = 0; k < j; ++k) tj[k] *= -tau;
+      tj[j] = tau;
+    }
+  }
+
+  // A (mv x n, leading dimension lda) <- (I - V op(T) V^H) A where op(T)
+  // is T or T^H.
+  template <typename T>
+  void qr_apply_block_reflector_(size_type mv, size_type n, size_type b,
+                                 const std::vector<T> &V,
+                                 const std::vector<T> &TT, dense_op_type op,
+                                 T *A, size_type lda) {
+    if (!n) return;
+    std::vector<T> W(b*n), W2(b*n);
+    dense_gemm(b, n, mv, T(1), &V[0], mv, DENSE_C, A, lda, DENSE_N,
+               &W[0], b);
+    dense_gemm(b, n, b, T(1), &TT[0], b, op, &W[0], b, DENSE_N,
+               &W2[0], b);
+    dense_gemm(mv, n, b, T(-1), &V[0], mv, DENSE_N, &W2[0], b, DENSE_N,
+               A, lda, true);
+  }
+
+  /** Blocked version of qr_factor(A) for a dense_matrix. The result is the
+      same (up to the rounding errors) as the one of the unblocked version.
+  */
+  template <typename T>
+  void qr_factor_blocked(dense_matrix<T> &A) {
+    typedef typename number_traits<T>::magnitude_type R;
+    size_type m = mat_nrows(A), n = mat_ncols(A);
+    GMM_ASSERT2(m >= n, "dimensions mismatch");
+    if (n == 0) return;
+
+    std::vector<T> V, TT, v(m);
+    for (size_type j0 = 0; j0 < n; j0 += dense_qr_block) {
+      size_type j1 = std::min(n, j0 + dense_qr_block);
+
+      for (size_type j = j0; j < j1; ++j) {  // panel factorization
+        v.resize(m-j);
+        for (size_type i = j; i < m; ++i) v[i-j] = A(i, j);
+        house_vector(v);
+        T tau = T(R(-2) / vect_norm2_sqr(v));
+        for (size_type k = j; k < j1; ++k) {
+          T *ak = &A(j, k);
+          T w(0);
+          for (size_type i = 0; i < m-j; ++i) w += gmm::conj(v[i]) * ak[i];
+          w *= tau;
+          for (size_type i = 0; i < m-j; ++i) ak[i] += v[i] * w;
+        }
+        for (size_type i = j+1; i < m; ++i) A(i, j) = v[i-j];
+      }
+
+      if (j1 < n) {                          // trailing matrix update
+        qr_block_reflector_(A, j0, j1-j0, V, TT);
+        qr_apply_block_reflector_(m-j0, n-j1, j1-j0, V, TT, DENSE_C,
+                                  &A(j0, j1), m);
+      }
+    }
+  }
+
+  /** Blocked version of qr_factor(A, Q, R) for dense_matrix. */
+  template <typename T>
+  void qr_factor_blocked(const dense_matrix<T> &A, dense_matrix<T> &Q,
+                         dense_matrix<T> &R) {
+    size_type m = mat_nrows(A), n = mat_ncols(A);
+    GMM_ASSERT2(m >= n, "dimensions mismatch");
+    if (n == 0) { gmm::clear(Q); return; }
+    dense_matrix<T> QR(m, n);
+    gmm::copy(A, QR);
+    qr_factor_blocked(QR);
+
+    for (size_type j = 0; j < n; ++j)
+      for (size_type i = 0; i < n; ++i)
+        R(i, j) = (i <= j) ? QR(i, j) : T(0);
+
+    std::vector<T> V, TT;
+    gmm::copy(identity_matrix(), Q);
+    size_type j0 = ((n-1) / dense_qr_block) * dense_qr_block;
+    for (;; j0 -= dense_qr_block) {
+      size_type b = std::min(n, j0 + dense_qr_block) - j0;
+      qr_block_reflector_(QR, j0, b, V, TT);
+      qr_apply_block_reflector_(m-j0, n-j0, b, V, TT, DENSE_N,
+                                &Q(j0, j0), m);
+      if (j0 == 0) break;
+    }
+  }
+
+#ifndef GMM_USES_LAPACK
+  inline void qr_factor(dense_matrix<double> &A) { qr_factor_blocked(A); }
+  inline void qr_factor(dense_matrix<std::complex<double> > &A)
+  { qr_factor_blocked(A); }
+  inline void qr_factor(const dense_matrix<double> &A,
+                        dense_matrix<double> &Q, dense_matrix<double> &R)
+  { qr_factor_blocked(A, Q, R); }
+  inline void qr_factor(const dense_matrix<std::complex<double> > &A,
+                        dense_matrix<std::complex<double> > &Q,
+                        dense_matrix<std::complex<double> > &R)
+  { qr_factor_blocked(A, Q, R); }
+#endif
+
   ///@cond DOXY_SHOW_ALL_FUNCTIONS
   template <typename TA, typename TV, typename Ttol,
             typename MAT, typename VECT>
@@ -49,6 +49,7 @@
 #include "gmm_matrix.h"
 #include "gmm_tri_solve.h"
 #include "gmm_blas_interface.h"
+#include "gmm_dense_kernels.h"
 #include "gmm_lapack_interface.h"
 
 
@@ -1013,6 +1013,17 @@ namespace gmm {
     return rest;
   }
 
+  template <typename MATSP, typename V1, typename V2, typename T> inline
+  void vect_hp_multiple(const mpi_distributed_matrix<MATSP> &ps,
+                        const V1 *const *v1, const V2 *const *v2, T *res,
+                        size_type nb) {
+    std::vector<T> resl(nb);
+    for (size_type k = 0; k < nb; ++k)
+      resl[k] = vect_hp(ps.M, *(v1[k]), *(v2[k]));
+    MPI_Allreduce(&(resl[0]), res, int(nb), mpi_type(T()), MPI_SUM,
+                  MPI_COMM_WORLD);
+  }
+
   template <typename MAT, typename V1, typename V2>
   inline void mult_add(const mpi_distributed_matrix<MAT> &m, const V1 &v1,
                        V2 &v2) {
@@ -122,6 +122,36 @@ namespace gmm {
   template <typename T, typename VecS, typename VecX>
   void combine(modified_gram_schmidt<T>& V, const VecS& s, VecX& x, size_t i)
   { for (size_t j = 0; j < i; ++j) gmm::add(gmm::scaled(V[j], s[j]), x); }
+
+  /** Classical Gram-Schmidt with one reorthogonalization (CGS2), to be
+      used as the basis of gmres instead of modified_gram_schmidt. Each
+      pass is done with two matrix-vector products on the basis, instead
+      of i+1 scalar products and axpys for the modified Gram-Schmidt, which
+      merges the reductions (and can use the multithreaded or BLAS
+      matrix-vector products). Two passes give an orthogonality at the
+      level of the machine precision.
+  */
+  template <typename T>
+  class classical_gram_schmidt : public modified_gram_schmidt<T> {
+  public:
+    classical_gram_schmidt(int restart, size_t s)
+      : modified_gram_schmidt<T>(restart, s) {}
+  };
+
+  template <typename T, typename VecHi>
+  void orthogonalize(classical_gram_schmidt<T>& V, const VecHi& Hi_,
+		     size_t i) {
+    VecHi& Hi = const_cast<VecHi&>(Hi_);
+    sub_interval SUBI(0, V.nrows()), SUBJ(0, i+1);
+    std::vector<T> corr(i+1);
+    for (int pass = 0; pass < 2; ++pass) {
+      gmm::mult(conjugated(sub_matrix(V.mat(), SUBI, SUBJ)), V[i+1], corr);
+      gmm::mult_add(sub_matrix(V.mat(), SUBI, SUBJ),
+		    scaled(corr, T(-1)), V[i+1]);
+      if (pass == 0) gmm::copy(corr, sub_vector(Hi, SUBJ));
+      else gmm::add(corr, sub_vector(Hi, SUBJ));
+    }
+  }
 }
 
 #endif
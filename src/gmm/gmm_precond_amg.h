@@ -0,0 +1,637 @@
+/* -*- c++ -*- (enables emacs c++ mode) */
+/*===========================================================================
+
+ Copyright (C) 2026 agent
+
+ This file is a part of GetFEM
+
+ GetFEM  is  free software;  you  can  redistribute  it  and/or modify it
+ under  the  terms  of the  GNU  Lesser General Public License as published
+ by  the  Free Software Foundation;  either version 3 of the License,  or
+ (at your option) any later version along with the GCC Runtime Library
+ Exception either version 3.1 or (at your option) any later version.
+ This program  is  distributed  in  the  hope  that it will be useful,  but
+ WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ or  FITNESS  FOR  A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ License and GCC Runtime Library Exception for more details.
+ You  should  have received a copy of the GNU Lesser General Public License
+ along  with  this program;  if not, write to the Free Software Foundation,
+ Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA.
+
+ As a special exception, you  may use  this file  as it is a part of a free
+ software  library  without  restriction.  Specifically,  if   other  files
+ instantiate  templates  or  use macros or inline functions from this file,
+ or  you compile this  file  and  link  it  with other files  to produce an
+ executable, this file  does  not  by itself cause the resulting executable
+ to be covered  by the GNU Lesser General Public License.  This   exception
+ does not  however  invalidate  any  other  reasons why the executable file
+ might be covered by the GNU Lesser General Public License.
+
+===========================================================================*/
+
+/**@file gmm_precond_amg.h
+   @author  agent <agent@local>
+   @date October 18, 2026.
+   @brief Smoothed aggregation algebraic multigrid preconditioner.
+
+   Reference: P. Vanek, J. Mandel, M. Brezina, Algebraic multigrid by
+   smoothed aggregation for second and fourth order elliptic problems,
+   Computing 56 (1996), 179-196.
+*/
+
+#ifndef GMM_PRECOND_AMG_H
+#define GMM_PRECOND_AMG_H
+
+#include "gmm_precond.h"
+#include "gmm_dense_lu.h"
+
+namespace gmm {
+
+  /** Smoothers of the algebraic multigrid preconditioner. Both are
+      symmetric (backward sweep after the coarse correction for
+      Gauss-Seidel) so that the preconditioner can be used with cg. */
+  enum amg_smoother_type { AMG_GAUSS_SEIDEL, AMG_CHEBYSHEV };
+
+  /** Parameters of the algebraic multigrid preconditioner. */
+  struct amg_parameters {
+    double theta;             // Threshold of the strong connections.
+    size_type max_levels;     // Maximal number of levels.
+    size_type max_coarse;     // Size of the coarsest level (dense LU).
+    size_type nb_smooth;      // Number of pre and post smoothing steps.
+    amg_smoother_type smoother;
+    size_type chebyshev_degree;
+    size_type block_size;     // Number of unknowns per node.
+    amg_parameters()
+      : theta(0.08), max_levels(10), max_coarse(500), nb_smooth(1),
+        smoother(AMG_GAUSS_SEIDEL), chebyshev_degree(3), block_size(1) {}
+  };
+
+  // Sparse matrix product C = A*B for CSR matrices (Gustavson algorithm).
+  template <typename T, typename IND_TYPE>
+  void amg_csr_mult_(const csr_matrix<T, IND_TYPE> &A,
+                     const csr_matrix<T, IND_TYPE> &B,
+                     csr_matrix<T, IND_TYPE> &C) {
+    size_type n = A.nr, m = B.nc;
+    std::vector<size_type> pos(m, size_type(-1));
+    csr_matrix<T, IND_TYPE> CC; CC.nr = n; CC.nc = m;
+    CC.jc.resize(n+1); CC.jc[0] = 0;
+    for (size_type i = 0; i < n; ++i) {
+      size_type row_begin = CC.pr.size();
+      for (size_type k = A.jc[i]; k < A.jc[i+1]; ++k) {
+        T a = A.pr[k];
+        size_type j = A.ir[k];
+        for (size_type l = B.jc[j]; l < B.jc[j+1]; ++l) {
+          size_type c = B.ir[l];
+          if (pos[c] == size_type(-1) || pos[c] < row_begin) {
+            pos[c] = CC.pr.size();
+            CC.ir.push_back(IND_TYPE(c));
+            CC.pr.push_back(a * B.pr[l]);
+          } else
+            CC.pr[pos[c]] += a * B.pr[l];
+        }
+      }
+      CC.jc[i+1] = IND_TYPE(CC.pr.size());
+    }
+    C.swap(CC);
+  }
+
+  // Conjugated transposition of a CSR matrix.
+  template <typename T, typename IND_TYPE>
+  void amg_csr_conjugated_transpose_(const csr_matrix<T, IND_TYPE> &A,
+                          csr_matrix<T, IND_TYPE> &At) {
+    csr_matrix<T, IND_TYPE> B; B.nr = A.nc; B.nc = A.nr;
+    B.jc.assign(A.nc+1, 0);
+    for (size_type k = 0; k < A.ir.size(); ++k) ++(B.jc[A.ir[k]+1]);
+    for (size_type j = 0; j < A.nc; ++j) B.jc[j+1] += B.jc[j];
+    B.pr.resize(A.pr.size()); B.ir.resize(A.ir.size());
+    std::vector<IND_TYPE> next(B.jc.begin(), B.jc.end()-1);
+    for (size_type i = 0; i < A.nr; ++i)
+      for (size_type k = A.jc[i]; k < A.jc[i+1]; ++k) {
+        IND_TYPE l = next[A.ir[k]]++;
+        B.ir[l] = IND_TYPE(i); B.pr[l] = gmm::conj(A.pr[k]);
+      }
+    At.swap(B);
+  }
+
+  // y = A*x for a CSR matrix.
+  template <typename T, typename IND_TYPE>
+  void amg_csr_mult_(const csr_matrix<T, IND_TYPE> &A,
+                     const std::vector<T> &x, std::vector<T> &y) {
+    for (size_type i = 0; i < A.nr; ++i) {
+      T a(0);
+      for (size_type k = A.jc[i]; k < A.jc[i+1]; ++k) a += A.pr[k] * x[A.ir[k]];
+      y[i] = a;
+    }
+  }
+
+  /** Smoothed aggregation algebraic multigrid preconditioner.
+
+      The aggregates are built on the graph of the strong connections
+      (|a_ij| > theta sqrt(|a_ii a_jj|)) between the nodes (groups of
+      block_size consecutive unknowns). The tentative prolongation is
+      obtained by a local orthonormalization of the near nullspace vectors
+      on each aggregate (the constant vector by default, the rigid body
+      modes for an elasticity problem) and is smoothed by a damped Jacobi
+      step. The coarse operators are the Galerkin products P^H A P. The
+      preconditioner applies one V-cycle with the chosen smoother and a
+      dense LU factorization on the coarsest level. It is designed for
+      symmetric positive definite matrices.
+
+      The work vectors of the V-cycle are allocated once by build_with.
+      Those used by mult(P, v, w) are stored in the preconditioner, which
+      cannot then be applied by several threads at the same time. Each
+      thread can instead call solve(b, x, W) with its own workspace W
+      initialized by init_workspace(W).
+  */
+  template <typename Matrix> class amg_precond {
+  public :
+    typedef typename linalg_traits<Matrix>::value_type value_type;
+    typedef typename number_traits<value_type>::magnitude_type magnitude_type;
+    typedef value_type T;
+    typedef magnitude_type R;
+    typedef unsigned int IND_TYPE;
+
+  protected :
+    struct level {
+      csr_matrix<T> A, P, Pt;   // Operator, prolongation and restriction
+                                // (conjugated transpose of P).
+      std::vector<T> invdiag;   // Inverse of the diagonal of A.
+      R rho;                    // Estimate of the spectral radius of D^-1 A.
+    };
+
+  public :
+    /** Work vectors of one level of the V-cycle. */
+    struct level_work { std::vector<T> x, b, r, d, q; };
+    typedef std::vector<level_work> workspace;
+
+  protected :
+
+    amg_parameters param;
+    std::vector<level> levels;
+    dense_matrix<T> coarse_lu;
+    lapack_ipvt coarse_ipvt;
+    bool coarse_direct;
+    mutable workspace work; // Used by mult(P, v, w)
+
+    void init_level(level &L);
+    R estimate_spectral_radius(const level &L) const;
+    size_type aggregate(const level &L, size_type bs,
+                        std::vector<size_type> &agg) const;
+    bool coarsen(level &L, size_type &bs, dense_matrix<T> &B);
+    void smooth(const level &L, level_work &w, bool pre) const;
+    void vcycle(size_type l, workspace &W) const;
+
+  public :
+    /** Build the hierarchy for the matrix M with the near nullspace
+        vectors given by the columns of B. */
+    void build_with(const Matrix &M, const dense_matrix<T> &B);
+    /** Build the hierarchy for the matrix M with, as near nullspace, the
+        constant vectors of each of the block_size components. */
+    void build_with(const Matrix &M);
+
+    /** Allocate the work vectors of each level. */
+    void init_workspace(workspace &W) const;
+    /** Apply one V-cycle: x = P^-1 b, with the work vectors W. */
+    void solve(const std::vector<T> &b, std::vector<T> &x,
+               workspace &W) const;
+    /** Apply one V-cycle: x = P^-1 b, with the work vectors of the
+        preconditioner. The sizes of b and x are those of the matrix. */
+    template <typename V1, typename V2>
+    void apply(const V1 &b, V2 &x) const {
+      GMM_ASSERT2(levels.size(), "Uninitialized amg preconditioner");
+      copy(b, work[0].b);
+      vcycle(0, work);
+      copy(work[0].x, x);
+    }
+
+    size_type nb_levels() const { return levels.size(); }
+    size_type level_size(size_type l) const { return levels[l].A.nr; }
+    /** Ratio between the number of stored entries of the operators of all
+        the levels and the one of the finest level. */
+    double operator_complexity() const;
+    size_type memsize() const;
+
+    amg_precond(const Matrix &M, const amg_parameters &p = amg_parameters())
+      : param(p), coarse_ipvt(0) { build_with(M); }
+    amg_precond(const Matrix &M, const dense_matrix<T> &B,
+                const amg_parameters &p = amg_parameters())
+      : param(p), coarse_ipvt(0) { build_with(M, B); }
+    amg_precond(const amg_parameters &p = amg_parameters())
+      : param(p), coarse_ipvt(0), coarse_direct(false) {}
+  };
+
+  template <typename Matrix>
+  void amg_precond<Matrix>::init_level(level &L) {
+    size_type n = L.A.nr;
+    L.invdiag.assign(n, T(1));
+    for (size_type i = 0; i < n; ++i)
+      for (size_type k = L.A.jc[i]; k < L.A.jc[i+1]; ++k)
+        if (L.A.ir[k] == i) {
+          if (L.A.pr[k] != T(0)) L.invdiag[i] = T(1) / L.A.pr[k];
+          else GMM_WARNING2("The matrix has a zero on its diagonal");
+        }
+    L.rho = estimate_spectral_radius(L);
+  }
+
+  // Power iterations on D^-1 A starting from a pseudo-random vector. The
+  // estimate is increased by 10% since an upper bound is needed by the
+  // Chebyshev smoother, and bounded by the Gershgorin one.
+  template <typename Matrix> typename amg_precond<Matrix>::R
+  amg_precond<Matrix>::estimate_spectral_radius(const level &L) const {
+    size_type n = L.A.nr;
+    if (n == 0) return R(1);
+    std::vector<T> x(n), y(n);
+    R rho(0), gersh(0);
+    unsigned int seed = 1;
+    for (size_type i = 0; i < n; ++i) {
+      seed = seed * 1103515245U + 12345U;
+      x[i] = T(R((seed >> 16) & 0x7fff) / R(0x7fff) - R(0.5));
+      R a(0);
+      for (size_type k = L.A.jc[i]; k < L.A.jc[i+1]; ++k)
+        a += gmm::abs(L.A.pr[k]);
+      gersh = std::max(gersh, a * gmm::abs(L.invdiag[i]));
+    }
+    for (size_type it = 0; it < 20; ++it) {
+      R nx = vect_norm2(x);
+      if (nx == R(0)) break;
+      scale(x, T(R(1) / nx));
+      amg_csr_mult_(L.A, x, y);
+      for (size_type i = 0; i < n; ++i) y[i] *= L.invdiag[i];
+      rho = vect_norm2(y);
+      std::swap(x, y);
+    }
+    rho = std::min(rho * R(1.1), gersh);
+    return (rho > R(0)) ? rho : R(1);
+  }
+
+  // Standard aggregation in three passes. Returns the number of aggregates.
+  // The isolated nodes (without strong connections, for instance the rows
+  // of eliminated Dirichlet conditions) are in no aggregate.
+  template <typename Matrix>
+  size_type amg_precond<Matrix>::aggregate(const level &L, size_type bs,
+                                           std::vector<size_type> &agg)
+    const {
+    const size_type none = size_type(-1), isolated = size_type(-2);
+    size_type nn = L.A.nr / bs;
+
+    // Graph of the nodes with the Frobenius norms of the blocks
+    std::vector<std::vector<std::pair<size_type, R>>> graph(nn);
+    std::vector<R> diag(nn, R(0)), acc(nn, R(0));
+    std::vector<bool> mark(nn, false);
+    std::vector<size_type> touched;
+    for (size_type I = 0; I < nn; ++I) {
+      touched.resize(0);
+      for (size_type i = I*bs; i < (I+1)*bs; ++i)
+        for (size_type k = L.A.jc[i]; k < L.A.jc[i+1]; ++k) {
+          size_type J = L.A.ir[k] / bs;
+          if (!mark[J]) { mark[J] = true; touched.push_back(J); }
+          acc[J] += gmm::abs_sqr(L.A.pr[k]);
+        }
+      for (size_type J : touched) {
+        if (J == I) diag[I] = gmm::sqrt(acc[J]);
+        else if (acc[J] > R(0))
+          graph[I].push_back(std::make_pair(J, gmm::sqrt(acc[J])));
+        acc[J] = R(0); mark[J] = false;
+      }
+    }
+    R theta = R(param.theta);
+    for (size_type I = 0; I < nn; ++I) {
+      size_type k = 0;
+      for (const auto &e : graph[I])
+        if (e.second > theta * gmm::sqrt(diag[I] * diag[e.first]))
+          graph[I][k++] = e;
+      graph[I].resize(k);
+    }
+
+    agg.assign(nn, none);
+    for (size_type I = 0; I < nn; ++I)
+      if (graph[I].empty()) agg[I] = isolated;
+    size_type nagg = 0;
+    // Pass 1: nodes whose strong neighbors are all free
+    for (size_type I = 0; I < nn; ++I) {
+      if (agg[I] != none) continue;
+      bool all_free = true;
+      for (const auto &e : graph[I])
+        if (agg[e.first] != none && agg[e.first] != isolated)
+          all_free = false;
+      if (!all_free) continue;
+      agg[I] = nagg;
+      for (const auto &e : graph[I])
+        if (agg[e.first] == none) agg[e.first] = nagg;
+      ++nagg;
+    }
+    // Pass 2: the remaining nodes join the aggregate of pass 1 to which
+    // they are the most strongly connected
+    std::vector<size_type> agg1(agg);
+    for (size_type I = 0; I < nn; ++I) {
+      if (agg[I] != none) continue;
+      R smax(0);
+      for (const auto &e : graph[I])
+        if (agg1[e.first] != none && agg1[e.first] != isolated
+            && e.second > smax)
+          { smax = e.second; agg[I] = agg1[e.first]; }
+    }
+    // Pass 3: new aggregates with the nodes still free
+    for (size_type I = 0; I < nn; ++I) {
+      if (agg[I] != none) continue;
+      agg[I] = nagg;
+      for (const auto &e : graph[I])
+        if (agg[e.first] == none) agg[e.first] = nagg;
+      ++nagg;
+    }
+    return nagg;
+  }
+
+  // Build the prolongation of level L and the operator of the next level.
+  // B is the near nullspace on L and is replaced by the one of the next
+  // level. Returns false if the coarsening is not effective.
+  template <typename Matrix>
+  bool amg_precond<Matrix>::coarsen(level &L, size_type &bs,
+                                    dense_matrix<T> &B) {
+    size_type n = L.A.nr, nk = mat_ncols(B);
+    if (n % bs) bs = 1;
+    std::vector<size_type> agg;
+    size_type nagg = aggregate(L, bs, agg);
+    if (nagg == 0) return false;
+
+    // Unknowns of each aggregate
+    std::vector<std::vector<size_type>> dofs(nagg);
+    for (size_type I = 0; I < agg.size(); ++I)
+      if (agg[I] < nagg)
+        for (size_type i = I*bs; i < (I+1)*bs; ++i) dofs[agg[I]].push_back(i);
+
+    // Tentative prolongation: local orthonormalization of B on each
+    // aggregate (modified Gram-Schmidt, dependent vectors are dropped).
+    std::vector<size_type> first(nagg+1, 0);
+    std::vector<dense_matrix<T>> Q(nagg), RR(nagg);
+    std::vector<size_type> rank(nagg);
+    bool full_rank = true;
+    for (size_type a = 0; a < nagg; ++a) {
+      size_type m = dofs[a].size();
+      dense_matrix<T> Qa(m, nk), Ra(nk, nk);
+      size_type r = 0;
+      for (size_type c = 0; c < nk; ++c) {
+        std::vector<T> v(m);
+        for (size_type i = 0; i < m; ++i) v[i] = B(dofs[a][i], c);
+        R nv0 = vect_norm2(v);
+        for (size_type q = 0; q < r; ++q) {
+          T s = vect_hp(v, mat_col(Qa, q));
+          Ra(q, c) = s;
+          add(scaled(mat_col(Qa, q), -s), v);
+        }
+        R nv = vect_norm2(v);
+        if (nv > R(1E-10) * nv0 && nv > R(0)) {
+          Ra(r, c) = T(nv);
+          copy(scaled(v, T(R(1)/nv)), mat_col(Qa, r));
+          ++r;
+        }
+      }
+      if (r < nk) full_rank = false;
+      rank[a] = r; first[a+1] = first[a] + r;
+      Q[a].swap(Qa); RR[a].swap(Ra);
+    }
+    size_type nc = first[nagg];
+    if (nc == 0 || nc >= n) return false;
+
+    csr_matrix<T> P0; P0.nr = n; P0.nc = nc;
+    {
+      std::vector<size_type> agg_of_dof(n, size_type(-1)), loc(n);
+      for (size_type a = 0; a < nagg; ++a)
+        for (size_type i = 0; i < dofs[a].size(); ++i)
+          { agg_of_dof[dofs[a][i]] = a; loc[dofs[a][i]] = i; }
+      P0.jc.resize(n+1); P0.jc[0] = 0;
+      for (size_type i = 0; i < n; ++i) {
+        size_type a = agg_of_dof[i];
+        if (a != size_type(-1))
+          for (size_type q = 0; q < rank[a]; ++q) {
+            P0.ir.push_back(IND_TYPE(first[a] + q));
+            P0.pr.push_back(Q[a](loc[i], q));
+          }
+        P0.jc[i+1] = IND_TYPE(P0.pr.size());
+      }
+    }
+
+    // Coarse near nullspace
+    dense_matrix<T> Bc(nc, nk);
+    for (size_type a = 0; a < nagg; ++a)
+      for (size_type q = 0; q < rank[a]; ++q)
+        for (size_type c = 0; c < nk; ++c) Bc(first[a]+q, c) = RR[a](q, c);
+    B.swap(Bc);
+    bs = full_rank ? nk : 1;
+
+    // Smoothed prolongation P = (I - omega D^-1 A) P0
+    csr_matrix<T> AP0;
+    amg_csr_mult_(L.A, P0, AP0);
+    T omega = T(R(4) / (R(3) * L.rho));
+    {
+      csr_matrix<T> PP; PP.nr = n; PP.nc = nc;
+      PP.jc.resize(n+1); PP.jc[0] = 0;
+      std::vector<size_type> pos(nc, size_type(-1));
+      for (size_type i = 0; i < n; ++i) {
+        size_type row_begin = PP.pr.size();
+        for (const csr_matrix<T> *M : {&P0, &AP0}) {
+          T coeff = (M == &P0) ? T(1) : -omega * L.invdiag[i];
+          for (size_type k = M->jc[i]; k < M->jc[i+1]; ++k) {
+            size_type c = M->ir[k];
+            if (pos[c] == size_type(-1) || pos[c] < row_begin) {
+              pos[c] = PP.pr.size();
+              PP.ir.push_back(IND_TYPE(c));
+              PP.pr.push_back(coeff * M->pr[k]);
+            } else
+              PP.pr[pos[c]] += coeff * M->pr[k];
+          }
+        }
+        PP.jc[i+1] = IND_TYPE(PP.pr.size());
+      }
+      L.P.swap(PP);
+    }
+    amg_csr_conjugated_transpose_(L.P, L.Pt);
+
+    // Galerkin coarse operator P^H A P
+    csr_matrix<T> AP;
+    amg_csr_mult_(L.A, L.P, AP);
+    levels.push_back(level()); // No reallocation, see build_with
+    level &Lc = levels.back();
+    amg_csr_mult_(L.Pt, AP, Lc.A);
+    init_level(Lc);
+    return true;
+  }
+
+  template <typename Matrix>
+  void amg_precond<Matrix>::build_with(const Matrix &M,
+                                       const dense_matrix<T> &B0) {
+    GMM_ASSERT1(mat_nrows(M) == mat_ncols(M), "Non-square matrix");
+    GMM_ASSERT1(mat_nrows(B0) == mat_nrows(M) && mat_ncols(B0) > 0,
+                "Wrong size of the near nullspace");
+    levels.resize(0);
+    levels.reserve(param.max_levels);
+    levels.resize(1);
+    levels[0].A.init_with(M);
+    init_level(levels[0]);
+    dense_matrix<T> B(mat_nrows(B0), mat_ncols(B0));
+    copy(B0, B);
+    size_type bs = param.block_size;
+    while (levels.size() < param.max_levels
+           && levels.back().A.nr > param.max_coarse) {
+      size_type l = levels.size() - 1;
+      if (!coarsen(levels[l], bs, B)) break;
+    }
+
+    const csr_matrix<T> &Ac = levels.back().A;
+    size_type nc = Ac.nr;
+    coarse_direct = (nc <= std::max(param.max_coarse, size_type(1500)));
+    if (coarse_direct) {
+      coarse_lu.resize(nc, nc); gmm::clear(coarse_lu);
+      for (size_type i = 0; i < nc; ++i)
+        for (size_type k = Ac.jc[i]; k < Ac.jc[i+1]; ++k)
+          coarse_lu(i, Ac.ir[k]) = Ac.pr[k];
+      coarse_ipvt = lapack_ipvt(nc);
+      size_type info = lu_factor(coarse_lu, coarse_ipvt);
+      if (info) {
+        GMM_WARNING2("Singular coarse operator in amg, smoothing is used "
+                     "on the coarsest level");
+        coarse_direct = false;
+        coarse_lu.resize(0, 0);
+      }
+    }
+    init_workspace(work);
+  }
+
+  template <typename Matrix>
+  void amg_precond<Matrix>::init_workspace(workspace &W) const {
+    W.resize(levels.size());
+    for (size_type l = 0; l < levels.size(); ++l) {
+      size_type n = levels[l].A.nr;
+      level_work &w = W[l];
+      w.x.resize(n); w.b.resize(n); w.r.resize(n); w.d.resize(n);
+      if (param.smoother == AMG_CHEBYSHEV) w.q.resize(n);
+    }
+  }
+
+  template <typename Matrix>
+  void amg_precond<Matrix>::build_with(const Matrix &M) {
+    size_type n = mat_nrows(M), bs = param.block_size;
+    if (bs == 0 || n % bs) bs = 1;
+    dense_matrix<T> B(n, bs);
+    for (size_type i = 0; i < n; ++i) B(i, i % bs) = T(1);
+    build_with(M, B);
+  }
+
+  template <typename Matrix>
+  void amg_precond<Matrix>::smooth(const level &L, level_work &w,
+                                   bool pre) const {
+    size_type n = L.A.nr;
+    std::vector<T> &x = w.x, &r = w.r, &d = w.d;
+    const std::vector<T> &b = w.b;
+    for (size_type s = 0; s < param.nb_smooth; ++s) {
+      if (param.smoother == AMG_GAUSS_SEIDEL) {
+        for (size_type ii = 0; ii < n; ++ii) {
+          size_type i = pre ? ii : n-1-ii;
+          T a = b[i];
+          for (size_type k = L.A.jc[i]; k < L.A.jc[i+1]; ++k)
+            a -= L.A.pr[k] * x[L.A.ir[k]];
+          x[i] += a * L.invdiag[i];
+        }
+      } else { // Chebyshev polynomial on [rho/30, rho] (Saad, alg. 12.1)
+        R lmax = L.rho, lmin = L.rho / R(30);
+        R th = (lmax + lmin) / R(2), delta = (lmax - lmin) / R(2);
+        R sigma = th / delta, rh = R(1) / sigma;
+        amg_csr_mult_(L.A, x, r);
+        for (size_type i = 0; i < n; ++i)
+          { r[i] = (b[i] - r[i]) * L.invdiag[i]; d[i] = r[i] / th; }
+        for (size_type k = 0; k < param.chebyshev_degree; ++k) {
+          add(d, x);
+          if (k+1 == param.chebyshev_degree) break;
+          amg_csr_mult_(L.A, d, w.q);
+          for (size_type i = 0; i < n; ++i) r[i] -= w.q[i] * L.invdiag[i];
+          R rh1 = R(1) / (R(2) * sigma - rh);
+          for (size_type i = 0; i < n; ++i)
+            d[i] = T(rh1 * rh) * d[i] + T(R(2) * rh1 / delta) * r[i];
+          rh = rh1;
+        }
+      }
+    }
+  }
+
+  template <typename Matrix>
+  void amg_precond<Matrix>::vcycle(size_type l, workspace &W) const {
+    const level &L = levels[l];
+    level_work &w = W[l];
+    if (l+1 == levels.size()) {
+      if (coarse_direct)
+        lu_solve(coarse_lu, coarse_ipvt, w.x, w.b);
+      else {
+        gmm::clear(w.x);
+        for (size_type s = 0; s < 10; ++s)
+          { smooth(L, w, true); smooth(L, w, false); }
+      }
+      return;
+    }
+    level_work &wc = W[l+1];
+    gmm::clear(w.x);
+    smooth(L, w, true);
+    amg_csr_mult_(L.A, w.x, w.r);
+    for (size_type i = 0; i < L.A.nr; ++i) w.r[i] = w.b[i] - w.r[i];
+    amg_csr_mult_(L.Pt, w.r, wc.b);
+    vcycle(l+1, W);
+    amg_csr_mult_(L.P, wc.x, w.r);
+    add(w.r, w.x);
+    smooth(L, w, false);
+  }
+
+  template <typename Matrix>
+  void amg_precond<Matrix>::solve(const std::vector<T> &b,
+                                  std::vector<T> &x, workspace &W) const {
+    GMM_ASSERT2(levels.size(), "Uninitialized amg preconditioner");
+    if (W.size() != levels.size()) init_workspace(W);
+    copy(b, W[0].b);
+    vcycle(0, W);
+    copy(W[0].x, x);
+  }
+
+  template <typename Matrix>
+  double amg_precond<Matrix>::operator_complexity() const {
+    double nnz0 = double(levels[0].A.pr.size()), nnzt = 0.;
+    for (const level &L : levels) nnzt += double(L.A.pr.size());
+    return nnzt / nnz0;
+  }
+
+  template <typename Matrix>
+  size_type amg_precond<Matrix>::memsize() const {
+    size_type s = sizeof(*this);
+    for (const level &L : levels)
+      s += (L.A.pr.size() + L.P.pr.size() + L.Pt.pr.size()) *
+        (sizeof(T) + sizeof(IND_TYPE)) + L.A.nr * 6 * sizeof(T);
+    return s + mat_nrows(coarse_lu) * mat_ncols(coarse_lu) * sizeof(T);
+  }
+
+  template <typename Matrix, typename V1, typename V2> inline
+  void mult(const amg_precond<Matrix>& P, const V1 &v1, V2 &v2)
+  { P.apply(v1, v2); }
+
+  template <typename Matrix, typename V1, typename V2> inline
+  void transposed_mult(const amg_precond<Matrix>& P, const V1 &v1, V2 &v2)
+  { mult(P, v1, v2); }
+
+  template <typename Matrix, typename V1, typename V2> inline
+  void left_mult(const amg_precond<Matrix>& P, const V1 &v1, V2 &v2)
+  { mult(P, v1, v2); }
+
+  template <typename Matrix, typename V1, typename V2> inline
+  void right_mult(const amg_precond<Matrix>&, const V1 &v1, V2 &v2)
+  { copy(v1, v2); }
+
+  template <typename Matrix, typename V1, typename V2> inline
+  void transposed_left_mult(const amg_precond<Matrix>& P, const V1 &v1,
+                            V2 &v2)
+  { mult(P, v1, v2); }
+
+  template <typename Matrix, typename V1, typename V2> inline
+  void transposed_right_mult(const amg_precond<Matrix>&, const V1 &v1,
+                             V2 &v2)
+  { copy(v1, v2); }
+
+}
+
+#endif
+
@@ -102,9 +102,15 @@ namespace gmm {
   protected :
     std::vector<value_type> Tri_val;
     std::vector<size_type> Tri_ind, Tri_ptr;
+    // Level schedules for the parallel triangular solves. The conjugated
+    // transpose of U is stored by rows in Uh.
+    tri_level_schedule U_lev, Uh_lev;
+    std::vector<value_type> Uh_val;
+    std::vector<size_type> Uh_ind, Uh_ptr;
  
     template<typename M> void do_ildlt(const M& A, row_major);
     void do_ildlt(const Matrix& A, col_major);
+    void build_levels(void);
 
   public:
 
@@ -112,20 +118,50 @@ namespace gmm {
     size_type ncols(void) const { return mat_ncols(U); }
     value_type &D(size_type i) { return Tri_val[Tri_ptr[i]]; }
     const value_type &D(size_type i) const { return Tri_val[Tri_ptr[i]]; }
+
+    /* x <- U^{-1} x and x <- U^{-H} x, U having a unit diagonal. */
+    template <typename V> void U_solve(V &x) const {
+      if (U_lev.parallel_enabled())
+	tri_solve_by_levels(U_lev, U.pr, U.ir, U.jc, x, false, true);
+      else gmm::upper_tri_solve(U, x, true);
+    }
+    template <typename V> void Uh_solve(V &x) const {
+      if (Uh_lev.parallel_enabled())
+	tri_solve_by_levels(Uh_lev, &(Uh_val[0]), &(Uh_ind[0]),
+			    &(Uh_ptr[0]), x, true, true);
+      else gmm::lower_tri_solve(gmm::conjugated(U), x, true);
+    }
+
     ildlt_precond(void) {}
     void build_with(const Matrix& A) {
       Tri_ptr.resize(mat_nrows(A)+1);
       do_ildlt(A, typename principal_orientation_type<typename
 		  linalg_traits<Matrix>::sub_orientation>::potype());
+      build_levels();
     }
     ildlt_precond(const Matrix& A)  { build_with(A); }
     size_type memsize() const { 
       return sizeof(*this) + 
-	Tri_val.size() * sizeof(value_type) + 
-	(Tri_ind.size()+Tri_ptr.size()) * sizeof(size_type); 
+	(Tri_val.size() + Uh_val.size()) * sizeof(value_type) + 
+	(Tri_ind.size()+Tri_ptr.size()) * sizeof(size_type) +
+	(Uh_ind.size()+Uh_ptr.size()) * sizeof(size_type) +
+	U_lev.memsize() + Uh_lev.memsize();
     }
   };
 
+  template <typename Matrix>
+  void ildlt_precond<Matrix>::build_levels(void) {
+    size_type n = Tri_ptr.size() - 1;
+    U_lev.clear(); Uh_lev.clear();
+    Uh_val.clear(); Uh_ind.clear(); Uh_ptr.clear();
+    if (n == 0 || !omp_kernel_enabled(n, omp_level_min_size)) return;
+    U_lev.build(&(Tri_ptr[0]), &(Tri_ind[0]), n, false);
+    if (!U_lev.parallel_enabled()) { U_lev.clear(); return; }
+    csr_transpose_(&(Tri_val[0]), &(Tri_ind[0]), &(Tri_ptr[0]), n,
+		   Uh_val, Uh_ind, Uh_ptr, true);
+    Uh_lev.build(&(Uh_ptr[0]), &(Uh_ind[0]), n, true);
+  }
+
   template <typename Matrix> template<typename M>
   void ildlt_precond<Matrix>::do_ildlt(const M& A, row_major) {
     typedef typename linalg_traits<Matrix>::storage_type store_type;
@@ -201,9 +237,9 @@ namespace gmm {
   template <typename Matrix, typename V1, typename V2> inline
   void mult(const ildlt_precond<Matrix>& P, const V1 &v1, V2 &v2) {
     gmm::copy(v1, v2);
-    gmm::lower_tri_solve(gmm::conjugated(P.U), v2, true);
+    P.Uh_solve(v2);
     for (size_type i = 0; i < mat_nrows(P.U); ++i) v2[i] /= P.D(i);
-    gmm::upper_tri_solve(P.U, v2, true);
+    P.U_solve(v2);
   }
 
   template <typename Matrix, typename V1, typename V2> inline
@@ -213,26 +249,26 @@ namespace gmm {
   template <typename Matrix, typename V1, typename V2> inline
   void left_mult(const ildlt_precond<Matrix>& P, const V1 &v1, V2 &v2) {
     copy(v1, v2);
-    gmm::lower_tri_solve(gmm::conjugated(P.U), v2, true);
+    P.Uh_solve(v2);
     for (size_type i = 0; i < mat_nrows(P.U); ++i) v2[i] /= P.D(i);
   }
 
   template <typename Matrix, typename V1, typename V2> inline
   void right_mult(const ildlt_precond<Matrix>& P, const V1 &v1, V2 &v2)
-  { copy(v1, v2); gmm::upper_tri_solve(P.U, v2, true);  }
+  { copy(v1, v2); P.U_solve(v2);  }
 
   template <typename Matrix, typename V1, typename V2> inline
   void transposed_left_mult(const ildlt_precond<Matrix>& P, const V1 &v1,
 			    V2 &v2) {
     copy(v1, v2);
-    gmm::upper_tri_solve(P.U, v2, true);
+    P.U_solve(v2);
     for (size_type i = 0; i < mat_nrows(P.U); ++i) v2[i] /= P.D(i);
   }
 
   template <typename Matrix, typename V1, typename V2> inline
   void transposed_right_mult(const ildlt_precond<Matrix>& P, const V1 &v1,
 			     V2 &v2)
-  { copy(v1, v2); gmm::lower_tri_solve(gmm::conjugated(P.U), v2, true); }
+  { copy(v1, v2); P.Uh_solve(v2); }
 
 
 }
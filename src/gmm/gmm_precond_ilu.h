@@ -94,21 +94,55 @@ namespace gmm {
   protected :
     std::vector<value_type> L_val, U_val;
     std::vector<size_type> L_ind, U_ind, L_ptr, U_ptr;
+    // Level schedules of the factors for the parallel triangular solves.
+    // When the factorization is done on the transposed matrix, the
+    // transposed factors are stored by rows in Lt and Ut.
+    tri_level_schedule L_lev, U_lev, Lt_lev, Ut_lev;
+    std::vector<value_type> Lt_val, Ut_val;
+    std::vector<size_type> Lt_ind, Ut_ind, Lt_ptr, Ut_ptr;
  
     template<typename M> void do_ilu(const M& A, row_major);
     void do_ilu(const Matrix& A, col_major);
+    void eliminate_row(size_type i);
+    void build_levels(void);
 
   public:
     
     size_type nrows(void) const { return mat_nrows(L); }
     size_type ncols(void) const { return mat_ncols(U); }
+
+    /* x <- L^{-1} x, x <- U^{-1} x, x <- L^{-T} x and x <- U^{-T} x. */
+    template <typename V> void L_solve(V &x) const {
+      if (L_lev.parallel_enabled())
+	tri_solve_by_levels(L_lev, L.pr, L.ir, L.jc, x, true, true);
+      else gmm::lower_tri_solve(L, x, true);
+    }
+    template <typename V> void U_solve(V &x) const {
+      if (U_lev.parallel_enabled())
+	tri_solve_by_levels(U_lev, U.pr, U.ir, U.jc, x, false, false);
+      else gmm::upper_tri_solve(U, x, false);
+    }
+    template <typename V> void Lt_solve(V &x) const {
+      if (Lt_lev.parallel_enabled())
+	tri_solve_by_levels(Lt_lev, &(Lt_val[0]), &(Lt_ind[0]),
+			    &(Lt_ptr[0]), x, false, true);
+      else gmm::upper_tri_solve(gmm::transposed(L), x, true);
+    }
+    template <typename V> void Ut_solve(V &x) const {
+      if (Ut_lev.parallel_enabled())
+	tri_solve_by_levels(Ut_lev, &(Ut_val[0]), &(Ut_ind[0]),
+			    &(Ut_ptr[0]), x, true, false);
+      else gmm::lower_tri_solve(gmm::transposed(U), x, false);
+    }
     
     void build_with(const Matrix& A) {
       invert = false;
+       L_lev.clear();
        L_ptr.resize(mat_nrows(A)+1);
        U_ptr.resize(mat_nrows(A)+1);
        do_ilu(A, typename principal_orientation_type<typename
 	      linalg_traits<Matrix>::sub_orientation>::potype());
+       build_levels();
     }
     ilu_precond(const Matrix& A) { build_with(A); }
     ilu_precond(void) {}
@@ -116,10 +150,59 @@ namespace gmm {
       return sizeof(*this) + 
 	(L_val.size()+U_val.size()) * sizeof(value_type) + 
 	(L_ind.size()+L_ptr.size()) * sizeof(size_type) +
-	(U_ind.size()+U_ptr.size()) * sizeof(size_type); 
+	(U_ind.size()+U_ptr.size()) * sizeof(size_type) +
+	(Lt_val.size()+Ut_val.size()) * sizeof(value_type) + 
+	(Lt_ind.size()+Lt_ptr.size()) * sizeof(size_type) +
+	(Ut_ind.size()+Ut_ptr.size()) * sizeof(size_type) +
+	L_lev.memsize() + U_lev.memsize() + Lt_lev.memsize()
+	+ Ut_lev.memsize();
     }
   };
 
+  template <typename Matrix>
+  void ilu_precond<Matrix>::eliminate_row(size_type i) {
+    size_type qn, pn, rn;
+    for (size_type j = L_ptr[i]; j < L_ptr[i+1]; j++) {
+      pn = U_ptr[L_ind[j]];
+	
+      value_type multiplier = (L_val[j] /= U_val[pn]);
+	
+      qn = j + 1;
+      rn = U_ptr[i];
+	
+      for (pn++; pn < U_ptr[L_ind[j]+1] && U_ind[pn] < i; pn++) {
+	while (qn < L_ptr[i+1] && L_ind[qn] < U_ind[pn])
+	  qn++;
+	if (qn < L_ptr[i+1] && U_ind[pn] == L_ind[qn])
+	  L_val[qn] -= multiplier * U_val[pn];
+      }
+      for (; pn < U_ptr[L_ind[j]+1]; pn++) {
+	while (rn < U_ptr[i+1] && U_ind[rn] < U_ind[pn])
+	  rn++;
+	if (rn < U_ptr[i+1] && U_ind[pn] == U_ind[rn])
+	  U_val[rn] -= multiplier * U_val[pn];
+      }
+    }
+  }
+
+  template <typename Matrix>
+  void ilu_precond<Matrix>::build_levels(void) {
+    size_type n = L_ptr.size() - 1;
+    U_lev.clear(); Lt_lev.clear(); Ut_lev.clear();
+    Lt_val.clear(); Lt_ind.clear(); Lt_ptr.clear();
+    Ut_val.clear(); Ut_ind.clear(); Ut_ptr.clear();
+    if (!L_lev.parallel_enabled()) { L_lev.clear(); return; }
+    U_lev.build(&(U_ptr[0]), &(U_ind[0]), n, false);
+    if (invert) {
+      csr_transpose_(&(L_val[0]), &(L_ind[0]), &(L_ptr[0]), n,
+		     Lt_val, Lt_ind, Lt_ptr, false);
+      csr_transpose_(&(U_val[0]), &(U_ind[0]), &(U_ptr[0]), n,
+		     Ut_val, Ut_ind, Ut_ptr, false);
+      Lt_lev.build(&(Lt_ptr[0]), &(Lt_ind[0]), n, false);
+      Ut_lev.build(&(Ut_ptr[0]), &(Ut_ind[0]), n, true);
+    }
+  }
+
   template <typename Matrix> template <typename M>
   void ilu_precond<Matrix>::do_ilu(const M& A, row_major) {
     typedef typename linalg_traits<Matrix>::storage_type store_type;
@@ -173,39 +256,34 @@ namespace gmm {
       GMM_WARNING2("pivot 0 is too small");
     }
 
-    size_type qn, pn, rn;
+    // The diagonal of the row i is only modified by the elimination of
+    // the row i itself, so that the pivots can be checked beforehand.
     for (i = 1; i < n; i++) {
-
-      pn = U_ptr[i];
+      size_type pn = U_ptr[i];
       if (gmm::abs(U_val[pn]) <= max_pivot) {
 	U_val[pn] = T(1);
 	GMM_WARNING2("pivot " << i << " is too small");
       }
       max_pivot = std::max(max_pivot,
 			   std::min(gmm::abs(U_val[pn]) * prec, R(1)));
+    }
 
-      for (j = L_ptr[i]; j < L_ptr[i+1]; j++) {
-	pn = U_ptr[L_ind[j]];
-	
-	T multiplier = (L_val[j] /= U_val[pn]);
-	
-	qn = j + 1;
-	rn = U_ptr[i];
-	
-	for (pn++; pn < U_ptr[L_ind[j]+1] && U_ind[pn] < i; pn++) {
-	  while (qn < L_ptr[i+1] && L_ind[qn] < U_ind[pn])
-	    qn++;
-	  if (qn < L_ptr[i+1] && U_ind[pn] == L_ind[qn])
-	    L_val[qn] -= multiplier * U_val[pn];
-	}
-	for (; pn < U_ptr[L_ind[j]+1]; pn++) {
-	  while (rn < U_ptr[i+1] && U_ind[rn] < U_ind[pn])
-	    rn++;
-	  if (rn < U_ptr[i+1] && U_ind[pn] == U_ind[rn])
-	    U_val[rn] -= multiplier * U_val[pn];
-	}
+    // The rows of a same level of L only depend on the rows of the
+    // previous levels and are eliminated concurrently.
+    if (omp_kernel_enabled(n, omp_level_min_size))
+      L_lev.build(&(L_ptr[0]), &(L_ind[0]), n, true);
+    if (L_lev.parallel_enabled()) {
+#ifdef GETFEM_HAS_OPENMP
+      #pragma omp parallel
+      for (size_type l = 0; l < L_lev.nb_levels(); ++l) {
+	long i0 = long(L_lev.level_ptr[l]), i1 = long(L_lev.level_ptr[l+1]);
+	#pragma omp for schedule(dynamic, 64)
+	for (long ll = i0; ll < i1; ++ll) eliminate_row(L_lev.rows[ll]);
       }
+#endif
     }
+    else
+      for (i = 1; i < n; i++) eliminate_row(i);
 
     L = tm_type(&(L_val[0]), &(L_ind[0]), &(L_ptr[0]), n, mat_ncols(A));
     U = tm_type(&(U_val[0]), &(U_ind[0]), &(U_ptr[0]), n, mat_ncols(A));
@@ -220,57 +298,41 @@ namespace gmm {
   template <typename Matrix, typename V1, typename V2> inline
   void mult(const ilu_precond<Matrix>& P, const V1 &v1, V2 &v2) {
     gmm::copy(v1, v2);
-    if (P.invert) {
-      gmm::lower_tri_solve(gmm::transposed(P.U), v2, false);
-      gmm::upper_tri_solve(gmm::transposed(P.L), v2, true);
-    }
-    else {
-      gmm::lower_tri_solve(P.L, v2, true);
-      gmm::upper_tri_solve(P.U, v2, false);
-    }
+    if (P.invert) { P.Ut_solve(v2); P.Lt_solve(v2); }
+    else { P.L_solve(v2); P.U_solve(v2); }
   }
 
   template <typename Matrix, typename V1, typename V2> inline
   void transposed_mult(const ilu_precond<Matrix>& P,const V1 &v1,V2 &v2) {
     gmm::copy(v1, v2);
-    if (P.invert) {
-      gmm::lower_tri_solve(P.L, v2, true);
-      gmm::upper_tri_solve(P.U, v2, false);
-    }
-    else {
-      gmm::lower_tri_solve(gmm::transposed(P.U), v2, false);
-      gmm::upper_tri_solve(gmm::transposed(P.L), v2, true);
-    }
+    if (P.invert) { P.L_solve(v2); P.U_solve(v2); }
+    else { P.Ut_solve(v2); P.Lt_solve(v2); }
   }
 
   template <typename Matrix, typename V1, typename V2> inline
   void left_mult(const ilu_precond<Matrix>& P, const V1 &v1, V2 &v2) {
     copy(v1, v2);
-    if (P.invert) gmm::lower_tri_solve(gmm::transposed(P.U), v2, false);
-    else gmm::lower_tri_solve(P.L, v2, true);
+    if (P.invert) P.Ut_solve(v2); else P.L_solve(v2);
   }
 
   template <typename Matrix, typename V1, typename V2> inline
   void right_mult(const ilu_precond<Matrix>& P, const V1 &v1, V2 &v2) {
     copy(v1, v2);
-    if (P.invert) gmm::upper_tri_solve(gmm::transposed(P.L), v2, true);
-    else gmm::upper_tri_solve(P.U, v2, false);
+    if (P.invert) P.Lt_solve(v2); else P.U_solve(v2);
   }
 
   template <typename Matrix, typename V1, typename V2> inline
   void transposed_left_mult(const ilu_precond<Matrix>& P, const V1 &v1,
 			    V2 &v2) {
     copy(v1, v2);
-    if (P.invert) gmm::upper_tri_solve(P.U, v2, false);
-    else gmm::upper_tri_solve(gmm::transposed(P.L), v2, true);
+    if (P.invert) P.U_solve(v2); else P.Lt_solve(v2);
   }
 
   template <typename Matrix, typename V1, typename V2> inline
   void transposed_right_mult(const ilu_precond<Matrix>& P, const V1 &v1,
 			     V2 &v2) {
     copy(v1, v2);
-    if (P.invert) gmm::lower_tri_solve(P.L, v2, true);
-    else gmm::lower_tri_solve(gmm::transposed(P.U), v2, false);
+    if (P.invert) P.L_solve(v2); else P.Ut_solve(v2);
   }
 
 
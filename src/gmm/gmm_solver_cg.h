@@ -73,6 +73,7 @@
 
 #include "gmm_kernel.h"
 #include "gmm_iter.h"
+#include "gmm_dense_lu.h"
 
 namespace gmm {
 
@@ -174,6 +175,254 @@ namespace gmm {
 	 const Precond &P, iteration &iter)
   { cg(A, x , b , identity_matrix(), P , iter); }
 
+  /* ******************************************************************** */
+  /*		pipelined conjugate gradient                		  */
+  /* ******************************************************************** */
+
+  /** Pipelined preconditioned conjugate gradient.
+
+      Mathematically equivalent to cg, but the three scalar products of an
+      iteration (including the residual norm) are computed at once, before
+      the application of the preconditioner and of the matrix they do not
+      depend on. With a distributed scalar product, there is only one
+      global reduction per iteration instead of three.
+
+      See: P. Ghysels and W. Vanroose, Hiding global synchronization latency
+      in the preconditioned Conjugate Gradient algorithm, Parallel
+      Computing 40(2014), pp. 224-238.
+
+      The recurrences make the residual drift from the true one after many
+      iterations. The residual and the auxiliary vectors are recomputed
+      every replace_period iterations to limit it (residual replacement).
+  */
+  template <typename Matrix, typename Matps, typename Precond,
+            typename Vector1, typename Vector2>
+  void pipelined_cg(const Matrix& A, Vector1& x, const Vector2& b,
+		    const Matps& PS, const Precond &P, iteration &iter,
+		    size_type replace_period = 50) {
+
+    typedef typename temporary_dense_vector<Vector1>::vector_type temp_vector;
+    typedef typename linalg_traits<Vector1>::value_type T;
+
+    size_type n = vect_size(x);
+    T gamma, gamma_1(0), delta, a(0), a_1(0), beta, res[3];
+    temp_vector r(n), u(n), w(n), m(n), nn(n), p(n), s(n), q(n), z(n);
+    iter.set_rhsnorm(gmm::sqrt(gmm::abs(vect_hp(PS, b, b))));
+
+    if (iter.get_rhsnorm() == 0.0) { clear(x); return; }
+
+    const temp_vector *v1[3] = { &u, &w, &r }, *v2[3] = { &r, &u, &r };
+    for (size_type k = 0; ; ++k) {
+      if (k == 0 || (replace_period > 0 && k % replace_period == 0)) {
+	// residual replacement: r = b - Ax, u = Pr, w = Au and the
+	// auxiliary vectors s = Ap, q = Ps, z = Aq are recomputed.
+	mult(A, scaled(x, T(-1)), b, r);
+	mult(P, r, u);
+	mult(A, u, w);
+	if (k > 0) { mult(A, p, s); mult(P, s, q); mult(A, q, z); }
+      }
+      vect_hp_multiple(PS, v1, v2, res, 3);
+      gamma = res[0]; delta = res[1];
+      if (iter.finished(gmm::sqrt(gmm::abs(res[2])))) break;
+
+      mult(P, w, m);
+      mult(A, m, nn);
+
+      if (k == 0) { beta = T(0); a = gamma / delta; }
+      else {
+	beta = gamma / gamma_1;
+	a = gamma / (delta - beta * gamma / a_1);
+      }
+      add(nn, scaled(z, beta), z);
+      add(m, scaled(q, beta), q);
+      add(w, scaled(s, beta), s);
+      add(u, scaled(p, beta), p);
+
+      add(scaled(p, a), x);
+      add(scaled(s, -a), r);
+      add(scaled(q, -a), u);
+      add(scaled(z, -a), w);
+      gamma_1 = gamma; a_1 = a;
+      ++iter;
+    }
+  }
+
+  template <typename Matrix, typename Matps, typename Precond, 
+            typename Vector1, typename Vector2> inline 
+  void pipelined_cg(const Matrix& A, const Vector1& x, const Vector2& b,
+		    const Matps& PS, const Precond &P, iteration &iter)
+  { pipelined_cg(A, linalg_const_cast(x), b, PS, P, iter); }
+
+  template <typename Matrix, typename Precond, 
+            typename Vector1, typename Vector2> inline
+  void pipelined_cg(const Matrix& A, Vector1& x, const Vector2& b,
+		    const Precond &P, iteration &iter)
+  { pipelined_cg(A, x , b, identity_matrix(), P, iter); }
+
+  template <typename Matrix, typename Precond, 
+            typename Vector1, typename Vector2> inline
+  void pipelined_cg(const Matrix& A, const Vector1& x, const Vector2& b,
+		    const Precond &P, iteration &iter)
+  { pipelined_cg(A, x , b , identity_matrix(), P , iter); }
+
+  /* ******************************************************************** */
+  /*		block conjugate gradient                		  */
+  /* ******************************************************************** */
+
+  /** Preconditioned block conjugate gradient (O'Leary) for several right
+      hand sides (the columns of B) and a symmetric positive definite
+      matrix. The columns of X are the initial guesses and the solutions.
+
+      The Krylov spaces of the right hand sides are shared, which reduces
+      the number of iterations compared to separate solves, and the
+      products by the matrix and the applications of the preconditioner of
+      an iteration are made for all the columns at once. The residual given
+      to iter is the maximum of the relative residuals of the columns.
+      When a column has converged, it is removed from the block and the
+      block is restarted on the remaining ones (deflation). If the block
+      becomes numerically rank deficient (a pivot of the small systems
+      below sqrt(eps) times their largest diagonal entry, for instance for
+      two identical right hand sides), the columns are solved one by one.
+
+      See: D.P. O'Leary, The block conjugate gradient algorithm and related
+      methods, Linear Algebra and its Applications 29(1980), pp. 293-322.
+  */
+  // LU factorization of the small matrices of block_cg. Returns false if
+  // a pivot is small compared to the largest diagonal entry, i.e. if the
+  // block is numerically rank deficient.
+  template <typename T>
+  bool block_cg_lu_factor_(dense_matrix<T> &M, lapack_ipvt &ipvt) {
+    typedef typename number_traits<T>::magnitude_type R;
+    R tol = gmm::sqrt(default_tol(R())), dmax(0);
+    size_type s = mat_nrows(M);
+    for (size_type k = 0; k < s; ++k) dmax = std::max(dmax, gmm::abs(M(k,k)));
+    if (lu_factor(M, ipvt)) return false;
+    for (size_type k = 0; k < s; ++k)
+      if (gmm::abs(M(k, k)) <= tol * dmax) return false;
+    return true;
+  }
+
+  template <typename Matrix, typename Precond,
+            typename Matrix1, typename Matrix2>
+  void block_cg(const Matrix& A, Matrix1& X, const Matrix2& B,
+		const Precond &P, iteration &iter) {
+
+    typedef typename linalg_traits<Matrix1>::value_type T;
+    typedef typename number_traits<T>::magnitude_type R;
+    typedef std::vector<T> temp_vector;
+
+    size_type n = mat_nrows(B), nrhs = mat_ncols(B), s = 0, bs = nrhs;
+    GMM_ASSERT1(mat_nrows(X) == n && mat_ncols(X) == nrhs,
+		"dimensions mismatch");
+    std::vector<R> bnorm(nrhs);
+    std::vector<size_type> act; // remaining columns
+    for (size_type j = 0; j < nrhs; ++j) {
+      bnorm[j] = vect_norm2(mat_const_col(B, j));
+      if (bnorm[j] == R(0)) clear(mat_col(X, j)); else act.push_back(j);
+    }
+    iter.set_rhsnorm(1.0);
+    if (act.empty()) { iter.enforce_converged(true); return; }
+
+    std::vector<temp_vector> x, r, z, p, q, pp;
+    dense_matrix<T> G, rho, rho_1, c;
+    lapack_ipvt ipvt(0);
+    temp_vector cc, rr;
+    bool restart = true;
+
+    for (;;) {
+      if (restart) { // loads the first bs remaining columns
+	s = std::min(bs, act.size());
+	x.assign(s, temp_vector(n)); r = z = p = q = pp = x;
+	resize(G, s, s); resize(rho, s, s); resize(rho_1, s, s);
+	resize(c, s, s); ipvt = lapack_ipvt(s);
+	cc.resize(s); rr.resize(s);
+	for (size_type k = 0; k < s; ++k) {
+	  copy(mat_const_col(X, act[k]), x[k]);
+	  mult(A, scaled(x[k], T(-1)), mat_const_col(B, act[k]), r[k]);
+	  mult(P, r[k], z[k]);
+	  p[k] = z[k];
+	}
+	for (size_type k = 0; k < s; ++k)
+	  for (size_type l = 0; l < s; ++l) rho(k, l) = vect_hp(r[l], z[k]);
+	restart = false;
+      }
+
+      R res(0);
+      bool conv = false;
+      for (size_type k = 0; k < s; ++k) {
+	R resk = vect_norm2(r[k]) / bnorm[act[k]];
+	res = std::max(res, resk);
+	if (resk <= iter.get_resmax()) conv = true;
+      }
+      if (conv) { // deflation of the converged columns
+	std::vector<size_type> act2;
+	for (size_type k = 0; k < act.size(); ++k)
+	  if (k >= s || vect_norm2(r[k]) / bnorm[act[k]] > iter.get_resmax())
+	    act2.push_back(act[k]);
+	for (size_type k = 0; k < s; ++k) copy(x[k], mat_col(X, act[k]));
+	act.swap(act2);
+	if (act.empty()) { iter.finished(res); return; }
+	restart = true; continue;
+      }
+      if (iter.finished(res)) break;
+
+      for (size_type k = 0; k < s; ++k) mult(A, p[k], q[k]);
+      // c = (P^H A P)^{-1} (Z^H R)
+      for (size_type k = 0; k < s; ++k)
+	for (size_type l = 0; l < s; ++l) G(k, l) = vect_hp(q[l], p[k]);
+      if (!block_cg_lu_factor_(G, ipvt)) {
+	if (s == 1) {
+	  GMM_WARNING1("block_cg breakdown");
+	  iter.enforce_converged(false); break;
+	}
+	for (size_type k = 0; k < s; ++k) copy(x[k], mat_col(X, act[k]));
+	bs = 1; restart = true; continue;
+      }
+      for (size_type l = 0; l < s; ++l) {
+	for (size_type k = 0; k < s; ++k) rr[k] = rho(k, l);
+	lu_solve(G, ipvt, cc, rr);
+	for (size_type k = 0; k < s; ++k) c(k, l) = cc[k];
+      }
+      for (size_type l = 0; l < s; ++l)
+	for (size_type k = 0; k < s; ++k) {
+	  add(scaled(p[k], c(k, l)), x[l]);
+	  add(scaled(q[k], -c(k, l)), r[l]);
+	}
+
+      // new directions p = z + p (Z^H R)_old^{-1} (Z^H R)
+      for (size_type k = 0; k < s; ++k) mult(P, r[k], z[k]);
+      copy(rho, rho_1);
+      for (size_type k = 0; k < s; ++k)
+	for (size_type l = 0; l < s; ++l) rho(k, l) = vect_hp(r[l], z[k]);
+      if (!block_cg_lu_factor_(rho_1, ipvt)) {
+	if (s == 1) {
+	  GMM_WARNING1("block_cg breakdown");
+	  iter.enforce_converged(false); break;
+	}
+	for (size_type k = 0; k < s; ++k) copy(x[k], mat_col(X, act[k]));
+	bs = 1; restart = true; ++iter; continue;
+      }
+      for (size_type l = 0; l < s; ++l) {
+	for (size_type k = 0; k < s; ++k) rr[k] = rho(k, l);
+	lu_solve(rho_1, ipvt, cc, rr);
+	for (size_type k = 0; k < s; ++k) c(k, l) = cc[k];
+      }
+      pp.swap(p);
+      for (size_type l = 0; l < s; ++l) {
+	copy(z[l], p[l]);
+	for (size_type k = 0; k < s; ++k) add(scaled(pp[k], c(k, l)), p[l]);
+      }
+      ++iter;
+    }
+    for (size_type k = 0; k < s; ++k) copy(x[k], mat_col(X, act[k]));
+  }
+
+  template <typename Matrix, typename Precond,
+            typename Matrix1, typename Matrix2> inline
+  void block_cg(const Matrix& A, const Matrix1& X, const Matrix2& B,
+		const Precond &P, iteration &iter)
+  { block_cg(A, linalg_const_cast(X), B, P, iter); }
+
 }
 
 
@@ -125,6 +125,9 @@ inline void GMM_NOPERATION_(int) { }
 #include <locale.h>
 
 #include <gmm/gmm_arch_config.h>
+#ifdef GETFEM_HAS_OPENMP
+# include <omp.h>
+#endif
 
 namespace std {
 #if defined(__GNUC__) && (__cplusplus <= 201103L)
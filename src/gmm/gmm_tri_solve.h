@@ -211,10 +211,116 @@ namespace gmm {
 		      is_unit);
   }
 
+  /* ******************************************************************** */
+  /*		Level scheduled sparse triangular solves                  */
+  /* ******************************************************************** */
 
- 
+  const size_type omp_level_min_size = 128;// Minimal mean size of a level
 
+  /** Level schedule of a sparse triangular matrix stored by rows (csr
+      arrays jc, ir). The rows are sorted by levels : the rows of a level
+      only depend on the rows of the previous levels, so that they can be
+      solved concurrently. Inside a level, the rows are kept in increasing
+      order. */
+  struct tri_level_schedule {
+    std::vector<size_type> level_ptr, rows;
 
+    size_type nb_levels(void) const
+    { return level_ptr.empty() ? 0 : level_ptr.size() - 1; }
+    size_type nb_rows(void) const { return rows.size(); }
+    bool empty(void) const { return rows.empty(); }
+    void clear(void) { level_ptr.clear(); rows.clear(); }
+    size_type memsize() const
+    { return (level_ptr.size() + rows.size()) * sizeof(size_type); }
+
+    /** true if the levels are large enough for a parallel solve. */
+    bool parallel_enabled(void) const {
+      return !empty() && omp_kernel_enabled(nb_rows(), omp_level_min_size)
+	&& nb_rows() >= nb_levels() * omp_level_min_size;
+    }
+
+    template <typename IND_TYPE>
+    void build(const IND_TYPE *jc, const IND_TYPE *ir, size_type n,
+	       bool lower) {
+      std::vector<size_type> level(n, 0);
+      size_type nbl = 0;
+      for (size_type ii = 0; ii < n; ++ii) {
+	size_type i = lower ? ii : n - 1 - ii, l = 0;
+	for (size_type k = jc[i]; k < jc[i+1]; ++k) {
+	  size_type j = ir[k];
+	  if ((lower && j < i) || (!lower && j > i && j < n))
+	    l = std::max(l, level[j] + 1);
+	}
+	level[i] = l; nbl = std::max(nbl, l + 1);
+      }
+      level_ptr.assign(nbl + 1, 0);
+      for (size_type i = 0; i < n; ++i) ++(level_ptr[level[i]+1]);
+      for (size_type l = 0; l < nbl; ++l) level_ptr[l+1] += level_ptr[l];
+      rows.resize(n);
+      std::vector<size_type> pos(level_ptr.begin(), level_ptr.end() - 1);
+      for (size_type i = 0; i < n; ++i) rows[pos[level[i]]++] = i;
+    }
+  };
+
+  template <typename T, typename IND_TYPE, typename VecX>
+  inline void tri_solve_row_(const T *pr, const IND_TYPE *ir,
+			     const IND_TYPE *jc, VecX &x, size_type i,
+			     bool lower, bool is_unit) {
+    T t = x[i], d(1);
+    for (size_type k = jc[i]; k < jc[i+1]; ++k) {
+      size_type j = ir[k];
+      if (lower ? (j < i) : (j > i)) t -= pr[k] * x[j];
+      else if (j == i) d = pr[k];
+    }
+    if (!is_unit) x[i] = t / d; else x[i] = t;
+  }
+
+  /** Triangular solve x <-- T^{-1} x for a sparse triangular matrix T
+      stored by rows (csr arrays pr, ir, jc), the rows being solved level
+      by level following the schedule s. The rows of a level are
+      distributed among the threads when OpenMP is enabled, the result
+      being independent of the number of threads. */
+  template <typename T, typename IND_TYPE, typename VecX>
+  void tri_solve_by_levels(const tri_level_schedule &s, const T *pr,
+			   const IND_TYPE *ir, const IND_TYPE *jc,
+			   VecX &x, bool lower, bool is_unit) {
+    GMM_ASSERT2(vect_size(x) >= s.nb_rows(), "dimensions mismatch");
+    const size_type *rows = s.rows.data();
+#ifdef GETFEM_HAS_OPENMP
+    if (s.parallel_enabled()) {
+      #pragma omp parallel
+      for (size_type l = 0; l < s.nb_levels(); ++l) {
+	long i0 = long(s.level_ptr[l]), i1 = long(s.level_ptr[l+1]);
+	#pragma omp for schedule(static)
+	for (long k = i0; k < i1; ++k)
+	  tri_solve_row_(pr, ir, jc, x, rows[k], lower, is_unit);
+      }
+      return;
+    }
+#endif
+    for (size_type k = 0; k < s.nb_rows(); ++k)
+      tri_solve_row_(pr, ir, jc, x, rows[k], lower, is_unit);
+  }
+
+  /** Conjugated transpose (or transpose if conj is false) of a n x n
+      sparse matrix stored by rows. The columns of each row of the
+      result are sorted. */
+  template <typename T, typename IND_TYPE>
+  void csr_transpose_(const T *pr, const IND_TYPE *ir, const IND_TYPE *jc,
+		      size_type n, std::vector<T> &tpr,
+		      std::vector<IND_TYPE> &tir, std::vector<IND_TYPE> &tjc,
+		      bool conj) {
+    size_type nnz = jc[n];
+    tjc.assign(n+1, IND_TYPE(0)); tir.resize(nnz); tpr.resize(nnz);
+    for (size_type k = 0; k < nnz; ++k) ++(tjc[ir[k]+1]);
+    for (size_type i = 0; i < n; ++i) tjc[i+1] += tjc[i];
+    std::vector<IND_TYPE> pos(tjc.begin(), tjc.end() - 1);
+    for (size_type i = 0; i < n; ++i)
+      for (size_type k = jc[i]; k < jc[i+1]; ++k) {
+	size_type l = pos[ir[k]]++;
+	tir[l] = IND_TYPE(i); tpr[l] = conj ? gmm::conj(pr[k]) : pr[k];
+      }
+  }
 
 }
 
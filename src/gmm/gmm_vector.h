@@ -1304,6 +1304,12 @@ namespace gmm {
     }
   }
 
+  /** Set the stored values to zero, keeping the stored indices. */
+  template <typename T> inline void clear_values(rsvector<T> &v) {
+    typename rsvector<T>::iterator it = v.begin(), ite = v.end();
+    for (; it != ite; ++it) (*it).e = T(0);
+  }
+
   template <typename T>
   inline void clean(const simple_vector_ref<rsvector<T> *> &l, double eps) {
     simple_vector_ref<rsvector<T> *>
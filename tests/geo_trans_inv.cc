@@ -25,6 +25,7 @@
  */
 
 #include "getfem/bgeot_geotrans_inv.h"
+#include "getfem/bgeot_torus.h"
 #include "getfem/getfem_regular_meshes.h"
 
 using std::endl; using std::cout; using std::cerr;
@@ -80,6 +81,34 @@ void check_inversion(bgeot::pgeometric_trans pgt, const std::vector<base_node>&
   }
 }
 
+/* batch inversion of pts, compared to the inversion point by point. The
+   results are identical except for the linear transformations, whose batch
+   version does the computation in another order. */
+void check_batch_inversion(bgeot::geotrans_inv_convex &gic,
+                           bgeot::pgeometric_trans pgt,
+                           const std::vector<base_node> &pts, bool project) {
+  size_type nb = pts.size(), N = pts[0].size(), nbin = 0;
+  base_vector xreal(N*nb), xref;
+  std::vector<bool> isin, converged;
+  for (size_type i=0; i < nb; ++i)
+    for (size_type j=0; j < N; ++j) xreal[j*nb+i] = pts[i][j];
+  size_type nbin_batch = gic.invert_points(nb, xreal, xref, isin, converged,
+                                           1e-12, project);
+  bool exact = !pgt->is_linear() || bgeot::is_torus_geom_trans(pgt);
+  for (size_type i=0; i < nb; ++i) {
+    base_node Pref; bool conv;
+    bool is_in = gic.invert(pts[i], Pref, conv, 1e-12, project);
+    if (is_in) ++nbin;
+    GMM_ASSERT1(is_in == isin[i] && conv == converged[i],
+                "batch inversion differs from the inversion of " << pts[i]);
+    for (size_type j=0; j < Pref.size(); ++j)
+      GMM_ASSERT1(exact ? (xref[j*nb+i] == Pref[j])
+                  : (gmm::abs(xref[j*nb+i] - Pref[j]) < 1e-8),
+                  "batch inversion differs from the inversion of " << pts[i]);
+  }
+  GMM_ASSERT1(nbin == nbin_batch, "wrong number of points in the convex");
+}
+
 void test_inversion(bgeot::pgeometric_trans pgt, bool verbose) {
   size_type N=pgt->dim();
   std::vector<base_node> cvpts(pgt->nb_points());
@@ -107,6 +136,36 @@ void test_inversion(bgeot::pgeometric_trans pgt, bool verbose) {
     base_node P = pgt->transform(Pref, cvpts.begin());
     check_inversion(pgt,cvpts,gic,P,Pref,pgt->convex_ref()->is_in(Pref)<1e-10,verbose);
   }
+
+  /* batch inversion, compared to the inversion point by point */
+  std::vector<base_node> pts(100);
+  for (size_type i=0; i < pts.size(); ++i) {
+    base_node Pref(N);
+    for (size_type j=0; j < N; ++j) Pref[j] = (gmm::random() * 1.5 - 0.25);
+    pts[i] = pgt->transform(Pref, cvpts.begin());
+  }
+  check_batch_inversion(gic, pgt, pts, false);
+  if (!pgt->is_linear()) check_batch_inversion(gic, pgt, pts, true);
+}
+
+/* torus transformations (3D points in the plane z = 0) */
+void test_torus_inversion(bgeot::pgeometric_trans pgt0) {
+  bgeot::pgeometric_trans pgt = bgeot::torus_geom_trans_descriptor(pgt0);
+  cout << "Testing geotrans_inv with the torus of "
+       << bgeot::name_of_geometric_trans(pgt0) << "\n";
+  std::vector<base_node> cvpts(pgt->nb_points());
+  for (size_type i=0; i < cvpts.size(); ++i) {
+    const base_node &Pref = pgt0->convex_ref()->points()[i];
+    cvpts[i] = base_node(1. + Pref[0] + gmm::random()*0.05,
+                         0.5 + Pref[1] + gmm::random()*0.05, 0.);
+  }
+  bgeot::geotrans_inv_convex gic;
+  gic.init(cvpts, pgt);
+  std::vector<base_node> pts(50);
+  for (size_type i=0; i < pts.size(); ++i)
+    pts[i] = base_node(1. + gmm::random() * 1.5 - 0.25,
+                       0.5 + gmm::random() * 1.5 - 0.25, 0.);
+  check_batch_inversion(gic, pgt, pts, false);
 }
 
 /* problematic test-cases .. */
@@ -142,6 +201,10 @@ void test_inversion(bool verbose) {
   }
   test_inversion(bgeot::parallelepiped_linear_geotrans(5),verbose);
   test_inversion(bgeot::prism_linear_geotrans(3),verbose);
+  for (short_type K=1; K < 3; ++K) {
+    test_torus_inversion(bgeot::simplex_geotrans(2,K));
+    test_torus_inversion(bgeot::parallelepiped_geotrans(2,K));
+  }
 }
 
 int main(int argc, char *argv[]) {
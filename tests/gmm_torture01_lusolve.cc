@@ -69,6 +69,23 @@ bool test_procedure(const MAT1 &m1_, const VECT1 &v1_, const VECT2 &v2_) {
     error = gmm::vect_norm2(v3);
     GMM_ASSERT1(error <= prec * cond * R(20000), "Error too large: " << error);
 
+    if (nb_iter == 1) { // blocked LU factorization
+      size_type mb = 2 * gmm::dense_lu_block + m + 5;
+      gmm::dense_matrix<T> dm(mb, mb), lu(mb, mb);
+      std::vector<T> x(mb), b(mb), y(mb);
+      gmm::fill_random(dm); gmm::fill_random(x);
+      gmm::mult(dm, x, b);
+      gmm::copy(dm, lu);
+      gmm::lapack_ipvt ipvt(mb);
+      if (gmm::lu_factor_blocked(lu, ipvt) == 0) {
+	gmm::lu_solve(lu, ipvt, y, b);
+	R cond2 = gmm::condition_number(dm);
+	error = gmm::vect_dist2(x, y);
+	GMM_ASSERT1(error <= prec * cond2 * R(20000) * gmm::vect_norm2(x),
+		    "Error too large: " << error);
+      }
+    }
+
     if (nb_iter == 100) return true;
   }
   return false;
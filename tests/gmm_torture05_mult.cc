@@ -145,6 +145,89 @@ template<typename VECT> void test_vect_swap(VECT &V, gmm::linalg_false) {
 }
 
 
+// The multithreaded kernels, used above a size threshold when gmm is
+// compiled with OpenMP: comparison with sequential loops and, with OpenMP,
+// identical results for several numbers of threads, except for the product
+// of a matrix with dense columns whose sum is done by thread.
+template <typename T> void test_omp_kernels() {
+  typedef typename gmm::number_traits<T>::magnitude_type R;
+  static bool done = false;
+  if (done) return;
+  done = true;
+  R prec = gmm::default_tol(R());
+  size_type n = 2 * gmm::omp_vect_min_size + 17;
+  size_type nm = 2 * gmm::omp_mat_min_size + 5;
+  std::vector<T> v1(n), v2(n), x(nm);
+  gmm::fill_random(v1); gmm::fill_random(v2); gmm::fill_random(x);
+  gmm::row_matrix<gmm::wsvector<T> > A(nm, nm);
+  gmm::fill_random(A, 0.005);
+  gmm::csr_matrix<T> Ar(nm, nm);
+  gmm::csc_matrix<T> Ac(nm, nm);
+  gmm::copy(A, Ar); gmm::copy(A, Ac);
+  size_type nd = gmm::omp_mat_min_size;
+  gmm::col_matrix<std::vector<T> > Ad(nd, nd);
+  gmm::sub_interval Id(0, nd);
+  gmm::copy(gmm::sub_matrix(A, Id), Ad);
+
+  T sp_ref(0); R nsq_ref(0), spa_ref(0);
+  for (size_type i = 0; i < n; ++i) {
+    sp_ref += v1[i] * v2[i]; spa_ref += gmm::abs(v1[i] * v2[i]);
+    nsq_ref += gmm::abs_sqr(v1[i]);
+  }
+  std::vector<T> y_ref(nm), w(nm), yd_ref(nd), wd(nd);
+  for (size_type i = 0; i < nm; ++i)
+    for (size_type j = 0; j < nm; ++j) y_ref[i] += A(i, j) * x[j];
+  for (size_type i = 0; i < nd; ++i)
+    for (size_type j = 0; j < nd; ++j) yd_ref[i] += A(i, j) * x[j];
+
+  T sp0(0); R nsq0(0);
+  std::vector<T> s0, a0, yr0, yc0;
+  std::vector<int> nbth = {1, 2, 3, 5};
+#ifdef GETFEM_HAS_OPENMP
+  int nbth_max = omp_get_max_threads();
+#else
+  nbth.resize(1);
+#endif
+  for (size_type k = 0; k < nbth.size(); ++k) {
+#ifdef GETFEM_HAS_OPENMP
+    omp_set_num_threads(nbth[k]);
+#endif
+    T sp = gmm::vect_sp(v1, v2);                     // vect_sp_dense_
+    R nsq = gmm::vect_norm2_sqr(v1);                 // vect_norm2_sqr_
+    std::vector<T> s(n), a(v2), yr(nm), yc(nm), yd(nd);
+    gmm::add(v1, gmm::scaled(v2, T(2)), s);          // add_full_
+    gmm::add(v1, a);                                 // add_dense_
+    gmm::mult(Ar, x, yr);                            // mult_by_row_omp_
+    gmm::mult(Ac, x, yc);                            // sequential
+    gmm::mult(Ad, gmm::sub_vector(x, Id), yd);       // mult_add_by_col_omp_
+    gmm::add(gmm::scaled(yd_ref, T(-1)), yd, wd);
+    GMM_ASSERT1(gmm::vect_norminf(wd) <= prec * R(1000),
+		"Error in the multithreaded product by columns: "
+		<< gmm::vect_norminf(wd) << " (" << nbth[k] << " threads)");
+    if (k == 0) {
+      GMM_ASSERT1(gmm::abs(sp - sp_ref) <= prec * R(1000) * spa_ref
+		  && gmm::abs(nsq - nsq_ref) <= prec * R(1000) * nsq_ref,
+		  "Error in the multithreaded reductions");
+      for (size_type i = 0; i < n; ++i)
+	GMM_ASSERT1(s[i] == v1[i] + T(2) * v2[i] && a[i] == v2[i] + v1[i],
+		    "Error in the multithreaded additions");
+      gmm::add(gmm::scaled(y_ref, T(-1)), yr, w);
+      R error = gmm::vect_norminf(w);
+      gmm::add(gmm::scaled(y_ref, T(-1)), yc, w);
+      error = std::max(error, gmm::vect_norminf(w));
+      GMM_ASSERT1(error <= prec * R(1000),
+		  "Error in the multithreaded products: " << error);
+      sp0 = sp; nsq0 = nsq; s0 = s; a0 = a; yr0 = yr; yc0 = yc;
+    } else
+      GMM_ASSERT1(sp == sp0 && nsq == nsq0 && s == s0 && a == a0
+		  && yr == yr0 && yc == yc0, "The results depend on the "
+		  "number of threads (" << nbth[k] << " threads)");
+  }
+#ifdef GETFEM_HAS_OPENMP
+  omp_set_num_threads(nbth_max);
+#endif
+}
+
 template <typename MAT1 , typename MAT2, typename VECT1, typename VECT2,
 	  typename VECT3, typename VECT4>
 bool test_procedure(const MAT1 &m1_, const VECT1 &v1_, const VECT2 &v2_, 
@@ -161,6 +244,7 @@ bool test_procedure(const MAT1 &m1_, const VECT1 &v1_, const VECT2 &v2_,
   static size_type nb_iter(0);
   ++nb_iter;
 
+  test_omp_kernels<T>();
   test_procedure2(m1, v1, v2, m2, v3, v4);
 
   size_type m = gmm::vect_size(v1), n = gmm::vect_size(v3);
@@ -106,6 +106,32 @@ bool test_procedure(const MAT1 &m1_, const MAT2 &m2_, const MAT3 &m3_) {
     if (!(error <= prec * R(10000)))
       GMM_ASSERT1(false, "Error too large: " << error);
   }
+
+  if (nb_iter == 1) { // blocked kernels of gmm_dense_kernels.h
+    size_type mb = 60 + size_type(rand() % 80);
+    size_type nb = 60 + size_type(rand() % 80);
+    size_type kb = 250 + size_type(rand() % 80);
+    gmm::dense_matrix<T> a(kb, mb), b(kb, nb), c(mb, nb), c2(mb, nb);
+    gmm::fill_random(a); gmm::fill_random(b);
+    gmm::dense_gemm(mb, nb, kb, T(2), &a(0,0), kb, gmm::DENSE_C,
+		    &b(0,0), kb, gmm::DENSE_N, &c(0,0), mb);
+    gmm::mult(gmm::conjugated(gmm::sub_matrix(a, gmm::sub_interval(0, kb),
+					      gmm::sub_interval(0, mb))),
+	      gmm::scaled(b, T(-2)), c2);
+    gmm::add(c2, c);
+    error = gmm::mat_euclidean_norm(c);
+    if (!(error <= prec * R(10000) * gmm::mat_euclidean_norm(c2)))
+      GMM_ASSERT1(false, "Error too large: " << error);
+
+    std::vector<T> x(mb), y(kb), y2(kb);
+    gmm::fill_random(x);
+    gmm::dense_gemv(kb, mb, &a(0,0), kb, &x[0], &y[0]);
+    gmm::mult_by_col(a, x, y2, gmm::abstract_dense());
+    error = gmm::vect_dist2(y, y2);
+    if (!(error <= prec * R(10000) * gmm::vect_norm2(y2)))
+      GMM_ASSERT1(false, "Error too large: " << error);
+  }
+
   if (nb_iter == 100) return true;
   return false;
   
@@ -315,6 +315,27 @@ bool test_procedure(const MAT1 &m1_, const MAT2 &m2_) {
   if (!(error <= sqrt(prec) * gmm::vect_norm2(cvr) * R(10)))
     GMM_ASSERT1(false, "Error in QR algorithm.");
 
+  if (nb_iter == 1) { // blocked QR factorization
+    size_type nb = 2 * gmm::dense_qr_block + n + 3, mb = nb + k;
+    gmm::dense_matrix<T> a(mb, nb), q(mb, nb), r(nb, nb), a2(mb, nb);
+    gmm::fill_random(a);
+    gmm::qr_factor_blocked(a, q, r);
+    gmm::mult(q, r, a2);
+    gmm::add(gmm::scaled(a, T(-1)), a2);
+    error = gmm::mat_euclidean_norm(a2);
+    if (!(error <= prec * R(10000) * gmm::mat_euclidean_norm(a)))
+      GMM_ASSERT1(false, "Error too large: " << error);
+
+    gmm::copy(a, a2);
+    gmm::qr_factor_blocked(a2);
+    gmm::qr_factor(gmm::sub_matrix(a, gmm::sub_interval(0, mb),
+				   gmm::sub_interval(0, nb)));
+    gmm::add(gmm::scaled(a, T(-1)), a2);
+    error = gmm::mat_euclidean_norm(a2);
+    if (!(error <= prec * R(10000) * gmm::mat_euclidean_norm(a)))
+      GMM_ASSERT1(false, "Error too large: " << error);
+  }
+
   if (nb_iter == 100) return true;
   return false;
 
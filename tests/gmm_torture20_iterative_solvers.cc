@@ -87,6 +87,16 @@ struct GMRES {
   { gmm::gmres(m, v1, v2, P, 50, iter); }
 };
 
+struct GMRES_CGS2 {
+  template <typename MAT, typename VECT1, typename VECT2, typename PRECOND>
+  void operator()(const MAT &m, VECT1 &v1, const VECT2 &v2, const PRECOND &P,
+		  gmm::iteration &iter) const {
+    typedef typename gmm::linalg_traits<MAT>::value_type T;
+    gmm::classical_gram_schmidt<T> orth(50, gmm::vect_size(v1));
+    gmm::gmres(m, v1, v2, P, 50, iter, orth);
+  }
+};
+
 struct QMR {
   template <typename MAT, typename VECT1, typename VECT2, typename PRECOND>
   void operator()(const MAT &m, VECT1 &v1, const VECT2 &v2, const PRECOND &P,
@@ -101,6 +111,46 @@ struct CG {
   { gmm::cg(m, v1, v2, P, iter); }
 };
 
+struct PIPELINED_CG {
+  template <typename MAT, typename VECT1, typename VECT2, typename PRECOND>
+  void operator()(const MAT &m, VECT1 &v1, const VECT2 &v2, const PRECOND &P,
+		  gmm::iteration &iter) const
+  { gmm::pipelined_cg(m, v1, v2, P, iter); }
+};
+
+struct BLOCK_CG { // v1 is the solution for the first of two right hand sides
+  template <typename MAT, typename VECT1, typename VECT2, typename PRECOND>
+  void operator()(const MAT &m, VECT1 &v1, const VECT2 &v2, const PRECOND &P,
+		  gmm::iteration &iter) const {
+    typedef typename gmm::linalg_traits<VECT1>::value_type T;
+    size_type n = gmm::vect_size(v1);
+    gmm::dense_matrix<T> X(n, 2), B(n, 2);
+    gmm::copy(v1, gmm::mat_col(X, 0));
+    gmm::copy(v2, gmm::mat_col(B, 0));
+    gmm::fill_random(gmm::mat_col(B, 1));
+    gmm::block_cg(m, X, B, P, iter);
+    gmm::copy(gmm::mat_col(X, 0), v1);
+  }
+};
+
+struct BLOCK_CG_DEP { // second right hand side nearly equal to the first
+  template <typename MAT, typename VECT1, typename VECT2, typename PRECOND>
+  void operator()(const MAT &m, VECT1 &v1, const VECT2 &v2, const PRECOND &P,
+		  gmm::iteration &iter) const {
+    typedef typename gmm::linalg_traits<VECT1>::value_type T;
+    typedef typename gmm::number_traits<T>::magnitude_type R;
+    size_type n = gmm::vect_size(v1);
+    gmm::dense_matrix<T> X(n, 2), B(n, 2);
+    gmm::copy(v1, gmm::mat_col(X, 0));
+    gmm::copy(v2, gmm::mat_col(B, 0));
+    gmm::fill_random(gmm::mat_col(B, 1));
+    gmm::scale(gmm::mat_col(B, 1), T(gmm::default_tol(R())));
+    gmm::add(v2, gmm::mat_col(B, 1));
+    gmm::block_cg(m, X, B, P, iter);
+    gmm::copy(gmm::mat_col(X, 0), v1);
+  }
+};
+
 template <typename SOLVER, typename PRECOND, typename MAT, typename VECT1,
 	  typename VECT2, typename Rcond>
 void do_test(const SOLVER &solver, const MAT &m1, VECT1 &v1,
@@ -139,6 +189,96 @@ void do_test(const SOLVER &solver, const MAT &m1, VECT1 &v1,
 
 }
 
+// Level scheduled triangular solves and ilu and ildlt preconditioners on
+// a matrix with 4 levels of 512 rows, compared with the sequential solves
+// and, when compiled with OpenMP, for several numbers of threads.
+template <typename T> void test_level_scheduled_solves() {
+  typedef typename gmm::number_traits<T>::magnitude_type R;
+  static bool done = false;
+  if (done) return;
+  done = true;
+  R prec = gmm::default_tol(R());
+  size_type w = 4 * gmm::omp_level_min_size, n = 4 * w;
+  gmm::row_matrix<gmm::wsvector<T> > A(n, n);
+  for (size_type i = 0; i < n; ++i) {
+    A(i, i) = T(5);
+    if (i >= w) A(i, i-w) = A(i-w, i) = T(-1);
+    if (i >= w && (i % w) + 1 < w) A(i, i-w+1) = A(i-w+1, i) = T(-1);
+  }
+  gmm::csr_matrix<T> Ar(n, n);
+  gmm::csc_matrix<T> Ac(n, n);
+  gmm::copy(A, Ar); gmm::copy(A, Ac);
+
+  gmm::tri_level_schedule sl, su;
+  sl.build(Ar.jc.data(), Ar.ir.data(), n, true);
+  su.build(Ar.jc.data(), Ar.ir.data(), n, false);
+  GMM_ASSERT1(sl.nb_levels() == 4 && su.nb_levels() == 4
+	      && n >= sl.nb_levels() * gmm::omp_level_min_size,
+	      "Wrong level schedule");
+
+  std::vector<T> b(n), xl(n), xu(n), yl(n), yu(n);
+  gmm::fill_random(b);
+  gmm::copy(b, xl); gmm::lower_tri_solve(Ar, xl, false);
+  gmm::copy(b, xu); gmm::upper_tri_solve(Ar, xu, false);
+
+  std::vector<std::vector<T> > y0, y1;
+  std::vector<int> nbth = {1, 2, 3, 4};
+#ifdef GETFEM_HAS_OPENMP
+  int nbth_max = omp_get_max_threads();
+#else
+  nbth.resize(1);
+#endif
+  for (size_type k = 0; k < nbth.size(); ++k) {
+#ifdef GETFEM_HAS_OPENMP
+    omp_set_num_threads(nbth[k]);
+#endif
+    gmm::copy(b, yl);
+    gmm::tri_solve_by_levels(sl, Ar.pr.data(), Ar.ir.data(), Ar.jc.data(),
+			     yl, true, false);
+    gmm::copy(b, yu);
+    gmm::tri_solve_by_levels(su, Ar.pr.data(), Ar.ir.data(), Ar.jc.data(),
+			     yu, false, false);
+    GMM_ASSERT1(yl == xl && yu == xu, "Error in the level scheduled "
+		"triangular solves (" << nbth[k] << " threads)");
+
+    // The factorizations and the solves are done level by level when
+    // several threads are used.
+    std::vector<std::vector<T> > y(4, std::vector<T>(n));
+    gmm::ilu_precond<gmm::csr_matrix<T> > P1(Ar);
+    gmm::ilu_precond<gmm::csc_matrix<T> > P2(Ac);
+    gmm::ildlt_precond<gmm::csr_matrix<T> > P3(Ar);
+    gmm::ildlt_precond<gmm::csc_matrix<T> > P4(Ac);
+    gmm::mult(P1, b, y[0]); gmm::mult(P2, b, y[1]);
+    gmm::mult(P3, b, y[2]); gmm::mult(P4, b, y[3]);
+    if (k == 0) {
+      for (size_type j = 0; j < 4; ++j) { // Residual of the preconditioners
+	std::vector<T> r(n);
+	gmm::mult(Ar, y[j], r);
+	gmm::add(gmm::scaled(b, T(-1)), r);
+	GMM_ASSERT1(gmm::vect_norm2(r) < R(1) * gmm::vect_norm2(b),
+		    "Error in the ilu or ildlt preconditioners");
+      }
+      GMM_ASSERT1(gmm::vect_dist2(y[0], y[1]) <= prec * R(100) * R(n)
+		  && gmm::vect_dist2(y[2], y[3]) <= prec * R(100) * R(n),
+		  "Error in the ilu or ildlt preconditioners");
+      y0 = y;
+    } else {
+      // The sequential sweeps on the transposed factors of ilu (column
+      // major matrix) are scatter based, the parallel ones gather based
+      for (size_type j = 0; j < 4; ++j)
+	GMM_ASSERT1(gmm::vect_dist2(y[j], y0[j])
+		    <= prec * R(10) * gmm::vect_norm2(y0[j]),
+		    "Error in the parallel ilu or ildlt preconditioners");
+      if (k == 1) y1 = y;
+      GMM_ASSERT1(y == y1, "The ilu or ildlt preconditioners depend on "
+		  "the number of threads (" << nbth[k] << " threads)");
+    }
+  }
+#ifdef GETFEM_HAS_OPENMP
+  omp_set_num_threads(nbth_max);
+#endif
+}
+
 template <typename MAT1, typename VECT1, typename VECT2>
 bool test_procedure(const MAT1 &m1_, const VECT1 &v1_, const VECT2 &v2_) {
   VECT1 &v1 = const_cast<VECT1 &>(v1_);
@@ -151,6 +291,7 @@ bool test_procedure(const MAT1 &m1_, const VECT1 &v1_, const VECT2 &v2_) {
   if (m == 0) return true;
   static int nexpe = 0, effexpe = 0;
   ++nexpe;
+  test_level_scheduled_solves<T>();
   gmm::set_warning_level(0);
 
   gmm::clean(v1, 0.01);
@@ -229,6 +370,9 @@ bool test_procedure(const MAT1 &m1_, const VECT1 &v1_, const VECT2 &v2_) {
   
   if (print_debug) cout << "\nGmres with ilutp preconditionner\n";
   do_test(GMRES(), m1, v1, v2, P5b, cond);
+
+  if (print_debug) cout << "\nGmres (CGS2) with ilu preconditionner\n";
+  do_test(GMRES_CGS2(), m1, v1, v2, P4, cond);
   
   if (sizeof(R) > 5 || m < 15) {
 
@@ -255,6 +399,20 @@ bool test_procedure(const MAT1 &m1_, const VECT1 &v1_, const VECT2 &v2_) {
   gmm::copy(m2, m1);
   gmm::ildlt_precond<MAT1> P6(m1);
   gmm::ildltt_precond<MAT1> P7(m1, 10, prec);
+  gmm::amg_parameters amg_param; amg_param.max_coarse = 2;
+  gmm::amg_precond<MAT1> P8(m1, amg_param);
+  {
+    // The V-cycle with the work vectors of the preconditioner (mult) and
+    // with a workspace of the caller (concurrent applications)
+    typename gmm::amg_precond<MAT1>::workspace W;
+    P8.init_workspace(W);
+    std::vector<T> b(m), x1(m), x2(m);
+    gmm::copy(v2, b);
+    gmm::mult(P8, b, x1);
+    P8.solve(b, x2, W);
+    gmm::add(gmm::scaled(x1, T(-1)), x2);
+    GMM_ASSERT1(gmm::vect_norm2(x2) == R(0), "Error in the amg workspaces");
+  }
   
   if (!is_hermitian(m1, prec*R(100)))
     GMM_ASSERT1(false, "The matrix is not hermitian");
@@ -271,6 +429,22 @@ bool test_procedure(const MAT1 &m1_, const VECT1 &v1_, const VECT2 &v2_) {
   if (print_debug) cout << "\nCG with ildltt preconditionner\n";
   do_test(CG(), m1, v1, v2, P7, cond*cond);
 
+  if (print_debug) cout << "\nCG with amg preconditionner\n";
+  do_test(CG(), m1, v1, v2, P8, cond*cond);
+
+  if (print_debug) cout << "\nPipelined CG with no preconditionner\n";
+  do_test(PIPELINED_CG(), m1, v1, v2, P1, cond*cond);
+
+  if (print_debug) cout << "\nPipelined CG with ildlt preconditionner\n";
+  do_test(PIPELINED_CG(), m1, v1, v2, P6, cond*cond);
+
+  if (print_debug) cout << "\nBlock CG with ildlt preconditionner\n";
+  do_test(BLOCK_CG(), m1, v1, v2, P6, cond*cond);
+
+  if (print_debug)
+    cout << "\nBlock CG with nearly dependent right hand sides\n";
+  do_test(BLOCK_CG_DEP(), m1, v1, v2, P6, cond*cond);
+
   if (effexpe == 50) {
     cout << "\n\n" << effexpe << " effective experiments with ";
     if (nb_fault > 1)  cout << nb_fault << " faults";
@@ -282,8 +456,12 @@ bool test_procedure(const MAT1 &m1_, const VECT1 &v1_, const VECT2 &v2_) {
     print_stat(LEAST_SQUARE_CG(), "solver least square cg");
     print_stat(BICGSTAB(), "solver bicgstab");
     print_stat(GMRES(), "solver gmres");
+    print_stat(GMRES_CGS2(), "solver gmres (CGS2)");
     print_stat(QMR(), "solver qmr");
     print_stat(CG(), "solver cg");
+    print_stat(PIPELINED_CG(), "solver pipelined cg");
+    print_stat(BLOCK_CG(), "solver block cg");
+    print_stat(BLOCK_CG_DEP(), "solver block cg (dependent)");
     print_stat(P1, "no precond");
     print_stat(P2, "diag precond");
     print_stat(P3, "mr precond");
@@ -292,6 +470,7 @@ bool test_procedure(const MAT1 &m1_, const VECT1 &v1_, const VECT2 &v2_) {
     print_stat(P5b, "ilutp precond");
     print_stat(P6, "ildlt precond");
     print_stat(P7, "ildltt precond");
+    print_stat(P8, "amg precond");
     if (sizeof(R) > 4 && ratio_max > 0.16)
       GMM_ASSERT1(false, "something wrong ..");
     if (sizeof(R) <= 4 && ratio_max > 0.3)
@@ -20,11 +20,13 @@
 ===========================================================================*/
 #include "getfem/getfem_assembling.h"
 #include "getfem/getfem_generic_assembly.h"
+#include "getfem/getfem_models.h"
 #include "getfem/getfem_export.h"
 #include "getfem/getfem_regular_meshes.h"
 #include "getfem/getfem_partial_mesh_fem.h"
 #include "getfem/getfem_mat_elem.h"
 #include "gmm/gmm.h"
+#include <numeric>
 #ifdef GETFEM_HAVE_SYS_TIMES
 # include <sys/times.h>
 #endif
@@ -882,9 +884,567 @@ static void test_new_assembly(int N, int NX, int pK) {
                  (K, mim2, mf_u, mf_p, lambda2, mu2));
     }
 
+    if (all) { // Reuse of the compiled instructions between assemblies
+      cout << "\nTest on repeated assembly with modified data" << endl;
+      workspace.clear_expressions();
+      workspace.add_expression("a*u.u", mim);
+      workspace.assembly(0);
+      scalar_type E0 = workspace.assembled_potential();
+      a[0] *= 2.0;                     // Fixed size data, read at compile time
+      workspace.assembly(0);
+      scalar_type E1 = workspace.assembled_potential();
+      gmm::scale(U, scalar_type(3));   // Fem variable, read at execution time
+      workspace.assembly(0);
+      scalar_type E2 = workspace.assembled_potential();
+      a[0] /= 2.0; gmm::scale(U, scalar_type(1)/scalar_type(3));
+      scalar_type error = gmm::abs(E1 - 2.0*E0) + gmm::abs(E2 - 18.0*E0);
+      cout << "Error : " << error << endl;
+      GMM_ASSERT1(error < 1E-8*gmm::abs(E0),
+                  "Error in repeated high level generic assembly");
+    }
+
+    if (all) { // Fusion of the multiplications by a scalar
+      cout << "\nTest on fused instructions" << endl;
+      scalar_type error(0);
+      for (size_type order = 1; order <= 2; ++order) {
+        std::string X = (order == 1) ? "Grad_u:Grad_Test_u"
+                                     : "Grad_Test2_u:Grad_Test_u";
+        std::string Y = (order == 1) ? "u.Test_u" : "Test2_u.Test_u";
+        workspace.clear_expressions();
+        workspace.add_expression("2*(3*("+X+")) - (-("+Y+")) + 2*("+Y+")"
+                                 "- 3*(2*("+Y+"))", mim);
+        workspace.assembly(order);
+        base_vector V1(workspace.assembled_vector());
+        getfem::model_real_sparse_matrix K1(workspace.assembled_matrix());
+        workspace.clear_expressions();
+        workspace.add_expression("6*("+X+") - 3*("+Y+")", mim);
+        workspace.assembly(order);
+        if (order == 1) {
+          gmm::add(gmm::scaled(workspace.assembled_vector(), -1.), V1);
+          error += gmm::vect_norminf(V1)
+            / gmm::vect_norminf(workspace.assembled_vector());
+        } else {
+          gmm::add(gmm::scaled(workspace.assembled_matrix(), -1.), K1);
+          error += gmm::mat_norminf(K1)
+            / gmm::mat_norminf(workspace.assembled_matrix());
+        }
+      }
+      cout << "Error : " << error << endl;
+      GMM_ASSERT1(error < 1E-12, "Error in fused instructions");
+    }
+
+    if (all) { // Colored parallel assembly (effective with several threads)
+      cout << "\nTest on colored parallel assembly" << endl;
+      size_type nbth = getfem::true_thread_policy::num_threads();
+      getfem::set_num_threads(3);
+      workspace.clear_expressions();
+      workspace.add_expression("Grad_u:Grad_Test_u + p*Test_p + u(1)*Test_p",
+                               mim);
+      workspace.add_expression("Grad_Test_u:Grad_Test2_u + Test_p*Test2_p"
+                               "+ Test_u(1)*Test2_p", mim);
+      workspace.assembly(1);
+      workspace.assembly(2);
+      getfem::base_vector V(workspace.assembled_vector());
+      size_type nd = gmm::vect_size(V);
+      getfem::model_real_sparse_matrix K(nd, nd);
+      gmm::copy(workspace.assembled_matrix(), K);
+      workspace.set_colored_parallel_assembly(true);
+      workspace.assembly(1);
+      workspace.assembly(2);
+      workspace.set_colored_parallel_assembly(false);
+      gmm::add(gmm::scaled(workspace.assembled_vector(), scalar_type(-1)), V);
+      gmm::add(gmm::scaled(workspace.assembled_matrix(), scalar_type(-1)), K);
+      scalar_type error = gmm::vect_norminf(V) + gmm::mat_norminf(K);
+      cout << "Error : " << error << endl;
+      GMM_ASSERT1(error < 1E-10, "Error in colored parallel assembly");
+
+      cout << "\nTest on assembly with a fixed sparsity pattern" << endl;
+      gmm::copy(workspace.assembled_matrix(), K);
+      workspace.set_fixed_sparsity_pattern(true);
+      workspace.assembly(2); // Computes the pattern
+      workspace.assembly(2); // Computes the positions
+      workspace.assembly_statistics().clear();
+      workspace.assembly(2); // Uses the stored positions
+      workspace.set_fixed_sparsity_pattern(false);
+      const getfem::ga_assembly_statistics &st
+        = workspace.assembly_statistics();
+      gmm::add(gmm::scaled(workspace.assembled_matrix(), scalar_type(-1)), K);
+      error = gmm::mat_norminf(K);
+      cout << "Error : " << error << ", " << st.nb_pattern_hits
+           << " element matrices added at stored positions, "
+           << st.nb_pattern_misses << " not" << endl;
+      GMM_ASSERT1(error < 1E-10, "Error in fixed sparsity pattern assembly");
+      GMM_ASSERT1(st.nb_pattern_hits > 0 && st.nb_pattern_misses == 0,
+                  "The stored positions are not reused");
+
+      cout << "\nTest on atomic parallel assembly" << endl;
+      gmm::copy(workspace.assembled_matrix(), K);
+      gmm::copy(workspace.assembled_vector(), V);
+      workspace.set_atomic_parallel_assembly(true);
+      workspace.assembly(1);
+      workspace.assembly(2);
+      workspace.assembly(2);
+      workspace.set_atomic_parallel_assembly(false);
+      gmm::add(gmm::scaled(workspace.assembled_vector(), scalar_type(-1)), V);
+      gmm::add(gmm::scaled(workspace.assembled_matrix(), scalar_type(-1)), K);
+      error = gmm::vect_norminf(V) + gmm::mat_norminf(K);
+      cout << "Error : " << error << endl;
+      GMM_ASSERT1(error < 1E-10, "Error in atomic parallel assembly");
+
+      cout << "\nTest on the profiling of the assembly" << endl;
+      workspace.set_profiling(true);
+      workspace.assembly(2);
+      workspace.set_profiling(false);
+      std::vector<getfem::ga_profiling_data::entry> entries;
+      workspace.profiling_data().report(entries);
+      size_type nb_calls(0);
+      for (const auto &e : entries)
+        if (e.stage == "point") nb_calls = std::max(nb_calls, e.nb_calls);
+      workspace.profiling_data().print(cout);
+      GMM_ASSERT1(entries.size() && nb_calls >= mim.convex_index().card(),
+                  "Error in the profiling of the assembly");
+      getfem::set_num_threads(int(nbth));
+    }
+
+}
+
+
+// Assembly of a nonlinear model compared with the direct assembly of its
+// expression by a workspace.
+static scalar_type model_assembly_error(getfem::model &md,
+                                        const getfem::mesh_im &mim,
+                                        const std::string &expr) {
+  getfem::ga_workspace workspace(md);
+  workspace.add_expression(expr, mim);
+  workspace.assembly(1);
+  workspace.assembly(2);
+  base_vector R(md.real_rhs());
+  gmm::add(workspace.assembled_vector(), R); // rhs = -residual
+  getfem::model_real_sparse_matrix K(md.real_tangent_matrix());
+  gmm::add(gmm::scaled(workspace.assembled_matrix(), scalar_type(-1)), K);
+  return (gmm::vect_norminf(R) + gmm::mat_norminf(K))
+    / gmm::mat_norminf(workspace.assembled_matrix());
+}
+
+static void test_model_assembly(int N, int NX) {
+  getfem::mesh m;
+  char Ns[5]; sprintf(Ns, "%d", N);
+  std::vector<size_type> nsubdiv(N, NX);
+  getfem::regular_unit_mesh
+    (m, nsubdiv, bgeot::geometric_trans_descriptor
+     ((std::string("GT_PK(") + Ns + ",1)").c_str()));
+  getfem::mesh_fem mf_u(m);
+  mf_u.set_classical_finite_element(2);
+  getfem::mesh_im mim(m);
+  mim.set_integration_method(4);
+
+  getfem::model md;
+  md.add_fem_variable("u", mf_u);
+  const std::string expr = "Grad_u:Grad_Test_u + u*u*Test_u";
+  getfem::add_nonlinear_term(md, mim, expr);
+  getfem::base_node P(N);
+
+  cout << "\nTest on the reuse of the compiled instructions by a model"
+       << endl;
+  scalar_type error(0);
+  md.clear_generic_assembly_statistics();
+  for (size_type iter = 0; iter < 4; ++iter) { // Newton like iterations
+    getfem::model_real_plain_vector &U = md.set_real_variable("u");
+    for (size_type i = 0; i < gmm::vect_size(U); ++i)
+      U[i] = sin(scalar_type(i*(iter+1)));
+    md.assembly(getfem::model::BUILD_ALL);
+    error = std::max(error, model_assembly_error(md, mim, expr));
+    if (iter == 0)
+      GMM_ASSERT1(md.generic_assembly_statistics().nb_compilations > 0,
+                  "Error in the assembly statistics");
+  }
+  const getfem::ga_assembly_statistics &st = md.generic_assembly_statistics();
+  cout << "Error : " << error << ", " << st.nb_compilations
+       << " compilations for " << st.nb_assemblies << " assemblies" << endl;
+  GMM_ASSERT1(error < 1E-10, "Error in repeated model assembly");
+  GMM_ASSERT1(st.nb_compilations * 4 == st.nb_assemblies,
+              "The compiled instructions are not reused by the model");
+
+  cout << "\nTest on colored parallel assembly of a model" << endl;
+  size_type nbth = getfem::true_thread_policy::num_threads();
+  getfem::set_num_threads(3);
+  md.set_colored_parallel_assembly(true);
+  md.clear_generic_assembly_statistics();
+  size_type nb_compilations(0);
+  error = scalar_type(0);
+  for (size_type iter = 0; iter < 3; ++iter) {
+    getfem::model_real_plain_vector &U = md.set_real_variable("u");
+    for (size_type i = 0; i < gmm::vect_size(U); ++i)
+      U[i] = cos(scalar_type(i*(iter+1)));
+    md.assembly(getfem::model::BUILD_ALL);
+    error = std::max(error, model_assembly_error(md, mim, expr));
+    if (iter == 0)
+      nb_compilations = md.generic_assembly_statistics().nb_compilations;
+  }
+  md.set_colored_parallel_assembly(false);
+  getfem::set_num_threads(int(nbth));
+  cout << "Error : " << error << ", " << nb_compilations
+       << " compilations for " << md.generic_assembly_statistics().nb_assemblies
+       << " assemblies" << endl;
+  GMM_ASSERT1(error < 1E-10, "Error in colored parallel assembly of a model");
+  GMM_ASSERT1(nb_compilations > 0 && nb_compilations
+              == md.generic_assembly_statistics().nb_compilations,
+              "The colored instructions are not reused by the model");
+
+  cout << "\nTest on atomic parallel assembly of a model" << endl;
+  getfem::set_num_threads(3);
+  md.set_atomic_parallel_assembly(true);
+  md.clear_generic_assembly_statistics();
+  error = scalar_type(0);
+  for (size_type iter = 0; iter < 3; ++iter) {
+    getfem::model_real_plain_vector &U = md.set_real_variable("u");
+    for (size_type i = 0; i < gmm::vect_size(U); ++i)
+      U[i] = cos(scalar_type(i*(iter+2)));
+    md.assembly(getfem::model::BUILD_ALL);
+    error = std::max(error, model_assembly_error(md, mim, expr));
+  }
+  md.set_atomic_parallel_assembly(false);
+  getfem::set_num_threads(int(nbth));
+  const getfem::ga_assembly_statistics &st1 = md.generic_assembly_statistics();
+  cout << "Error : " << error << ", " << st1.nb_parallel_assemblies
+       << " parallel assemblies out of " << st1.nb_assemblies << endl;
+  GMM_ASSERT1(error < 1E-10, "Error in atomic parallel assembly of a model");
+  // The structure of the tangent matrix built by the previous assemblies is
+  // kept, so that the matrix assemblies are also parallel
+  GMM_ASSERT1(st1.nb_parallel_assemblies == st1.nb_assemblies,
+              "The atomic parallel assembly is not used by the model");
+
+  cout << "\nTest on model assembly with a fixed sparsity pattern" << endl;
+  getfem::model md2;
+  md2.add_fem_variable("u", mf_u);
+  const std::string expr2 = "u*u*u*Test_u"; // Zero tangent matrix for u = 0
+  getfem::add_nonlinear_term(md2, mim, expr2);
+  md2.set_fixed_sparsity_pattern(true);
+  error = scalar_type(0);
+  for (size_type iter = 0; iter < 3; ++iter) {
+    getfem::model_real_plain_vector &U = md2.set_real_variable("u");
+    for (size_type i = 0; i < gmm::vect_size(U); ++i)
+      U[i] = iter ? sin(scalar_type(i*iter)) : scalar_type(0);
+    md2.clear_generic_assembly_statistics();
+    md2.assembly(getfem::model::BUILD_ALL);
+    if (iter == 0) {
+      GMM_ASSERT1(gmm::nnz(md2.real_tangent_matrix()) > 0,
+                  "The sparsity pattern is not built for zero values");
+    } else
+      error = std::max(error, model_assembly_error(md2, mim, expr2));
+  }
+  const getfem::ga_assembly_statistics &st2
+    = md2.generic_assembly_statistics(); // Last assembly only
+  cout << "Error : " << error << ", " << st2.nb_pattern_hits
+       << " element matrices added at stored positions, "
+       << st2.nb_pattern_misses << " not" << endl;
+  GMM_ASSERT1(error < 1E-10, "Error in fixed pattern assembly of a model");
+  GMM_ASSERT1(st2.nb_pattern_hits > 0 && st2.nb_pattern_misses == 0,
+              "The stored positions are not reused by the model");
+
+  cout << "\nTest on the structure version of the tangent matrix" << endl;
+  getfem::model md3;
+  md3.add_fem_variable("u", mf_u);
+  md3.add_fem_variable("v", mf_u);
+  size_type ib = getfem::add_linear_term(md3, mim, "u*Test_v");
+  md3.assembly(getfem::model::BUILD_MATRIX);
+  size_type version = md3.tangent_matrix_structure_version();
+  size_type nnz = gmm::nnz(md3.real_tangent_matrix());
+  md3.assembly(getfem::model::BUILD_MATRIX);
+  GMM_ASSERT1(md3.tangent_matrix_structure_version() == version,
+              "The structure version changed for the same structure");
+  // Transposed coupling term: same number of nonzero entries in another
+  // pattern
+  md3.delete_brick(ib);
+  getfem::add_linear_term(md3, mim, "v*Test_u");
+  md3.assembly(getfem::model::BUILD_MATRIX);
+  cout << "nnz : " << nnz << " and " << gmm::nnz(md3.real_tangent_matrix())
+       << ", versions : " << version << " and "
+       << md3.tangent_matrix_structure_version() << endl;
+  GMM_ASSERT1(gmm::nnz(md3.real_tangent_matrix()) == nnz,
+              "The number of nonzero entries should be the same");
+  GMM_ASSERT1(md3.tangent_matrix_structure_version() == version + 1,
+              "The structure version is not changed with the pattern");
+}
+
+// Comparison of the instructions specialized for the sizes of the tensors
+// with the generic ones, for each specialized size.
+static void test_size_specialized_instructions() {
+  getfem::mesh m;
+  std::vector<size_type> nsubdiv(2, 2);
+  getfem::regular_unit_mesh(m, nsubdiv, bgeot::simplex_geotrans(2, 1));
+  getfem::mesh_im mim(m);
+  mim.set_integration_method(2);
+
+  cout << "\nTest on the size specialized instructions" << endl;
+  // Variables of each specialized size, whose values vary in the elements
+  const size_type sizes[5] = {2, 3, 4, 6, 9};
+  std::vector<std::unique_ptr<getfem::mesh_fem>> mfs;
+  for (size_type i = 0; i < 6; ++i) {
+    mfs.emplace_back(new getfem::mesh_fem(m, dim_type(i < 5 ? sizes[i] : 1)));
+    mfs.back()->set_classical_finite_element(1);
+  }
+  std::vector<base_vector> values(11);
+  for (size_type i = 0; i < 11; ++i) {
+    values[i].resize(mfs[i/2]->nb_dof());
+    for (size_type j = 0; j < values[i].size(); ++j)
+      values[i][j] = sin(scalar_type(7*i+j+1));
+  }
+  getfem::ga_workspace workspace;
+  std::vector<std::string> expressions;
+  size_type first(0);
+  for (size_type i = 0; i < 11; ++i) {
+    std::stringstream name;
+    if (i < 10) name << ((i%2) ? "B" : "A") << sizes[i/2]; else name << "c";
+    gmm::sub_interval I(first, values[i].size());
+    workspace.add_fem_variable(name.str(), *(mfs[i/2]), I, values[i]);
+    first = I.last();
+  }
+  for (size_type i = 0; i < 5; ++i) {
+    std::stringstream A, B;
+    A << "A" << sizes[i]; B << "B" << sizes[i];
+    expressions.push_back("Norm_sqr(" + A.str() + "+" + B.str() + ")");
+    expressions.push_back("Norm_sqr(" + A.str() + "-" + B.str() + ")");
+    expressions.push_back("Norm_sqr(c*" + A.str() + ")");
+  }
+  for (size_type n = 2; n <= 3; ++n)
+    for (size_type s1 = 1; s1 <= 3; ++s1)
+      for (size_type s2 = 1; s2 <= 3; ++s2) {
+        std::stringstream ss;
+        ss << "Norm_sqr(Reshape(A" << s1*n << "," << s1 << "," << n
+           << ")*Reshape(B" << n*s2 << "," << n << "," << s2 << "))";
+        expressions.push_back(ss.str());
+      }
+
+  scalar_type error(0);
+  std::set<std::string> specialized;
+  for (const std::string &expr : expressions) {
+    workspace.clear_expressions();
+    workspace.add_expression(expr, mim);
+    workspace.set_size_specialized_instructions(false);
+    workspace.assembly(0);
+    scalar_type generic = workspace.assembled_potential();
+    workspace.set_size_specialized_instructions(true);
+    workspace.set_profiling(true);
+    workspace.assembly(0);
+    workspace.set_profiling(false);
+    scalar_type fixed = workspace.assembled_potential();
+    error = std::max(error, gmm::abs(fixed - generic) / gmm::abs(generic));
+    std::vector<getfem::ga_profiling_data::entry> entries;
+    workspace.profiling_data().report(entries);
+    workspace.profiling_data().clear();
+    size_type nb_specialized = specialized.size();
+    for (const auto &e : entries)
+      if (e.instruction.find("_fixed<") != std::string::npos)
+        specialized.insert(e.instruction);
+    GMM_ASSERT1(specialized.size() == nb_specialized + 1,
+                "No new size specialized instruction for " << expr);
+  }
+  cout << "Error : " << error << ", " << specialized.size()
+       << " size specialized instructions" << endl;
+  GMM_ASSERT1(error < 1E-14, "Error in the size specialized instructions");
+}
+
+// Assembly with a workspace kept while the reduced mesh_fem of its variable
+// changes its number of basic dofs, compared with a new workspace.
+static scalar_type reduced_assembly_error(getfem::ga_workspace &workspace,
+                                          const getfem::mesh_fem &mf,
+                                          const getfem::mesh_im &mim,
+                                          const base_vector &U) {
+  getfem::ga_workspace workspace2;
+  workspace2.add_fem_variable("u", mf, gmm::sub_interval(0, mf.nb_dof()), U);
+  workspace2.add_expression("Grad_u:Grad_Test_u + u*u*Test_u", mim);
+  scalar_type error(0);
+  for (size_type order = 1; order <= 2; ++order) {
+    workspace.assembly(order);
+    workspace2.assembly(order);
+    if (order == 1) {
+      base_vector V(workspace2.assembled_vector());
+      gmm::add(gmm::scaled(workspace.assembled_vector(), scalar_type(-1)), V);
+      error += gmm::vect_norminf(V)
+        / gmm::vect_norminf(workspace2.assembled_vector());
+    } else {
+      getfem::model_real_sparse_matrix K(workspace2.assembled_matrix());
+      gmm::add(gmm::scaled(workspace.assembled_matrix(), scalar_type(-1)), K);
+      error += gmm::mat_norminf(K)
+        / gmm::mat_norminf(workspace2.assembled_matrix());
+    }
+  }
+  return error;
 }
 
+static void test_reduced_fem_reassembly() {
+  getfem::mesh m;
+  std::vector<size_type> nsubdiv(2, 6);
+  getfem::regular_unit_mesh(m, nsubdiv, bgeot::simplex_geotrans(2, 1));
+  getfem::mesh_fem mf(m);
+  mf.set_classical_finite_element(1);
+  getfem::mesh_im mim(m);
+  mim.set_integration_method(4);
+  size_type nbd = mf.nb_basic_dof() - 5;
+  dal::bit_vector kept; kept.add(0, nbd);
+  mf.reduce_to_basic_dof(kept);
+  base_vector U(nbd);
+  for (size_type i = 0; i < nbd; ++i) U[i] = sin(scalar_type(i));
+
+  cout << "\nTest on repeated assembly with a modified reduced mesh_fem"
+       << endl;
+  getfem::ga_workspace workspace;
+  workspace.add_fem_variable("u", mf, gmm::sub_interval(0, nbd), U);
+  workspace.add_expression("Grad_u:Grad_Test_u + u*u*Test_u", mim);
+  scalar_type error = reduced_assembly_error(workspace, mf, mim, U);
+  // Same number of dofs, with more basic dofs
+  mf.set_classical_finite_element(2);
+  mf.reduce_to_basic_dof(kept);
+  GMM_ASSERT1(mf.is_reduced() && mf.nb_dof() == nbd, "Wrong reduction");
+  error += reduced_assembly_error(workspace, mf, mim, U);
+  cout << "Error : " << error << endl;
+  GMM_ASSERT1(error < 1E-12, "Error in the assembly with a modified reduced "
+              "mesh_fem");
+}
 
+// Element-batched execution of the assembly (see
+// ga_workspace::set_element_batch_size) on a mesh whose element types
+// (integration methods and fems) change along the elements, compared with
+// the standard execution.
+static void test_element_batched_assembly() {
+  getfem::mesh m;
+  std::vector<size_type> nsubdiv(2, 8);
+  getfem::regular_unit_mesh(m, nsubdiv, bgeot::simplex_geotrans(2, 1));
+  getfem::mesh_region border = getfem::outer_faces_of_mesh(m);
+  getfem::mesh_im mim(m);
+  getfem::mesh_fem mf_u(m), mf_v(m, 2);
+  mf_v.set_classical_finite_element(1);
+  for (dal::bv_visitor cv(m.convex_index()); !cv.finished(); ++cv) {
+    mim.set_integration_method
+      (cv, getfem::classical_approx_im(m.trans_of_convex(cv),
+                                       (cv*2 < m.nb_convex() || cv%2) ? 4 : 2));
+    mf_u.set_finite_element
+      (cv, getfem::classical_fem(m.trans_of_convex(cv), (cv%7) ? 1 : 2));
+  }
+  base_vector U(mf_u.nb_dof()), V(mf_v.nb_dof());
+  for (size_type i = 0; i < U.size(); ++i) U[i] = sin(scalar_type(i));
+  for (size_type i = 0; i < V.size(); ++i) V[i] = cos(scalar_type(i));
+
+  cout << "\nTest on the element-batched assembly" << endl;
+  getfem::ga_workspace workspace;
+  workspace.add_fem_variable("u", mf_u, gmm::sub_interval(0, U.size()), U);
+  workspace.add_fem_variable("v", mf_v, gmm::sub_interval(U.size(), V.size()),
+                             V);
+  workspace.add_expression("(1+u*u)*Grad_u.Grad_Test_u + 3*u*Test_u", mim);
+  workspace.add_expression("Sym(Grad_v):Grad_Test_v + 2*Div_v*Div_Test_v"
+                           "+ u*Test_v(1)", mim);
+  workspace.add_expression("u*Test_u + v.Test_v", mim, border);
+
+  scalar_type error(0);
+  base_vector R0;
+  getfem::model_real_sparse_matrix K0;
+  for (size_type nb : {0, 4, 7}) {
+    workspace.set_element_batch_size(nb);
+    workspace.assembly_statistics().clear();
+    workspace.assembly(1);
+    workspace.assembly(2);
+    size_type nb_batched
+      = workspace.assembly_statistics().nb_batched_elements;
+    GMM_ASSERT1((nb == 0) == (nb_batched == 0), "Wrong number of elements "
+                "executed by batches: " << nb_batched);
+    if (nb == 0) {
+      gmm::resize(R0, workspace.assembled_vector().size());
+      gmm::copy(workspace.assembled_vector(), R0);
+      gmm::resize(K0, U.size()+V.size(), U.size()+V.size());
+      gmm::copy(workspace.assembled_matrix(), K0);
+    } else {
+      base_vector R(R0);
+      getfem::model_real_sparse_matrix K(K0);
+      gmm::add(gmm::scaled(workspace.assembled_vector(), scalar_type(-1)), R);
+      gmm::add(gmm::scaled(workspace.assembled_matrix(), scalar_type(-1)), K);
+      error = std::max(error, gmm::vect_norminf(R) / gmm::vect_norminf(R0)
+                       + gmm::mat_norminf(K) / gmm::mat_norminf(K0));
+      cout << "Batches of " << nb << " elements: " << nb_batched
+           << " elements executed by batches" << endl;
+    }
+  }
+  cout << "Error : " << error << endl;
+  GMM_ASSERT1(error < 1E-13, "Error in the element-batched assembly");
+}
+
+// Multithreaded model assembly with a dynamic distribution of the
+// partitions to the threads, on a mesh with uneven element costs, compared
+// with the sequential assembly.
+static void test_dynamic_partitions(int N, int NX) {
+  getfem::mesh m;
+  char Ns[5]; sprintf(Ns, "%d", N);
+  std::vector<size_type> nsubdiv(N, NX);
+  getfem::regular_unit_mesh
+    (m, nsubdiv, bgeot::geometric_trans_descriptor
+     ((std::string("GT_PK(") + Ns + ",1)").c_str()));
+  getfem::mesh_fem mf_u(m);
+  mf_u.set_classical_finite_element(2);
+  getfem::mesh_im mim(m);
+  dal::bit_vector costly, cheap; // The costly elements are contiguous
+  for (dal::bv_visitor cv(m.convex_index()); !cv.finished(); ++cv)
+    if (cv * 5 < m.nb_convex()) costly.add(cv); else cheap.add(cv);
+  mim.set_integration_method(costly, 12);
+  mim.set_integration_method(cheap, 2);
+
+  getfem::model md;
+  md.add_fem_variable("u", mf_u);
+  getfem::add_nonlinear_term(md, mim, "Grad_u:Grad_Test_u + u*u*Test_u");
+  getfem::model_real_plain_vector &U = md.set_real_variable("u");
+  for (size_type i = 0; i < gmm::vect_size(U); ++i)
+    U[i] = sin(scalar_type(i));
+
+  cout << "\nTest on the dynamic distribution of the partitions" << endl;
+  md.assembly(getfem::model::BUILD_ALL);
+  base_vector R(md.real_rhs());
+  getfem::model_real_sparse_matrix K(md.real_tangent_matrix());
+
+  getfem::partition_master &pm = getfem::partition_master::get();
+  size_type nbth = getfem::true_thread_policy::num_threads();
+  pm.set_behaviour(getfem::thread_behaviour::dynamic_partition_threads);
+  getfem::set_num_threads(24); // The number of partitions is not reduced
+  getfem::set_num_threads(3);  // when the number of threads is.
+  md.assembly(getfem::model::BUILD_ALL);
+  size_type nb_partitions = pm.get_nb_partitions();
+  double load_balance = pm.get_load_balance();
+
+  // Work of each partition (contiguous ranges of elements), counted in
+  // integration points. Taking the partitions one by one, the threads are
+  // busy at least until the total work minus the one of the largest
+  // partition is done, which gives a lower bound of the load balance.
+  std::vector<scalar_type> work(nb_partitions);
+  size_type nbcv = m.convex_index().card(), i = 0;
+  size_type psize = (nbcv + nb_partitions - 1) / nb_partitions;
+  for (dal::bv_visitor cv(m.convex_index()); !cv.finished(); ++cv, ++i)
+    work[i / psize] += scalar_type(mim.int_method_of_element(cv)
+                                   ->approx_method()->nb_points_on_convex());
+  scalar_type max_work = *std::max_element(work.begin(), work.end());
+  scalar_type mean_work = std::accumulate(work.begin(), work.end(), 0.)
+    / scalar_type(nb_partitions);
+  scalar_type balance_bound
+    = scalar_type(1) / (scalar_type(1) + (max_work / mean_work)
+                        * scalar_type(3) / scalar_type(nb_partitions));
+  pm.set_behaviour(getfem::thread_behaviour::partition_threads);
+  getfem::set_num_threads(int(nbth));
+
+  gmm::add(gmm::scaled(md.real_rhs(), scalar_type(-1)), R);
+  gmm::add(gmm::scaled(md.real_tangent_matrix(), scalar_type(-1)), K);
+  scalar_type error = gmm::vect_norminf(R) / gmm::vect_norminf(md.real_rhs())
+    + gmm::mat_norminf(K) / gmm::mat_norminf(md.real_tangent_matrix());
+  cout << "Error : " << error << ", " << nb_partitions
+       << " partitions on 3 threads, max/mean work per partition "
+       << max_work / mean_work << ", load balance " << load_balance
+       << " (expected at least " << balance_bound << ")" << endl;
+  GMM_ASSERT1(nb_partitions >= 24, "Wrong number of partitions");
+  GMM_ASSERT1(max_work / mean_work <= scalar_type(nb_partitions) / 6.,
+              "The partitions are too coarse to balance the load");
+  // The measured balance is only meaningful with a core for each thread.
+  if (getfem::max_concurrency() >= 3)
+    GMM_ASSERT1(load_balance >= 0.75 * balance_bound, "Unbalanced "
+                "dynamic distribution of the partitions: " << load_balance);
+  GMM_ASSERT1(error < 1E-10, "Error in the dynamic distribution of the "
+              "partitions");
+}
 
 
 int main(int argc, char *argv[]) {
@@ -895,6 +1455,11 @@ int main(int argc, char *argv[]) {
   
   test_new_assembly(2, 25, 2);
   test_new_assembly(3, 7, 2);
+  test_model_assembly(2, 10);
+  test_size_specialized_instructions();
+  test_reduced_fem_reassembly();
+  test_element_batched_assembly();
+  test_dynamic_partitions(2, 20);
 
 
   // testbug();
@@ -326,6 +326,129 @@ void test0() {
   getfem::interpolation(mf1, mf2, M);
 }
 
+/* Checks the distribution of points computed by mti, comparing the
+   geometric transformation of the reference coordinates with the points.
+   cvx is the convex of each point, or size_type(-1). */
+void check_distribution(const getfem::mesh_trans_inv &mti, const mesh &m,
+                        const std::vector<base_node> &pts,
+                        std::vector<size_type> &cvx) {
+  cvx.assign(pts.size(), size_type(-1));
+  std::vector<size_type> itab;
+  for (dal::bv_visitor cv(m.convex_index()); !cv.finished(); ++cv) {
+    mti.points_on_convex(cv, itab);
+    GMM_ASSERT1(itab.size() == mti.nb_points_on_convex(cv), "error");
+    for (size_type i = 0; i < itab.size(); ++i) {
+      size_type ipt = itab[i];
+      GMM_ASSERT1(cvx[ipt] == size_type(-1) && mti.point_on_convex(cv, i) == ipt
+                  && (i == 0 || itab[i-1] < ipt), "error");
+      cvx[ipt] = cv;
+      base_node P = m.trans_of_convex(cv)->transform
+        (mti.reference_coords()[ipt], m.points_of_convex(cv));
+      GMM_ASSERT1(gmm::vect_dist2(P, pts[ipt]) < 1E-8, "Wrong "
+                  "reference coordinates for point " << ipt);
+    }
+  }
+}
+
+/* Distribution of points on a mesh with mesh_trans_inv. */
+void test_mesh_trans_inv() {
+  mesh m;
+  std::vector<size_type> nsubdiv(2, quick ? 10 : 40);
+  getfem::regular_unit_mesh(m, nsubdiv, bgeot::parallelepiped_geotrans(2,2));
+  for (dal::bv_visitor ip(m.points().index()); !ip.finished(); ++ip)
+    m.points()[ip] = shake_func(m.points()[ip]);
+  getfem::mesh_trans_inv mti(m);
+  size_type NPT = quick ? 1000 : 20000;
+  std::vector<base_node> pts(NPT);
+  for (size_type i = 0; i < NPT; ++i) {
+    pts[i] = base_node(gmm::random(double())*0.7+0.5,
+                       gmm::random(double())*0.7+0.5);
+    mti.add_point(pts[i]);
+  }
+  std::vector<size_type> cvx;
+  for (int extrapolation = 0; extrapolation < 3; extrapolation += 2)
+    for (int k = 0; k < 2; ++k) { // the second distribution is reused
+      mti.distribute(extrapolation);
+      check_distribution(mti, m, pts, cvx);
+      for (size_type i = 0; i < NPT; ++i) {
+        if (extrapolation == 2)
+          GMM_ASSERT1(cvx[i] != size_type(-1), "point " << i << " not found");
+        if (gmm::vect_norminf(pts[i] - base_node(0.5, 0.5)) < 0.45)
+          GMM_ASSERT1(cvx[i] != size_type(-1), "point " << i << " not found");
+      }
+    }
+
+  // The distribution is computed again after a change of the mesh.
+  m.translation(base_small_vector(0.05, -0.03));
+  mti.distribute(2);
+  check_distribution(mti, m, pts, cvx);
+  for (size_type i = 0; i < NPT; ++i)
+    GMM_ASSERT1(cvx[i] != size_type(-1), "point " << i << " not found");
+
+  // The parallel search gives the same result as the sequential one.
+  size_type nbth = getfem::true_thread_policy::num_threads();
+  for (int extrapolation = 0; extrapolation < 3; extrapolation += 2) {
+    std::vector<size_type> cvx_seq;
+    std::vector<base_node> ref_seq;
+    for (int nth = 1; nth <= 3; nth += 2) {
+      getfem::set_num_threads(nth);
+      getfem::mesh_trans_inv mti2(m);
+      mti2.add_points(pts);
+      mti2.distribute(extrapolation);
+      check_distribution(mti2, m, pts, cvx);
+      if (nth == 1) { cvx_seq = cvx; ref_seq = mti2.reference_coords(); }
+      else
+        for (size_type i = 0; i < NPT; ++i)
+          GMM_ASSERT1(cvx[i] == cvx_seq[i] && (cvx[i] == size_type(-1) ||
+                      mti2.reference_coords()[i] == ref_seq[i]),
+                      "The parallel search differs from the sequential one "
+                      "for point " << i);
+    }
+  }
+  getfem::set_num_threads(int(nbth));
+}
+
+/* Cached transfer operator, compared to the direct interpolation, for
+   several components per dof, a batch of fields and after a modification
+   of the source mesh. */
+void test_interpolation_operator() {
+  mesh m1, m2;
+  size_type NX = quick ? 8 : 30;
+  build_mesh(m1, 0, 2, 2, NX, 1, true);
+  build_mesh(m2, 0, 2, 2, NX+3, 1, true);
+  mesh_fem mf1(m1, 2); mf1.set_finite_element(getfem::PK_fem(2, 2));
+  mesh_fem mf2(m2, 2); mf2.set_finite_element(getfem::PK_fem(2, 1));
+  getfem::interpolation_operator op(mf1, mf2, 1);
+  GMM_ASSERT1(!op.is_built() && op.nrows() == mf2.nb_dof()
+              && op.ncols() == mf1.nb_dof() && op.is_built(), "error");
+
+  for (int k = 0; k < 2; ++k) {
+    size_type nf = 3;
+    for (size_type q = 1; q <= 3; q += 2) {
+      std::vector<scalar_type> U(mf1.nb_dof()*q), V1(mf2.nb_dof()*q);
+      std::vector<scalar_type> V2(mf2.nb_dof()*q);
+      gmm::fill_random(U);
+      getfem::interpolation(mf1, mf2, U, V1, 1);
+      op.apply(U, V2);
+      GMM_ASSERT1(gmm::vect_dist2(V1, V2) < 1E-10 * gmm::vect_norm2(V1),
+                  "wrong transfer, q = " << q);
+    }
+    gmm::dense_matrix<scalar_type> UU(mf1.nb_dof()*3, nf);
+    gmm::dense_matrix<scalar_type> VV(mf2.nb_dof()*3, nf);
+    gmm::fill_random(UU);
+    op.apply(UU, VV);
+    for (size_type f = 0; f < nf; ++f) {
+      std::vector<scalar_type> V(mf2.nb_dof()*3);
+      op.apply(gmm::mat_col(UU, f), V);
+      GMM_ASSERT1(gmm::vect_dist2(V, gmm::mat_col(VV, f)) < 1E-12,
+                  "wrong batch transfer");
+    }
+    // The operator has to be rebuilt when the source mesh is modified.
+    m1.translation(bgeot::base_small_vector(0.01, -0.02));
+    GMM_ASSERT1(!op.is_built(), "the transfer operator is not invalidated");
+  }
+}
+
 /* this test is raising a dimension mismatch except in bgeot::geotrans_inv_convex::invert_nonlin
    at line 123         gmm::mult(gmm::transposed(K), rn, vres);
    K is 2x3 , rn size is 3, vres is 3
@@ -411,6 +534,8 @@ int main(int argc, char *argv[]) {
   
   testDim_3D();
   test0();
+  test_mesh_trans_inv();
+  test_interpolation_operator();
   for (int mat_version = 0; mat_version < 5; ++mat_version) {
     const char *msg[] = {"Testing interpolation", 
 			 "Testing stored interpolator in rsc matrix",
@@ -26,6 +26,7 @@ using std::ends; using std::cin;
 using bgeot::base_node;
 using bgeot::size_type;
 using bgeot::dim_type;
+using bgeot::scalar_type;
 
 bool quick = false;
 
@@ -103,6 +104,34 @@ void check_tree() {
     verify_points_in_box(pts, tree, pts[0], pts[0]);
     verify_points_in_box(pts, tree, pts[0], pts[1]);
   }
+
+  /* moving points, the tree being refitted */
+  pts.clear(); tree.clear();
+  for (size_type i=0; i < 500; ++i) {
+    pts.push_back(base_node(gmm::random(),gmm::random()));
+    tree.add_point(pts.back());
+  }
+  verify_points_in_box(pts, tree, base_node(.2,.3),base_node(.6,.5));
+  for (size_type step=0; step < 20; ++step) {
+    for (size_type k=0; k < tree.nb_points(); ++k) {
+      size_type i = tree.points()[k].i;
+      pts[i] += base_node(gmm::random()*0.02, gmm::random()*0.02);
+      tree.move_point(k, pts[i]);
+    }
+    tree.refit();
+    verify_points_in_box(pts, tree, base_node(.2,.3),base_node(.6,.5));
+    for (size_type i=0; i < 10; ++i) {
+      base_node P(gmm::random()*1.2, gmm::random()*1.2);
+      bgeot::index_node_pair ipt;
+      scalar_type dist2 = tree.nearest_neighbor(ipt, P), dmin(-1);
+      for (size_type j=0; j < pts.size(); ++j) {
+        scalar_type d = gmm::vect_dist2_sqr(pts[j], P);
+        if (dmin < 0 || d < dmin) dmin = d;
+      }
+      assert(gmm::abs(dist2 - dmin) < 1E-14
+             && gmm::abs(gmm::vect_dist2_sqr(pts[ipt.i], P) - dmin) < 1E-14);
+    }
+  }
   cout << "\nthe kdtree is ok!\n";
 }
 
@@ -26,6 +26,7 @@
 using std::endl; using std::cout; using std::cerr;
 using std::ends; using std::cin;
 using getfem::size_type;
+using getfem::scalar_type;
 using getfem::base_node;
 using getfem::base_small_vector;
 
@@ -529,6 +530,206 @@ void test_search_point() {
 
 
 
+size_type dof_bandwidth(const getfem::mesh_fem &mf) {
+  size_type bw = 0;
+  for (dal::bv_visitor cv(mf.convex_index()); !cv.finished(); ++cv) {
+    getfem::mesh_fem::ind_dof_ct dofs = mf.ind_basic_dof_of_element(cv);
+    size_type dmin = *std::min_element(dofs.begin(), dofs.end());
+    size_type dmax = *std::max_element(dofs.begin(), dofs.end());
+    bw = std::max(bw, dmax - dmin);
+  }
+  return bw;
+}
+
+// Scattered numbering of the elements, as for an imported mesh
+void scattered_unit_mesh(getfem::mesh &m, size_type n) {
+  getfem::mesh m0;
+  std::vector<size_type> nsubdiv(2, n);
+  getfem::regular_unit_mesh(m0, nsubdiv, bgeot::simplex_geotrans(2, 1));
+  size_type nbcv = m0.nb_convex();
+  for (size_type k = 0; k < nbcv; ++k) {
+    size_type cv = (k * 97) % nbcv;
+    m.add_convex_by_points(m0.trans_of_convex(cv),
+                           m0.points_of_convex(cv).begin());
+  }
+}
+
+// Mean extent of the point numbers of the convexes
+scalar_type point_spread(const getfem::mesh &m) {
+  scalar_type s(0);
+  for (dal::bv_visitor cv(m.convex_index()); !cv.finished(); ++cv) {
+    const getfem::mesh::ind_cv_ct &ipts = m.ind_points_of_convex(cv);
+    s += scalar_type(*std::max_element(ipts.begin(), ipts.end())
+                     - *std::min_element(ipts.begin(), ipts.end()));
+  }
+  return s / scalar_type(m.nb_convex());
+}
+
+void test_optimize_layout(void) {
+  getfem::mesh m;
+  scattered_unit_mesh(m, 30);
+  getfem::outer_faces_of_mesh(m, m.region(1));
+  for (dal::bv_visitor cv(m.convex_index()); !cv.finished(); ++cv)
+    if (gmm::vect_norm2(m.points_of_convex(cv)[0]) < 0.5) m.region(2).add(cv);
+  size_type nbc = m.nb_convex(), nbp = m.nb_points();
+  size_type nbf1 = m.region(1).size(), nbc2 = m.region(2).size();
+  scalar_type sp0 = point_spread(m);
+
+  m.optimize_layout();
+  GMM_ASSERT1(m.nb_convex() == nbc && m.nb_points() == nbp &&
+              m.convex_index().last_true() + 1 == nbc,
+              "Wrong number of convexes or points");
+  GMM_ASSERT1(m.region(1).size() == nbf1 && m.region(2).size() == nbc2,
+              "Wrong renumbering of the regions");
+  for (getfem::mr_visitor v(m.region(1)); !v.finished(); ++v)
+    GMM_ASSERT1(!m.is_convex_having_neighbor(v.cv(), v.f()),
+                "Wrong renumbering of a face region");
+  for (getfem::mr_visitor v(m.region(2)); !v.finished(); ++v)
+    GMM_ASSERT1(gmm::vect_norm2(m.points_of_convex(v.cv())[0]) < 0.5,
+                "Wrong renumbering of a convex region");
+  scalar_type area(0);
+  for (dal::bv_visitor cv(m.convex_index()); !cv.finished(); ++cv)
+    area += m.convex_area_estimate(cv);
+  GMM_ASSERT1(gmm::abs(area - 1.) < 1e-10, "Wrong mesh after renumbering");
+  test_conforming(m);
+  cout << "mean point spread of the convexes: " << sp0
+       << " before optimize_layout, " << point_spread(m) << " after\n";
+  GMM_ASSERT1(point_spread(m) < sp0 / 10, "Bad locality after renumbering");
+}
+
+// The regions and the mesh_fem dofs follow the renumbering, the isolated
+// points being kept (at the end of the numbering).
+void test_optimize_layout_isolated_points(void) {
+  getfem::mesh m;
+  scattered_unit_mesh(m, 12);
+  std::vector<base_node> iso;
+  iso.push_back(base_node(2.0, 2.0));
+  iso.push_back(base_node(0.31, 0.77));
+  iso.push_back(base_node(-1.0, 0.5));
+  for (size_type k = 0; k < iso.size(); ++k) m.add_point(iso[k]);
+  // holes in the numbering of the convexes
+  for (size_type cv = 5; cv < m.nb_convex(); cv += 37) m.sup_convex(cv);
+  getfem::outer_faces_of_mesh(m, m.region(1));
+  for (dal::bv_visitor cv(m.convex_index()); !cv.finished(); ++cv)
+    if (m.points_of_convex(cv)[0][0] < 0.5) m.region(2).add(cv);
+
+  getfem::mesh_fem mf(m, 2);
+  mf.set_classical_finite_element(2);
+  size_type nbd = mf.nb_dof(), nbp = m.nb_points(), nbc = m.nb_convex();
+  size_type nbf1 = m.region(1).size(), nbc2 = m.region(2).size();
+  std::vector<base_node> dofpts;
+  for (size_type i = 0; i < nbd; i += 2) dofpts.push_back(mf.point_of_basic_dof(i));
+  std::sort(dofpts.begin(), dofpts.end());
+
+  m.optimize_layout();
+  GMM_ASSERT1(m.nb_points() == nbp && m.nb_convex() == nbc,
+              "Wrong number of points or convexes");
+  for (size_type k = 0; k < iso.size(); ++k) {
+    size_type ip = nbp - iso.size() + k;
+    GMM_ASSERT1(m.points_index().is_in(ip) && m.convex_to_point(ip).empty(),
+                "The isolated points are not at the end");
+    bool found = false;
+    for (size_type l = 0; l < iso.size(); ++l)
+      if (gmm::vect_dist2(m.points()[ip], iso[l]) < 1e-14) found = true;
+    GMM_ASSERT1(found, "An isolated point has been lost");
+  }
+  GMM_ASSERT1(m.region(1).size() == nbf1 && m.region(2).size() == nbc2,
+              "Wrong renumbering of the regions");
+  for (getfem::mr_visitor v(m.region(1)); !v.finished(); ++v)
+    GMM_ASSERT1(!m.is_convex_having_neighbor(v.cv(), v.f()),
+                "Wrong renumbering of a face region");
+  for (getfem::mr_visitor v(m.region(2)); !v.finished(); ++v)
+    GMM_ASSERT1(m.points_of_convex(v.cv())[0][0] < 0.5,
+                "Wrong renumbering of a convex region");
+
+  // The dofs are enumerated again on the renumbered mesh: same dof
+  // nodes, and dofs consistent with the elements.
+  GMM_ASSERT1(mf.nb_dof() == nbd && mf.convex_index() == m.convex_index(),
+              "Wrong number of dofs after renumbering");
+  std::vector<base_node> dofpts2;
+  for (size_type i = 0; i < nbd; i += 2) {
+    GMM_ASSERT1(mf.basic_dof_qdim(i) == 0 && mf.basic_dof_qdim(i+1) == 1,
+                "Wrong components of the dofs");
+    dofpts2.push_back(mf.point_of_basic_dof(i));
+  }
+  std::sort(dofpts2.begin(), dofpts2.end());
+  for (size_type i = 0; i < dofpts.size(); ++i)
+    GMM_ASSERT1(gmm::vect_dist2(dofpts[i], dofpts2[i]) < 1e-12,
+                "The dof nodes have changed");
+  for (dal::bv_visitor cv(m.convex_index()); !cv.finished(); ++cv) {
+    getfem::mesh_fem::ind_dof_ct dofs = mf.ind_basic_dof_of_element(cv);
+    for (size_type i = 0; i < dofs.size(); ++i)
+      GMM_ASSERT1(gmm::vect_dist2(mf.point_of_basic_dof(cv, i),
+                                  mf.point_of_basic_dof(dofs[i])) < 1e-12,
+                  "Inconsistent dofs after renumbering");
+  }
+
+  // Finite elements set on the renumbered region
+  getfem::mesh_fem mf2(m);
+  mf2.set_finite_element(m.region(2).index(),
+                         getfem::classical_fem(m.trans_of_convex(0), 1));
+  GMM_ASSERT1(mf2.convex_index() == m.region(2).index(),
+              "Wrong fems on the renumbered region");
+  for (dal::bv_visitor cv(mf2.convex_index()); !cv.finished(); ++cv) {
+    getfem::mesh_fem::ind_dof_ct dofs = mf2.ind_basic_dof_of_element(cv);
+    for (size_type i = 0; i < dofs.size(); ++i)
+      GMM_ASSERT1(dofs[i] < mf2.nb_dof() &&
+                  gmm::vect_dist2(mf2.point_of_basic_dof(dofs[i]),
+                                  m.points_of_convex(cv)[i]) < 1e-12,
+                  "Inconsistent dofs on the renumbered region");
+  }
+}
+
+void test_dof_renumbering(void) {
+  getfem::mesh m;
+  scattered_unit_mesh(m, 20);
+  getfem::mesh_fem mf(m, 2);
+  mf.set_classical_finite_element(2);
+  size_type nbd = mf.nb_dof(), bw0 = dof_bandwidth(mf);
+  dal::bit_vector kept;
+  for (size_type i = 0; i < nbd; i += 3) kept.add(i);
+  mf.reduce_to_basic_dof(kept);
+  std::vector<base_node> pts0;
+  std::vector<size_type> qdim0;
+  for (dal::bv_visitor i(kept); !i.finished(); ++i) {
+    pts0.push_back(mf.point_of_basic_dof(i));
+    qdim0.push_back(mf.basic_dof_qdim(i));
+  }
+
+  getfem::dof_renumbering_type ren[2] = {
+    getfem::DOF_RENUMBERING_RCM, getfem::DOF_RENUMBERING_NESTED_DISSECTION };
+  for (size_type k = 0; k < 2; ++k) {
+    mf.set_dof_renumbering(ren[k]);
+    GMM_ASSERT1(mf.nb_basic_dof() == nbd, "Wrong number of dofs");
+    for (dal::bv_visitor cv(mf.convex_index()); !cv.finished(); ++cv)
+      for (size_type i = 0; i < mf.nb_basic_dof_of_element(cv); ++i) {
+        size_type d = mf.ind_basic_dof_of_element(cv)[i];
+        GMM_ASSERT1(gmm::vect_dist2(mf.point_of_basic_dof(d),
+                                    mf.point_of_basic_dof(cv, i)) < 1e-10
+                    && mf.basic_dof_qdim(d) == i % 2,
+                    "Wrong renumbering of dofs");
+      }
+    // The reduced dofs are the same, in the same order
+    size_type j = 0;
+    for (size_type i = 0; i < nbd; ++i)
+      for (size_type l = 0; l < mf.nb_dof(); ++l)
+        if (mf.reduction_matrix()(l, i) != 0.) {
+          GMM_ASSERT1(gmm::vect_dist2(mf.point_of_basic_dof(i),
+                                      pts0[l]) < 1e-10
+                      && mf.basic_dof_qdim(i) == qdim0[l],
+                      "Wrong permutation of the reduction matrix");
+          ++j;
+        }
+    GMM_ASSERT1(j == pts0.size(), "Wrong permutation of the reduction matrix");
+  }
+  mf.set_reduction(false);
+  mf.set_dof_renumbering(getfem::DOF_RENUMBERING_RCM);
+  cout << "dof bandwidth: " << bw0 << " without renumbering, "
+       << dof_bandwidth(mf) << " with the reverse Cuthill-McKee ordering\n";
+  GMM_ASSERT1(dof_bandwidth(mf) <= bw0, "RCM renumbering increases the "
+              "bandwidth");
+}
+
 void test_incomplete_Q2(void) {
   // By Yao Koutsawa <yao.koutsawa@tudor.lu> 2012-12-10
   bgeot::pgeometric_trans pgt = bgeot::geometric_trans_descriptor("GT_Q2_INCOMPLETE(2)");
@@ -657,6 +858,12 @@ int main(void) {
   test_refinable(3, 3);
 
   test_incomplete_Q2();
+
+  test_dof_renumbering();
+
+  test_optimize_layout();
+
+  test_optimize_layout_isolated_points();
   
   return 0;
 }
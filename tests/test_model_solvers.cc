@@ -0,0 +1,230 @@
+/*===========================================================================
+
+ Copyright (C) 2026 agent.
+
+ This file is a part of GetFEM
+
+ GetFEM  is  free software;  you  can  redistribute  it  and/or modify it
+ under  the  terms  of the  GNU  Lesser General Public License as published
+ by  the  Free Software Foundation;  either version 3 of the License,  or
+ (at your option) any later version along with the GCC Runtime Library
+ Exception either version 3.1 or (at your option) any later version.
+ This program  is  distributed  in  the  hope  that it will be useful,  but
+ WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ or  FITNESS  FOR  A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+ License and GCC Runtime Library Exception for more details.
+ You  should  have received a copy of the GNU Lesser General Public License
+ along  with  this program;  if not, write to the Free Software Foundation,
+ Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301, USA.
+
+===========================================================================*/
+/* Tests of the linear solvers of the model solvers.                        */
+
+#include "getfem/getfem_regular_meshes.h"
+#include "getfem/getfem_model_solvers.h"
+#include "getfem/getfem_generic_assembly.h"
+
+using bgeot::size_type;
+using bgeot::scalar_type;
+using std::endl; using std::cout;
+
+typedef getfem::model_real_sparse_matrix sparse_matrix;
+typedef getfem::model_real_plain_vector plain_vector;
+
+static scalar_type residual(const sparse_matrix &K, const plain_vector &x,
+                            const plain_vector &b) {
+  plain_vector r(b);
+  gmm::mult(K, gmm::scaled(x, scalar_type(-1)), r, r);
+  return gmm::vect_norminf(r) / gmm::vect_norminf(b);
+}
+
+// Reuse of the SuperLU symbolic factorization: two solves with the same
+// pattern, then one with a changed pattern, then a nonlinear model solve.
+static void test_superlu_pattern_reuse(const getfem::mesh_fem &mf,
+                                       const getfem::mesh_im &mim) {
+  getfem::model md;
+  md.add_fem_variable("u", mf);
+  getfem::add_linear_term(md, mim, "Grad_u:Grad_Test_u + u*Test_u");
+  md.assembly(getfem::model::BUILD_MATRIX);
+  const sparse_matrix &K1 = md.real_tangent_matrix();
+  size_type n = gmm::mat_nrows(K1);
+
+  cout << "Test on the reuse of the SuperLU symbolic factorization" << endl;
+  getfem::linear_solver_superlu<sparse_matrix, plain_vector> ls;
+  plain_vector x(n), b(n);
+  for (size_type i = 0; i < n; ++i) b[i] = sin(scalar_type(i));
+  gmm::iteration iter(1E-10, 1);
+  ls(K1, x, b, iter);
+  scalar_type error = residual(K1, x, b);
+  GMM_ASSERT1(ls.factor.rcond() > 0, "The condition number is not computed");
+
+  // Same pattern, other values
+  sparse_matrix K2(n, n);
+  gmm::copy(K1, K2);
+  for (size_type i = 0; i < n; ++i) K2(i, i) *= scalar_type(2);
+  iter.set_noisy(0);
+  ls(K2, x, b, iter);
+  error = std::max(error, residual(K2, x, b));
+  GMM_ASSERT1(ls.nb_factorizations == 2 && ls.nb_numerical_factorizations == 1,
+              "The symbolic factorization is not reused");
+
+  // Changed pattern
+  sparse_matrix K3(n, n);
+  gmm::copy(K2, K3);
+  K3(0, n-1) = K3(n-1, 0) = scalar_type(1E-3);
+  ls(K3, x, b, iter);
+  error = std::max(error, residual(K3, x, b));
+  GMM_ASSERT1(ls.nb_factorizations == 3 && ls.nb_numerical_factorizations == 1,
+              "The symbolic factorization is reused for another pattern");
+
+  // Same pattern as the previous matrix, with another structure version
+  ls.structure_version = 7;
+  ls(K3, x, b, iter);
+  error = std::max(error, residual(K3, x, b));
+  GMM_ASSERT1(ls.nb_numerical_factorizations == 1,
+              "The structure version is not taken into account");
+  ls(K3, x, b, iter);
+  GMM_ASSERT1(ls.nb_numerical_factorizations == 2,
+              "The symbolic factorization is not reused for the same version");
+  cout << "Residual : " << error << endl;
+  GMM_ASSERT1(error < 1E-10, "Error in the SuperLU solves");
+
+  // Newton iterations of a nonlinear model: only the first factorization
+  // is a full one
+  getfem::model md2;
+  md2.add_fem_variable("u", mf);
+  getfem::add_nonlinear_term
+    (md2, mim, "Grad_u:Grad_Test_u + u*Test_u + u*u*u*Test_u - Test_u");
+  auto pls = std::make_shared
+    <getfem::linear_solver_superlu<sparse_matrix, plain_vector>>();
+  gmm::iteration iter2(1E-9, 0, 40000);
+  getfem::standard_solve(md2, iter2, pls);
+  cout << pls->nb_factorizations << " factorizations, "
+       << pls->nb_numerical_factorizations << " numerical only" << endl;
+  GMM_ASSERT1(iter2.converged(), "The Newton method did not converge");
+  GMM_ASSERT1(pls->nb_factorizations > 1 && pls->nb_numerical_factorizations
+              == pls->nb_factorizations - 1,
+              "The symbolic factorization is not reused by the model solver");
+}
+
+// Stiffness plus eps times mass matrix, whose condition number is about
+// 1/eps for small eps.
+static void shifted_laplacian(const getfem::mesh_fem &mf,
+                              const getfem::mesh_im &mim, scalar_type eps,
+                              sparse_matrix &K) {
+  getfem::model md;
+  md.add_fem_variable("u", mf);
+  md.add_initialized_scalar_data("eps", eps);
+  getfem::add_linear_term(md, mim, "Grad_u:Grad_Test_u + eps*u*Test_u");
+  md.assembly(getfem::model::BUILD_MATRIX);
+  gmm::resize(K, md.nb_dof(), md.nb_dof());
+  gmm::copy(md.real_tangent_matrix(), K);
+}
+
+// Mixed precision SuperLU solver: iterative refinement for a well
+// conditioned matrix, gmres for an ill conditioned one and the double
+// precision factorization for a matrix out of the single precision range.
+static void test_superlu_mixed(const getfem::mesh_fem &mf,
+                               const getfem::mesh_im &mim) {
+  cout << "Test on the mixed precision SuperLU solver" << endl;
+  getfem::linear_solver_superlu_mixed<sparse_matrix, plain_vector> ls;
+  sparse_matrix K;
+  shifted_laplacian(mf, mim, scalar_type(1), K);
+  size_type n = gmm::mat_nrows(K);
+  plain_vector x(n), b(n);
+  for (size_type i = 0; i < n; ++i) b[i] = sin(scalar_type(i));
+  gmm::iteration iter(1E-10);
+  ls(K, x, b, iter);
+  scalar_type res = residual(K, x, b);
+  cout << "well conditioned matrix, residual : " << res << endl;
+  GMM_ASSERT1(iter.converged() && res < 1E-12, "Error in the mixed solve");
+  GMM_ASSERT1(ls.nb_refinement_solves == 1 && ls.nb_gmres_solves == 0
+              && ls.nb_double_solves == 0,
+              "The iterative refinement is not used");
+
+  // The residual is about sqrt(n) eps cond(K) |b|
+  shifted_laplacian(mf, mim, scalar_type(1E-7), K);
+  ls(K, x, b, iter);
+  res = residual(K, x, b);
+  cout << "ill conditioned matrix, residual : " << res << ", "
+       << ls.nb_gmres_solves << " gmres and " << ls.nb_double_solves
+       << " double precision solves" << endl;
+  GMM_ASSERT1(iter.converged() && res < 1E-6, "Error in the mixed solve");
+  GMM_ASSERT1(ls.nb_refinement_solves == 1
+              && ls.nb_gmres_solves + ls.nb_double_solves == 1,
+              "No fallback for the ill conditioned matrix");
+
+  gmm::scale(K, scalar_type(1E39));
+  ls(K, x, b, iter);
+  res = residual(K, x, b);
+  cout << "matrix out of the single precision range, residual : " << res
+       << endl;
+  GMM_ASSERT1(iter.converged() && res < 1E-6, "Error in the mixed solve");
+  GMM_ASSERT1(ls.nb_double_solves >= 1 && ls.nb_refinement_solves == 1,
+              "The double precision factorization is not used");
+}
+
+// Solve of several right hand sides compared to the solves of each column.
+template <typename SOLVER>
+static void test_solve_multiple(const SOLVER &ls, const sparse_matrix &K,
+                                const std::string &name) {
+  typedef typename SOLVER::MULTI_VECTOR MULTI_VECTOR;
+  size_type n = gmm::mat_nrows(K), nrhs = 3;
+  MULTI_VECTOR X(n, nrhs), B(n, nrhs);
+  for (size_type j = 0; j < nrhs; ++j)
+    for (size_type i = 0; i < n; ++i)
+      B(i, j) = sin(scalar_type(i * (j+1)));
+  gmm::iteration iter(1E-10);
+  ls.solve_multiple(K, X, B, iter);
+  GMM_ASSERT1(iter.converged(), "The multiple solve with " << name
+              << " has failed");
+
+  scalar_type error(0);
+  plain_vector x(n), b(n);
+  for (size_type j = 0; j < nrhs; ++j) {
+    gmm::copy(gmm::mat_col(B, j), b);
+    gmm::clear(x);
+    gmm::iteration iter2(1E-10);
+    ls(K, x, b, iter2);
+    GMM_ASSERT1(iter2.converged(), "The solve with " << name << " has failed");
+    gmm::add(gmm::scaled(gmm::mat_col(X, j), scalar_type(-1)), x);
+    error = std::max(error, gmm::vect_norminf(x));
+  }
+  cout << "Multiple solve with " << name << ", difference with the solves "
+       "of each column : " << error << endl;
+  GMM_ASSERT1(error < 1E-10, "Error in the multiple solve with " << name);
+}
+
+static void test_solve_multiple(const getfem::mesh_fem &mf,
+                                const getfem::mesh_im &mim) {
+  sparse_matrix K;
+  shifted_laplacian(mf, mim, scalar_type(1), K);
+  test_solve_multiple
+    (getfem::linear_solver_superlu<sparse_matrix, plain_vector>(), K,
+     "SuperLU");
+  test_solve_multiple
+    (getfem::linear_solver_superlu_mixed<sparse_matrix, plain_vector>(), K,
+     "mixed precision SuperLU");
+#ifdef GMM_USES_MUMPS
+  test_solve_multiple
+    (getfem::linear_solver_mumps<sparse_matrix, plain_vector>(), K, "MUMPS");
+  test_solve_multiple
+    (getfem::linear_solver_mumps_sym<sparse_matrix, plain_vector>(), K,
+     "symmetric MUMPS");
+#endif
+}
+
+int main(void) {
+  getfem::mesh m;
+  getfem::regular_unit_mesh(m, {10, 10},
+                            bgeot::geometric_trans_descriptor("GT_PK(2,1)"));
+  getfem::mesh_fem mf(m);
+  mf.set_classical_finite_element(2);
+  getfem::mesh_im mim(m);
+  mim.set_integration_method(4);
+
+  test_superlu_pattern_reuse(mf, mim);
+  test_superlu_mixed(mf, mim);
+  test_solve_multiple(mf, mim);
+  return 0;
+}
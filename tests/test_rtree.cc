@@ -113,6 +113,20 @@ static void brute_force_check(const std::vector<base_node>& rmin,
   }
 }
 
+/* the outputs as box_index pointers should match the output as ids */
+static void check_outputs(const bgeot::rtree& tree, const base_node& min,
+                          const base_node& max,
+                          const std::vector<size_type>& pbset) {
+  rtree::pbox_cont bc;
+  rtree::pbox_set bs;
+  tree.find_intersecting_boxes(min, max, bc);
+  tree.find_intersecting_boxes(min, max, bs);
+  assert(bc.size() == pbset.size() && bs.size() == pbset.size());
+  rtree::pbox_set::const_iterator it = bs.begin();
+  for (size_type i=0; i < pbset.size(); ++i, ++it)
+    assert(bc[i]->id == pbset[i] && (*it)->id == pbset[i]);
+}
+
 static void verify(const std::vector<base_node>& rmin, const std::vector<base_node>& rmax, bgeot::rtree& tree) {
   size_type N=rmin.front().size();
   std::vector<size_type> pbset;
@@ -134,6 +148,7 @@ static void verify(const std::vector<base_node>& rmin, const std::vector<base_no
 
     tree.find_intersecting_boxes(min,max,pbset);
     brute_force_check(rmin,rmax,pbset,intersection_p(min,max));
+    check_outputs(tree,min,max,pbset);
 
     tree.find_contained_boxes(min,max,pbset);
     brute_force_check(rmin,rmax,pbset,contained_p(min,max));
@@ -233,6 +248,33 @@ static void check_tree() {
     tree.add_box(rmin.back(),rmax.back());
   }
   verify(rmin, rmax, tree);
+
+  cout << "refit checks\n";
+  tree.clear(); rmin.clear(); rmax.clear();
+  for (size_type i=0; i < 600; ++i) {
+    rmin.push_back(base_node(gmm::random(double()), gmm::random(double())));
+    rmax.push_back(rmin.back() + base_node(1.+gmm::random(), 1.+gmm::random())/10.);
+    tree.add_box(rmin.back(),rmax.back());
+  }
+  tree.build_tree();
+  for (size_type step=0; step < 5; ++step) { /* small motions */
+    for (size_type i=0; i < rmin.size(); ++i) {
+      base_node d(gmm::random()*0.01, gmm::random()*0.01);
+      rmin[i] += d; rmax[i] += d;
+      tree.move_box(i, rmin[i], rmax[i]);
+    }
+    bool rebuilt = tree.refit();
+    assert(!rebuilt);
+    verify(rmin, rmax, tree);
+  }
+  for (size_type i=0; i < rmin.size(); ++i) { /* scrambling */
+    base_node d(rmin[rmin.size()-1-i]); d -= rmin[i];
+    rmin[i] += d; rmax[i] += d;
+    tree.move_box(i, rmin[i], rmax[i]);
+  }
+  bool rebuilt = tree.refit();
+  assert(rebuilt);
+  verify(rmin, rmax, tree);
   cout << "\nthe rtree is ok!\n";
 }
 